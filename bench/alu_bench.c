@@ -0,0 +1,199 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "bench_workload.h"
+#include "alu/alu.h"
+#include "alu/alu_lut.h"
+#include "alu/alu_batch.h"
+#include "alu/alu_bitslice.h"
+#include "alu/alu_bigint.h"
+
+/* Default element count per run for the bulk kernels; the size argument overrides it. */
+#define BENCH_ALU_ELEMENTS (1u << 22)
+#define BENCH_ALU_BIGINT_NIBBLES 4096u
+
+/* Keeps results alive so the calls are not optimised away. */
+static volatile uint8_t bench_alu_sink;
+
+static uint8_t bench_alu_fold(AluResult result) {
+    return (uint8_t)(result.result ^ result.zero_flag ^ result.carry_flag ^ result.negative_flag ^
+                     result.overflow_flag);
+}
+
+/* Every operation on every operand pair, through alu_* or the tables. */
+static void bench_scalar(BenchContext *bench, int use_tables, size_t elements) {
+    size_t rounds = elements / 256u + 1u;
+    BenchSamples rates;
+    bench_samples_begin(&rates);
+    while (bench_samples_pending(bench, &rates)) {
+        uint8_t fold = 0;
+        double start = bench_now_seconds();
+        for (size_t round = 0; round < rounds; ++round) {
+            for (unsigned pair = 0; pair < 256u; ++pair) {
+                uint8_t a = (uint8_t)(pair & 0x0Fu);
+                uint8_t b = (uint8_t)((pair >> 4) ^ fold);
+                if (use_tables) {
+                    fold ^= bench_alu_fold(alu_lut_add(a, b)) ^ bench_alu_fold(alu_lut_sub(a, b)) ^
+                            bench_alu_fold(alu_lut_and(a, b)) ^ bench_alu_fold(alu_lut_or(a, b)) ^
+                            bench_alu_fold(alu_lut_xor(a, b)) ^ bench_alu_fold(alu_lut_not(a)) ^
+                            bench_alu_fold(alu_lut_shl(a)) ^ bench_alu_fold(alu_lut_shr(a));
+                } else {
+                    fold ^= bench_alu_fold(alu_add(a, b)) ^ bench_alu_fold(alu_sub(a, b)) ^
+                            bench_alu_fold(alu_and(a, b)) ^ bench_alu_fold(alu_or(a, b)) ^
+                            bench_alu_fold(alu_xor(a, b)) ^ bench_alu_fold(alu_not(a)) ^
+                            bench_alu_fold(alu_shl(a)) ^ bench_alu_fold(alu_shr(a));
+                }
+                fold &= 0x0Fu;
+            }
+        }
+        double elapsed = bench_now_seconds() - start;
+        bench_alu_sink = fold;
+        bench_samples_add(bench, &rates, (double)rounds * 256.0 * 8.0 / elapsed);
+    }
+    bench_report(bench, "all_ops", use_tables ? "lut" : "scalar", "ops/s", &rates, NULL);
+}
+
+/* A carry chain through alu_adc, one nibble at a time. */
+static void bench_carry_chain(BenchContext *bench, const uint8_t *nibbles, size_t elements) {
+    BenchSamples rates;
+    bench_samples_begin(&rates);
+    while (bench_samples_pending(bench, &rates)) {
+        uint8_t carry = 0;
+        uint8_t fold = 0;
+        double start = bench_now_seconds();
+        for (size_t index = 0; index < elements; ++index) {
+            AluResult result = alu_adc(nibbles[index] & 0x0Fu, nibbles[index] >> 4, carry);
+            carry = result.carry_flag;
+            fold ^= result.result;
+        }
+        double elapsed = bench_now_seconds() - start;
+        bench_alu_sink = fold;
+        bench_samples_add(bench, &rates, (double)elements / elapsed);
+    }
+    bench_report(bench, "adc_chain", "scalar", "ops/s", &rates, NULL);
+}
+
+static const char *const bench_batch_kernel_names[] = {"scalar", "sse2", "avx2", "avx512"};
+
+/* alu_batch_run ADD over packed operands with every supported kernel. */
+static void bench_batch(BenchContext *bench, const uint8_t *operands, size_t elements, uint8_t *buffers) {
+    AluBatchOutput out = {
+        buffers,
+        buffers + elements,
+        buffers + elements + elements / 8u + 1u,
+        NULL,
+        NULL
+    };
+    for (int kernel = ALU_BATCH_KERNEL_SCALAR; kernel <= ALU_BATCH_KERNEL_AVX512; ++kernel) {
+        if (alu_batch_run((AluBatchKernel)kernel, ALU_BATCH_ADD, operands, 1, &out) == -2) {
+            continue;
+        }
+        BenchSamples rates;
+        bench_samples_begin(&rates);
+        while (bench_samples_pending(bench, &rates)) {
+            double start = bench_now_seconds();
+            alu_batch_run((AluBatchKernel)kernel, ALU_BATCH_ADD, operands, elements, &out);
+            double elapsed = bench_now_seconds() - start;
+            bench_samples_add(bench, &rates, (double)elements / elapsed);
+        }
+        bench_report(bench, "batch_add", bench_batch_kernel_names[kernel], "elements/s", &rates, NULL);
+    }
+}
+
+/* 256-lane bit-sliced ADD, planes packed once up front. */
+static void bench_bitslice(BenchContext *bench, const uint8_t *nibbles, size_t elements) {
+    static AluSlice256 operand_a;
+    static AluSlice256 operand_b;
+    static AluSliceResult256 result;
+    uint8_t lanes[256];
+    for (size_t lane = 0; lane < 256u; ++lane) {
+        lanes[lane] = nibbles[lane] & 0x0Fu;
+    }
+    alu_slice256_pack(lanes, &operand_a);
+    for (size_t lane = 0; lane < 256u; ++lane) {
+        lanes[lane] = nibbles[lane] >> 4;
+    }
+    alu_slice256_pack(lanes, &operand_b);
+
+    size_t rounds = elements / 256u + 1u;
+    BenchSamples rates;
+    bench_samples_begin(&rates);
+    while (bench_samples_pending(bench, &rates)) {
+        double start = bench_now_seconds();
+        for (size_t round = 0; round < rounds; ++round) {
+            alu_slice256_eval(ALU_SLICE_ADD, &operand_a, &operand_b, &result);
+            operand_a.plane[0][round & 3u] ^= result.carry_flags[round & 3u];
+        }
+        double elapsed = bench_now_seconds() - start;
+        bench_samples_add(bench, &rates, (double)rounds * 256.0 / elapsed);
+    }
+    bench_report(bench, "slice256_add", "bitslice", "lanes/s", &rates, NULL);
+}
+
+static const char *const bench_bigint_kernel_names[] = {"scalar", "avx2", "avx512"};
+
+/* Long N-nibble additions with every supported kernel. */
+static void bench_bigint(BenchContext *bench, const uint8_t *nibbles, size_t elements, uint8_t *result) {
+    size_t bytes = BENCH_ALU_BIGINT_NIBBLES / 2u;
+    size_t rounds = elements / BENCH_ALU_BIGINT_NIBBLES + 1u;
+    for (int kernel = ALU_BIGINT_KERNEL_SCALAR; kernel <= ALU_BIGINT_KERNEL_AVX512; ++kernel) {
+        if (alu_bigint_run((AluBigintKernel)kernel, ALU_BIGINT_ADD, nibbles, nibbles + bytes, 2, 0, result,
+                           NULL) == -2) {
+            continue;
+        }
+        BenchSamples rates;
+        bench_samples_begin(&rates);
+        while (bench_samples_pending(bench, &rates)) {
+            AluResult flags = {0};
+            double start = bench_now_seconds();
+            for (size_t round = 0; round < rounds; ++round) {
+                alu_bigint_run((AluBigintKernel)kernel, ALU_BIGINT_ADD, nibbles, nibbles + bytes,
+                               BENCH_ALU_BIGINT_NIBBLES, (uint8_t)(round & 1u), result, &flags);
+            }
+            double elapsed = bench_now_seconds() - start;
+            bench_alu_sink = flags.result;
+            bench_samples_add(bench, &rates, (double)rounds * BENCH_ALU_BIGINT_NIBBLES / elapsed);
+        }
+        char detail[48];
+        snprintf(detail, sizeof(detail), "of %u-nibble operands", BENCH_ALU_BIGINT_NIBBLES);
+        bench_report(bench, "bigint_add", bench_bigint_kernel_names[kernel], "nibbles/s", &rates, detail);
+    }
+}
+
+int main(int argc, char **argv) {
+    BenchContext bench;
+    if (bench_init(&bench, "bench_alu", argc, argv) != 0) {
+        return 2;
+    }
+    size_t elements = (bench.size != 0) ? (size_t)bench.size : BENCH_ALU_ELEMENTS;
+    if (elements < BENCH_ALU_BIGINT_NIBBLES) {
+        elements = BENCH_ALU_BIGINT_NIBBLES;
+    }
+
+    /* random operand bytes (a in the low nibble, b in the high one) and output space */
+    uint8_t *operands = (uint8_t *)malloc(elements);
+    uint8_t *buffers = (uint8_t *)malloc(elements * 2u + 16u);
+    if (operands == NULL || buffers == NULL) {
+        free(operands);
+        free(buffers);
+        bench_fail(&bench, "out of memory");
+        return bench_finish(&bench);
+    }
+    uint32_t seed = 2024u;
+    for (size_t index = 0; index < elements; ++index) {
+        operands[index] = (uint8_t)bench_workload_random(&seed);
+    }
+
+    bench_scalar(&bench, 0, elements);
+    bench_scalar(&bench, 1, elements);
+    bench_carry_chain(&bench, operands, elements);
+    bench_batch(&bench, operands, elements, buffers);
+    bench_bitslice(&bench, operands, elements);
+    bench_bigint(&bench, operands, elements, buffers);
+
+    free(operands);
+    free(buffers);
+    return bench_finish(&bench);
+}
@@ -0,0 +1,203 @@
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "bench.h"
+#include "bench_workload.h"
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "assembler/assembler.h"
+#include "assembler/assembler_cache.h"
+#include "vm/vm.h"
+
+/* Default total source size in lines; the size argument overrides it. */
+#define BENCH_ASSEMBLER_LINES 1000000u
+/* Lines per program: enough to reach the assembler's word limit. */
+#define BENCH_ASSEMBLER_PROGRAM_LINES 150u
+
+typedef struct {
+    char *source;
+    size_t length;
+    GigaLexer lexer;
+    GigaParser parser;
+} BenchAsmProgram;
+
+static void bench_assembler_fail(BenchContext *bench, const char *stage, size_t line, const char *error) {
+    char message[96];
+    snprintf(message, sizeof(message), "%s error at line %zu: %s", stage, line, error);
+    bench_fail(bench, message);
+}
+
+/* Lex, parse and assemble every program from source. */
+static void bench_pipeline(BenchContext *bench, BenchAsmProgram *programs, size_t program_count, size_t lines) {
+    BenchSamples rates;
+    bench_samples_begin(&rates);
+    while (bench_samples_pending(bench, &rates)) {
+        double start = bench_now_seconds();
+        for (size_t index = 0; index < program_count; ++index) {
+            GigaLexer lexer;
+            GigaParser parser;
+            GigaAssemblerResult result;
+            giga_lexer_init(&lexer, programs[index].source, programs[index].length);
+            giga_parser_init(&parser, &lexer);
+            if (giga_parser_parse(&parser) != 0) {
+                bench_assembler_fail(bench, "parse", parser.error_line, parser.error_message);
+                giga_parser_free(&parser);
+                return;
+            }
+            int status = giga_assemble(parser.first_statement, &result);
+            if (status != 0) {
+                bench_assembler_fail(bench, "assembly", result.error_line, result.error_message);
+            }
+            giga_assembler_free(&result);
+            giga_parser_free(&parser);
+            if (status != 0) {
+                return;
+            }
+        }
+        double elapsed = bench_now_seconds() - start;
+        bench_samples_add(bench, &rates, (double)lines / elapsed);
+    }
+    char detail[64];
+    snprintf(detail, sizeof(detail), "over %zu programs, %zu lines", program_count, lines);
+    bench_report(bench, "lex+parse+assemble", "scalar", "lines/s", &rates, detail);
+}
+
+/* Every program served from a warm on-disk cache: hashing and reading the entry only. */
+static void bench_cached(BenchContext *bench, BenchAsmProgram *programs, size_t program_count, size_t lines) {
+    char directory[] = "/tmp/bench_assembler_XXXXXX";
+    GigaAssemblerCache *cache = (mkdtemp(directory) != NULL) ? giga_assembler_cache_open(directory) : NULL;
+    if (cache == NULL) {
+        bench_fail(bench, "cannot create a cache directory");
+        return;
+    }
+    int failed = 0;
+    BenchSamples rates;
+    bench_samples_begin(&rates);
+    for (int warm = 1; !failed && (warm || bench_samples_pending(bench, &rates)); warm = 0) {
+        double start = bench_now_seconds();
+        for (size_t index = 0; index < program_count && !failed; ++index) {
+            GigaAssemblerResult result;
+            if (giga_assembler_cache_assemble(cache, programs[index].source, programs[index].length, &result) != 0) {
+                bench_assembler_fail(bench, "assembly", result.error_line, result.error_message);
+                failed = 1;
+            }
+            giga_assembler_free(&result);
+        }
+        double elapsed = bench_now_seconds() - start;
+        if (!warm) {
+            bench_samples_add(bench, &rates, (double)lines / elapsed);
+        }
+    }
+    GigaAssemblerCacheStats stats;
+    giga_assembler_cache_stats(cache, &stats);
+    giga_assembler_cache_clear(cache);
+    giga_assembler_cache_close(cache);
+    rmdir(directory);
+    if (failed) {
+        return;
+    }
+    if (stats.write_failures != 0) {
+        bench_fail(bench, "cache entries could not be written");
+        return;
+    }
+    char detail[64];
+    snprintf(detail, sizeof(detail), "over %zu programs, %llu hits", program_count,
+             (unsigned long long)stats.hits);
+    bench_report(bench, "lex+parse+assemble", "cached", "lines/s", &rates, detail);
+}
+
+/* Both assembler passes alone, on statements parsed up front. */
+static void bench_assemble_only(BenchContext *bench, BenchAsmProgram *programs, size_t program_count,
+                                size_t lines) {
+    for (size_t index = 0; index < program_count; ++index) {
+        BenchAsmProgram *program = &programs[index];
+        giga_lexer_init(&program->lexer, program->source, program->length);
+        giga_parser_init(&program->parser, &program->lexer);
+        if (giga_parser_parse(&program->parser) != 0) {
+            bench_assembler_fail(bench, "parse", program->parser.error_line, program->parser.error_message);
+            for (size_t done = 0; done <= index; ++done) {
+                giga_parser_free(&programs[done].parser);
+            }
+            return;
+        }
+    }
+
+    size_t words = 0;
+    int failed = 0;
+    BenchSamples rates;
+    bench_samples_begin(&rates);
+    while (!failed && bench_samples_pending(bench, &rates)) {
+        words = 0;
+        double start = bench_now_seconds();
+        for (size_t index = 0; index < program_count && !failed; ++index) {
+            GigaAssemblerResult result;
+            if (giga_assemble(programs[index].parser.first_statement, &result) != 0) {
+                bench_assembler_fail(bench, "assembly", result.error_line, result.error_message);
+                failed = 1;
+            }
+            words += result.word_count;
+            giga_assembler_free(&result);
+        }
+        double elapsed = bench_now_seconds() - start;
+        bench_samples_add(bench, &rates, (double)lines / elapsed);
+    }
+    for (size_t index = 0; index < program_count; ++index) {
+        giga_parser_free(&programs[index].parser);
+    }
+    if (failed) {
+        return;
+    }
+    char detail[64];
+    snprintf(detail, sizeof(detail), "over %zu programs, %zu words", program_count, words);
+    bench_report(bench, "assemble", "scalar", "lines/s", &rates, detail);
+}
+
+int main(int argc, char **argv) {
+    BenchContext bench;
+    if (bench_init(&bench, "bench_assembler", argc, argv) != 0) {
+        return 2;
+    }
+    size_t lines = (bench.size != 0) ? (size_t)bench.size : BENCH_ASSEMBLER_LINES;
+
+    /* The assembler caps programs at 128 words, so split the lines into many programs. */
+    size_t program_count = (lines + BENCH_ASSEMBLER_PROGRAM_LINES - 1u) / BENCH_ASSEMBLER_PROGRAM_LINES;
+    BenchAsmProgram *programs = (BenchAsmProgram *)calloc(program_count, sizeof(*programs));
+    if (programs == NULL) {
+        bench_fail(&bench, "out of memory");
+        return bench_finish(&bench);
+    }
+    size_t total_lines = 0;
+    for (size_t index = 0; index < program_count; ++index) {
+        size_t program_lines = lines - index * BENCH_ASSEMBLER_PROGRAM_LINES;
+        if (program_lines > BENCH_ASSEMBLER_PROGRAM_LINES) {
+            program_lines = BENCH_ASSEMBLER_PROGRAM_LINES;
+        }
+        /* at most 127 words, so every program also loads into VM memory */
+        programs[index].source = bench_workload_asm(program_lines, GIGA_VM_MAX_PROGRAM_WORDS - 1u,
+                                                    (uint32_t)index + 1u, &programs[index].length);
+        if (programs[index].source == NULL) {
+            bench_fail(&bench, "out of memory");
+            program_count = index;
+            break;
+        }
+        /* generation stops at the word cap, so count what was produced */
+        for (size_t offset = 0; offset < programs[index].length; ++offset) {
+            total_lines += (programs[index].source[offset] == '\n');
+        }
+    }
+
+    if (bench.failures == 0) {
+        bench_pipeline(&bench, programs, program_count, total_lines);
+        bench_cached(&bench, programs, program_count, total_lines);
+        bench_assemble_only(&bench, programs, program_count, total_lines);
+    }
+
+    for (size_t index = 0; index < program_count; ++index) {
+        free(programs[index].source);
+    }
+    free(programs);
+    return bench_finish(&bench);
+}
@@ -0,0 +1,213 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef BENCH_VERSION
+#define BENCH_VERSION "unknown"
+#endif
+
+#define BENCH_DEFAULT_WARMUP 1u
+#define BENCH_DEFAULT_REPETITIONS 7u
+
+static void bench_print_usage(const char *suite) {
+    fprintf(stderr,
+            "usage: %s [--json PATH] [--warmup N] [--repetitions N] [size]\n"
+            "  --json PATH        also write results as JSON (- for stdout)\n"
+            "  --warmup N         unmeasured runs before each benchmark (default %u)\n"
+            "  --repetitions N    measured runs per benchmark (default %u, max %u)\n"
+            "  size               workload size; see the benchmark's source for the unit\n",
+            suite, BENCH_DEFAULT_WARMUP, BENCH_DEFAULT_REPETITIONS, BENCH_MAX_SAMPLES);
+}
+
+int bench_init(BenchContext *bench, const char *suite, int argc, char **argv) {
+    memset(bench, 0, sizeof(*bench));
+    bench->suite = suite;
+    bench->warmup = BENCH_DEFAULT_WARMUP;
+    bench->repetitions = BENCH_DEFAULT_REPETITIONS;
+
+    for (int index = 1; index < argc; ++index) {
+        const char *argument = argv[index];
+        if (strcmp(argument, "--json") == 0 && index + 1 < argc) {
+            bench->json_path = argv[++index];
+        } else if (strcmp(argument, "--warmup") == 0 && index + 1 < argc) {
+            bench->warmup = (size_t)strtoull(argv[++index], NULL, 10);
+        } else if (strcmp(argument, "--repetitions") == 0 && index + 1 < argc) {
+            bench->repetitions = (size_t)strtoull(argv[++index], NULL, 10);
+        } else if (argument[0] != '-' && bench->size == 0) {
+            bench->size = strtoull(argument, NULL, 10);
+        } else {
+            bench_print_usage(suite);
+            return -1;
+        }
+    }
+    if (bench->repetitions == 0 || bench->repetitions > BENCH_MAX_SAMPLES) {
+        bench_print_usage(suite);
+        return -1;
+    }
+    return 0;
+}
+
+double bench_now_seconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+}
+
+void bench_samples_begin(BenchSamples *samples) {
+    samples->runs = 0;
+    samples->count = 0;
+}
+
+int bench_samples_pending(const BenchContext *bench, const BenchSamples *samples) {
+    return samples->runs < bench->warmup + bench->repetitions;
+}
+
+void bench_samples_add(const BenchContext *bench, BenchSamples *samples, double value) {
+    if (samples->runs++ >= bench->warmup && samples->count < BENCH_MAX_SAMPLES) {
+        samples->values[samples->count++] = value;
+    }
+}
+
+/* Human-readable lines move to stderr when the JSON goes to stdout. */
+static FILE *bench_text_output(const BenchContext *bench) {
+    return (bench->json_path != NULL && strcmp(bench->json_path, "-") == 0) ? stderr : stdout;
+}
+
+static int bench_compare_doubles(const void *left, const void *right) {
+    double a = *(const double *)left;
+    double b = *(const double *)right;
+    return (a > b) - (a < b);
+}
+
+/* Linear interpolation between the closest ranks of sorted values. */
+static double bench_percentile(const double *sorted, size_t count, double fraction) {
+    double position = fraction * (double)(count - 1u);
+    size_t lower = (size_t)position;
+    if (lower + 1u >= count) {
+        return sorted[count - 1u];
+    }
+    double weight = position - (double)lower;
+    return sorted[lower] + (sorted[lower + 1u] - sorted[lower]) * weight;
+}
+
+static void bench_copy_text(char *destination, size_t capacity, const char *text) {
+    snprintf(destination, capacity, "%s", (text != NULL) ? text : "");
+}
+
+void bench_report(BenchContext *bench, const char *name, const char *variant, const char *unit,
+                  const BenchSamples *samples, const char *detail) {
+    if (samples->count == 0) {
+        bench_fail(bench, "no samples recorded");
+        return;
+    }
+    if (bench->result_count == bench->result_capacity) {
+        size_t capacity = (bench->result_capacity == 0) ? 16u : bench->result_capacity * 2u;
+        BenchResult *results = (BenchResult *)realloc(bench->results, capacity * sizeof(*results));
+        if (results == NULL) {
+            bench_fail(bench, "out of memory");
+            return;
+        }
+        bench->results = results;
+        bench->result_capacity = capacity;
+    }
+
+    double sorted[BENCH_MAX_SAMPLES];
+    size_t count = samples->count;
+    memcpy(sorted, samples->values, count * sizeof(sorted[0]));
+    qsort(sorted, count, sizeof(sorted[0]), bench_compare_doubles);
+    double sum = 0.0;
+    for (size_t index = 0; index < count; ++index) {
+        sum += sorted[index];
+    }
+
+    BenchResult *result = &bench->results[bench->result_count++];
+    bench_copy_text(result->name, sizeof(result->name), name);
+    bench_copy_text(result->variant, sizeof(result->variant), variant);
+    bench_copy_text(result->unit, sizeof(result->unit), unit);
+    bench_copy_text(result->detail, sizeof(result->detail), detail);
+    result->sample_count = count;
+    result->min = sorted[0];
+    result->p10 = bench_percentile(sorted, count, 0.10);
+    result->median = bench_percentile(sorted, count, 0.50);
+    result->p90 = bench_percentile(sorted, count, 0.90);
+    result->max = sorted[count - 1u];
+    result->mean = sum / (double)count;
+
+    fprintf(bench_text_output(bench),
+            "%s: %-18s %-12s median %.1f M %s (p10 %.1f, p90 %.1f, min %.1f, max %.1f)%s%s\n",
+            bench->suite, result->name, result->variant, result->median / 1e6, result->unit,
+            result->p10 / 1e6, result->p90 / 1e6, result->min / 1e6, result->max / 1e6,
+            (result->detail[0] != '\0') ? " " : "", result->detail);
+}
+
+void bench_fail(BenchContext *bench, const char *message) {
+    fprintf(bench_text_output(bench), "%s: %s\n", bench->suite, message);
+    ++bench->failures;
+}
+
+/* Names and units are plain ASCII, but keep the output valid JSON anyway. */
+static void bench_write_json_string(FILE *output, const char *text) {
+    fputc('"', output);
+    for (const unsigned char *cursor = (const unsigned char *)text; *cursor != '\0'; ++cursor) {
+        if (*cursor == '"' || *cursor == '\\') {
+            fprintf(output, "\\%c", *cursor);
+        } else if (*cursor < 0x20) {
+            fprintf(output, "\\u%04x", *cursor);
+        } else {
+            fputc(*cursor, output);
+        }
+    }
+    fputc('"', output);
+}
+
+static int bench_write_json(const BenchContext *bench, FILE *output) {
+    fprintf(output, "{\n  \"suite\": ");
+    bench_write_json_string(output, bench->suite);
+    fprintf(output, ",\n  \"version\": ");
+    bench_write_json_string(output, BENCH_VERSION);
+    fprintf(output, ",\n  \"timestamp\": %lld,\n  \"warmup\": %zu,\n  \"repetitions\": %zu,\n  \"results\": [",
+            (long long)time(NULL), bench->warmup, bench->repetitions);
+    for (size_t index = 0; index < bench->result_count; ++index) {
+        const BenchResult *result = &bench->results[index];
+        fprintf(output, "%s\n    {\"name\": ", (index == 0) ? "" : ",");
+        bench_write_json_string(output, result->name);
+        fprintf(output, ", \"variant\": ");
+        bench_write_json_string(output, result->variant);
+        fprintf(output, ", \"unit\": ");
+        bench_write_json_string(output, result->unit);
+        fprintf(output, ", \"detail\": ");
+        bench_write_json_string(output, result->detail);
+        fprintf(output,
+                ", \"samples\": %zu, \"min\": %.6g, \"p10\": %.6g, \"median\": %.6g, \"p90\": %.6g, "
+                "\"max\": %.6g, \"mean\": %.6g}",
+                result->sample_count, result->min, result->p10, result->median, result->p90, result->max,
+                result->mean);
+    }
+    fprintf(output, "\n  ],\n  \"failures\": %d\n}\n", bench->failures);
+    return ferror(output) ? -1 : 0;
+}
+
+int bench_finish(BenchContext *bench) {
+    int status = (bench->failures == 0) ? 0 : 1;
+    if (bench->json_path != NULL) {
+        int to_stdout = strcmp(bench->json_path, "-") == 0;
+        FILE *output = to_stdout ? stdout : fopen(bench->json_path, "w");
+        if (output == NULL || bench_write_json(bench, output) != 0) {
+            fprintf(stderr, "%s: cannot write %s\n", bench->suite, bench->json_path);
+            status = 1;
+        }
+        if (output != NULL && !to_stdout && fclose(output) != 0) {
+            status = 1;
+        }
+    }
+    free(bench->results);
+    bench->results = NULL;
+    bench->result_count = 0;
+    bench->result_capacity = 0;
+    return status;
+}
@@ -0,0 +1,108 @@
+#ifndef GIGA_BENCH_H
+#define GIGA_BENCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Most measured runs one benchmark can keep.
+ */
+#define BENCH_MAX_SAMPLES 1000
+
+/**
+ * @brief Statistics of one benchmark, in its unit per second.
+ *
+ * Percentiles interpolate linearly between the sorted samples.
+ */
+typedef struct {
+    char name[64];
+    char variant[32];
+    char unit[32];
+    char detail[96];
+    size_t sample_count;
+    double min;
+    double p10;
+    double median;
+    double p90;
+    double max;
+    double mean;
+} BenchResult;
+
+/**
+ * @brief Settings and collected results of one bench_* executable.
+ */
+typedef struct {
+    const char *suite;       /** executable name, prefixes every line */
+    size_t warmup;           /** unmeasured runs before the samples */
+    size_t repetitions;      /** measured runs per benchmark */
+    uint64_t size;           /** workload size from the command line, 0 = default */
+    const char *json_path;   /** where to write JSON, "-" for stdout, NULL for none */
+    BenchResult *results;
+    size_t result_count;
+    size_t result_capacity;
+    int failures;            /** benchmarks that reported an error */
+} BenchContext;
+
+/**
+ * @brief Measured values of one benchmark (warmup runs are dropped).
+ */
+typedef struct {
+    size_t runs;             /** runs so far, warmup included */
+    size_t count;            /** samples kept */
+    double values[BENCH_MAX_SAMPLES];
+} BenchSamples;
+
+/**
+ * @brief Parse the common options.
+ *
+ * Accepts --json PATH, --warmup N, --repetitions N and one optional
+ * positional workload size (stored in bench->size).
+ *
+ * @return 0 on success; prints usage and returns -1 on bad arguments.
+ */
+int bench_init(BenchContext *bench, const char *suite, int argc, char **argv);
+
+/**
+ * @brief Monotonic clock in seconds.
+ */
+double bench_now_seconds(void);
+
+/**
+ * @brief Start collecting samples for one benchmark.
+ */
+void bench_samples_begin(BenchSamples *samples);
+
+/**
+ * @brief Whether another run (warmup or measured) is due.
+ */
+int bench_samples_pending(const BenchContext *bench, const BenchSamples *samples);
+
+/**
+ * @brief Record one run; kept only once the warmup runs are done.
+ */
+void bench_samples_add(const BenchContext *bench, BenchSamples *samples, double value);
+
+/**
+ * @brief Print one line of statistics and keep them for the JSON report.
+ *
+ * Values are printed in millions of @p unit per second.
+ *
+ * @param detail Extra text for the line and the report, or NULL.
+ */
+void bench_report(BenchContext *bench, const char *name, const char *variant, const char *unit,
+                  const BenchSamples *samples, const char *detail);
+
+/**
+ * @brief Count a failed benchmark and print why.
+ */
+void bench_fail(BenchContext *bench, const char *message);
+
+/**
+ * @brief Write the JSON report if requested and release the results.
+ *
+ * @return Process exit code: 0, or 1 if a benchmark failed or the report
+ *         could not be written.
+ */
+int bench_finish(BenchContext *bench);
+
+#endif /* GIGA_BENCH_H */
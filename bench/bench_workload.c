@@ -0,0 +1,118 @@
+#include "bench_workload.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "isa/isa.h"
+
+/* Longest generated line, label and comment included. */
+#define BENCH_WORKLOAD_MAX_LINE 64u
+
+uint32_t bench_workload_random(uint32_t *seed) {
+    *seed = *seed * 1103515245u + 12345u;
+    return (*seed >> 16) & 0x7FFFu;
+}
+
+static const char *const bench_workload_binary[] = {"MOV", "ADD", "SUB", "AND", "OR", "XOR", "ADC", "SBC"};
+static const char *const bench_workload_unary[] = {"NOT", "SHL", "SHR"};
+
+/* Register-to-register opcodes of the loop body. */
+static const uint16_t bench_workload_loop_ops[] = {
+    GIGA_OP_MOV, GIGA_OP_ADD, GIGA_OP_SUB, GIGA_OP_AND, GIGA_OP_OR, GIGA_OP_XOR, GIGA_OP_NOT, GIGA_OP_SHR
+};
+
+/* One instruction line; JMPs pick one of the labels defined so far. */
+static int bench_workload_instruction(char *line, uint32_t *seed, size_t labels_defined) {
+    unsigned dest = bench_workload_random(seed) % 8u;
+    unsigned src = bench_workload_random(seed) % 8u;
+    unsigned value = bench_workload_random(seed) % 16u;
+    unsigned kind = bench_workload_random(seed) % 16u;
+
+    if (kind < 7) {
+        return sprintf(line, "    %-4s R%u, R%u", bench_workload_binary[bench_workload_random(seed) % 8u], dest, src);
+    }
+    if (kind < 9) {
+        return sprintf(line, (value & 1u) ? "    MOVI R%u, 0x%X" : "    MOVI R%u, %u", dest, value);
+    }
+    if (kind < 11) {
+        return sprintf(line, "    %s R%u", bench_workload_unary[bench_workload_random(seed) % 3u], dest);
+    }
+    if (kind < 12) {
+        return sprintf(line, "    LD   R%u, [%u]", dest, value);
+    }
+    if (kind < 13) {
+        return sprintf(line, "    ST   [%u], R%u", value, src);
+    }
+    if (kind < 14 && labels_defined > 0) {
+        return sprintf(line, "    JMP  L%zu", (size_t)bench_workload_random(seed) % labels_defined);
+    }
+    if (kind < 15) {
+        return sprintf(line, "    NOP");
+    }
+    return sprintf(line, "    HALT");
+}
+
+char *bench_workload_asm(size_t line_count, size_t max_instructions, uint32_t seed, size_t *out_length) {
+    size_t capacity = line_count * BENCH_WORKLOAD_MAX_LINE + 1u;
+    char *source = (char *)malloc(capacity);
+    if (source == NULL) {
+        return NULL;
+    }
+
+    size_t length = 0;
+    size_t instructions = 0;
+    size_t labels = 0;
+    for (size_t line = 0; line < line_count && instructions < max_instructions; ++line) {
+        char *cursor = source + length;
+        int written;
+        if (line % 16u == 15u) {
+            written = sprintf(cursor, "; block %zu", line / 16u);
+        } else if (line % 29u == 28u) {
+            written = 0; /* blank line */
+        } else {
+            written = 0;
+            if (instructions % 8u == 0) {
+                written = sprintf(cursor, "L%zu:", labels++);
+            }
+            written += bench_workload_instruction(cursor + written, &seed, labels);
+            if (bench_workload_random(&seed) % 8u == 0) {
+                written += sprintf(cursor + written, " ; note");
+            }
+            ++instructions;
+        }
+        length += (size_t)written;
+        source[length++] = '\n';
+    }
+    source[length] = '\0';
+    *out_length = length;
+    return source;
+}
+
+size_t bench_workload_loop(uint16_t *words, size_t max_words, uint32_t seed) {
+    size_t word_count = 8u + bench_workload_random(&seed) % (max_words - 7u);
+    size_t body = 4;
+    for (size_t index = 0; index < body; ++index) {
+        words[index] = (uint16_t)((GIGA_OP_MOVI << 12) | (index << 8) | (bench_workload_random(&seed) % 16u));
+    }
+    for (size_t index = body; index + 1u < word_count; ++index) {
+        unsigned dest = bench_workload_random(&seed) % 8u;
+        unsigned src = bench_workload_random(&seed) % 8u;
+        unsigned choice = bench_workload_random(&seed) % 12u;
+        uint16_t word;
+        if (choice < 8) {
+            word = (uint16_t)((bench_workload_loop_ops[choice] << 12) | (dest << 8) | (src << 4));
+        } else if (choice < 9) {
+            word = (uint16_t)((GIGA_OP_SHL << 12) | (dest << 8));
+        } else if (choice < 10) {
+            unsigned extended = bench_workload_random(&seed) % 2u; /* ADC or SBC */
+            word = (uint16_t)((GIGA_OP_EXT << 12) | (extended << 8) | (dest << 4) | src);
+        } else if (choice < 11) {
+            word = (uint16_t)((GIGA_OP_LD << 12) | (dest << 8) | 0x00F0u | src);
+        } else {
+            word = (uint16_t)((GIGA_OP_ST << 12) | 0x0F00u | (src << 4) | dest); /* ST [0xF0 + src], Rdest */
+        }
+        words[index] = word;
+    }
+    words[word_count - 1u] = (uint16_t)((GIGA_OP_JMP << 12) | body);
+    return word_count;
+}
@@ -0,0 +1,41 @@
+#ifndef GIGA_BENCH_WORKLOAD_H
+#define GIGA_BENCH_WORKLOAD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Generate assembly source with every mnemonic and operand form.
+ *
+ * Lines are instructions, with a label every 8 instructions, a comment
+ * line every 16 lines and some blank lines and trailing comments. JMPs
+ * only target labels defined earlier, so the text assembles whenever it
+ * stays within the assembler's word limit.
+ *
+ * @param line_count       Lines to generate.
+ * @param max_instructions Stop after this many instructions.
+ * @param seed             Generator seed; equal seeds give equal text.
+ * @param out_length       Receives the length in bytes (without the NUL).
+ * @return NUL-terminated source to free(), or NULL on allocation failure.
+ */
+char *bench_workload_asm(size_t line_count, size_t max_instructions, uint32_t seed, size_t *out_length);
+
+/**
+ * @brief Generate a loop program that never halts.
+ *
+ * A few MOVI set-up words, then a body of random ALU, MOV, LD and ST
+ * words (stores stay above the program) closed by a JMP back to the body.
+ *
+ * @param words      Output buffer.
+ * @param max_words  Capacity of words, 8 to 120 (stores use 0xF0-0xF7).
+ * @param seed       Generator seed.
+ * @return Number of words written.
+ */
+size_t bench_workload_loop(uint16_t *words, size_t max_words, uint32_t seed);
+
+/**
+ * @brief Next value of the generators' linear congruential sequence.
+ */
+uint32_t bench_workload_random(uint32_t *seed);
+
+#endif /* GIGA_BENCH_WORKLOAD_H */
@@ -0,0 +1,64 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "bench_workload.h"
+#include "lexer/lexer.h"
+
+/* Default source size in lines; the size argument overrides it. */
+#define BENCH_LEXER_LINES 1000000u
+
+/* Block width the lexer was built with (see src/lexer/lexer.c). */
+#if defined(__AVX2__)
+#define BENCH_LEXER_VARIANT "avx2"
+#elif defined(__SSE2__)
+#define BENCH_LEXER_VARIANT "sse2"
+#else
+#define BENCH_LEXER_VARIANT "scalar"
+#endif
+
+/* Tokenize the whole source once; returns the token count. */
+static size_t bench_lex(const char *source, size_t length) {
+    GigaLexer lexer;
+    giga_lexer_init(&lexer, source, length);
+    size_t tokens = 0;
+    while (giga_lexer_next_token(&lexer).kind != GIGA_TOKEN_EOF) {
+        ++tokens;
+    }
+    return tokens;
+}
+
+int main(int argc, char **argv) {
+    BenchContext bench;
+    if (bench_init(&bench, "bench_lexer", argc, argv) != 0) {
+        return 2;
+    }
+    size_t lines = (bench.size != 0) ? (size_t)bench.size : BENCH_LEXER_LINES;
+
+    size_t length = 0;
+    char *source = bench_workload_asm(lines, lines, 1u, &length);
+    if (source == NULL) {
+        bench_fail(&bench, "out of memory");
+        return bench_finish(&bench);
+    }
+
+    size_t tokens = 0;
+    BenchSamples line_rates;
+    BenchSamples byte_rates;
+    bench_samples_begin(&line_rates);
+    bench_samples_begin(&byte_rates);
+    while (bench_samples_pending(&bench, &line_rates)) {
+        double start = bench_now_seconds();
+        tokens = bench_lex(source, length);
+        double elapsed = bench_now_seconds() - start;
+        bench_samples_add(&bench, &line_rates, (double)lines / elapsed);
+        bench_samples_add(&bench, &byte_rates, (double)length / elapsed);
+    }
+    free(source);
+
+    char detail[96];
+    snprintf(detail, sizeof(detail), "over %zu lines, %zu bytes, %zu tokens", lines, length, tokens);
+    bench_report(&bench, "tokenize", BENCH_LEXER_VARIANT, "lines/s", &line_rates, detail);
+    bench_report(&bench, "tokenize", BENCH_LEXER_VARIANT, "bytes/s", &byte_rates, detail);
+    return bench_finish(&bench);
+}
@@ -0,0 +1,60 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "bench_workload.h"
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+
+/* Default source size in lines; the size argument overrides it. */
+#define BENCH_PARSER_LINES 1000000u
+
+int main(int argc, char **argv) {
+    BenchContext bench;
+    if (bench_init(&bench, "bench_parser", argc, argv) != 0) {
+        return 2;
+    }
+    size_t lines = (bench.size != 0) ? (size_t)bench.size : BENCH_PARSER_LINES;
+
+    size_t length = 0;
+    char *source = bench_workload_asm(lines, lines, 1u, &length);
+    if (source == NULL) {
+        bench_fail(&bench, "out of memory");
+        return bench_finish(&bench);
+    }
+
+    /* lexing is included: the parser pulls tokens on demand */
+    BenchSamples parse_rates;
+    BenchSamples free_rates;
+    bench_samples_begin(&parse_rates);
+    bench_samples_begin(&free_rates);
+    while (bench_samples_pending(&bench, &parse_rates)) {
+        GigaLexer lexer;
+        GigaParser parser;
+        giga_lexer_init(&lexer, source, length);
+        giga_parser_init(&parser, &lexer);
+
+        double start = bench_now_seconds();
+        int status = giga_parser_parse(&parser);
+        double parsed = bench_now_seconds();
+        giga_parser_free(&parser);
+        double freed = bench_now_seconds();
+        if (status != 0) {
+            char message[96];
+            snprintf(message, sizeof(message), "parse error at line %zu: %s", parser.error_line,
+                     parser.error_message);
+            bench_fail(&bench, message);
+            free(source);
+            return bench_finish(&bench);
+        }
+        bench_samples_add(&bench, &parse_rates, (double)lines / (parsed - start));
+        bench_samples_add(&bench, &free_rates, (double)lines / (freed - parsed));
+    }
+    free(source);
+
+    char detail[64];
+    snprintf(detail, sizeof(detail), "over %zu lines, %zu bytes", lines, length);
+    bench_report(&bench, "lex+parse", "scalar", "lines/s", &parse_rates, detail);
+    bench_report(&bench, "free", "scalar", "lines/s", &free_rates, detail);
+    return bench_finish(&bench);
+}
@@ -0,0 +1,449 @@
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench.h"
+#include "bench_workload.h"
+#include "vm/vm.h"
+#include "vm/vm_jit.h"
+#include "vm/vm_batch.h"
+#include "vm/vm_trace.h"
+#include "vm/vm_ports.h"
+
+/* Default instructions per measured run; the size argument overrides it. */
+#define BENCH_STEPS_PER_RUN 200000000ull
+#define BENCH_BATCH_LANES 4096u
+#define BENCH_INSTANCES 65536u
+#define BENCH_INSTANCE_SLICE 40u
+#define BENCH_TRACE_PATH "bench_vm_trace.gtr"
+#define BENCH_TRACE_CAPACITY (64u * 1024u * 1024u)
+#define BENCH_RANDOM_LOOP_WORDS 96u
+#define BENCH_PORT_CAPACITY 4096u
+
+/* Execution modes compared by the benchmark. */
+typedef enum {
+    BENCH_MODE_UNFUSED,
+    BENCH_MODE_FUSED,
+    BENCH_MODE_JIT,
+    BENCH_MODE_HARVARD    /* fused, from a separate instruction store */
+} BenchMode;
+
+static const char *const bench_mode_names[] = {"unfused", "fused", "jit", "harvard"};
+
+static void bench_unexpected_status(BenchContext *bench, const char *what, GigaVmStatus status) {
+    char message[64];
+    snprintf(message, sizeof(message), "unexpected %sstatus %d", what, (int)status);
+    bench_fail(bench, message);
+}
+
+static void bench_program(BenchContext *bench,
+                          const char *name,
+                          const uint16_t *program,
+                          size_t word_count,
+                          BenchMode mode,
+                          GigaVmJit *jit) {
+    uint64_t steps_per_run = bench->size;
+    BenchSamples rates;
+    bench_samples_begin(&rates);
+    while (bench_samples_pending(bench, &rates)) {
+        static GigaVmState state;
+        static GigaVmCode code;
+        giga_vm_init(&state);
+        if (mode == BENCH_MODE_HARVARD) {
+            giga_vm_code_init(&code, program, word_count);
+            giga_vm_code_fuse(&code);
+        } else {
+            giga_vm_load_program(&state, program, word_count);
+        }
+        if (mode == BENCH_MODE_FUSED) {
+            giga_vm_fuse_superinstructions(&state);
+        }
+
+        double start = bench_now_seconds();
+        GigaVmStatus status;
+        if (mode == BENCH_MODE_JIT) {
+            status = giga_vm_jit_run(jit, &state, steps_per_run);
+        } else if (mode == BENCH_MODE_HARVARD) {
+            status = giga_vm_run_code(&state, &code, steps_per_run);
+        } else {
+            status = giga_vm_run(&state, steps_per_run);
+        }
+        double elapsed = bench_now_seconds() - start;
+        if (status != GIGA_VM_STATUS_STEP_LIMIT) {
+            bench_unexpected_status(bench, "", status);
+            return;
+        }
+        bench_samples_add(bench, &rates, (double)steps_per_run / elapsed);
+    }
+    bench_report(bench, name, bench_mode_names[mode], "instr/s", &rates, NULL);
+}
+
+static const char *const bench_kernel_names[] = {"batch-scalar", "batch-sse2", "batch-avx2"};
+
+/* Lock-step batch: reports lane-instructions per second (steps x lanes). */
+static void bench_batch(BenchContext *bench,
+                        const char *name,
+                        const uint16_t *program,
+                        size_t word_count,
+                        GigaVmBatchKernel kernel) {
+    GigaVmBatch batch;
+    if (giga_vm_batch_init(&batch, BENCH_BATCH_LANES, program, word_count) != 0) {
+        bench_fail(bench, "batch init failed");
+        return;
+    }
+    if (giga_vm_batch_set_kernel(&batch, kernel) != 0) {
+        giga_vm_batch_free(&batch);
+        return;
+    }
+
+    uint64_t batch_steps = bench->size / BENCH_BATCH_LANES;
+    if (batch_steps == 0) {
+        batch_steps = 1;
+    }
+    BenchSamples rates;
+    bench_samples_begin(&rates);
+    while (bench_samples_pending(bench, &rates)) {
+        double start = bench_now_seconds();
+        giga_vm_batch_run(&batch, batch_steps);
+        double elapsed = bench_now_seconds() - start;
+        if (batch.status[0] != GIGA_VM_STATUS_STEP_LIMIT) {
+            bench_unexpected_status(bench, "batch ", batch.status[0]);
+            giga_vm_batch_free(&batch);
+            return;
+        }
+        bench_samples_add(bench, &rates, (double)batch_steps * BENCH_BATCH_LANES / elapsed);
+    }
+    giga_vm_batch_free(&batch);
+    bench_report(bench, name, bench_kernel_names[kernel], "lane-instr/s", &rates, NULL);
+}
+
+/*
+ * Many resident instances, each run for a short slice in turn: reports
+ * instructions per second for full GigaVmState vs packed instances.
+ */
+static void bench_instances(BenchContext *bench, const char *name, const uint16_t *program, size_t word_count,
+                            int packed) {
+    static GigaVmProgram shared;
+    GigaVmState *full_states = NULL;
+    GigaVmPackedState *packed_states = NULL;
+    size_t instance_bytes = packed ? sizeof(GigaVmPackedState) : sizeof(GigaVmState);
+
+    if (packed) {
+        giga_vm_program_init(&shared, program, word_count);
+        packed_states = malloc(BENCH_INSTANCES * sizeof(*packed_states));
+        if (packed_states == NULL) {
+            bench_fail(bench, "out of memory");
+            return;
+        }
+        for (size_t index = 0; index < BENCH_INSTANCES; ++index) {
+            giga_vm_packed_init(&packed_states[index], &shared);
+        }
+    } else {
+        full_states = malloc(BENCH_INSTANCES * sizeof(*full_states));
+        if (full_states == NULL) {
+            bench_fail(bench, "out of memory");
+            return;
+        }
+        giga_vm_init(&full_states[0]);
+        giga_vm_load_program(&full_states[0], program, word_count);
+        for (size_t index = 1; index < BENCH_INSTANCES; ++index) {
+            full_states[index] = full_states[0];
+        }
+    }
+
+    uint64_t rounds = bench->size / 4u / ((uint64_t)BENCH_INSTANCES * BENCH_INSTANCE_SLICE);
+    if (rounds == 0) {
+        rounds = 1;
+    }
+    BenchSamples rates;
+    bench_samples_begin(&rates);
+    while (bench_samples_pending(bench, &rates)) {
+        double start = bench_now_seconds();
+        for (uint64_t round = 0; round < rounds; ++round) {
+            for (size_t index = 0; index < BENCH_INSTANCES; ++index) {
+                if (packed) {
+                    giga_vm_packed_run(&packed_states[index], &shared, BENCH_INSTANCE_SLICE);
+                } else {
+                    giga_vm_run(&full_states[index], BENCH_INSTANCE_SLICE);
+                }
+            }
+        }
+        double elapsed = bench_now_seconds() - start;
+        bench_samples_add(bench, &rates, (double)rounds * BENCH_INSTANCES * BENCH_INSTANCE_SLICE / elapsed);
+    }
+    free(full_states);
+    free(packed_states);
+
+    char detail[64];
+    snprintf(detail, sizeof(detail), "over %u instances of %zu bytes", BENCH_INSTANCES, instance_bytes);
+    bench_report(bench, name, packed ? "packed" : "full", "instr/s", &rates, detail);
+}
+
+static const char *const bench_fork_names[] = {"copy", "fork", "restore"};
+
+/*
+ * Fork-heavy workload: start a short job from the same captured state again
+ * and again, by struct copy, by giga_vm_fork, or by restoring one state.
+ */
+static void bench_forks(BenchContext *bench, const char *name, const uint16_t *program, size_t word_count,
+                        int method) {
+    static GigaVmState parent;
+    static GigaVmState scratch;
+    giga_vm_init(&parent);
+    giga_vm_load_program(&parent, program, word_count);
+    giga_vm_run(&parent, 1000);
+    GigaVmSnapshot *snapshot = giga_vm_snapshot_take(&parent);
+    if (snapshot == NULL) {
+        bench_fail(bench, "snapshot failed");
+        return;
+    }
+    scratch = parent;
+
+    uint64_t jobs = bench->size / 4u / BENCH_INSTANCE_SLICE;
+    if (jobs == 0) {
+        jobs = 1;
+    }
+    BenchSamples rates;
+    bench_samples_begin(&rates);
+    while (bench_samples_pending(bench, &rates)) {
+        double start = bench_now_seconds();
+        for (uint64_t job = 0; job < jobs; ++job) {
+            if (method == 0) {
+                scratch = parent;
+                giga_vm_run(&scratch, BENCH_INSTANCE_SLICE);
+            } else if (method == 1) {
+                GigaVmFork child;
+                giga_vm_fork(&child, snapshot);
+                giga_vm_fork_run(&child, BENCH_INSTANCE_SLICE);
+                giga_vm_fork_release(&child);
+            } else {
+                giga_vm_snapshot_restore(&scratch, snapshot);
+                giga_vm_run(&scratch, BENCH_INSTANCE_SLICE);
+            }
+        }
+        double elapsed = bench_now_seconds() - start;
+        bench_samples_add(bench, &rates, (double)jobs / elapsed);
+    }
+    giga_vm_snapshot_release(snapshot);
+
+    char detail[48];
+    snprintf(detail, sizeof(detail), "of %u instructions", BENCH_INSTANCE_SLICE);
+    bench_report(bench, name, bench_fork_names[method], "jobs/s", &rates, detail);
+}
+
+/* Unfused interpreter with and without recording a trace into a mapped ring. */
+static void bench_trace(BenchContext *bench, const char *name, const uint16_t *program, size_t word_count,
+                        int traced) {
+    GigaVmTraceWriter *writer = NULL;
+    if (traced) {
+        writer = giga_vm_trace_create(BENCH_TRACE_PATH, BENCH_TRACE_CAPACITY);
+        if (writer == NULL) {
+            bench_fail(bench, "cannot create " BENCH_TRACE_PATH);
+            return;
+        }
+    }
+
+    uint64_t steps_per_run = bench->size;
+    BenchSamples rates;
+    bench_samples_begin(&rates);
+    while (bench_samples_pending(bench, &rates)) {
+        static GigaVmState state;
+        giga_vm_init(&state);
+        giga_vm_load_program(&state, program, word_count);
+
+        double start = bench_now_seconds();
+        GigaVmStatus status = traced ? giga_vm_trace_run(writer, &state, steps_per_run)
+                                     : giga_vm_run(&state, steps_per_run);
+        double elapsed = bench_now_seconds() - start;
+        if (status != GIGA_VM_STATUS_STEP_LIMIT) {
+            bench_unexpected_status(bench, "", status);
+            giga_vm_trace_close(writer);
+            return;
+        }
+        bench_samples_add(bench, &rates, (double)steps_per_run / elapsed);
+    }
+    if (writer != NULL) {
+        giga_vm_trace_close(writer);
+        remove(BENCH_TRACE_PATH);
+    }
+    bench_report(bench, name, traced ? "traced" : "plain", "instr/s", &rates, NULL);
+}
+
+/* Host side of bench_ports: fills port 0 and drains port 1 until every nibble is back or done is set. */
+typedef struct {
+    GigaVmPorts *ports;
+    uint64_t nibbles;
+    atomic_int done;
+} BenchPortStream;
+
+static void *bench_port_host(void *argument) {
+    BenchPortStream *stream = argument;
+    GigaVmRing *input = &stream->ports->input[0];
+    GigaVmRing *output = &stream->ports->output[1];
+    uint64_t sent = 0;
+    uint64_t received = 0;
+    while (received < stream->nibbles && !atomic_load(&stream->done)) {
+        uint8_t *write_at;
+        size_t span = giga_vm_ring_write_span(input, &write_at);
+        if (span > stream->nibbles - sent) {
+            span = (size_t)(stream->nibbles - sent);
+        }
+        for (size_t index = 0; index < span; ++index) {
+            write_at[index] = (uint8_t)((sent + index) & 0x0Fu);
+        }
+        giga_vm_ring_write_commit(input, span);
+        sent += span;
+
+        const uint8_t *read_at;
+        size_t read_span = giga_vm_ring_read_span(output, &read_at);
+        giga_vm_ring_read_commit(output, read_span);
+        received += read_span;
+        if (span == 0 && read_span == 0) {
+            sched_yield();
+        }
+    }
+    atomic_store(&stream->done, 1);
+    return NULL;
+}
+
+/* Nibbles streamed through IN and OUT while a host thread feeds and drains the rings. */
+static void bench_ports(BenchContext *bench, const char *name, const uint16_t *program, size_t word_count) {
+    GigaVmPorts *ports = giga_vm_ports_create(BENCH_PORT_CAPACITY);
+    if (ports == NULL) {
+        bench_fail(bench, "cannot create ports");
+        return;
+    }
+    uint64_t nibbles_per_run = bench->size / word_count;
+    BenchSamples rates;
+    bench_samples_begin(&rates);
+    while (bench_samples_pending(bench, &rates)) {
+        static GigaVmState state;
+        giga_vm_init(&state);
+        giga_vm_load_program(&state, program, word_count);
+        giga_vm_attach_ports(&state, ports);
+        giga_vm_ports_reset(ports);
+        BenchPortStream stream = {ports, nibbles_per_run, 0};
+        pthread_t host;
+
+        double start = bench_now_seconds();
+        if (pthread_create(&host, NULL, bench_port_host, &stream) != 0) {
+            bench_fail(bench, "cannot start the host thread");
+            break;
+        }
+        GigaVmStatus status;
+        while ((status = giga_vm_run(&state, UINT64_MAX)) == GIGA_VM_STATUS_IO_WAIT &&
+               !atomic_load(&stream.done)) {
+            sched_yield(); /* let the host catch up, even on one CPU */
+        }
+        if (status != GIGA_VM_STATUS_IO_WAIT) {
+            bench_unexpected_status(bench, "", status);
+            atomic_store(&stream.done, 1); /* stop the host, which still waits for nibbles */
+        }
+        pthread_join(host, NULL);
+        double elapsed = bench_now_seconds() - start;
+        bench_samples_add(bench, &rates, (double)nibbles_per_run / elapsed);
+    }
+    giga_vm_ports_destroy(ports);
+    bench_report(bench, name, "host-thread", "nibbles/s", &rates, NULL);
+}
+
+int main(int argc, char **argv) {
+    BenchContext bench;
+    if (bench_init(&bench, "bench_vm", argc, argv) != 0) {
+        return 2;
+    }
+    if (bench.size == 0) {
+        bench.size = BENCH_STEPS_PER_RUN;
+    }
+
+    /* Tight ALU loop: every instruction retires, JMP closes the loop. */
+    const uint16_t alu_loop[] = {
+        0x2101, /* MOVI R1, 1 */
+        0x2203, /* MOVI R2, 3 */
+        0x3010, /* loop: ADD R0, R1 */
+        0x4320, /* SUB R3, R2 */
+        0x7400, /* XOR R4, R0 */
+        0x9500, /* SHL R5 */
+        0x6530, /* OR  R5, R3 */
+        0xA600, /* SHR R6 */
+        0x1760, /* MOV R7, R6 */
+        0xD002  /* JMP loop */
+    };
+
+    /* Loop built from the fused sequences: MOVI;ADD, LD;ADD;ST, SHL;SHL. */
+    const uint16_t fusable_loop[] = {
+        0x2103, /* loop: MOVI R1, 3 */
+        0x3010, /* ADD R0, R1 */
+        0xB2F0, /* LD R2, [0xF0] */
+        0x3200, /* ADD R2, R0 */
+        0xCF12, /* ST [0xF1], R2 */
+        0x9300, /* SHL R3 */
+        0x9300, /* SHL R3 */
+        0xD000  /* JMP loop */
+    };
+
+    /* Countdown loop closed by CMP; JNZ, the pair fused into one dispatch. */
+    const uint16_t branch_loop[] = {
+        0x2101, /* MOVI R1, 1 */
+        0x2200, /* MOVI R2, 0 */
+        0x4010, /* loop: SUB R0, R1 */
+        0x3300, /* ADD R3, R0 */
+        0xE202, /* CMP R0, R2 */
+        0xE902, /* JNZ loop */
+        0xD002  /* JMP loop */
+    };
+
+    /* Doubles every nibble from port 0 onto port 1. */
+    const uint16_t port_loop[] = {
+        0x2101, /* MOVI R1, 1 */
+        0xE500, /* loop: IN R0, 0 */
+        0x3000, /* ADD R0, R0 */
+        0xE610, /* OUT 1, R0 */
+        0x3210, /* ADD R2, R1 */
+        0xD001  /* JMP loop */
+    };
+
+    /* Long synthetic loop mixing every instruction class, ADC/SBC included. */
+    uint16_t random_loop[BENCH_RANDOM_LOOP_WORDS];
+    size_t random_loop_words = bench_workload_loop(random_loop, BENCH_RANDOM_LOOP_WORDS, 7u);
+
+    GigaVmJit *jit = giga_vm_jit_create();
+    BenchMode last_mode = (jit != NULL) ? BENCH_MODE_JIT : BENCH_MODE_FUSED;
+
+    for (int mode = BENCH_MODE_UNFUSED; mode <= (int)last_mode; ++mode) {
+        bench_program(&bench, "alu_loop", alu_loop, sizeof(alu_loop) / sizeof(alu_loop[0]), (BenchMode)mode,
+                      jit);
+        bench_program(&bench, "fusable_loop", fusable_loop, sizeof(fusable_loop) / sizeof(fusable_loop[0]),
+                      (BenchMode)mode, jit);
+        bench_program(&bench, "branch_loop", branch_loop, sizeof(branch_loop) / sizeof(branch_loop[0]),
+                      (BenchMode)mode, jit);
+        bench_program(&bench, "random_loop", random_loop, random_loop_words, (BenchMode)mode, jit);
+    }
+    giga_vm_jit_destroy(jit);
+
+    bench_program(&bench, "alu_loop", alu_loop, sizeof(alu_loop) / sizeof(alu_loop[0]), BENCH_MODE_HARVARD, NULL);
+    bench_program(&bench, "branch_loop", branch_loop, sizeof(branch_loop) / sizeof(branch_loop[0]),
+                  BENCH_MODE_HARVARD, NULL);
+
+    for (int kernel = GIGA_VM_BATCH_KERNEL_SCALAR; kernel <= GIGA_VM_BATCH_KERNEL_AVX2; ++kernel) {
+        bench_batch(&bench, "alu_loop", alu_loop, sizeof(alu_loop) / sizeof(alu_loop[0]),
+                    (GigaVmBatchKernel)kernel);
+    }
+
+    for (int packed = 0; packed <= 1; ++packed) {
+        bench_instances(&bench, "alu_loop", alu_loop, sizeof(alu_loop) / sizeof(alu_loop[0]), packed);
+    }
+
+    for (int method = 0; method <= 2; ++method) {
+        bench_forks(&bench, "fusable_loop", fusable_loop, sizeof(fusable_loop) / sizeof(fusable_loop[0]),
+                    method);
+    }
+
+    for (int traced = 0; traced <= 1; ++traced) {
+        bench_trace(&bench, "alu_loop", alu_loop, sizeof(alu_loop) / sizeof(alu_loop[0]), traced);
+    }
+
+    bench_ports(&bench, "port_loop", port_loop, sizeof(port_loop) / sizeof(port_loop[0]));
+    return bench_finish(&bench);
+}
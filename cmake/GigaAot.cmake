@@ -0,0 +1,38 @@
+# giga_add_aot_program(<target> SOURCE <program.asm|program.bin> [FUNCTION <name>])
+#
+# Translates a Giga program to C with giga_aot at build time and compiles it
+# into the object library <target>. The generated function is named after
+# FUNCTION (default: <target>) and declared in <FUNCTION>.h, which is on the
+# target's public include path. Consumers link <target> together with the VM
+# sources (src/vm/vm.c, src/vm/vm_banks.c,
+# src/vm/vm_ports.c, src/vm/vm_image.c, src/alu/alu.c), which the
+# generated code falls back to.
+function(giga_add_aot_program target)
+    cmake_parse_arguments(GIGA_AOT "" "SOURCE;FUNCTION" "" ${ARGN})
+    if(NOT GIGA_AOT_SOURCE)
+        message(FATAL_ERROR "giga_add_aot_program(${target}): SOURCE is required")
+    endif()
+    if(NOT GIGA_AOT_FUNCTION)
+        set(GIGA_AOT_FUNCTION ${target})
+    endif()
+
+    get_filename_component(source_path ${GIGA_AOT_SOURCE} ABSOLUTE)
+    set(output_dir ${CMAKE_CURRENT_BINARY_DIR}/aot_generated/${target})
+    set(output_c ${output_dir}/${GIGA_AOT_FUNCTION}.c)
+    set(output_h ${output_dir}/${GIGA_AOT_FUNCTION}.h)
+
+    add_custom_command(
+        OUTPUT ${output_c} ${output_h}
+        COMMAND ${CMAKE_COMMAND} -E make_directory ${output_dir}
+        COMMAND giga_aot --function ${GIGA_AOT_FUNCTION}
+                --output ${output_c} --header ${output_h} ${source_path}
+        DEPENDS giga_aot ${source_path}
+        COMMENT "Translating ${GIGA_AOT_SOURCE} to C"
+        VERBATIM)
+
+    add_library(${target} OBJECT ${output_c} ${output_h})
+    target_include_directories(${target} PUBLIC
+        ${output_dir}
+        ${PROJECT_SOURCE_DIR}/include)
+    target_compile_features(${target} PRIVATE c_std_17)
+endfunction()
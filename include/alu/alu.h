@@ -36,6 +36,32 @@ AluResult alu_add(uint8_t operand_a, uint8_t operand_b);
  */
 AluResult alu_sub(uint8_t operand_a, uint8_t operand_b);
 
+/**
+ * @brief Add with carry-in, for chaining 4-bit slices.
+ *
+ * 4-bit add: operand_a + operand_b + carry_in. alu_adc(a, b, 0) equals
+ * alu_add(a, b).
+ *
+ * @param operand_a  First 4-bit value.
+ * @param operand_b  Second 4-bit value.
+ * @param carry_in   Incoming carry; any nonzero value counts as 1.
+ * @return Result and flags after addition.
+ */
+AluResult alu_adc(uint8_t operand_a, uint8_t operand_b, uint8_t carry_in);
+
+/**
+ * @brief Subtract with borrow, for chaining 4-bit slices.
+ *
+ * 4-bit subtract: operand_a - operand_b - (carry_in ? 0 : 1), computed as
+ * operand_a + ~operand_b + carry_in. alu_sbc(a, b, 1) equals alu_sub(a, b).
+ *
+ * @param operand_a  First 4-bit value (minuend).
+ * @param operand_b  Second 4-bit value (subtrahend).
+ * @param carry_in   Incoming carry (1 = no borrow); nonzero counts as 1.
+ * @return Result and flags; carry_flag is 1 when no borrow.
+ */
+AluResult alu_sbc(uint8_t operand_a, uint8_t operand_b, uint8_t carry_in);
+
 /**
  * @brief Bitwise AND on two 4-bit operands.
  *
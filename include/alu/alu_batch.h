@@ -0,0 +1,92 @@
+#ifndef GIGA_ALU_BATCH_H
+#define GIGA_ALU_BATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Operations available on packed-nibble batches.
+ */
+typedef enum {
+    ALU_BATCH_ADD = 0,
+    ALU_BATCH_SUB,
+    ALU_BATCH_AND,
+    ALU_BATCH_OR,
+    ALU_BATCH_XOR,
+    ALU_BATCH_NOT,  /** unary */
+    ALU_BATCH_SHL,  /** unary */
+    ALU_BATCH_SHR   /** unary */
+} AluBatchOp;
+
+/**
+ * @brief Implementation used for the bulk of a batch.
+ */
+typedef enum {
+    ALU_BATCH_KERNEL_SCALAR = 0,  /** portable loop over alu_* */
+    ALU_BATCH_KERNEL_SSE2,        /** 16 bytes per vector (x86-64 baseline) */
+    ALU_BATCH_KERNEL_AVX2,        /** 32 bytes per vector */
+    ALU_BATCH_KERNEL_AVX512       /** 64 bytes per vector (AVX-512BW) */
+} AluBatchKernel;
+
+/**
+ * @brief Output buffers of a batch operation over count elements.
+ *
+ * Results are packed like unary inputs: element 2k in the low nibble of
+ * results[k] and element 2k + 1 in the high nibble ((count + 1) / 2 bytes).
+ * Each flag bitmap holds element i's flag in bit i % 8 of byte i / 8
+ * ((count + 7) / 8 bytes); unused high bits are cleared. Flag pointers may
+ * be NULL to skip that flag.
+ */
+typedef struct {
+    uint8_t *results;
+    uint8_t *zero_flags;
+    uint8_t *carry_flags;
+    uint8_t *negative_flags;
+    uint8_t *overflow_flags;
+} AluBatchOutput;
+
+/**
+ * @brief Fastest kernel the running CPU supports.
+ */
+AluBatchKernel alu_batch_best_kernel(void);
+
+/**
+ * @brief Apply one operation to count elements with a given kernel.
+ *
+ * Binary ops read one byte per element: operand_a in the low nibble and
+ * operand_b in the high nibble. Unary ops read two elements per byte, packed
+ * like the results. Every element's result and flags equal the matching
+ * alu_* call. The vector kernel covers whole blocks and a scalar tail
+ * finishes the rest.
+ *
+ * @param kernel   Kernel to use.
+ * @param op       Operation.
+ * @param operands Packed operands (count bytes for binary ops,
+ *                 (count + 1) / 2 for unary ops).
+ * @param count    Number of elements.
+ * @param out      Output buffers.
+ * @return 0 on success, -1 on NULL buffers, -2 if the kernel is unsupported.
+ */
+int alu_batch_run(AluBatchKernel kernel,
+                  AluBatchOp op,
+                  const uint8_t *operands,
+                  size_t count,
+                  const AluBatchOutput *out);
+
+/**
+ * @brief Batch forms of alu_add .. alu_shr using alu_batch_best_kernel().
+ *
+ * See alu_batch_run for the operand and output layouts.
+ *
+ * @return 0 on success, -1 on NULL buffers.
+ */
+int alu_add_batch(const uint8_t *operands, size_t count, const AluBatchOutput *out);
+int alu_sub_batch(const uint8_t *operands, size_t count, const AluBatchOutput *out);
+int alu_and_batch(const uint8_t *operands, size_t count, const AluBatchOutput *out);
+int alu_or_batch(const uint8_t *operands, size_t count, const AluBatchOutput *out);
+int alu_xor_batch(const uint8_t *operands, size_t count, const AluBatchOutput *out);
+int alu_not_batch(const uint8_t *operands, size_t count, const AluBatchOutput *out);
+int alu_shl_batch(const uint8_t *operands, size_t count, const AluBatchOutput *out);
+int alu_shr_batch(const uint8_t *operands, size_t count, const AluBatchOutput *out);
+
+#endif /* GIGA_ALU_BATCH_H */
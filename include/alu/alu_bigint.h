@@ -0,0 +1,127 @@
+#ifndef GIGA_ALU_BIGINT_H
+#define GIGA_ALU_BIGINT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "alu/alu.h"
+
+/**
+ * @brief Operations of alu_bigint_run.
+ */
+typedef enum {
+    ALU_BIGINT_ADD = 0,  /** result = a + b + carry_in */
+    ALU_BIGINT_SUB       /** result = a - b - (carry_in ? 0 : 1) */
+} AluBigintOp;
+
+/**
+ * @brief Implementation used for the bulk of an add or subtract.
+ */
+typedef enum {
+    ALU_BIGINT_KERNEL_SCALAR = 0,  /** portable 64-bit ripple carry */
+    ALU_BIGINT_KERNEL_AVX2,        /** 4 x 64-bit lanes, carry-lookahead */
+    ALU_BIGINT_KERNEL_AVX512       /** 8 x 64-bit lanes, carry-lookahead */
+} AluBigintKernel;
+
+/*
+ * N-nibble integers are stored like packed ALU operands: nibble i (i = 0 is
+ * least significant) in the low half of byte i / 2 when i is even and the
+ * high half when i is odd, (nibble_count + 1) / 2 bytes in all. With an odd
+ * count the unused high nibble of the last byte is ignored on input and
+ * cleared on output. Results may alias either operand.
+ *
+ * Flags describe the whole N-nibble value the way a chain of alu_adc /
+ * alu_sbc calls from the lowest nibble would leave them, except zero_flag,
+ * which is set only when every result nibble is zero:
+ * - result:        most significant result nibble
+ * - carry_flag:    carry out of the top nibble (1 = no borrow for SUB)
+ * - negative_flag: sign bit of the top nibble
+ * - overflow_flag: two's complement overflow of the N-nibble operation
+ * A zero-length operation leaves zero_flag set and carry_flag = carry_in.
+ */
+
+/**
+ * @brief Fastest kernel the running CPU supports.
+ */
+AluBigintKernel alu_bigint_best_kernel(void);
+
+/**
+ * @brief Add or subtract two N-nibble integers with a given kernel.
+ *
+ * Every kernel gives the same result and flags. The vector kernels add 64-bit
+ * limbs in parallel lanes and resolve carries between lanes with a
+ * generate/propagate prefix instead of rippling limb by limb.
+ *
+ * @param kernel       Kernel to use.
+ * @param op           ALU_BIGINT_ADD or ALU_BIGINT_SUB.
+ * @param operand_a    First operand.
+ * @param operand_b    Second operand.
+ * @param nibble_count Number of nibbles in each operand and the result.
+ * @param carry_in     Incoming carry (for SUB: 1 = no borrow); nonzero is 1.
+ * @param result       Output; may be NULL to compute only the flags.
+ * @param flags        Output flags; may be NULL.
+ * @return 0 on success, -1 on invalid arguments, -2 if the kernel is
+ *         unsupported.
+ */
+int alu_bigint_run(AluBigintKernel kernel,
+                   AluBigintOp op,
+                   const uint8_t *operand_a,
+                   const uint8_t *operand_b,
+                   size_t nibble_count,
+                   uint8_t carry_in,
+                   uint8_t *result,
+                   AluResult *flags);
+
+/**
+ * @brief N-nibble add with carry-in, using alu_bigint_best_kernel().
+ *
+ * @return 0 on success, -1 on invalid arguments.
+ */
+int alu_bigint_add(const uint8_t *operand_a, const uint8_t *operand_b, size_t nibble_count,
+                   uint8_t carry_in, uint8_t *result, AluResult *flags);
+
+/**
+ * @brief N-nibble subtract with borrow, using alu_bigint_best_kernel().
+ *
+ * Pass carry_in = 1 for a plain subtraction.
+ *
+ * @return 0 on success, -1 on invalid arguments.
+ */
+int alu_bigint_sub(const uint8_t *operand_a, const uint8_t *operand_b, size_t nibble_count,
+                   uint8_t carry_in, uint8_t *result, AluResult *flags);
+
+/**
+ * @brief Compare two N-nibble integers.
+ *
+ * Sets flags as alu_bigint_sub(a, b, n, 1) would without writing a result:
+ * zero_flag when a == b, carry_flag when a >= b unsigned, and
+ * negative_flag != overflow_flag when a < b signed.
+ *
+ * @return 0 on success, -1 on invalid arguments.
+ */
+int alu_bigint_compare(const uint8_t *operand_a, const uint8_t *operand_b, size_t nibble_count,
+                       AluResult *flags);
+
+/**
+ * @brief Logical shift left of an N-nibble integer by bit_count bits.
+ *
+ * carry_flag holds the last bit shifted out (0 when bit_count is 0 or
+ * exceeds 4 * nibble_count); overflow_flag is 0. A shift by 1 matches a
+ * chain of alu_shl over the nibbles.
+ *
+ * @return 0 on success, -1 on invalid arguments.
+ */
+int alu_bigint_shl(const uint8_t *operand, size_t nibble_count, size_t bit_count,
+                   uint8_t *result, AluResult *flags);
+
+/**
+ * @brief Logical shift right of an N-nibble integer by bit_count bits.
+ *
+ * Flags as for alu_bigint_shl.
+ *
+ * @return 0 on success, -1 on invalid arguments.
+ */
+int alu_bigint_shr(const uint8_t *operand, size_t nibble_count, size_t bit_count,
+                   uint8_t *result, AluResult *flags);
+
+#endif /* GIGA_ALU_BIGINT_H */
@@ -0,0 +1,122 @@
+#ifndef GIGA_ALU_BITSLICE_H
+#define GIGA_ALU_BITSLICE_H
+
+#include <stdalign.h>
+#include <stdint.h>
+
+/**
+ * @brief Operations available on bit-sliced operands.
+ */
+typedef enum {
+    ALU_SLICE_ADD = 0,
+    ALU_SLICE_SUB,
+    ALU_SLICE_AND,
+    ALU_SLICE_OR,
+    ALU_SLICE_XOR,
+    ALU_SLICE_NOT,  /** unary: operand_b is ignored */
+    ALU_SLICE_SHL,  /** unary */
+    ALU_SLICE_SHR   /** unary */
+} AluSliceOp;
+
+/**
+ * @brief 64 4-bit operands stored as four bit-planes.
+ *
+ * Bit i of plane[k] is bit k of lane i.
+ */
+typedef struct {
+    uint64_t plane[4];
+} AluSlice64;
+
+/**
+ * @brief Result planes and per-lane flags of a 64-lane operation.
+ *
+ * Bit i of each flag mask is that flag for lane i, with the same meaning
+ * as the fields of AluResult.
+ */
+typedef struct {
+    AluSlice64 result;
+    uint64_t zero_flags;
+    uint64_t carry_flags;
+    uint64_t negative_flags;
+    uint64_t overflow_flags;
+} AluSliceResult64;
+
+/**
+ * @brief 256 4-bit operands stored as four 256-bit bit-planes.
+ *
+ * Bit i of plane[k][w] is bit k of lane 64 * w + i.
+ */
+typedef struct {
+    alignas(32) uint64_t plane[4][4];
+} AluSlice256;
+
+/**
+ * @brief Result planes and per-lane flags of a 256-lane operation.
+ *
+ * Bit i of word w of each flag mask belongs to lane 64 * w + i.
+ */
+typedef struct {
+    AluSlice256 result;
+    alignas(32) uint64_t zero_flags[4];
+    alignas(32) uint64_t carry_flags[4];
+    alignas(32) uint64_t negative_flags[4];
+    alignas(32) uint64_t overflow_flags[4];
+} AluSliceResult256;
+
+/**
+ * @brief Transpose 64 operands (low 4 bits of each byte) into bit-planes.
+ *
+ * @param operands 64 values; bits above the low nibble are ignored.
+ * @param slice    Output planes.
+ */
+void alu_slice64_pack(const uint8_t operands[64], AluSlice64 *slice);
+
+/**
+ * @brief Transpose bit-planes back into 64 4-bit values.
+ *
+ * @param slice  Input planes.
+ * @param values Output, one value per byte.
+ */
+void alu_slice64_unpack(const AluSlice64 *slice, uint8_t values[64]);
+
+/**
+ * @brief Apply one operation to 64 lanes with bitwise logic only.
+ *
+ * ADD and SUB are ripple-carry adders over the planes (SUB adds the
+ * complement with carry-in 1, so carry means "no borrow" as in alu_sub).
+ * Every lane's result and flags equal the matching alu_* call.
+ *
+ * @param op        Operation.
+ * @param operand_a First operand planes (the only operand for unary ops).
+ * @param operand_b Second operand planes.
+ * @return Result planes and flag masks.
+ */
+AluSliceResult64 alu_slice64_eval(AluSliceOp op, AluSlice64 operand_a, AluSlice64 operand_b);
+
+/**
+ * @brief Transpose 256 operands into bit-planes.
+ */
+void alu_slice256_pack(const uint8_t operands[256], AluSlice256 *slice);
+
+/**
+ * @brief Transpose 256-lane bit-planes back into 4-bit values.
+ */
+void alu_slice256_unpack(const AluSlice256 *slice, uint8_t values[256]);
+
+/**
+ * @brief Apply one operation to 256 lanes.
+ *
+ * Same semantics as alu_slice64_eval. Uses 256-bit AVX2 logic when the CPU
+ * supports it and pairs of 128-bit (or 64-bit) operations otherwise.
+ *
+ * @param op        Operation.
+ * @param operand_a First operand planes.
+ * @param operand_b Second operand planes (ignored for unary ops).
+ * @param out       Result planes and flag masks.
+ */
+void alu_slice256_eval(AluSliceOp op,
+                       const AluSlice256 *operand_a,
+                       const AluSlice256 *operand_b,
+                       AluSliceResult256 *out);
+
+#endif /* GIGA_ALU_BITSLICE_H */
@@ -0,0 +1,90 @@
+#ifndef GIGA_ALU_LUT_H
+#define GIGA_ALU_LUT_H
+
+#include <stdint.h>
+
+#include "alu/alu.h"
+
+/**
+ * @brief Table-driven ALU backend.
+ *
+ * Each table entry is one byte holding the result nibble and all four
+ * flags (layout below). Binary ops are indexed by (a << 4) | b, unary ops
+ * by the operand; all tables together take 1328 bytes. The tables are built
+ * by the preprocessor from the same formulas as alu.c, and every alu_lut_*
+ * result is identical to the matching alu_* call.
+ */
+
+#define ALU_LUT_RESULT_MASK   0x0Fu  /** bits 0-3: result nibble */
+#define ALU_LUT_ZERO_BIT      4      /** bit 4: zero_flag */
+#define ALU_LUT_CARRY_BIT     5      /** bit 5: carry_flag */
+#define ALU_LUT_NEGATIVE_BIT  6      /** bit 6: negative_flag */
+#define ALU_LUT_OVERFLOW_BIT  7      /** bit 7: overflow_flag */
+
+extern const uint8_t alu_lut_add_table[256];
+extern const uint8_t alu_lut_sub_table[256];
+extern const uint8_t alu_lut_and_table[256];
+extern const uint8_t alu_lut_or_table[256];
+extern const uint8_t alu_lut_xor_table[256];
+extern const uint8_t alu_lut_not_table[16];
+extern const uint8_t alu_lut_shl_table[16];
+extern const uint8_t alu_lut_shr_table[16];
+
+/**
+ * @brief Expand a packed table entry into an AluResult.
+ */
+static inline AluResult alu_lut_unpack(uint8_t entry) {
+    AluResult result;
+    result.result = (uint8_t)(entry & ALU_LUT_RESULT_MASK);
+    result.zero_flag = (uint8_t)((entry >> ALU_LUT_ZERO_BIT) & 1u);
+    result.carry_flag = (uint8_t)((entry >> ALU_LUT_CARRY_BIT) & 1u);
+    result.negative_flag = (uint8_t)((entry >> ALU_LUT_NEGATIVE_BIT) & 1u);
+    result.overflow_flag = (uint8_t)((entry >> ALU_LUT_OVERFLOW_BIT) & 1u);
+    return result;
+}
+
+static inline uint8_t alu_lut_binary_index(uint8_t operand_a, uint8_t operand_b) {
+    return (uint8_t)(((operand_a & 0x0Fu) << 4) | (operand_b & 0x0Fu));
+}
+
+/** @brief Table form of alu_add. */
+static inline AluResult alu_lut_add(uint8_t operand_a, uint8_t operand_b) {
+    return alu_lut_unpack(alu_lut_add_table[alu_lut_binary_index(operand_a, operand_b)]);
+}
+
+/** @brief Table form of alu_sub. */
+static inline AluResult alu_lut_sub(uint8_t operand_a, uint8_t operand_b) {
+    return alu_lut_unpack(alu_lut_sub_table[alu_lut_binary_index(operand_a, operand_b)]);
+}
+
+/** @brief Table form of alu_and. */
+static inline AluResult alu_lut_and(uint8_t operand_a, uint8_t operand_b) {
+    return alu_lut_unpack(alu_lut_and_table[alu_lut_binary_index(operand_a, operand_b)]);
+}
+
+/** @brief Table form of alu_or. */
+static inline AluResult alu_lut_or(uint8_t operand_a, uint8_t operand_b) {
+    return alu_lut_unpack(alu_lut_or_table[alu_lut_binary_index(operand_a, operand_b)]);
+}
+
+/** @brief Table form of alu_xor. */
+static inline AluResult alu_lut_xor(uint8_t operand_a, uint8_t operand_b) {
+    return alu_lut_unpack(alu_lut_xor_table[alu_lut_binary_index(operand_a, operand_b)]);
+}
+
+/** @brief Table form of alu_not. */
+static inline AluResult alu_lut_not(uint8_t operand) {
+    return alu_lut_unpack(alu_lut_not_table[operand & 0x0Fu]);
+}
+
+/** @brief Table form of alu_shl. */
+static inline AluResult alu_lut_shl(uint8_t operand) {
+    return alu_lut_unpack(alu_lut_shl_table[operand & 0x0Fu]);
+}
+
+/** @brief Table form of alu_shr. */
+static inline AluResult alu_lut_shr(uint8_t operand) {
+    return alu_lut_unpack(alu_lut_shr_table[operand & 0x0Fu]);
+}
+
+#endif /* GIGA_ALU_LUT_H */
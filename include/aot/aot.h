@@ -0,0 +1,52 @@
+#ifndef GIGA_AOT_H
+#define GIGA_AOT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * @brief Translate a Giga program into a C translation unit.
+ *
+ * Emits one function
+ * @code
+ * GigaVmStatus <function_name>(GigaVmState *state, uint64_t max_steps);
+ * @endcode
+ * with the same behaviour as giga_vm_run on a state loaded with the program.
+ * Registers and flags live in locals, JMP targets become labels and gotos,
+ * and the ALU operations are emitted as static inline code so the host
+ * compiler can optimise the whole program. The step budget is charged once
+ * per basic block.
+ *
+ * Paths the translation does not cover fall back to giga_vm_run for the
+ * rest of the call: resuming at a PC that does not start a block, a step
+ * budget smaller than the next block, ST into the program region, BANK and
+ * BANKI selecting a bank other than 0, IN and OUT, and a state whose
+ * program no longer matches the translated words or that has another bank
+ * selected. The state must be loaded with giga_vm_load_program (the
+ * generated <function_name>_load does this).
+ *
+ * The unit also defines <function_name>_program / _program_words with the
+ * translated words.
+ *
+ * @param program_words Instruction words.
+ * @param word_count    Number of words (at most GIGA_VM_MAX_PROGRAM_WORDS).
+ * @param function_name C identifier for the generated function.
+ * @param output        Stream receiving the C source.
+ * @return 0 on success, -1 on invalid arguments, -2 on a stream error.
+ */
+int giga_aot_translate(const uint16_t *program_words,
+                       size_t word_count,
+                       const char *function_name,
+                       FILE *output);
+
+/**
+ * @brief Write the header declaring the functions giga_aot_translate emits.
+ *
+ * @param function_name Same name as passed to giga_aot_translate.
+ * @param output        Stream receiving the header.
+ * @return 0 on success, -1 on invalid arguments, -2 on a stream error.
+ */
+int giga_aot_write_header(const char *function_name, FILE *output);
+
+#endif /* GIGA_AOT_H */
@@ -8,8 +8,29 @@
 
 /**
  * @brief Maximum number of instruction words in assembled program.
+ *
+ * This is the 12-bit JMP range. Only GIGA_VM_MAX_PROGRAM_WORDS of them fit
+ * in VM memory; longer programs run from a separate instruction store
+ * (giga_vm_run_code).
+ */
+#define GIGA_ASSEMBLER_MAX_WORDS 4096
+
+/**
+ * @brief Version of the assembler's output.
+ *
+ * Bump it whenever the same source would assemble to different words,
+ * lines or labels, so cached programs (assembler_cache.h) are rebuilt.
  */
-#define GIGA_ASSEMBLER_MAX_WORDS 128
+#define GIGA_ASSEMBLER_VERSION 1u
+
+/**
+ * @brief Label defined in the source.
+ */
+typedef struct {
+    const char *name;                 /** Points into the source text; not NUL-terminated */
+    size_t name_length;               /** Length of name */
+    uint16_t address;                 /** Instruction word the label marks */
+} GigaAssemblerLabel;
 
 /**
  * @brief Assembler result containing bytecode and metadata.
@@ -17,6 +38,9 @@
 typedef struct {
     uint16_t *bytecode;              /** Array of 16-bit instruction words */
     size_t word_count;                /** Number of words in bytecode */
+    size_t *source_lines;             /** Source line of each word */
+    GigaAssemblerLabel *labels;       /** Labels in source order */
+    size_t label_count;               /** Number of labels */
     int has_error;                    /** 1 if assembly failed */
     const char *error_message;        /** Error message if has_error is 1 */
     size_t error_line;                /** Source line of error */
@@ -0,0 +1,99 @@
+#ifndef GIGA_ASSEMBLER_CACHE_H
+#define GIGA_ASSEMBLER_CACHE_H
+
+#include "assembler/assembler.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * On-disk cache of assembled programs (GigaAssemblerCache).
+ *
+ * Entries are keyed by a 64-bit hash of the source text seeded with
+ * GIGA_ASSEMBLER_VERSION, and named after it: <directory>/<hash>.gac. An
+ * entry holds the bytecode, source lines and labels of one program; a hit
+ * rebuilds the GigaAssemblerResult from it without lexing, parsing or
+ * assembling. Each entry also keeps the source text it was built from. An
+ * entry is only used when its assembler version, source length, source hash,
+ * source text and payload checksum all match, so a changed source, a hash
+ * collision, a new assembler or a damaged file is a miss that rewrites the
+ * entry.
+ *
+ * Entries are written to a temporary file in the directory and renamed into
+ * place, so processes sharing a directory never read a partial entry.
+ */
+
+/** @brief Opaque cache handle. */
+typedef struct GigaAssemblerCache GigaAssemblerCache;
+
+/**
+ * @brief Lookup counters since giga_assembler_cache_open.
+ */
+typedef struct {
+    uint64_t hits;             /** lookups served from an entry */
+    uint64_t misses;           /** lookups that had to assemble */
+    uint64_t write_failures;   /** misses whose entry could not be written */
+} GigaAssemblerCacheStats;
+
+/**
+ * @brief 64-bit hash of bytes (XXH64).
+ *
+ * @param bytes  Data to hash (may be NULL when length is 0).
+ * @param length Number of bytes.
+ * @param seed   Seed; equal data and seeds give equal hashes on every host.
+ */
+uint64_t giga_assembler_hash(const void *bytes, size_t length, uint64_t seed);
+
+/**
+ * @brief Open a cache directory, creating it if it does not exist.
+ *
+ * @param directory Directory path; its parent must exist.
+ * @return New cache, or NULL if the directory cannot be created or memory
+ *         runs out.
+ */
+GigaAssemblerCache *giga_assembler_cache_open(const char *directory);
+
+/**
+ * @brief Release a cache handle. Entries stay on disk.
+ *
+ * @param cache Cache (may be NULL).
+ */
+void giga_assembler_cache_close(GigaAssemblerCache *cache);
+
+/**
+ * @brief Assemble source text, through the cache when one is given.
+ *
+ * Lexing, parsing and assembly errors are all reported in result, as
+ * giga_assemble does; failed programs are not cached. Label names point
+ * into source whether the result was assembled or read from an entry.
+ * Free the result with giga_assembler_free.
+ *
+ * @param cache  Cache, or NULL to always assemble.
+ * @param source Source text.
+ * @param length Length of source in bytes.
+ * @param result Output structure to fill with bytecode and status.
+ * @return 0 on success, non-zero on error. Check result->has_error.
+ */
+int giga_assembler_cache_assemble(GigaAssemblerCache *cache, const char *source, size_t length,
+                                  GigaAssemblerResult *result);
+
+/**
+ * @brief Read the cache's counters.
+ *
+ * @param cache Cache.
+ * @param stats Receives the counters.
+ */
+void giga_assembler_cache_stats(const GigaAssemblerCache *cache, GigaAssemblerCacheStats *stats);
+
+/**
+ * @brief Delete every entry in the cache directory.
+ *
+ * Temporary files left by stores that never finished are deleted too, but
+ * not counted. A store running at the same time then fails and counts as a
+ * write failure.
+ *
+ * @param cache Cache.
+ * @return Number of entries removed, or -1 if the directory cannot be read.
+ */
+long giga_assembler_cache_clear(GigaAssemblerCache *cache);
+
+#endif /* GIGA_ASSEMBLER_CACHE_H */
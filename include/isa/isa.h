@@ -15,6 +15,19 @@
  */
 #define GIGA_VM_MEMORY_SIZE 256
 
+/**
+ * @brief Number of data banks BANK and BANKI can select.
+ *
+ * Each bank is GIGA_VM_MEMORY_SIZE bytes of LD/ST address space, so 4096
+ * banks give 1 MiB. Bank 0 is VM memory itself, program included.
+ */
+#define GIGA_VM_BANK_COUNT 4096
+
+/**
+ * @brief Number of I/O ports IN and OUT can address.
+ */
+#define GIGA_VM_PORT_COUNT 16
+
 /**
  * @brief Opcode values for the Giga-ALU instruction set.
  *
@@ -38,9 +51,56 @@ typedef enum {
     GIGA_OP_LD   = 0xB, /** LD dest_reg */
     GIGA_OP_ST   = 0xC, /** ST src_reg */
     GIGA_OP_JMP  = 0xD, /** JMP to address */
+    GIGA_OP_EXT  = 0xE, /** extended opcode, see GigaExtOpcode */
     GIGA_OP_HALT = 0xF  /** Stop execution */
 } GigaOpcode;
 
+/**
+ * @brief Sub-opcodes of GIGA_OP_EXT.
+ *
+ * Extended words use [15:12] = 0xE, [11:8] sub-opcode, [7:4] dest_reg and
+ * [3:0] src_reg. Conditional branches (0x8-0xB) instead hold the target
+ * word in [7:0] and jump when their flag condition holds; otherwise they
+ * fall through. Relative branches (0xC-0xF) test the same conditions but
+ * hold a signed offset from the next word in [7:0]; they are only defined
+ * in instruction stores (giga_vm_run_code), where code can run past word
+ * 255. BANKI holds its bank number in [7:0]. IN and OUT hold a 4-bit port
+ * number in place of one register. Sub-opcodes not listed here are
+ * undefined.
+ */
+typedef enum {
+    GIGA_EXT_ADC   = 0x0, /** ADC dest_reg, src_reg: dest + src + carry */
+    GIGA_EXT_SBC   = 0x1, /** SBC dest_reg, src_reg: dest - src - !carry */
+    GIGA_EXT_CMP   = 0x2, /** CMP dest_reg, src_reg: flags of dest - src, no register written */
+    GIGA_EXT_BANK  = 0x3, /** BANK dest_reg: LD/ST use bank R<d>:R<d+1>:R<d+2>, high nibble first */
+    GIGA_EXT_BANKI = 0x4, /** BANKI imm8: LD/ST use bank imm8 */
+    GIGA_EXT_IN    = 0x5, /** IN dest_reg, port: dest = next nibble from the port's input */
+    GIGA_EXT_OUT   = 0x6, /** OUT port, src_reg: append src to the port's output */
+    GIGA_EXT_JZ    = 0x8, /** JZ address: jump if zero */
+    GIGA_EXT_JNZ   = 0x9, /** JNZ address: jump if not zero */
+    GIGA_EXT_JC    = 0xA, /** JC address: jump if carry (no borrow after SUB/CMP) */
+    GIGA_EXT_JN    = 0xB, /** JN address: jump if negative */
+    GIGA_EXT_JZR   = 0xC, /** JZ by offset: jump if zero */
+    GIGA_EXT_JNZR  = 0xD, /** JNZ by offset: jump if not zero */
+    GIGA_EXT_JCR   = 0xE, /** JC by offset: jump if carry */
+    GIGA_EXT_JNR   = 0xF  /** JN by offset: jump if negative */
+} GigaExtOpcode;
+
+/**
+ * @brief Nonzero when an EXT sub-opcode is a conditional branch.
+ */
+#define GIGA_EXT_IS_BRANCH(sub_opcode) (((sub_opcode) & 0xCu) == 0x8u)
+
+/**
+ * @brief Nonzero when an EXT sub-opcode is a relative conditional branch.
+ */
+#define GIGA_EXT_IS_RELATIVE_BRANCH(sub_opcode) (((sub_opcode) & 0xCu) == 0xCu)
+
+/**
+ * @brief Condition (GIGA_EXT_JZ..JN) a relative branch tests.
+ */
+#define GIGA_EXT_RELATIVE_CONDITION(sub_opcode) ((sub_opcode) & ~0x4u)
+
 /**
  * @brief Decoded view of a single 16-bit instruction word.
  */
@@ -31,13 +31,22 @@ typedef struct {
 
 /**
  * @brief Lexer state for one source buffer.
+ *
+ * Columns are not tracked per byte: a token's column is its offset from
+ * line_start_index, the offset just past the last newline.
  */
 typedef struct {
     const char *buffer;
     size_t buffer_length;
     size_t current_index;
     size_t line_number;
-    size_t column_number;
+    size_t line_start_index;
+    /* 64 bytes from window_index classified at once; one bit per byte (SIMD builds only) */
+    size_t window_index;
+    size_t window_end;          /* where the next window starts once window_starts is empty */
+    uint64_t window_starts;     /* token starts not yet returned */
+    uint64_t window_word;
+    uint64_t window_digit;
 } GigaLexer;
 
 /**
@@ -0,0 +1,108 @@
+#ifndef GIGA_RUNNER_H
+#define GIGA_RUNNER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "vm/vm.h"
+
+/**
+ * @brief One independent program execution.
+ *
+ * With @c initial_state set, that state is copied and run as-is and the
+ * program fields are ignored. Otherwise the worker loads the program into a
+ * fresh state and applies @c initial_registers (when not NULL).
+ *
+ * Banked memory is not part of @c initial_state: every job gets the
+ * worker's own banks, all zero, and keeps the state's selected bank.
+ * Neither are ports: jobs run with none attached, so IN and OUT stop with
+ * GIGA_VM_STATUS_PORT_FAULT even when @c initial_state has ports.
+ */
+typedef struct {
+    const uint16_t *program_words;     /** instruction words */
+    size_t word_count;                 /** number of words */
+    const uint8_t *initial_registers;  /** GIGA_VM_REGISTER_COUNT values, or NULL for zeros */
+    const GigaVmState *initial_state;  /** full starting state, or NULL */
+    uint64_t max_steps;                /** step budget passed to giga_vm_run */
+} GigaRunnerJob;
+
+/**
+ * @brief Architectural state at the end of a job.
+ */
+typedef struct {
+    GigaVmStatus status;               /** INVALID_STATE if the program did not load */
+    uint16_t program_counter;
+    uint8_t registers[GIGA_VM_REGISTER_COUNT];
+    uint8_t flags_zero;
+    uint8_t flags_carry;
+    uint8_t flags_negative;
+    uint8_t flags_overflow;
+    GigaVmCounters counters;           /** giga_vm_counters for this job alone */
+} GigaRunnerResult;
+
+/**
+ * @brief Runner configuration.
+ */
+typedef struct {
+    size_t thread_count;               /** worker threads; 0 = one per online CPU */
+    int pin_threads;                   /** pin worker i to CPU i (Linux only) */
+    int fuse_superinstructions;        /** apply giga_vm_fuse_superinstructions per job */
+} GigaRunnerOptions;
+
+/**
+ * @brief Pool of worker threads executing batches of jobs.
+ *
+ * Each worker owns a reusable GigaVmState, the banks attached to it and a
+ * deque holding a contiguous range of job indices. A call to
+ * giga_runner_run splits the jobs evenly across the deques; workers take
+ * jobs from the front of their own range and, once it is empty, steal the
+ * back half of another worker's range.
+ * Deques are single 64-bit atomics updated by compare-and-swap, so no lock
+ * is taken per job or per instruction; the pool's mutex is only used to
+ * start and finish a batch.
+ */
+typedef struct GigaRunner GigaRunner;
+
+/**
+ * @brief Fill @p options with the defaults (all CPUs, no pinning, fusion on).
+ */
+void giga_runner_default_options(GigaRunnerOptions *options);
+
+/**
+ * @brief Start a runner and its worker threads.
+ *
+ * @param options Configuration, or NULL for the defaults.
+ * @return New runner, or NULL if threads or memory could not be allocated.
+ */
+GigaRunner *giga_runner_create(const GigaRunnerOptions *options);
+
+/**
+ * @brief Stop the workers and release the runner.
+ *
+ * @param runner Runner (may be NULL).
+ */
+void giga_runner_destroy(GigaRunner *runner);
+
+/**
+ * @brief Number of worker threads in the runner.
+ */
+size_t giga_runner_thread_count(const GigaRunner *runner);
+
+/**
+ * @brief Execute @p job_count jobs and wait for all of them.
+ *
+ * results[i] receives the outcome of jobs[i]. Calls on one runner must not
+ * overlap.
+ *
+ * @param runner    Runner.
+ * @param jobs      Jobs to execute.
+ * @param job_count Number of jobs (below 2^32).
+ * @param results   Preallocated array of @p job_count results.
+ * @return 0 on success, -1 on invalid arguments.
+ */
+int giga_runner_run(GigaRunner *runner,
+                    const GigaRunnerJob *jobs,
+                    size_t job_count,
+                    GigaRunnerResult *results);
+
+#endif /* GIGA_RUNNER_H */
@@ -7,6 +7,93 @@
 #include "isa/isa.h"
 #include "alu/alu.h"
 
+/**
+ * @brief Maximum number of instruction words that fit in VM memory.
+ */
+#define GIGA_VM_MAX_PROGRAM_WORDS (GIGA_VM_MEMORY_SIZE / 2)
+
+/**
+ * @brief Maximum number of words in a separate instruction store: the JMP range.
+ */
+#define GIGA_VM_MAX_CODE_WORDS 4096u
+
+/**
+ * @brief Granularity of dirty tracking for snapshots and forks, in bytes.
+ */
+#define GIGA_VM_DIRTY_BLOCK_SIZE 16u
+
+/**
+ * @brief Number of dirty-tracking blocks in VM memory (one bit each).
+ */
+#define GIGA_VM_DIRTY_BLOCK_COUNT (GIGA_VM_MEMORY_SIZE / GIGA_VM_DIRTY_BLOCK_SIZE)
+
+/** @brief dirty_blocks bit covering a memory address. */
+#define GIGA_VM_DIRTY_BIT(address) ((uint16_t)(1u << ((address) / GIGA_VM_DIRTY_BLOCK_SIZE)))
+
+/**
+ * @brief Lazily backed memory for data banks 1 and up; see vm/vm_banks.h.
+ */
+typedef struct GigaVmBanks GigaVmBanks;
+
+/**
+ * @brief Host ring buffers behind IN and OUT; see vm/vm_ports.h.
+ */
+typedef struct GigaVmPorts GigaVmPorts;
+
+/**
+ * @brief One predecoded instruction word.
+ *
+ * Built by giga_vm_load_program so the run loop never re-reads or re-splits
+ * the byte-level program. Treat as internal to the VM.
+ */
+typedef struct {
+    uint8_t handler;      /** run-loop handler index (may be a fused superinstruction) */
+    uint8_t base_handler; /** handler for this word alone, before fusion */
+    uint8_t dest_reg;     /** destination register index, already masked */
+    uint8_t src_reg;      /** source register index, already masked */
+    uint8_t imm4;         /** low nibble of the word; sub-opcode of a branch */
+    uint16_t operand;     /** LD/ST byte address, JMP/branch target, BANKI bank or IN/OUT port */
+} GigaVmDecodedInstruction;
+
+/**
+ * @brief Version of handler numbering and GigaVmDecodedInstruction.
+ *
+ * Bytecode images store predecoded entries (vm/vm_image.h). Bump this
+ * whenever either changes so images from older builds are rejected.
+ */
+#define GIGA_VM_DECODE_ABI 1u
+
+/**
+ * @brief Slots of GigaVmCounters::alu_ops, one per ALU instruction.
+ */
+typedef enum {
+    GIGA_VM_COUNTER_ADD = 0,
+    GIGA_VM_COUNTER_SUB,
+    GIGA_VM_COUNTER_AND,
+    GIGA_VM_COUNTER_OR,
+    GIGA_VM_COUNTER_XOR,
+    GIGA_VM_COUNTER_NOT,
+    GIGA_VM_COUNTER_SHL,
+    GIGA_VM_COUNTER_SHR,
+    GIGA_VM_COUNTER_ADC,
+    GIGA_VM_COUNTER_SBC,
+    GIGA_VM_COUNTER_CMP,
+    GIGA_VM_COUNTER_ALU_KINDS
+} GigaVmAluCounter;
+
+/**
+ * @brief Performance counters, as returned by giga_vm_counters.
+ */
+typedef struct {
+    uint64_t retired;                          /**instructions retired, HALT and JMPs out of the program included */
+    uint64_t alu_ops[GIGA_VM_COUNTER_ALU_KINDS]; /**ALU instructions, indexed by GigaVmAluCounter */
+    uint64_t loads;                            /**LD instructions */
+    uint64_t stores;                           /**ST instructions */
+    uint64_t taken_jumps;                      /**JMPs plus conditional branches that were taken */
+    uint64_t code_writes;                      /**ST instructions addressing the loaded program (bank 0) */
+    uint64_t flag_reads;                       /**instructions that read a flag (ADC/SBC carry in, branches) */
+} GigaVmCounters;
+
 /**
  * @brief Virtual machine state for the Giga-ALU CPU.
  */
@@ -19,13 +106,118 @@ typedef struct {
 
     uint16_t program_counter;                  /**index of next instruction word */
 
-    uint8_t memory[GIGA_VM_MEMORY_SIZE];       /**main memory, byte addressed */
+    uint8_t memory[GIGA_VM_MEMORY_SIZE];       /**main memory, byte addressed; also data bank 0 */
+    uint16_t data_bank;                        /**bank LD and ST address, 0 = memory above */
+    GigaVmBanks *banks;                        /**banks 1 and up, or NULL; attached by the host, not owned */
+    GigaVmPorts *ports;                        /**IN/OUT rings, or NULL; attached by the host, not owned */
     size_t loaded_program_words;               /**number of valid instruction words loaded */
+    uint64_t snapshot_id;                      /**snapshot dirty_blocks is relative to, 0 = none */
+    uint16_t dirty_blocks;                     /**bit b: memory block b written since that snapshot */
+
+    /**predecoded program plus one end-of-program sentinel */
+    GigaVmDecodedInstruction decoded[GIGA_VM_MAX_PROGRAM_WORDS + 1];
+
+    /**runs and JMPs entering at pc minus those leaving before pc, not yet in counters */
+    uint64_t block_edges[GIGA_VM_MAX_PROGRAM_WORDS + 1];
+    GigaVmCounters counters;                   /**totals as of the last fold; read via giga_vm_counters */
 } GigaVmState;
 
+/**
+ * @brief Program image shared read-only by any number of packed instances.
+ *
+ * Built once by giga_vm_program_init; holds the bytes a GigaVmState would
+ * have in memory after giga_vm_load_program, plus the predecoded program.
+ */
+typedef struct {
+    uint8_t image[GIGA_VM_MEMORY_SIZE];        /**program bytes, zero after them */
+    size_t word_count;                         /**number of instruction words */
+    GigaVmDecodedInstruction decoded[GIGA_VM_MAX_PROGRAM_WORDS + 1];
+} GigaVmProgram;
+
+/**
+ * @brief Instruction memory apart from VM memory, for giga_vm_run_code.
+ *
+ * Words are kept host-endian and predecoded once, so a run never reads
+ * code through state->memory. Programs can use the whole 12-bit JMP range
+ * and all of VM memory is left for data. Nothing writes to it during a run,
+ * so one store can serve any number of states. About 41 KiB.
+ */
+typedef struct {
+    uint16_t words[GIGA_VM_MAX_CODE_WORDS];    /**instruction words, host-endian */
+    size_t word_count;                         /**number of instruction words */
+    GigaVmDecodedInstruction decoded[GIGA_VM_MAX_CODE_WORDS + 1];
+} GigaVmCode;
+
+#define GIGA_VM_PACKED_FLAG_ZERO     0x01u
+#define GIGA_VM_PACKED_FLAG_CARRY    0x02u
+#define GIGA_VM_PACKED_FLAG_NEGATIVE 0x04u
+#define GIGA_VM_PACKED_FLAG_OVERFLOW 0x08u
+
+/**
+ * @brief Compact VM instance running a shared GigaVmProgram.
+ *
+ * Memory keeps one 4-bit value per address, two per byte, which is all LD
+ * can observe. Program bytes a store has not touched are read from the
+ * shared image, so a self-modifying store only has to set a bit in
+ * code_written. Registers and memory values are 4-bit. Use the
+ * giga_vm_packed_* accessors instead of decoding the fields by hand.
+ */
+typedef struct {
+    uint32_t registers;                        /**R<i> in bits [4i+3:4i] */
+    uint16_t program_counter;                  /**index of next instruction word */
+    uint8_t flags;                             /**GIGA_VM_PACKED_FLAG_* bits */
+    uint8_t code_modified;                     /**nonzero once a store hit the program */
+    uint8_t memory[GIGA_VM_MEMORY_SIZE / 2];   /**address a in byte a / 2, low nibble if a is even */
+    uint8_t code_written[GIGA_VM_MEMORY_SIZE / 8]; /**bit a set: program byte a was overwritten */
+} GigaVmPackedState;
+
+/**
+ * @brief Immutable copy of a GigaVmState that states can be restored to and
+ *        forks can run from. Reference counted; see giga_vm_snapshot_take.
+ */
+typedef struct GigaVmSnapshot GigaVmSnapshot;
+
+/**
+ * @brief Copy-on-write child of a snapshot.
+ *
+ * Registers, flags and pc are private. Memory is read from the snapshot
+ * until the child stores into a block, which is then copied into memory
+ * below and marked in dirty_blocks; bytes of clean blocks are undefined.
+ * Use giga_vm_fork_load / giga_vm_fork_store rather than memory directly.
+ */
+typedef struct {
+    GigaVmSnapshot *snapshot;                  /**parent memory and program */
+    uint8_t registers[GIGA_VM_REGISTER_COUNT]; /**4-bit general registers */
+    uint8_t flags_zero;
+    uint8_t flags_carry;
+    uint8_t flags_negative;
+    uint8_t flags_overflow;
+    uint16_t program_counter;                  /**index of next instruction word */
+    uint16_t dirty_blocks;                     /**bit b: block b of memory is private */
+    uint8_t memory[GIGA_VM_MEMORY_SIZE];       /**private copies of dirty blocks */
+} GigaVmFork;
+
+/**
+ * @brief Outcome of giga_vm_step / giga_vm_run.
+ */
+typedef enum {
+    GIGA_VM_STATUS_RUNNING = 0,        /** one instruction retired, machine can continue (step only) */
+    GIGA_VM_STATUS_HALTED,             /** HALT retired; PC left pointing at the HALT */
+    GIGA_VM_STATUS_STEP_LIMIT,         /** max_steps instructions retired without HALT */
+    GIGA_VM_STATUS_PC_OUT_OF_RANGE,    /** PC left the loaded program */
+    GIGA_VM_STATUS_INVALID_OPCODE,     /** undefined opcode; PC left pointing at it */
+    GIGA_VM_STATUS_INVALID_STATE,      /** NULL state */
+    GIGA_VM_STATUS_BANK_FAULT,         /** BANK/BANKI selected a bank that is not available; PC left pointing at it */
+    GIGA_VM_STATUS_IO_WAIT,            /** IN found its port empty or OUT found it full; PC left pointing at it */
+    GIGA_VM_STATUS_PORT_FAULT          /** IN/OUT without ports attached; PC left pointing at it */
+} GigaVmStatus;
+
 /**
  * @brief Initialise VM state with all registers, flags and memory cleared.
  *
+ * Selects bank 0 and detaches any banked memory (giga_vm_attach_banks) and
+ * ports (giga_vm_attach_ports).
+ *
  * @param state VM instance.
  */
 void giga_vm_init(GigaVmState *state);
@@ -34,6 +226,9 @@ void giga_vm_init(GigaVmState *state);
  * @brief Load a program into VM memory as 16-bit instruction words.
  *
  * Words are stored little-endian: low byte at even address, high byte at odd.
+ * The program is also predecoded into state->decoded; ST instructions that
+ * write into the program region invalidate only the affected entry, so
+ * self-modifying programs stay correct.
  *
  * @param state          VM instance.
  * @param program_words  Pointer to instruction words.
@@ -53,6 +248,310 @@ int giga_vm_load_program(GigaVmState *state,
  */
 int giga_vm_fetch_word(const GigaVmState *state, uint16_t *out_word);
 
+/**
+ * @brief Fuse common instruction sequences into superinstructions.
+ *
+ * Rewrites the predecoded program so these sequences dispatch once:
+ * - MOVI Rx, imm; ADD Rd, Rs
+ * - LD Rx, [a]; ADD Rd, Rs; ST [b], Rs
+ * - SHL Rd; SHL Rd
+ *
+ * Fused handlers produce the same register, flag and memory state as the
+ * individual instructions, and the covered words keep their own entries so
+ * jumps into the middle of a sequence still work. Call after
+ * giga_vm_load_program; skipping the call leaves the program unfused.
+ *
+ * @param state VM instance with a loaded program.
+ * @return Number of superinstructions formed.
+ */
+size_t giga_vm_fuse_superinstructions(GigaVmState *state);
+
+/**
+ * @brief Drop the predecoded entry covering one byte of program memory.
+ *
+ * Call after the host writes directly into the program region of
+ * state->memory; the entry is re-decoded the next time it executes, and
+ * any superinstruction covering it falls back to unfused execution.
+ *
+ * @param state        VM instance.
+ * @param byte_address Address of the modified byte.
+ */
+void giga_vm_invalidate_code(GigaVmState *state, size_t byte_address);
+
+/**
+ * @brief Record a host write to state->memory for snapshot restores.
+ *
+ * ST, giga_vm_run and the JIT and AOT paths track their own stores; call
+ * this after writing memory directly, or giga_vm_snapshot_restore may keep
+ * the written bytes. giga_vm_invalidate_code marks its byte as well.
+ *
+ * @param state        VM instance.
+ * @param byte_address Address of the modified byte.
+ */
+void giga_vm_mark_dirty(GigaVmState *state, size_t byte_address);
+
+/**
+ * @brief Execute a single instruction at the current PC.
+ *
+ * @param state VM instance.
+ * @return GIGA_VM_STATUS_RUNNING if the instruction retired normally,
+ *         otherwise the halt or error status.
+ */
+GigaVmStatus giga_vm_step(GigaVmState *state);
+
+/**
+ * @brief Execute instructions until HALT, an error, or max_steps retire.
+ *
+ * Uses computed-goto threaded dispatch when the compiler supports it
+ * (GCC/Clang) and a portable switch loop otherwise. Define
+ * GIGA_VM_SWITCH_DISPATCH to force the switch loop.
+ *
+ * ALU instructions update flags_* from the AluResult; MOV, MOVI, LD, ST and
+ * JMP leave flags untouched. Register fields use their low 3 bits. Flags are
+ * evaluated lazily inside the loop and are current in the state on return.
+ *
+ * LD and ST address state->data_bank: bank 0 is state->memory, other banks
+ * live in state->banks. Selecting a bank the state has no memory for stops
+ * with GIGA_VM_STATUS_BANK_FAULT, as does starting with one selected.
+ *
+ * IN and OUT move nibbles through state->ports while the host fills and
+ * drains them from another thread. When a port has nothing to read or no
+ * room to write, the run stops with GIGA_VM_STATUS_IO_WAIT before the
+ * instruction, so running again resumes it.
+ *
+ * @param state     VM instance.
+ * @param max_steps Maximum number of instructions to retire.
+ * @return Reason execution stopped (never GIGA_VM_STATUS_RUNNING).
+ */
+GigaVmStatus giga_vm_run(GigaVmState *state, uint64_t max_steps);
+
+/**
+ * @brief Fill a separate instruction store.
+ *
+ * @param code           Output store.
+ * @param program_words  Instruction words.
+ * @param word_count     Number of words, at most GIGA_VM_MAX_CODE_WORDS.
+ * @return 0 on success, -1 on NULL arguments, -2 if it does not fit.
+ */
+int giga_vm_code_init(GigaVmCode *code, const uint16_t *program_words, size_t word_count);
+
+/**
+ * @brief Fuse superinstructions in an instruction store.
+ *
+ * Same sequences as giga_vm_fuse_superinstructions.
+ *
+ * @return Number of superinstructions formed.
+ */
+size_t giga_vm_code_fuse(GigaVmCode *code);
+
+/**
+ * @brief Execute code from a separate instruction store (Harvard mode).
+ *
+ * Same semantics as giga_vm_run, except that instructions come from code
+ * and the PC ranges over code->word_count words. The state's own program
+ * (loaded_program_words, decoded) is ignored and left alone, so state->memory
+ * is all data, and stores never modify code. Start from giga_vm_init without
+ * loading a program. Runs are not counted in the performance counters.
+ *
+ * @param state     VM instance holding registers, flags, PC and data.
+ * @param code      Instruction store.
+ * @param max_steps Maximum number of instructions to retire.
+ * @return Reason execution stopped (never GIGA_VM_STATUS_RUNNING).
+ */
+GigaVmStatus giga_vm_run_code(GigaVmState *state, const GigaVmCode *code, uint64_t max_steps);
+
+/**
+ * @brief Read the performance counters of a state.
+ *
+ * giga_vm_run and giga_vm_step only record where each basic block was
+ * entered and left (one pair of increments per JMP and per run) in
+ * state->block_edges. This call turns those into per-word execution counts,
+ * adds them to state->counters by each word's predecoded kind and clears the
+ * edges, so the cost is O(program words) per query rather than per
+ * instruction. Self-modifying code is folded before a word is re-decoded,
+ * so its executions are counted under the kind they ran as.
+ *
+ * Counters accumulate across runs and program loads until
+ * giga_vm_counters_reset and survive giga_vm_snapshot_restore. Only the
+ * interpreter maintains them: traced, profiled, packed, fork, batch,
+ * Harvard-mode, JIT and AOT execution is not counted, except instructions the JIT and AOT
+ * code hand back to giga_vm_run. BANK, BANKI, IN and OUT only count
+ * as retired.
+ *
+ * @param state VM instance.
+ * @param out   Receives the counters.
+ * @return 0 on success, -1 on NULL arguments.
+ */
+int giga_vm_counters(GigaVmState *state, GigaVmCounters *out);
+
+/**
+ * @brief Zero the performance counters of a state.
+ */
+void giga_vm_counters_reset(GigaVmState *state);
+
+/**
+ * @brief Build a shared program for packed instances.
+ *
+ * @param program        Output program.
+ * @param program_words  Instruction words.
+ * @param word_count     Number of words.
+ * @return 0 on success, -1 on NULL arguments, -2 if it does not fit.
+ */
+int giga_vm_program_init(GigaVmProgram *program, const uint16_t *program_words, size_t word_count);
+
+/**
+ * @brief Fuse superinstructions in a shared program.
+ *
+ * Same sequences as giga_vm_fuse_superinstructions. Instances that modify
+ * their own code fall back to unfused entries automatically.
+ *
+ * @return Number of superinstructions formed.
+ */
+size_t giga_vm_program_fuse(GigaVmProgram *program);
+
+/**
+ * @brief Reset a packed instance to the state right after loading program.
+ */
+void giga_vm_packed_init(GigaVmPackedState *state, const GigaVmProgram *program);
+
+static inline uint8_t giga_vm_packed_register(const GigaVmPackedState *state, size_t index) {
+    return (uint8_t)((state->registers >> (4u * (index & 7u))) & 0x0Fu);
+}
+
+static inline void giga_vm_packed_set_register(GigaVmPackedState *state, size_t index, uint8_t value) {
+    uint32_t shift = 4u * (uint32_t)(index & 7u);
+    state->registers = (state->registers & ~(0x0Fu << shift)) | ((uint32_t)(value & 0x0Fu) << shift);
+}
+
+/** @brief 4-bit value at a memory address (what LD reads). */
+static inline uint8_t giga_vm_packed_load(const GigaVmPackedState *state, size_t address) {
+    address %= GIGA_VM_MEMORY_SIZE;
+    return (uint8_t)((state->memory[address / 2u] >> (4u * (address % 2u))) & 0x0Fu);
+}
+
+/** @brief One flag, given as a GIGA_VM_PACKED_FLAG_* bit: 1 if set. */
+static inline uint8_t giga_vm_packed_flag(const GigaVmPackedState *state, uint8_t flag_bit) {
+    return (uint8_t)((state->flags & flag_bit) != 0);
+}
+
+/**
+ * @brief Store a 4-bit value as ST would, marking program bytes as written.
+ */
+void giga_vm_packed_store(GigaVmPackedState *state, const GigaVmProgram *program,
+                          size_t address, uint8_t value);
+
+/**
+ * @brief Execute a packed instance; same semantics as giga_vm_run.
+ *
+ * @param state     Packed instance.
+ * @param program   Program the instance was initialised with.
+ * @param max_steps Maximum number of instructions to retire.
+ * @return Reason execution stopped (never GIGA_VM_STATUS_RUNNING).
+ */
+GigaVmStatus giga_vm_packed_run(GigaVmPackedState *state, const GigaVmProgram *program,
+                                uint64_t max_steps);
+
+/**
+ * @brief Expand a packed instance into a full GigaVmState (unfused).
+ *
+ * @return 0 on success, -1 on NULL arguments.
+ */
+int giga_vm_packed_unpack(const GigaVmPackedState *state, const GigaVmProgram *program,
+                          GigaVmState *out);
+
+/**
+ * @brief Compress a full state that was loaded with program's words.
+ *
+ * Register and memory values are reduced to their low 4 bits. Packed
+ * instances only have bank 0 and no ports (see giga_vm_fork for what BANK,
+ * IN and OUT do then).
+ *
+ * @return 0 on success, -1 on NULL arguments, -2 if state->loaded_program_words
+ *         differs from program->word_count, -3 if the state has a bank
+ *         other than 0 selected.
+ */
+int giga_vm_packed_pack(const GigaVmState *state, const GigaVmProgram *program,
+                        GigaVmPackedState *out);
+
+/**
+ * @brief Capture a state for later restores and forks.
+ *
+ * Copies the state once and clears its dirty_blocks, so a following
+ * giga_vm_snapshot_restore into the same state only copies the blocks
+ * written in between. The snapshot starts with one reference.
+ *
+ * @param state VM instance.
+ * @return New snapshot, or NULL on NULL state or allocation failure.
+ */
+GigaVmSnapshot *giga_vm_snapshot_take(GigaVmState *state);
+
+/**
+ * @brief Drop one reference; the snapshot is freed with the last one.
+ *
+ * Every fork holds a reference until giga_vm_fork_release. Thread-safe.
+ */
+void giga_vm_snapshot_release(GigaVmSnapshot *snapshot);
+
+/**
+ * @brief Return a state to the contents of a snapshot.
+ *
+ * If the state was the one captured (or was last restored from this
+ * snapshot), only registers, flags, pc and the dirty memory blocks are
+ * copied, with the predecoded entries for dirty program blocks. Any other
+ * state gets a full copy. Either way dirty_blocks is cleared afterwards.
+ *
+ * The selected bank is restored, but banked memory is not part of a
+ * snapshot: the state keeps its own banks attachment and their contents.
+ *
+ * @return 0 on success, -1 on NULL arguments.
+ */
+int giga_vm_snapshot_restore(GigaVmState *state, const GigaVmSnapshot *snapshot);
+
+/**
+ * @brief Start a child of a snapshot in O(1).
+ *
+ * Copies registers, flags and pc and takes a reference on the snapshot; no
+ * memory is copied until the child stores. Children only have bank 0, so
+ * a BANK or BANKI selecting another bank stops them with
+ * GIGA_VM_STATUS_BANK_FAULT. They have no ports, so IN and OUT stop them
+ * with GIGA_VM_STATUS_PORT_FAULT.
+ *
+ * @return 0 on success, -1 on NULL arguments, -2 if the snapshot has a
+ *         bank other than 0 selected.
+ */
+int giga_vm_fork(GigaVmFork *child, GigaVmSnapshot *snapshot);
+
+/**
+ * @brief Release the child's snapshot reference. The child must not run again.
+ */
+void giga_vm_fork_release(GigaVmFork *child);
+
+/**
+ * @brief 4-bit value at a memory address (what LD reads in the child).
+ */
+uint8_t giga_vm_fork_load(const GigaVmFork *child, size_t address);
+
+/**
+ * @brief Store into the child as ST would, copying the block on first write.
+ */
+void giga_vm_fork_store(GigaVmFork *child, size_t address, uint8_t value);
+
+/**
+ * @brief Execute a child; same semantics as giga_vm_run on the captured state.
+ *
+ * @param child     Fork started with giga_vm_fork.
+ * @param max_steps Maximum number of instructions to retire.
+ * @return Reason execution stopped (never GIGA_VM_STATUS_RUNNING).
+ */
+GigaVmStatus giga_vm_fork_run(GigaVmFork *child, uint64_t max_steps);
+
+/**
+ * @brief Expand a child into a full GigaVmState (unfused, no snapshot base).
+ *
+ * @return 0 on success, -1 on NULL arguments.
+ */
+int giga_vm_fork_unpack(const GigaVmFork *child, GigaVmState *out);
+
 #endif /* GIGA_VM_H */
 
 
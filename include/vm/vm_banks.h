@@ -0,0 +1,74 @@
+#ifndef GIGA_VM_BANKS_H
+#define GIGA_VM_BANKS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "vm/vm.h"
+
+/*
+ * Sparse backing store for data banks 1 and up (GigaVmBanks).
+ *
+ * One anonymous mapping reserves GIGA_VM_MEMORY_SIZE bytes per bank, but
+ * the kernel only backs a page once a bank on it is stored to, so banks a
+ * program never touches cost address space and no resident memory. Bank 0
+ * is always VM memory and has no storage here. Banks start zeroed.
+ *
+ * A store may be attached to several states that do not run concurrently.
+ */
+
+/**
+ * @brief Reserve banks 1 to bank_count - 1.
+ *
+ * @param bank_count Number of banks including bank 0, 2 to GIGA_VM_BANK_COUNT.
+ * @return New store, or NULL on bad arguments or when the mapping fails.
+ */
+GigaVmBanks *giga_vm_banks_create(size_t bank_count);
+
+/**
+ * @brief Release a store and its mapping.
+ *
+ * @param banks Store (may be NULL). Detach it from every state first.
+ */
+void giga_vm_banks_destroy(GigaVmBanks *banks);
+
+/**
+ * @brief Number of banks the store was created for, bank 0 included.
+ */
+size_t giga_vm_banks_count(const GigaVmBanks *banks);
+
+/**
+ * @brief GIGA_VM_MEMORY_SIZE bytes of a bank.
+ *
+ * @return The bank's bytes, or NULL for bank 0, banks past the store and a
+ *         NULL store.
+ */
+uint8_t *giga_vm_banks_data(GigaVmBanks *banks, size_t bank);
+
+/**
+ * @brief Zero every bank, returning touched pages to the kernel.
+ *
+ * @param banks Store (may be NULL).
+ */
+void giga_vm_banks_clear(GigaVmBanks *banks);
+
+/**
+ * @brief Bytes of the store currently backed by memory.
+ *
+ * @return Resident bytes, a multiple of the page size.
+ */
+size_t giga_vm_banks_resident_bytes(const GigaVmBanks *banks);
+
+/**
+ * @brief Give a state banks 1 and up.
+ *
+ * The state does not own the store. Detach with NULL, which does not
+ * change data_bank; a run that starts with an unavailable bank selected
+ * stops with GIGA_VM_STATUS_BANK_FAULT.
+ *
+ * @param state VM instance.
+ * @param banks Store, or NULL to detach.
+ */
+void giga_vm_attach_banks(GigaVmState *state, GigaVmBanks *banks);
+
+#endif /* GIGA_VM_BANKS_H */
@@ -0,0 +1,133 @@
+#ifndef GIGA_VM_BATCH_H
+#define GIGA_VM_BATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "vm/vm.h"
+
+/**
+ * @brief Vector kernels available to giga_vm_batch_run.
+ */
+typedef enum {
+    GIGA_VM_BATCH_KERNEL_SCALAR = 0, /** portable per-lane loop */
+    GIGA_VM_BATCH_KERNEL_SSE2,       /** 16 lanes per vector (x86-64) */
+    GIGA_VM_BATCH_KERNEL_AVX2        /** 32 lanes per vector (x86-64 with AVX2) */
+} GigaVmBatchKernel;
+
+/**
+ * @brief Many VM instances running one program in lock-step.
+ *
+ * State is kept as structure-of-arrays so one instruction is applied to 16
+ * or 32 lanes per vector operation:
+ * - register r of lane i is registers[r * lane_stride + i];
+ * - memory byte a of lane i is memory[a * lane_stride + i];
+ * - each flag is a bitmask, lane i at bit i % 64 of word i / 64.
+ * lane_stride is lane_count rounded up to a multiple of 64; padding lanes
+ * are never active.
+ *
+ * Lanes in active_mask share one program counter and one copy of the
+ * program. Control flow is data-independent in this ISA, so lanes only
+ * diverge when a ST into the program region writes different values in
+ * different lanes. The shared copy then takes the value written by the
+ * first active lane; lanes that wrote something else are cleared from
+ * active_mask and finished by giga_vm_run, one lane at a time.
+ *
+ * Lanes only have data bank 0: a BANK or BANKI selecting another bank
+ * stops them with GIGA_VM_STATUS_BANK_FAULT. Lanes have no ports either,
+ * so IN and OUT stop them with GIGA_VM_STATUS_PORT_FAULT.
+ *
+ * Fill inputs through the register/memory rows directly or with
+ * giga_vm_batch_set_lane; read results with giga_vm_batch_get_lane or the
+ * rows. Other fields are internal.
+ */
+typedef struct {
+    size_t lane_count;                 /**number of lanes in use */
+    size_t lane_stride;                /**lane_count rounded up to a multiple of 64 */
+    uint8_t *registers;                /**GIGA_VM_REGISTER_COUNT rows of lane_stride bytes */
+    uint8_t *memory;                   /**GIGA_VM_MEMORY_SIZE rows of lane_stride bytes */
+    uint64_t *flags_zero;              /**lane_stride / 64 words per flag */
+    uint64_t *flags_carry;
+    uint64_t *flags_negative;
+    uint64_t *flags_overflow;
+    uint64_t *active_mask;             /**lanes executing in lock-step */
+    uint8_t *lane_mask;                /**active_mask expanded to 0x00 / 0xFF bytes */
+    uint16_t *program_counter;         /**per-lane PC */
+    uint8_t *status;                   /**per-lane GigaVmStatus of the last run */
+    uint64_t *lane_budget;             /**steps left for lanes that leave lock-step mid-run */
+
+    uint16_t shared_program_counter;   /**PC of the lock-step lanes */
+    size_t word_count;                 /**program length in words */
+    GigaInstruction instructions[GIGA_VM_MAX_PROGRAM_WORDS]; /**lock-step program, decoded */
+    GigaVmBatchKernel kernel;          /**kernel used by giga_vm_batch_run */
+    GigaVmState *scratch;              /**state used to run diverged lanes */
+} GigaVmBatch;
+
+/**
+ * @brief Best kernel supported by the running CPU.
+ */
+GigaVmBatchKernel giga_vm_batch_best_kernel(void);
+
+/**
+ * @brief Allocate a batch whose lanes all start as a freshly loaded program.
+ *
+ * Every lane matches giga_vm_init followed by giga_vm_load_program. The
+ * best kernel for this CPU is selected.
+ *
+ * @param batch         Batch to initialise.
+ * @param lane_count    Number of lanes (at least 1).
+ * @param program_words Instruction words.
+ * @param word_count    Number of words.
+ * @return 0 on success, -1 on invalid arguments, -2 if the program does not
+ *         fit in memory, -3 on allocation failure.
+ */
+int giga_vm_batch_init(GigaVmBatch *batch,
+                       size_t lane_count,
+                       const uint16_t *program_words,
+                       size_t word_count);
+
+/**
+ * @brief Release memory owned by a batch.
+ *
+ * @param batch Batch to free (may be NULL).
+ */
+void giga_vm_batch_free(GigaVmBatch *batch);
+
+/**
+ * @brief Select the kernel used by giga_vm_batch_run.
+ *
+ * @return 0 on success, -1 if the kernel is not supported here.
+ */
+int giga_vm_batch_set_kernel(GigaVmBatch *batch, GigaVmBatchKernel kernel);
+
+/**
+ * @brief Copy a scalar state into one lane.
+ *
+ * The lane stays in lock-step only if its PC and program words match the
+ * lock-step lanes; otherwise it is run on its own.
+ *
+ * @return 0 on success, -1 on invalid arguments, a state holding a program
+ *         of a different length or one with a bank other than 0 selected.
+ */
+int giga_vm_batch_set_lane(GigaVmBatch *batch, size_t lane, const GigaVmState *state);
+
+/**
+ * @brief Copy one lane out into a runnable scalar state.
+ *
+ * @return 0 on success, -1 on invalid arguments.
+ */
+int giga_vm_batch_get_lane(const GigaVmBatch *batch, size_t lane, GigaVmState *state);
+
+/**
+ * @brief Run every lane for up to max_steps instructions.
+ *
+ * Each lane ends with the same registers, flags, memory, PC and status that
+ * giga_vm_run would produce for it; statuses are stored in status[].
+ *
+ * @param batch     Initialised batch.
+ * @param max_steps Maximum number of instructions each lane retires.
+ * @return 0 on success, -1 on invalid arguments.
+ */
+int giga_vm_batch_run(GigaVmBatch *batch, uint64_t max_steps);
+
+#endif /* GIGA_VM_BATCH_H */
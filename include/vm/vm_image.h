@@ -0,0 +1,215 @@
+#ifndef GIGA_VM_IMAGE_H
+#define GIGA_VM_IMAGE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "vm/vm.h"
+
+/*
+ * Bytecode images: the .gbc container (GigaVmImage).
+ *
+ * A .gbc file holds an assembled program ready to run. It has a
+ * GigaVmImageHeader and then these sections, each starting on a
+ * GIGA_VM_IMAGE_ALIGN boundary:
+ *
+ *   code     word_count instruction words
+ *   decoded  word_count + 1 predecoded entries, the last one ending the
+ *            program, fused if GIGA_VM_IMAGE_FUSED is set
+ *   data     initial VM memory, at most GIGA_VM_MEMORY_SIZE bytes
+ *   symbols  symbol_count GigaVmImageSymbol
+ *   names    symbol names, each followed by a NUL
+ *   lines    source line of each word as uint32_t, or empty
+ *
+ * Fields are in host byte order; byte_order rejects files written on a
+ * host of the other order. Opening maps the file read-only and checks the
+ * header and the decoded entries. giga_vm_run_image then runs the mapped
+ * entries directly, so a program's pages are only read when it runs and no
+ * copy of its code is made.
+ */
+
+#define GIGA_VM_IMAGE_MAGIC "GBC\x1a"
+#define GIGA_VM_IMAGE_VERSION 1u
+#define GIGA_VM_IMAGE_BYTE_ORDER 0x0102u
+#define GIGA_VM_IMAGE_ALIGN 64u
+
+/** @brief Header flag: the decoded section has superinstructions. */
+#define GIGA_VM_IMAGE_FUSED 0x1u
+
+/**
+ * @brief Sections of an image, in file order.
+ */
+typedef enum {
+    GIGA_VM_IMAGE_CODE = 0,
+    GIGA_VM_IMAGE_DECODED,
+    GIGA_VM_IMAGE_DATA,
+    GIGA_VM_IMAGE_SYMBOLS,
+    GIGA_VM_IMAGE_NAMES,
+    GIGA_VM_IMAGE_LINES,
+    GIGA_VM_IMAGE_SECTION_COUNT
+} GigaVmImageSectionKind;
+
+/**
+ * @brief Where a section lies in the file.
+ */
+typedef struct {
+    uint64_t offset;                   /**from the start of the file, a multiple of GIGA_VM_IMAGE_ALIGN */
+    uint64_t bytes;                    /**section length */
+} GigaVmImageSection;
+
+/**
+ * @brief First bytes of a .gbc file.
+ */
+typedef struct {
+    char magic[4];                     /**GIGA_VM_IMAGE_MAGIC */
+    uint16_t version;                  /**GIGA_VM_IMAGE_VERSION */
+    uint16_t byte_order;               /**GIGA_VM_IMAGE_BYTE_ORDER as written by the host */
+    uint32_t decode_abi;               /**GIGA_VM_DECODE_ABI of the writer */
+    uint32_t flags;                    /**GIGA_VM_IMAGE_FUSED */
+    uint32_t word_count;               /**instruction words, at most GIGA_VM_MAX_CODE_WORDS */
+    uint32_t symbol_count;             /**entries in the symbols section */
+    uint64_t file_bytes;               /**whole file, header included */
+    GigaVmImageSection sections[GIGA_VM_IMAGE_SECTION_COUNT];
+} GigaVmImageHeader;
+
+/**
+ * @brief One label in the symbols section.
+ */
+typedef struct {
+    uint32_t name_offset;              /**into the names section */
+    uint32_t name_length;              /**bytes, without the NUL */
+    uint32_t address;                  /**instruction word index */
+} GigaVmImageSymbol;
+
+/**
+ * @brief Label given to giga_vm_image_write.
+ */
+typedef struct {
+    const char *name;                  /**not NUL-terminated */
+    size_t name_length;
+    uint16_t address;                  /**instruction word index */
+} GigaVmImageLabel;
+
+/**
+ * @brief Everything giga_vm_image_write stores.
+ */
+typedef struct {
+    const uint16_t *words;             /**instruction words, host-endian */
+    size_t word_count;                 /**at most GIGA_VM_MAX_CODE_WORDS */
+    const uint8_t *data;               /**initial VM memory, or NULL */
+    size_t data_bytes;                 /**at most GIGA_VM_MEMORY_SIZE */
+    const GigaVmImageLabel *labels;    /**symbols, or NULL */
+    size_t label_count;
+    const size_t *source_lines;        /**source line of each word, or NULL */
+    int fuse;                          /**store superinstructions */
+} GigaVmImageSource;
+
+/**
+ * @brief An opened image. The pointers lead into the file mapping.
+ */
+typedef struct {
+    const GigaVmImageHeader *header;
+    const uint16_t *words;             /**code section */
+    size_t word_count;
+    const GigaVmDecodedInstruction *decoded; /**decoded section, word_count + 1 entries */
+    const uint8_t *data;               /**data section */
+    size_t data_bytes;
+    const GigaVmImageSymbol *symbols;  /**symbols section */
+    size_t symbol_count;
+    const char *names;                 /**names section */
+    size_t names_bytes;
+    const uint32_t *lines;             /**lines section, or NULL */
+    void *mapping;                     /**whole file, or NULL if not owned */
+    size_t mapping_bytes;
+} GigaVmImage;
+
+/**
+ * @brief Write a program as a .gbc file.
+ *
+ * The file is written under a temporary name and renamed into place, so
+ * readers never see a partial image.
+ *
+ * @return 0 on success, -1 on bad arguments, -2 on I/O errors.
+ */
+int giga_vm_image_write(const char *path, const GigaVmImageSource *source);
+
+/**
+ * @brief Map a .gbc file and check it.
+ *
+ * @param path  File to open.
+ * @param image Receives the image; close it with giga_vm_image_close.
+ * @return 0 on success, -1 on bad arguments, -2 if the file cannot be
+ *         read or mapped, -3 if it is not a valid image for this build.
+ */
+int giga_vm_image_open(const char *path, GigaVmImage *image);
+
+/**
+ * @brief Check an image already in memory, such as one read by the host.
+ *
+ * image points into bytes, which must be GIGA_VM_IMAGE_ALIGN-aligned and
+ * outlive the image; giga_vm_image_close does not free them.
+ *
+ * @return 0 on success, -1 on bad arguments, -3 if bytes are not a valid
+ *         image for this build.
+ */
+int giga_vm_image_view(const void *bytes, size_t byte_count, GigaVmImage *image);
+
+/**
+ * @brief Unmap an image opened by giga_vm_image_open.
+ *
+ * @param image Image (may be NULL).
+ */
+void giga_vm_image_close(GigaVmImage *image);
+
+/**
+ * @brief Find a symbol by name.
+ *
+ * @return Its word index, or -1 if the image has no such symbol.
+ */
+long giga_vm_image_find_symbol(const GigaVmImage *image, const char *name);
+
+/**
+ * @brief Source line of a word.
+ *
+ * @return The line, or 0 if the image has no line table or pc is past it.
+ */
+size_t giga_vm_image_source_line(const GigaVmImage *image, size_t pc);
+
+/**
+ * @brief Whether predecoded entries are safe to run.
+ *
+ * Checks every entry giga_vm_run_image could reach: handler numbers,
+ * register indices, addresses, ports and branch targets, the operands of
+ * superinstructions and the sentinel after the last word. Images are
+ * checked with this when they are opened.
+ *
+ * @param decoded    word_count + 1 entries.
+ * @param word_count At most GIGA_VM_MAX_CODE_WORDS.
+ * @return 1 if they are, 0 otherwise.
+ */
+int giga_vm_image_decoded_valid(const GigaVmDecodedInstruction *decoded, size_t word_count);
+
+/**
+ * @brief Prepare a state to run an image.
+ *
+ * Resets the state as giga_vm_init does (detaching banks and ports) and
+ * copies the data section into memory. The code stays in the mapping.
+ *
+ * @return 0 on success, -1 on NULL arguments.
+ */
+int giga_vm_load_image(GigaVmState *state, const GigaVmImage *image);
+
+/**
+ * @brief Execute an image's code (Harvard mode).
+ *
+ * Same as giga_vm_run_code with the image as instruction store: the
+ * mapped entries are run in place, and state->memory is all data.
+ *
+ * @param state     VM instance, prepared with giga_vm_load_image.
+ * @param image     Opened image.
+ * @param max_steps Maximum number of instructions to retire.
+ * @return Reason execution stopped (never GIGA_VM_STATUS_RUNNING).
+ */
+GigaVmStatus giga_vm_run_image(GigaVmState *state, const GigaVmImage *image, uint64_t max_steps);
+
+#endif /* GIGA_VM_IMAGE_H */
@@ -0,0 +1,61 @@
+#ifndef GIGA_VM_JIT_H
+#define GIGA_VM_JIT_H
+
+#include <stdint.h>
+
+#include "vm/vm.h"
+
+/**
+ * @brief Basic-block JIT translating Giga programs to native x86-64 code.
+ *
+ * Straight-line blocks are compiled on first execution into mmap'd pages.
+ * The eight VM registers live in host registers inside translated code and
+ * flags are recorded lazily (last flag-setting op and its operands) and
+ * materialised into flags_* when control returns to C. Blocks ending in JMP
+ * are chained directly to their target once it is compiled.
+ *
+ * Instructions the translator does not handle (ST into the program region,
+ * ADC/SBC, IN/OUT, HALT, undefined opcodes, out-of-range jumps) end the block and run one
+ * step in the interpreter. A self-modifying store that changes the program
+ * flushes all translated blocks. Translated LD and ST only address bank 0,
+ * so while BANK or BANKI has another bank selected the interpreter runs.
+ */
+typedef struct GigaVmJit GigaVmJit;
+
+/**
+ * @brief Report whether this build can generate native code.
+ *
+ * @return 1 on x86-64 Unix builds with the JIT enabled, 0 otherwise.
+ */
+int giga_vm_jit_available(void);
+
+/**
+ * @brief Create a JIT instance with its own code cache.
+ *
+ * @return New JIT, or NULL when unavailable or out of memory.
+ */
+GigaVmJit *giga_vm_jit_create(void);
+
+/**
+ * @brief Release a JIT instance and its executable pages.
+ *
+ * @param jit JIT instance (may be NULL).
+ */
+void giga_vm_jit_destroy(GigaVmJit *jit);
+
+/**
+ * @brief Execute like giga_vm_run, using translated code where possible.
+ *
+ * Produces the same register, flag, memory, PC and status results as
+ * giga_vm_run. The code cache follows the program loaded in @p state and is
+ * rebuilt when a different program is run. With a NULL @p jit this is
+ * giga_vm_run.
+ *
+ * @param jit       JIT instance.
+ * @param state     VM instance with a loaded program.
+ * @param max_steps Maximum number of instructions to retire.
+ * @return Reason execution stopped.
+ */
+GigaVmStatus giga_vm_jit_run(GigaVmJit *jit, GigaVmState *state, uint64_t max_steps);
+
+#endif /* GIGA_VM_JIT_H */
@@ -0,0 +1,171 @@
+#ifndef GIGA_VM_PORTS_H
+#define GIGA_VM_PORTS_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "vm/vm.h"
+
+/*
+ * I/O ports behind IN and OUT (GigaVmPorts).
+ *
+ * Each of the GIGA_VM_PORT_COUNT ports has an input ring the host fills and
+ * IN drains, and an output ring OUT fills and the host drains. A ring holds
+ * one nibble per byte and is single-producer, single-consumer and lock-free,
+ * so a host thread can stream through it while another thread is inside
+ * giga_vm_run. The host can work on a ring in place: a span call returns
+ * the contiguous bytes it may write or read, and a commit publishes them.
+ *
+ * All rings live in one anonymous mapping; pages are backed when first
+ * written, so rings a program does not use cost no resident memory.
+ */
+
+/**
+ * @brief One single-producer, single-consumer ring of nibbles.
+ *
+ * head and tail count bytes ever consumed and produced. Each side keeps a
+ * private copy of the other's index and only re-reads it when the copy says
+ * the ring is empty or full.
+ */
+typedef struct {
+    uint8_t *data;                     /**capacity bytes */
+    size_t mask;                       /**capacity - 1; the capacity is a power of two */
+    _Alignas(64) _Atomic size_t head;  /**consumer position */
+    size_t cached_tail;                /**consumer's copy of tail */
+    _Alignas(64) _Atomic size_t tail;  /**producer position */
+    size_t cached_head;                /**producer's copy of head */
+} GigaVmRing;
+
+/**
+ * @brief Rings of every port. Create with giga_vm_ports_create.
+ */
+struct GigaVmPorts {
+    GigaVmRing input[GIGA_VM_PORT_COUNT];  /**host to VM, read by IN */
+    GigaVmRing output[GIGA_VM_PORT_COUNT]; /**VM to host, written by OUT */
+    uint8_t *mapping;                      /**backing of all rings */
+    size_t mapping_bytes;
+};
+
+/**
+ * @brief Create empty rings for every port.
+ *
+ * @param capacity Bytes per ring, a power of two of at least 2.
+ * @return New ports, or NULL on bad arguments or when the mapping fails.
+ */
+GigaVmPorts *giga_vm_ports_create(size_t capacity);
+
+/**
+ * @brief Release ports and their mapping.
+ *
+ * @param ports Ports (may be NULL). Detach them from every state first.
+ */
+void giga_vm_ports_destroy(GigaVmPorts *ports);
+
+/**
+ * @brief Empty every ring. Only call while nothing else uses the ports.
+ *
+ * @param ports Ports (may be NULL).
+ */
+void giga_vm_ports_reset(GigaVmPorts *ports);
+
+/**
+ * @brief Give a state ports for IN and OUT.
+ *
+ * The state does not own them. A state runs IN/OUT on one thread at a
+ * time, so attach one set of ports to one running state.
+ *
+ * @param state VM instance.
+ * @param ports Ports, or NULL to detach.
+ */
+void giga_vm_attach_ports(GigaVmState *state, GigaVmPorts *ports);
+
+/** @brief Bytes the consumer could read now. */
+static inline size_t giga_vm_ring_count(GigaVmRing *ring) {
+    return atomic_load_explicit(&ring->tail, memory_order_acquire) -
+           atomic_load_explicit(&ring->head, memory_order_acquire);
+}
+
+/**
+ * @brief Append one byte (producer side).
+ *
+ * @return 1 if it was appended, 0 if the ring is full.
+ */
+static inline int giga_vm_ring_push(GigaVmRing *ring, uint8_t value) {
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    if (tail - ring->cached_head > ring->mask) {
+        ring->cached_head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        if (tail - ring->cached_head > ring->mask) {
+            return 0;
+        }
+    }
+    ring->data[tail & ring->mask] = value;
+    atomic_store_explicit(&ring->tail, tail + 1u, memory_order_release);
+    return 1;
+}
+
+/**
+ * @brief Take one byte (consumer side).
+ *
+ * @return 1 if a byte was taken, 0 if the ring is empty.
+ */
+static inline int giga_vm_ring_pop(GigaVmRing *ring, uint8_t *value) {
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    if (head == ring->cached_tail) {
+        ring->cached_tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+        if (head == ring->cached_tail) {
+            return 0;
+        }
+    }
+    *value = ring->data[head & ring->mask];
+    atomic_store_explicit(&ring->head, head + 1u, memory_order_release);
+    return 1;
+}
+
+/**
+ * @brief Contiguous free bytes the producer may fill in place.
+ *
+ * @param ring Ring.
+ * @param out  Receives where to write.
+ * @return Number of bytes at *out, 0 if the ring is full. Fewer than are
+ *         free when the space wraps; commit and call again for the rest.
+ */
+static inline size_t giga_vm_ring_write_span(GigaVmRing *ring, uint8_t **out) {
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    ring->cached_head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    size_t free_bytes = ring->mask + 1u - (tail - ring->cached_head);
+    size_t to_end = ring->mask + 1u - (tail & ring->mask);
+    *out = ring->data + (tail & ring->mask);
+    return (free_bytes < to_end) ? free_bytes : to_end;
+}
+
+/** @brief Publish count bytes written after giga_vm_ring_write_span. */
+static inline void giga_vm_ring_write_commit(GigaVmRing *ring, size_t count) {
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    atomic_store_explicit(&ring->tail, tail + count, memory_order_release);
+}
+
+/**
+ * @brief Contiguous bytes the consumer may read in place.
+ *
+ * @param ring Ring.
+ * @param out  Receives where to read.
+ * @return Number of bytes at *out, 0 if the ring is empty. Fewer than are
+ *         queued when the data wraps; commit and call again for the rest.
+ */
+static inline size_t giga_vm_ring_read_span(GigaVmRing *ring, const uint8_t **out) {
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    ring->cached_tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    size_t used = ring->cached_tail - head;
+    size_t to_end = ring->mask + 1u - (head & ring->mask);
+    *out = ring->data + (head & ring->mask);
+    return (used < to_end) ? used : to_end;
+}
+
+/** @brief Release count bytes read after giga_vm_ring_read_span. */
+static inline void giga_vm_ring_read_commit(GigaVmRing *ring, size_t count) {
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    atomic_store_explicit(&ring->head, head + count, memory_order_release);
+}
+
+#endif /* GIGA_VM_PORTS_H */
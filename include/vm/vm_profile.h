@@ -0,0 +1,88 @@
+#ifndef GIGA_VM_PROFILE_H
+#define GIGA_VM_PROFILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "vm/vm.h"
+
+/** @brief Slots in the per-PC arrays: every program word plus the end sentinel. */
+#define GIGA_VM_PROFILE_PC_SLOTS (GIGA_VM_MAX_PROGRAM_WORDS + 1)
+
+/** @brief Opcode histogram size, one slot per GigaOpcode. */
+#define GIGA_VM_PROFILE_OPCODE_SLOTS 16
+
+/**
+ * @brief Execution profile filled by giga_vm_run_profiled.
+ *
+ * Flat arrays indexed by pc or opcode, so recording is one increment each.
+ * Counts accumulate across runs until giga_vm_profile_reset.
+ */
+typedef struct {
+    uint64_t pc_counts[GIGA_VM_PROFILE_PC_SLOTS];   /**times the word at pc retired (never the end sentinel) */
+    uint64_t jump_counts[GIGA_VM_PROFILE_PC_SLOTS]; /**taken JMPs and branches from pc to its target */
+    uint64_t opcode_counts[GIGA_VM_PROFILE_OPCODE_SLOTS]; /**dispatches per GigaOpcode (EXT sub-opcodes under EXT) */
+} GigaVmProfile;
+
+/**
+ * @brief Straight-line run of words that executed the same number of times.
+ */
+typedef struct {
+    uint16_t first_pc;                         /**first word of the block */
+    uint16_t last_pc;                          /**last word, inclusive */
+    uint64_t entry_count;                      /**times the block was entered */
+    uint64_t instruction_count;                /**words dispatched inside the block */
+} GigaVmHotBlock;
+
+/**
+ * @brief Clear all counters.
+ */
+void giga_vm_profile_reset(GigaVmProfile *profile);
+
+/**
+ * @brief Execute like giga_vm_run while counting into a profile.
+ *
+ * Runs a separate instantiation of the run loop with its own dispatch
+ * table, so giga_vm_run pays nothing for it. Superinstructions are not
+ * used, so each word is counted on its own. HALT and the word that caused
+ * an error are counted too. Defined in vm.c so it shares the run loop.
+ *
+ * @param state     VM instance.
+ * @param max_steps Maximum number of instructions to retire.
+ * @param profile   Counters to add to.
+ * @return Reason execution stopped, or GIGA_VM_STATUS_INVALID_STATE on NULL
+ *         arguments.
+ */
+GigaVmStatus giga_vm_run_profiled(GigaVmState *state, uint64_t max_steps, GigaVmProfile *profile);
+
+/**
+ * @brief Split the profiled program into blocks, hottest first.
+ *
+ * A block ends after a JMP, branch or HALT, before a word some JMP or
+ * branch in the program targets, and where the execution count changes. Blocks that never ran
+ * are left out. Blocks are sorted by instruction_count, then by first_pc.
+ *
+ * @param profile    Counters from giga_vm_run_profiled.
+ * @param state      State holding the profiled program.
+ * @param blocks     Output array.
+ * @param max_blocks Capacity of blocks.
+ * @return Number of blocks written.
+ */
+size_t giga_vm_profile_hot_blocks(const GigaVmProfile *profile, const GigaVmState *state,
+                                  GigaVmHotBlock *blocks, size_t max_blocks);
+
+/**
+ * @brief Print a hot-block listing, taken jumps and the opcode histogram.
+ *
+ * @param profile      Counters from giga_vm_run_profiled.
+ * @param state        State holding the profiled program.
+ * @param source_lines Source line of each word (GigaAssemblerResult), or NULL.
+ * @param max_blocks   Blocks to list.
+ * @param output       Stream to write to.
+ * @return 0 on success, -1 on NULL arguments.
+ */
+int giga_vm_profile_write_report(const GigaVmProfile *profile, const GigaVmState *state,
+                                 const size_t *source_lines, size_t max_blocks, FILE *output);
+
+#endif /* GIGA_VM_PROFILE_H */
@@ -0,0 +1,178 @@
+#ifndef GIGA_VM_TRACE_H
+#define GIGA_VM_TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "vm/vm.h"
+
+/*
+ * Execution trace format.
+ *
+ * A trace is a byte stream with one record per retired instruction. Each
+ * record holds only what that instruction changed, and the pc advances by
+ * one unless the record says otherwise (an untaken branch is a NOP):
+ *
+ *   0rrrvvvv              R<r> = v (MOV, MOVI, LD)
+ *   1000ffff 0rrrvvvv     flags = f, R<r> = v (ALU ops, ADC, SBC)
+ *   0x90                  no change (NOP)
+ *   0x91 aa vv            memory[a] = v (ST)
+ *   0x92 <varint>         pc = pc + 1 + zigzag-decoded delta (JMP, taken branch)
+ *   0x95 ff               flags = f (CMP)
+ *
+ * Flags use the GIGA_VM_PACKED_FLAG_* bits. Two records carry no instruction:
+ *
+ *   0x93 <keyframe>       full state; replay can start here
+ *   0x94 ss pppp          run stopped with status s, pc = p (HALT, errors)
+ *
+ * A keyframe holds the instruction index (8 bytes), registers (8), flags
+ * (1), pc (2), loaded program words (1) and memory (256 bytes). Multi-byte
+ * fields are little-endian, and varints use 7 bits per byte, low bits first.
+ */
+
+#define GIGA_VM_TRACE_TAG_ALU      0x80u
+#define GIGA_VM_TRACE_TAG_NOP      0x90u
+#define GIGA_VM_TRACE_TAG_STORE    0x91u
+#define GIGA_VM_TRACE_TAG_JUMP     0x92u
+#define GIGA_VM_TRACE_TAG_KEYFRAME 0x93u
+#define GIGA_VM_TRACE_TAG_STOP     0x94u
+#define GIGA_VM_TRACE_TAG_FLAGS    0x95u
+
+/** @brief Longest instruction record, in bytes. */
+#define GIGA_VM_TRACE_MAX_RECORD_BYTES 3u
+
+/** @brief Size of a stop record, in bytes. */
+#define GIGA_VM_TRACE_STOP_BYTES 4u
+
+/** @brief Size of a keyframe record, in bytes. */
+#define GIGA_VM_TRACE_KEYFRAME_BYTES (1u + 8u + GIGA_VM_REGISTER_COUNT + 1u + 2u + 1u + GIGA_VM_MEMORY_SIZE)
+
+/** @brief Retired instructions between keyframes written by a trace writer. */
+#define GIGA_VM_TRACE_KEYFRAME_INTERVAL 16384u
+
+/** @brief Smallest ring a trace writer accepts, in bytes of records. */
+#define GIGA_VM_TRACE_MIN_CAPACITY (256u * 1024u)
+
+/**
+ * @brief Run like giga_vm_run, appending a trace record per retired instruction.
+ *
+ * Superinstructions are not used, so each word gets its own record. A run
+ * that ends with HALT or an error also appends a stop record. Defined in
+ * vm.c so it shares the interpreter's run loop.
+ *
+ * @param state        VM instance.
+ * @param max_steps    Maximum number of instructions to retire.
+ * @param records      Output; needs room for max_steps *
+ *                     GIGA_VM_TRACE_MAX_RECORD_BYTES + GIGA_VM_TRACE_STOP_BYTES.
+ * @param record_bytes Output: bytes appended.
+ * @param retired      Output: instructions retired (stop records excluded).
+ * @return Reason execution stopped (never GIGA_VM_STATUS_RUNNING).
+ */
+GigaVmStatus giga_vm_run_traced(GigaVmState *state, uint64_t max_steps, uint8_t *records,
+                                size_t *record_bytes, uint64_t *retired);
+
+/**
+ * @brief Trace file being written; see giga_vm_trace_create.
+ */
+typedef struct GigaVmTraceWriter GigaVmTraceWriter;
+
+/**
+ * @brief Trace file opened for replay; see giga_vm_replay_open.
+ */
+typedef struct GigaVmReplay GigaVmReplay;
+
+/**
+ * @brief Create (or truncate) a trace file and map it.
+ *
+ * Records go into a ring of capacity bytes after a header holding the
+ * write position and an index of keyframes. When the ring is full, the
+ * oldest records are overwritten. Records are encoded into an in-memory
+ * batch and copied into the mapping in large blocks.
+ *
+ * @param path     File to create.
+ * @param capacity Ring size in bytes, at least GIGA_VM_TRACE_MIN_CAPACITY.
+ * @return Writer, or NULL on invalid arguments or I/O failure.
+ */
+GigaVmTraceWriter *giga_vm_trace_create(const char *path, size_t capacity);
+
+/**
+ * @brief Run a state like giga_vm_run and record every retired instruction.
+ *
+ * May be called repeatedly, including on different states. A keyframe is
+ * written every GIGA_VM_TRACE_KEYFRAME_INTERVAL instructions, and also
+ * whenever the state differs from where the previous call left it.
+ *
+ * @return Reason execution stopped, or GIGA_VM_STATUS_INVALID_STATE on NULL
+ *         arguments.
+ */
+GigaVmStatus giga_vm_trace_run(GigaVmTraceWriter *writer, GigaVmState *state, uint64_t max_steps);
+
+/**
+ * @brief Total instructions recorded so far.
+ */
+uint64_t giga_vm_trace_instruction_count(const GigaVmTraceWriter *writer);
+
+/**
+ * @brief Copy pending records into the file and update its header.
+ *
+ * @return 0 on success, -1 on NULL writer.
+ */
+int giga_vm_trace_flush(GigaVmTraceWriter *writer);
+
+/**
+ * @brief Flush, unmap and close; frees the writer.
+ *
+ * @return 0 on success, -1 if syncing or closing the file failed.
+ */
+int giga_vm_trace_close(GigaVmTraceWriter *writer);
+
+/**
+ * @brief Open a trace file written by a GigaVmTraceWriter.
+ *
+ * @return Replay handle, or NULL if the file is missing or not a trace.
+ */
+GigaVmReplay *giga_vm_replay_open(const char *path);
+
+/**
+ * @brief Unmap and free a replay handle.
+ */
+void giga_vm_replay_close(GigaVmReplay *replay);
+
+/**
+ * @brief Oldest instruction index that can still be reached.
+ *
+ * 0 until the ring wraps. After that it is the oldest keyframe that has
+ * not been overwritten.
+ */
+uint64_t giga_vm_replay_first_instruction(const GigaVmReplay *replay);
+
+/**
+ * @brief Number of instructions in the trace; seek accepts up to this index.
+ */
+uint64_t giga_vm_replay_instruction_count(const GigaVmReplay *replay);
+
+/**
+ * @brief Rebuild the state after instruction_index retired instructions.
+ *
+ * Starts at the closest keyframe at or before the index and applies records
+ * from there, so a seek costs at most GIGA_VM_TRACE_KEYFRAME_INTERVAL
+ * records. Stop records and keyframes right after the index are applied as
+ * well, so out is the state the next recorded instruction ran from. out is
+ * a loaded, runnable state.
+ *
+ * @return 0 on success, -1 on NULL arguments, -2 if the index is outside
+ *         [first_instruction, instruction_count], -3 on a malformed trace.
+ */
+int giga_vm_replay_seek(GigaVmReplay *replay, uint64_t instruction_index, GigaVmState *out);
+
+/**
+ * @brief Apply the next recorded instruction to a state from giga_vm_replay_seek.
+ *
+ * Like a seek, also applies the stop records and keyframes that follow it.
+ *
+ * @return 0 on success, 1 at the end of the trace, -1 on NULL arguments or
+ *         without a successful seek, -3 on a malformed trace.
+ */
+int giga_vm_replay_step(GigaVmReplay *replay, GigaVmState *state);
+
+#endif /* GIGA_VM_TRACE_H */
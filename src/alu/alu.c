@@ -57,6 +57,29 @@ AluResult alu_sub(uint8_t operand_a, uint8_t operand_b) {
     return operation_result;
 }
 
+AluResult alu_adc(uint8_t operand_a, uint8_t operand_b, uint8_t carry_in) {
+    AluResult operation_result = {0, 0, 0, 0, 0};
+    uint8_t operand_a_4bit = mask4(operand_a);
+    uint8_t operand_b_4bit = mask4(operand_b);
+    uint8_t raw_sum = (uint8_t)(operand_a_4bit + operand_b_4bit + (carry_in ? 1u : 0u));
+
+    operation_result.result = mask4(raw_sum);
+    operation_result.carry_flag = (raw_sum & 0x10u) ? 1u : 0u;
+
+    uint8_t sign_a = sign4(operand_a_4bit);
+    uint8_t sign_b = sign4(operand_b_4bit);
+    uint8_t sign_result = sign4(operation_result.result);
+    operation_result.overflow_flag = ((sign_a == sign_b) && (sign_a != sign_result)) ? 1u : 0u;
+
+    set_zero_and_negative_flags(&operation_result);
+    return operation_result;
+}
+
+AluResult alu_sbc(uint8_t operand_a, uint8_t operand_b, uint8_t carry_in) {
+    /* a - b - borrow == a + ~b + carry; overflow and carry follow from the add */
+    return alu_adc(operand_a, (uint8_t)~operand_b, carry_in);
+}
+
 AluResult alu_and(uint8_t operand_a, uint8_t operand_b) {
     AluResult operation_result = {0, 0, 0, 0, 0};
     operation_result.result = mask4(mask4(operand_a) & mask4(operand_b));
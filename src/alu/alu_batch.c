@@ -0,0 +1,308 @@
+#include "alu/alu_batch.h"
+
+#include <string.h>
+
+#include "alu/alu.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define ALU_BATCH_X86 1
+#include <immintrin.h>
+#else
+#define ALU_BATCH_X86 0
+#endif
+
+/* ---- scalar path: also finishes whatever the vector kernels leave ---- */
+
+static AluResult alu_batch_scalar_op(AluBatchOp op, uint8_t operand_a, uint8_t operand_b) {
+    switch (op) {
+        case ALU_BATCH_ADD: return alu_add(operand_a, operand_b);
+        case ALU_BATCH_SUB: return alu_sub(operand_a, operand_b);
+        case ALU_BATCH_AND: return alu_and(operand_a, operand_b);
+        case ALU_BATCH_OR:  return alu_or(operand_a, operand_b);
+        case ALU_BATCH_XOR: return alu_xor(operand_a, operand_b);
+        case ALU_BATCH_NOT: return alu_not(operand_a);
+        case ALU_BATCH_SHL: return alu_shl(operand_a);
+        default:            return alu_shr(operand_a);
+    }
+}
+
+static void alu_batch_set_bit(uint8_t *bitmap, size_t element, uint8_t value) {
+    if (bitmap != NULL) {
+        bitmap[element / 8u] = (uint8_t)(bitmap[element / 8u] | (value << (element % 8u)));
+    }
+}
+
+static void alu_batch_clear_bits(uint8_t *bitmap, size_t first_byte, size_t end_byte) {
+    if (bitmap != NULL && end_byte > first_byte) {
+        memset(bitmap + first_byte, 0, end_byte - first_byte);
+    }
+}
+
+/* Elements [start, count); start is a multiple of 8. */
+static void alu_batch_scalar_tail(AluBatchOp op, const uint8_t *operands, size_t start, size_t count,
+                                  const AluBatchOutput *out) {
+    int unary = op >= ALU_BATCH_NOT;
+    size_t bitmap_end = (count + 7u) / 8u;
+    alu_batch_clear_bits(out->zero_flags, start / 8u, bitmap_end);
+    alu_batch_clear_bits(out->carry_flags, start / 8u, bitmap_end);
+    alu_batch_clear_bits(out->negative_flags, start / 8u, bitmap_end);
+    alu_batch_clear_bits(out->overflow_flags, start / 8u, bitmap_end);
+
+    for (size_t element = start; element < count; ++element) {
+        uint8_t operand_a, operand_b = 0;
+        if (unary) {
+            operand_a = (uint8_t)(operands[element / 2u] >> (4u * (element % 2u)));
+        } else {
+            operand_a = operands[element];
+            operand_b = (uint8_t)(operands[element] >> 4);
+        }
+        AluResult result = alu_batch_scalar_op(op, operand_a, operand_b);
+        if (element % 2u == 0) {
+            out->results[element / 2u] = result.result;
+        } else {
+            out->results[element / 2u] = (uint8_t)(out->results[element / 2u] | (result.result << 4));
+        }
+        alu_batch_set_bit(out->zero_flags, element, result.zero_flag);
+        alu_batch_set_bit(out->carry_flags, element, result.carry_flag);
+        alu_batch_set_bit(out->negative_flags, element, result.negative_flag);
+        alu_batch_set_bit(out->overflow_flags, element, result.overflow_flag);
+    }
+}
+
+#if ALU_BATCH_X86
+
+/* ---- SSE2 kernel: 32 elements per block, baseline on x86-64 ---- */
+
+#define ALU_BATCH_FN(name) alu_batch_sse2_##name
+#define ALU_BATCH_TARGET
+#define ALU_BATCH_WIDTH 16u
+#define ALU_BATCH_VEC __m128i
+#define ALU_BATCH_LOAD(pointer) _mm_loadu_si128((const __m128i *)(const void *)(pointer))
+#define ALU_BATCH_STORE(pointer, value) _mm_storeu_si128((__m128i *)(void *)(pointer), (value))
+#define ALU_BATCH_SET1(value) _mm_set1_epi8((char)(value))
+#define ALU_BATCH_AND(a, b) _mm_and_si128((a), (b))
+#define ALU_BATCH_OR(a, b) _mm_or_si128((a), (b))
+#define ALU_BATCH_XOR(a, b) _mm_xor_si128((a), (b))
+#define ALU_BATCH_ANDNOT(a, b) _mm_andnot_si128((a), (b))
+#define ALU_BATCH_ADD(a, b) _mm_add_epi8((a), (b))
+#define ALU_BATCH_SUB(a, b) _mm_sub_epi8((a), (b))
+#define ALU_BATCH_CMPEQ(a, b) _mm_cmpeq_epi8((a), (b))
+#define ALU_BATCH_MAX(a, b) _mm_max_epu8((a), (b))
+#define ALU_BATCH_SLLI16(a, count) _mm_slli_epi16((a), (count))
+#define ALU_BATCH_SRLI16(a, count) _mm_srli_epi16((a), (count))
+#define ALU_BATCH_MOVEMASK(a) ((uint64_t)(uint32_t)_mm_movemask_epi8(a))
+#define ALU_BATCH_INTERLEAVE(even, odd, first, second)                         \
+    do {                                                                       \
+        (first) = _mm_unpacklo_epi8((even), (odd));                            \
+        (second) = _mm_unpackhi_epi8((even), (odd));                           \
+    } while (0)
+#define ALU_BATCH_PACK(first, second) _mm_packus_epi16((first), (second))
+#include "alu_batch_kernel.inc"
+#undef ALU_BATCH_FN
+#undef ALU_BATCH_TARGET
+#undef ALU_BATCH_WIDTH
+#undef ALU_BATCH_VEC
+#undef ALU_BATCH_LOAD
+#undef ALU_BATCH_STORE
+#undef ALU_BATCH_SET1
+#undef ALU_BATCH_AND
+#undef ALU_BATCH_OR
+#undef ALU_BATCH_XOR
+#undef ALU_BATCH_ANDNOT
+#undef ALU_BATCH_ADD
+#undef ALU_BATCH_SUB
+#undef ALU_BATCH_CMPEQ
+#undef ALU_BATCH_MAX
+#undef ALU_BATCH_SLLI16
+#undef ALU_BATCH_SRLI16
+#undef ALU_BATCH_MOVEMASK
+#undef ALU_BATCH_INTERLEAVE
+#undef ALU_BATCH_PACK
+
+/*
+ * ---- AVX2 kernel: 64 elements per block ----
+ * unpack and pack work within 128-bit halves, so quadwords are reordered
+ * around them to keep elements in memory order.
+ */
+
+#define ALU_BATCH_FN(name) alu_batch_avx2_##name
+#define ALU_BATCH_TARGET __attribute__((target("avx2")))
+#define ALU_BATCH_WIDTH 32u
+#define ALU_BATCH_VEC __m256i
+#define ALU_BATCH_LOAD(pointer) _mm256_loadu_si256((const __m256i *)(const void *)(pointer))
+#define ALU_BATCH_STORE(pointer, value) _mm256_storeu_si256((__m256i *)(void *)(pointer), (value))
+#define ALU_BATCH_SET1(value) _mm256_set1_epi8((char)(value))
+#define ALU_BATCH_AND(a, b) _mm256_and_si256((a), (b))
+#define ALU_BATCH_OR(a, b) _mm256_or_si256((a), (b))
+#define ALU_BATCH_XOR(a, b) _mm256_xor_si256((a), (b))
+#define ALU_BATCH_ANDNOT(a, b) _mm256_andnot_si256((a), (b))
+#define ALU_BATCH_ADD(a, b) _mm256_add_epi8((a), (b))
+#define ALU_BATCH_SUB(a, b) _mm256_sub_epi8((a), (b))
+#define ALU_BATCH_CMPEQ(a, b) _mm256_cmpeq_epi8((a), (b))
+#define ALU_BATCH_MAX(a, b) _mm256_max_epu8((a), (b))
+#define ALU_BATCH_SLLI16(a, count) _mm256_slli_epi16((a), (count))
+#define ALU_BATCH_SRLI16(a, count) _mm256_srli_epi16((a), (count))
+#define ALU_BATCH_MOVEMASK(a) ((uint64_t)(uint32_t)_mm256_movemask_epi8(a))
+#define ALU_BATCH_INTERLEAVE(even, odd, first, second)                         \
+    do {                                                                       \
+        __m256i even_ordered = _mm256_permute4x64_epi64((even), 0xD8);         \
+        __m256i odd_ordered = _mm256_permute4x64_epi64((odd), 0xD8);           \
+        (first) = _mm256_unpacklo_epi8(even_ordered, odd_ordered);             \
+        (second) = _mm256_unpackhi_epi8(even_ordered, odd_ordered);            \
+    } while (0)
+#define ALU_BATCH_PACK(first, second) \
+    _mm256_permute4x64_epi64(_mm256_packus_epi16((first), (second)), 0xD8)
+#include "alu_batch_kernel.inc"
+#undef ALU_BATCH_FN
+#undef ALU_BATCH_TARGET
+#undef ALU_BATCH_WIDTH
+#undef ALU_BATCH_VEC
+#undef ALU_BATCH_LOAD
+#undef ALU_BATCH_STORE
+#undef ALU_BATCH_SET1
+#undef ALU_BATCH_AND
+#undef ALU_BATCH_OR
+#undef ALU_BATCH_XOR
+#undef ALU_BATCH_ANDNOT
+#undef ALU_BATCH_ADD
+#undef ALU_BATCH_SUB
+#undef ALU_BATCH_CMPEQ
+#undef ALU_BATCH_MAX
+#undef ALU_BATCH_SLLI16
+#undef ALU_BATCH_SRLI16
+#undef ALU_BATCH_MOVEMASK
+#undef ALU_BATCH_INTERLEAVE
+#undef ALU_BATCH_PACK
+
+/*
+ * ---- AVX-512BW kernel: 128 elements per block ----
+ * Compares produce mask registers; CMPEQ expands them back to byte vectors
+ * so the shared kernel body applies unchanged.
+ */
+
+#define ALU_BATCH_FN(name) alu_batch_avx512_##name
+#define ALU_BATCH_TARGET __attribute__((target("avx512f,avx512bw")))
+#define ALU_BATCH_WIDTH 64u
+#define ALU_BATCH_VEC __m512i
+#define ALU_BATCH_LOAD(pointer) _mm512_loadu_si512((const void *)(pointer))
+#define ALU_BATCH_STORE(pointer, value) _mm512_storeu_si512((void *)(pointer), (value))
+#define ALU_BATCH_SET1(value) _mm512_set1_epi8((char)(value))
+#define ALU_BATCH_AND(a, b) _mm512_and_si512((a), (b))
+#define ALU_BATCH_OR(a, b) _mm512_or_si512((a), (b))
+#define ALU_BATCH_XOR(a, b) _mm512_xor_si512((a), (b))
+#define ALU_BATCH_ANDNOT(a, b) _mm512_andnot_si512((a), (b))
+#define ALU_BATCH_ADD(a, b) _mm512_add_epi8((a), (b))
+#define ALU_BATCH_SUB(a, b) _mm512_sub_epi8((a), (b))
+#define ALU_BATCH_CMPEQ(a, b) _mm512_movm_epi8(_mm512_cmpeq_epi8_mask((a), (b)))
+#define ALU_BATCH_MAX(a, b) _mm512_max_epu8((a), (b))
+#define ALU_BATCH_SLLI16(a, count) _mm512_slli_epi16((a), (count))
+#define ALU_BATCH_SRLI16(a, count) _mm512_srli_epi16((a), (count))
+#define ALU_BATCH_MOVEMASK(a) ((uint64_t)_mm512_movepi8_mask(a))
+#define ALU_BATCH_INTERLEAVE(even, odd, first, second)                         \
+    do {                                                                       \
+        const __m512i order = _mm512_set_epi64(7, 3, 6, 2, 5, 1, 4, 0);       \
+        __m512i even_ordered = _mm512_permutexvar_epi64(order, (even));        \
+        __m512i odd_ordered = _mm512_permutexvar_epi64(order, (odd));          \
+        (first) = _mm512_unpacklo_epi8(even_ordered, odd_ordered);             \
+        (second) = _mm512_unpackhi_epi8(even_ordered, odd_ordered);            \
+    } while (0)
+#define ALU_BATCH_PACK(first, second)                                          \
+    _mm512_permutexvar_epi64(_mm512_set_epi64(7, 5, 3, 1, 6, 4, 2, 0),         \
+                             _mm512_packus_epi16((first), (second)))
+#include "alu_batch_kernel.inc"
+#undef ALU_BATCH_FN
+#undef ALU_BATCH_TARGET
+#undef ALU_BATCH_WIDTH
+#undef ALU_BATCH_VEC
+#undef ALU_BATCH_LOAD
+#undef ALU_BATCH_STORE
+#undef ALU_BATCH_SET1
+#undef ALU_BATCH_AND
+#undef ALU_BATCH_OR
+#undef ALU_BATCH_XOR
+#undef ALU_BATCH_ANDNOT
+#undef ALU_BATCH_ADD
+#undef ALU_BATCH_SUB
+#undef ALU_BATCH_CMPEQ
+#undef ALU_BATCH_MAX
+#undef ALU_BATCH_SLLI16
+#undef ALU_BATCH_SRLI16
+#undef ALU_BATCH_MOVEMASK
+#undef ALU_BATCH_INTERLEAVE
+#undef ALU_BATCH_PACK
+
+#endif /* ALU_BATCH_X86 */
+
+/* ---- dispatch ---- */
+
+static int alu_batch_kernel_supported(AluBatchKernel kernel) {
+    switch (kernel) {
+        case ALU_BATCH_KERNEL_SCALAR:
+            return 1;
+#if ALU_BATCH_X86
+        case ALU_BATCH_KERNEL_SSE2:
+            return 1;
+        case ALU_BATCH_KERNEL_AVX2:
+            return __builtin_cpu_supports("avx2");
+        case ALU_BATCH_KERNEL_AVX512:
+            return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+#endif
+        default:
+            return 0;
+    }
+}
+
+AluBatchKernel alu_batch_best_kernel(void) {
+    if (alu_batch_kernel_supported(ALU_BATCH_KERNEL_AVX512)) {
+        return ALU_BATCH_KERNEL_AVX512;
+    }
+    if (alu_batch_kernel_supported(ALU_BATCH_KERNEL_AVX2)) {
+        return ALU_BATCH_KERNEL_AVX2;
+    }
+    if (alu_batch_kernel_supported(ALU_BATCH_KERNEL_SSE2)) {
+        return ALU_BATCH_KERNEL_SSE2;
+    }
+    return ALU_BATCH_KERNEL_SCALAR;
+}
+
+int alu_batch_run(AluBatchKernel kernel,
+                  AluBatchOp op,
+                  const uint8_t *operands,
+                  size_t count,
+                  const AluBatchOutput *out) {
+    if (out == NULL || (count > 0 && (operands == NULL || out->results == NULL)) ||
+        (unsigned)op > ALU_BATCH_SHR) {
+        return -1;
+    }
+    if (!alu_batch_kernel_supported(kernel)) {
+        return -2;
+    }
+
+    size_t done = 0;
+#if ALU_BATCH_X86
+    switch (kernel) {
+        case ALU_BATCH_KERNEL_SSE2:   done = alu_batch_sse2_run(op, operands, count, out); break;
+        case ALU_BATCH_KERNEL_AVX2:   done = alu_batch_avx2_run(op, operands, count, out); break;
+        case ALU_BATCH_KERNEL_AVX512: done = alu_batch_avx512_run(op, operands, count, out); break;
+        default: break;
+    }
+#endif
+    alu_batch_scalar_tail(op, operands, done, count, out);
+    return 0;
+}
+
+#define ALU_BATCH_DEFINE(name, op)                                                   \
+    int alu_##name##_batch(const uint8_t *operands, size_t count, const AluBatchOutput *out) { \
+        return alu_batch_run(alu_batch_best_kernel(), (op), operands, count, out);   \
+    }
+
+ALU_BATCH_DEFINE(add, ALU_BATCH_ADD)
+ALU_BATCH_DEFINE(sub, ALU_BATCH_SUB)
+ALU_BATCH_DEFINE(and, ALU_BATCH_AND)
+ALU_BATCH_DEFINE(or, ALU_BATCH_OR)
+ALU_BATCH_DEFINE(xor, ALU_BATCH_XOR)
+ALU_BATCH_DEFINE(not, ALU_BATCH_NOT)
+ALU_BATCH_DEFINE(shl, ALU_BATCH_SHL)
+ALU_BATCH_DEFINE(shr, ALU_BATCH_SHR)
+
+#undef ALU_BATCH_DEFINE
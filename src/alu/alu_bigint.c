@@ -0,0 +1,394 @@
+#include "alu/alu_bigint.h"
+
+#include <string.h>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define ALU_BIGINT_X86 1
+#include <immintrin.h>
+#else
+#define ALU_BIGINT_X86 0
+#endif
+
+/* 64-bit limbs: 16 nibbles each, little-endian like the nibble order. */
+#define ALU_BIGINT_LIMB_NIBBLES 16u
+
+static inline uint64_t alu_bigint_load_limb(const uint8_t *bytes) {
+    return (uint64_t)bytes[0] | ((uint64_t)bytes[1] << 8) | ((uint64_t)bytes[2] << 16) |
+           ((uint64_t)bytes[3] << 24) | ((uint64_t)bytes[4] << 32) | ((uint64_t)bytes[5] << 40) |
+           ((uint64_t)bytes[6] << 48) | ((uint64_t)bytes[7] << 56);
+}
+
+static inline void alu_bigint_store_limb(uint8_t *bytes, uint64_t limb) {
+    bytes[0] = (uint8_t)limb;
+    bytes[1] = (uint8_t)(limb >> 8);
+    bytes[2] = (uint8_t)(limb >> 16);
+    bytes[3] = (uint8_t)(limb >> 24);
+    bytes[4] = (uint8_t)(limb >> 32);
+    bytes[5] = (uint8_t)(limb >> 40);
+    bytes[6] = (uint8_t)(limb >> 48);
+    bytes[7] = (uint8_t)(limb >> 56);
+}
+
+/* Running state of one add: carry between limbs and OR of every result limb. */
+typedef struct {
+    uint64_t carry;
+    uint64_t nonzero;
+} AluBigintCarry;
+
+/* ---- scalar path: also finishes whatever the vector kernels leave ---- */
+
+static void alu_bigint_scalar_limbs(const uint8_t *operand_a, const uint8_t *operand_b, uint8_t *result,
+                                    size_t start, size_t limb_count, uint64_t invert,
+                                    AluBigintCarry *state) {
+    uint64_t carry = state->carry;
+    uint64_t nonzero = state->nonzero;
+    for (size_t limb = start; limb < limb_count; ++limb) {
+        uint64_t a = alu_bigint_load_limb(operand_a + limb * 8u);
+        uint64_t b = alu_bigint_load_limb(operand_b + limb * 8u) ^ invert;
+        uint64_t sum = a + b;
+        uint64_t carry_out = sum < a;
+        sum += carry;
+        carry_out |= sum < carry;
+        carry = carry_out;
+        nonzero |= sum;
+        if (result != NULL) {
+            alu_bigint_store_limb(result + limb * 8u, sum);
+        }
+    }
+    state->carry = carry;
+    state->nonzero = nonzero;
+}
+
+#if ALU_BIGINT_X86
+
+/*
+ * Vector kernels add one limb per lane, then fix up carries between lanes
+ * in one step. Lane i generates a carry when its sum wrapped (G) and
+ * propagates one when its sum is all ones (P). Adding (G << 1) + P + carry
+ * as integers ripples the carries through the P lanes, so
+ * ((G << 1) + P + carry) ^ P has the carry into every lane, and the bit
+ * above the top lane is the carry out of the block.
+ */
+
+static __attribute__((target("avx2"))) size_t alu_bigint_avx2_run(const uint8_t *operand_a,
+                                                                    const uint8_t *operand_b,
+                                                                    uint8_t *result,
+                                                                    size_t limb_count,
+                                                                    uint64_t invert,
+                                                                    AluBigintCarry *state) {
+    const __m256i flip = _mm256_set1_epi64x((long long)invert);
+    const __m256i sign = _mm256_set1_epi64x((long long)0x8000000000000000ull);
+    const __m256i ones = _mm256_set1_epi64x(-1);
+    const __m256i lane_bits = _mm256_set_epi64x(8, 4, 2, 1);
+    __m256i nonzero = _mm256_setzero_si256();
+    unsigned carry = (unsigned)state->carry;
+    size_t limb = 0;
+
+    for (; limb + 4u <= limb_count; limb += 4u) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(const void *)(operand_a + limb * 8u));
+        __m256i b = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(const void *)(operand_b + limb * 8u)),
+                                     flip);
+        __m256i sum = _mm256_add_epi64(a, b);
+        /* unsigned sum < a, via the signed compare with both sign bits flipped */
+        __m256i wrapped = _mm256_cmpgt_epi64(_mm256_xor_si256(a, sign), _mm256_xor_si256(sum, sign));
+        unsigned generate = (unsigned)_mm256_movemask_pd(_mm256_castsi256_pd(wrapped));
+        unsigned propagate = (unsigned)_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(sum, ones)));
+        unsigned lookahead = (generate << 1) + propagate + carry;
+        unsigned carry_in = (lookahead ^ propagate) & 0x0Fu;
+        carry = lookahead >> 4;
+        /* subtract -1 in the lanes that take a carry */
+        __m256i selected = _mm256_and_si256(_mm256_set1_epi64x((long long)carry_in), lane_bits);
+        sum = _mm256_sub_epi64(sum, _mm256_cmpeq_epi64(selected, lane_bits));
+        nonzero = _mm256_or_si256(nonzero, sum);
+        if (result != NULL) {
+            _mm256_storeu_si256((__m256i *)(void *)(result + limb * 8u), sum);
+        }
+    }
+
+    state->carry = carry;
+    state->nonzero |= (uint64_t)_mm256_extract_epi64(nonzero, 0) | (uint64_t)_mm256_extract_epi64(nonzero, 1) |
+                      (uint64_t)_mm256_extract_epi64(nonzero, 2) | (uint64_t)_mm256_extract_epi64(nonzero, 3);
+    return limb;
+}
+
+static __attribute__((target("avx512f"))) size_t alu_bigint_avx512_run(const uint8_t *operand_a,
+                                                                         const uint8_t *operand_b,
+                                                                         uint8_t *result,
+                                                                         size_t limb_count,
+                                                                         uint64_t invert,
+                                                                         AluBigintCarry *state) {
+    const __m512i flip = _mm512_set1_epi64((long long)invert);
+    const __m512i ones = _mm512_set1_epi64(-1);
+    __m512i nonzero = _mm512_setzero_si512();
+    unsigned carry = (unsigned)state->carry;
+    size_t limb = 0;
+
+    for (; limb + 8u <= limb_count; limb += 8u) {
+        __m512i a = _mm512_loadu_si512((const void *)(operand_a + limb * 8u));
+        __m512i b = _mm512_xor_si512(_mm512_loadu_si512((const void *)(operand_b + limb * 8u)), flip);
+        __m512i sum = _mm512_add_epi64(a, b);
+        unsigned generate = (unsigned)_mm512_cmplt_epu64_mask(sum, a);
+        unsigned propagate = (unsigned)_mm512_cmpeq_epi64_mask(sum, ones);
+        unsigned lookahead = (generate << 1) + propagate + carry;
+        __mmask8 carry_in = (__mmask8)(lookahead ^ propagate);
+        carry = lookahead >> 8;
+        sum = _mm512_mask_sub_epi64(sum, carry_in, sum, ones);
+        nonzero = _mm512_or_si512(nonzero, sum);
+        if (result != NULL) {
+            _mm512_storeu_si512((void *)(result + limb * 8u), sum);
+        }
+    }
+
+    state->carry = carry;
+    state->nonzero |= (uint64_t)_mm512_reduce_or_epi64(nonzero);
+    return limb;
+}
+
+#endif /* ALU_BIGINT_X86 */
+
+/* ---- dispatch ---- */
+
+static int alu_bigint_kernel_supported(AluBigintKernel kernel) {
+    switch (kernel) {
+        case ALU_BIGINT_KERNEL_SCALAR:
+            return 1;
+#if ALU_BIGINT_X86
+        case ALU_BIGINT_KERNEL_AVX2:
+            return __builtin_cpu_supports("avx2");
+        case ALU_BIGINT_KERNEL_AVX512:
+            return __builtin_cpu_supports("avx512f");
+#endif
+        default:
+            return 0;
+    }
+}
+
+AluBigintKernel alu_bigint_best_kernel(void) {
+    if (alu_bigint_kernel_supported(ALU_BIGINT_KERNEL_AVX512)) {
+        return ALU_BIGINT_KERNEL_AVX512;
+    }
+    if (alu_bigint_kernel_supported(ALU_BIGINT_KERNEL_AVX2)) {
+        return ALU_BIGINT_KERNEL_AVX2;
+    }
+    return ALU_BIGINT_KERNEL_SCALAR;
+}
+
+static inline uint8_t alu_bigint_top_nibble(uint64_t limb, size_t nibble_count) {
+    return (uint8_t)((limb >> (4u * (nibble_count - 1u))) & 0x0Fu);
+}
+
+int alu_bigint_run(AluBigintKernel kernel,
+                   AluBigintOp op,
+                   const uint8_t *operand_a,
+                   const uint8_t *operand_b,
+                   size_t nibble_count,
+                   uint8_t carry_in,
+                   uint8_t *result,
+                   AluResult *flags) {
+    if ((nibble_count > 0 && (operand_a == NULL || operand_b == NULL)) ||
+        (op != ALU_BIGINT_ADD && op != ALU_BIGINT_SUB)) {
+        return -1;
+    }
+    if (!alu_bigint_kernel_supported(kernel)) {
+        return -2;
+    }
+    if (nibble_count == 0) {
+        if (flags != NULL) {
+            AluResult empty = {0, 1u, carry_in ? 1u : 0u, 0, 0};
+            *flags = empty;
+        }
+        return 0;
+    }
+
+    /* a - b - borrow == a + ~b + carry, limb by limb */
+    const uint64_t invert = (op == ALU_BIGINT_SUB) ? ~(uint64_t)0 : 0;
+    AluBigintCarry state = {carry_in ? 1u : 0u, 0};
+
+    /* every limb below the one holding the top nibble */
+    size_t full_limbs = (nibble_count - 1u) / ALU_BIGINT_LIMB_NIBBLES;
+    size_t done = 0;
+#if ALU_BIGINT_X86
+    switch (kernel) {
+        case ALU_BIGINT_KERNEL_AVX2:
+            done = alu_bigint_avx2_run(operand_a, operand_b, result, full_limbs, invert, &state);
+            break;
+        case ALU_BIGINT_KERNEL_AVX512:
+            done = alu_bigint_avx512_run(operand_a, operand_b, result, full_limbs, invert, &state);
+            break;
+        default:
+            break;
+    }
+#endif
+    alu_bigint_scalar_limbs(operand_a, operand_b, result, done, full_limbs, invert, &state);
+
+    /* top limb: 1..16 nibbles, zero-extended */
+    size_t top_nibbles = nibble_count - full_limbs * ALU_BIGINT_LIMB_NIBBLES;
+    size_t top_bytes = (top_nibbles + 1u) / 2u;
+    size_t top_offset = full_limbs * 8u;
+    uint8_t bytes_a[8] = {0}, bytes_b[8] = {0};
+    memcpy(bytes_a, operand_a + top_offset, top_bytes);
+    memcpy(bytes_b, operand_b + top_offset, top_bytes);
+
+    uint64_t mask = (top_nibbles == ALU_BIGINT_LIMB_NIBBLES) ? ~(uint64_t)0
+                                                             : (((uint64_t)1 << (4u * top_nibbles)) - 1u);
+    uint64_t a = alu_bigint_load_limb(bytes_a) & mask;
+    uint64_t b = (alu_bigint_load_limb(bytes_b) ^ invert) & mask;
+    uint64_t sum = a + b;
+    uint64_t wrapped = sum < a;
+    sum += state.carry;
+    wrapped |= sum < state.carry;
+    uint64_t carry_out = (top_nibbles == ALU_BIGINT_LIMB_NIBBLES) ? wrapped : ((sum >> (4u * top_nibbles)) & 1u);
+    sum &= mask;
+
+    if (result != NULL) {
+        uint8_t bytes_result[8];
+        alu_bigint_store_limb(bytes_result, sum);
+        memcpy(result + top_offset, bytes_result, top_bytes);
+    }
+
+    if (flags != NULL) {
+        uint8_t top_a = alu_bigint_top_nibble(a, top_nibbles);
+        uint8_t top_b = alu_bigint_top_nibble(b, top_nibbles);
+        uint8_t top_result = alu_bigint_top_nibble(sum, top_nibbles);
+        flags->result = top_result;
+        flags->zero_flag = (uint8_t)((state.nonzero | sum) == 0);
+        flags->carry_flag = (uint8_t)carry_out;
+        flags->negative_flag = (uint8_t)(top_result >> 3);
+        /* as alu_adc on the top nibble: operand signs agree, result sign differs */
+        flags->overflow_flag = (uint8_t)(((~(top_a ^ top_b) & (top_a ^ top_result)) >> 3) & 1u);
+    }
+    return 0;
+}
+
+int alu_bigint_add(const uint8_t *operand_a, const uint8_t *operand_b, size_t nibble_count,
+                   uint8_t carry_in, uint8_t *result, AluResult *flags) {
+    return alu_bigint_run(alu_bigint_best_kernel(), ALU_BIGINT_ADD, operand_a, operand_b, nibble_count,
+                          carry_in, result, flags);
+}
+
+int alu_bigint_sub(const uint8_t *operand_a, const uint8_t *operand_b, size_t nibble_count,
+                   uint8_t carry_in, uint8_t *result, AluResult *flags) {
+    return alu_bigint_run(alu_bigint_best_kernel(), ALU_BIGINT_SUB, operand_a, operand_b, nibble_count,
+                          carry_in, result, flags);
+}
+
+int alu_bigint_compare(const uint8_t *operand_a, const uint8_t *operand_b, size_t nibble_count,
+                       AluResult *flags) {
+    if (flags == NULL) {
+        return -1;
+    }
+    return alu_bigint_run(alu_bigint_best_kernel(), ALU_BIGINT_SUB, operand_a, operand_b, nibble_count, 1u,
+                          NULL, flags);
+}
+
+/* ---- shifts ---- */
+
+/* Byte of an operand with the unused high nibble of an odd-length value cleared. */
+static inline uint8_t alu_bigint_byte(const uint8_t *operand, size_t index, size_t byte_count, uint8_t top_mask) {
+    return (index + 1u == byte_count) ? (uint8_t)(operand[index] & top_mask) : operand[index];
+}
+
+static inline uint8_t alu_bigint_bit(const uint8_t *operand, size_t bit) {
+    return (uint8_t)((operand[bit / 8u] >> (bit % 8u)) & 1u);
+}
+
+static void alu_bigint_shift_flags(const uint8_t *result, size_t nibble_count, uint8_t carry, AluResult *flags) {
+    size_t byte_count = (nibble_count + 1u) / 2u;
+    uint8_t nonzero = 0;
+    for (size_t index = 0; index < byte_count; ++index) {
+        nonzero |= result[index];
+    }
+    size_t top = nibble_count - 1u;
+    flags->result = (uint8_t)((result[top / 2u] >> (4u * (top % 2u))) & 0x0Fu);
+    flags->zero_flag = (uint8_t)(nonzero == 0);
+    flags->carry_flag = carry;
+    flags->negative_flag = (uint8_t)(flags->result >> 3);
+    flags->overflow_flag = 0;
+}
+
+int alu_bigint_shl(const uint8_t *operand, size_t nibble_count, size_t bit_count,
+                   uint8_t *result, AluResult *flags) {
+    if (nibble_count > 0 && (operand == NULL || result == NULL)) {
+        return -1;
+    }
+    if (nibble_count == 0) {
+        if (flags != NULL) {
+            AluResult empty = {0, 1u, 0, 0, 0};
+            *flags = empty;
+        }
+        return 0;
+    }
+
+    const size_t bit_total = nibble_count * 4u;
+    const size_t byte_count = (nibble_count + 1u) / 2u;
+    const uint8_t top_mask = (nibble_count % 2u) ? 0x0Fu : 0xFFu;
+    uint8_t carry = (bit_count >= 1u && bit_count <= bit_total) ? alu_bigint_bit(operand, bit_total - bit_count) : 0u;
+
+    if (bit_count >= bit_total) {
+        memset(result, 0, byte_count);
+    } else {
+        size_t byte_shift = bit_count / 8u;
+        unsigned bit_shift = (unsigned)(bit_count % 8u);
+        /* high to low, so result may alias operand */
+        for (size_t index = byte_count; index-- > 0;) {
+            unsigned value = 0;
+            if (index >= byte_shift) {
+                value = (unsigned)alu_bigint_byte(operand, index - byte_shift, byte_count, top_mask) << bit_shift;
+                if (bit_shift != 0 && index >= byte_shift + 1u) {
+                    value |= (unsigned)operand[index - byte_shift - 1u] >> (8u - bit_shift);
+                }
+            }
+            result[index] = (uint8_t)value;
+        }
+        result[(nibble_count - 1u) / 2u] &= top_mask;
+    }
+
+    if (flags != NULL) {
+        alu_bigint_shift_flags(result, nibble_count, carry, flags);
+    }
+    return 0;
+}
+
+int alu_bigint_shr(const uint8_t *operand, size_t nibble_count, size_t bit_count,
+                   uint8_t *result, AluResult *flags) {
+    if (nibble_count > 0 && (operand == NULL || result == NULL)) {
+        return -1;
+    }
+    if (nibble_count == 0) {
+        if (flags != NULL) {
+            AluResult empty = {0, 1u, 0, 0, 0};
+            *flags = empty;
+        }
+        return 0;
+    }
+
+    const size_t bit_total = nibble_count * 4u;
+    const size_t byte_count = (nibble_count + 1u) / 2u;
+    const uint8_t top_mask = (nibble_count % 2u) ? 0x0Fu : 0xFFu;
+    uint8_t carry = (bit_count >= 1u && bit_count <= bit_total) ? alu_bigint_bit(operand, bit_count - 1u) : 0u;
+
+    if (bit_count >= bit_total) {
+        memset(result, 0, byte_count);
+    } else {
+        size_t byte_shift = bit_count / 8u;
+        unsigned bit_shift = (unsigned)(bit_count % 8u);
+        /* low to high, so result may alias operand */
+        for (size_t index = 0; index < byte_count; ++index) {
+            unsigned value = 0;
+            if (index + byte_shift < byte_count) {
+                value = (unsigned)alu_bigint_byte(operand, index + byte_shift, byte_count, top_mask) >> bit_shift;
+                if (bit_shift != 0 && index + byte_shift + 1u < byte_count) {
+                    value |= (unsigned)alu_bigint_byte(operand, index + byte_shift + 1u, byte_count, top_mask)
+                             << (8u - bit_shift);
+                }
+            }
+            result[index] = (uint8_t)value;
+        }
+        result[(nibble_count - 1u) / 2u] &= top_mask;
+    }
+
+    if (flags != NULL) {
+        alu_bigint_shift_flags(result, nibble_count, carry, flags);
+    }
+    return 0;
+}
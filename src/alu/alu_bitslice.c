@@ -0,0 +1,197 @@
+#include "alu/alu_bitslice.h"
+
+#include <string.h>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define ALU_SLICE_HAVE_VECTORS 1
+/* 256-bit plane: one AVX2 register, or two SSE2 registers without AVX2. */
+typedef uint64_t AluSliceVector __attribute__((vector_size(32)));
+#else
+#define ALU_SLICE_HAVE_VECTORS 0
+#endif
+
+#if ALU_SLICE_HAVE_VECTORS && defined(__x86_64__)
+#define ALU_SLICE_DISPATCH_AVX2 1
+#else
+#define ALU_SLICE_DISPATCH_AVX2 0
+#endif
+
+/* ---- core instantiations ---- */
+
+#define ALU_SLICE_T uint64_t
+#define ALU_SLICE_FN(name) alu_slice_word_##name
+#define ALU_SLICE_TARGET
+#include "alu_bitslice_core.inc"
+#undef ALU_SLICE_T
+#undef ALU_SLICE_FN
+#undef ALU_SLICE_TARGET
+
+#if ALU_SLICE_HAVE_VECTORS
+#define ALU_SLICE_T AluSliceVector
+#define ALU_SLICE_FN(name) alu_slice_vector_##name
+#define ALU_SLICE_TARGET
+#include "alu_bitslice_core.inc"
+#undef ALU_SLICE_T
+#undef ALU_SLICE_FN
+#undef ALU_SLICE_TARGET
+#endif
+
+#if ALU_SLICE_DISPATCH_AVX2
+#define ALU_SLICE_T AluSliceVector
+#define ALU_SLICE_FN(name) alu_slice_avx2_##name
+#define ALU_SLICE_TARGET __attribute__((target("avx2")))
+#include "alu_bitslice_core.inc"
+#undef ALU_SLICE_T
+#undef ALU_SLICE_FN
+#undef ALU_SLICE_TARGET
+#endif
+
+/* ---- transposition ---- */
+
+static inline uint64_t alu_slice_load_le64(const uint8_t *bytes) {
+    uint64_t value = 0;
+    for (int index = 7; index >= 0; --index) {
+        value = (value << 8) | bytes[index];
+    }
+    return value;
+}
+
+static inline void alu_slice_store_le64(uint8_t *bytes, uint64_t value) {
+    for (int index = 0; index < 8; ++index) {
+        bytes[index] = (uint8_t)(value >> (8 * index));
+    }
+}
+
+/* Bit k of each of 8 bytes -> 8 consecutive bits (byte j to bit j). */
+static inline uint64_t alu_slice_gather_bits(uint64_t bytes, int bit) {
+    return (((bytes >> bit) & 0x0101010101010101ull) * 0x0102040810204080ull) >> 56;
+}
+
+/* 8 bits -> low bit of 8 bytes (bit j to byte j). */
+static inline uint64_t alu_slice_spread_bits(uint64_t bits) {
+    uint64_t selected = ((bits & 0xFFu) * 0x0101010101010101ull) & 0x8040201008040201ull;
+    return ((selected + 0x7F7F7F7F7F7F7F7Full) >> 7) & 0x0101010101010101ull;
+}
+
+static void alu_slice_pack_words(const uint8_t operands[64], uint64_t *plane0, uint64_t *plane1,
+                                 uint64_t *plane2, uint64_t *plane3) {
+    uint64_t planes[4] = {0, 0, 0, 0};
+    for (int group = 0; group < 8; ++group) {
+        uint64_t bytes = alu_slice_load_le64(operands + 8 * group);
+        for (int bit = 0; bit < 4; ++bit) {
+            planes[bit] |= alu_slice_gather_bits(bytes, bit) << (8 * group);
+        }
+    }
+    *plane0 = planes[0];
+    *plane1 = planes[1];
+    *plane2 = planes[2];
+    *plane3 = planes[3];
+}
+
+static void alu_slice_unpack_words(uint64_t plane0, uint64_t plane1, uint64_t plane2, uint64_t plane3,
+                                   uint8_t values[64]) {
+    for (int group = 0; group < 8; ++group) {
+        int shift = 8 * group;
+        uint64_t bytes = alu_slice_spread_bits(plane0 >> shift) |
+                         (alu_slice_spread_bits(plane1 >> shift) << 1) |
+                         (alu_slice_spread_bits(plane2 >> shift) << 2) |
+                         (alu_slice_spread_bits(plane3 >> shift) << 3);
+        alu_slice_store_le64(values + 8 * group, bytes);
+    }
+}
+
+void alu_slice64_pack(const uint8_t operands[64], AluSlice64 *slice) {
+    alu_slice_pack_words(operands, &slice->plane[0], &slice->plane[1], &slice->plane[2], &slice->plane[3]);
+}
+
+void alu_slice64_unpack(const AluSlice64 *slice, uint8_t values[64]) {
+    alu_slice_unpack_words(slice->plane[0], slice->plane[1], slice->plane[2], slice->plane[3], values);
+}
+
+void alu_slice256_pack(const uint8_t operands[256], AluSlice256 *slice) {
+    for (int word = 0; word < 4; ++word) {
+        alu_slice_pack_words(operands + 64 * word, &slice->plane[0][word], &slice->plane[1][word],
+                             &slice->plane[2][word], &slice->plane[3][word]);
+    }
+}
+
+void alu_slice256_unpack(const AluSlice256 *slice, uint8_t values[256]) {
+    for (int word = 0; word < 4; ++word) {
+        alu_slice_unpack_words(slice->plane[0][word], slice->plane[1][word], slice->plane[2][word],
+                               slice->plane[3][word], values + 64 * word);
+    }
+}
+
+/* ---- evaluation ---- */
+
+AluSliceResult64 alu_slice64_eval(AluSliceOp op, AluSlice64 operand_a, AluSlice64 operand_b) {
+    AluSliceResult64 out;
+    uint64_t flags[4];
+    alu_slice_word_core(op, operand_a.plane, operand_b.plane, out.result.plane, flags);
+    out.zero_flags = flags[0];
+    out.carry_flags = flags[1];
+    out.negative_flags = flags[2];
+    out.overflow_flags = flags[3];
+    return out;
+}
+
+#if ALU_SLICE_HAVE_VECTORS
+/* Load the planes into vectors, run one core, store results and flags. */
+#define ALU_SLICE_EVAL256(core, operand_a, operand_b, out)                     \
+    do {                                                                       \
+        AluSliceVector a_planes[4], b_planes[4], result_planes[4], flags[4];   \
+        memcpy(a_planes, (operand_a)->plane, sizeof(a_planes));                \
+        memcpy(b_planes, (operand_b)->plane, sizeof(b_planes));                \
+        core(op, a_planes, b_planes, result_planes, flags);                    \
+        memcpy((out)->result.plane, result_planes, sizeof(result_planes));     \
+        memcpy((out)->zero_flags, &flags[0], sizeof(flags[0]));                \
+        memcpy((out)->carry_flags, &flags[1], sizeof(flags[1]));               \
+        memcpy((out)->negative_flags, &flags[2], sizeof(flags[2]));            \
+        memcpy((out)->overflow_flags, &flags[3], sizeof(flags[3]));            \
+    } while (0)
+
+#if ALU_SLICE_DISPATCH_AVX2
+static __attribute__((target("avx2"))) void alu_slice256_eval_avx2(AluSliceOp op,
+                                                                   const AluSlice256 *operand_a,
+                                                                   const AluSlice256 *operand_b,
+                                                                   AluSliceResult256 *out) {
+    ALU_SLICE_EVAL256(alu_slice_avx2_core, operand_a, operand_b, out);
+}
+#endif
+
+void alu_slice256_eval(AluSliceOp op,
+                       const AluSlice256 *operand_a,
+                       const AluSlice256 *operand_b,
+                       AluSliceResult256 *out) {
+#if ALU_SLICE_DISPATCH_AVX2
+    if (__builtin_cpu_supports("avx2")) {
+        alu_slice256_eval_avx2(op, operand_a, operand_b, out);
+        return;
+    }
+#endif
+    ALU_SLICE_EVAL256(alu_slice_vector_core, operand_a, operand_b, out);
+}
+
+#undef ALU_SLICE_EVAL256
+#else
+void alu_slice256_eval(AluSliceOp op,
+                       const AluSlice256 *operand_a,
+                       const AluSlice256 *operand_b,
+                       AluSliceResult256 *out) {
+    for (int word = 0; word < 4; ++word) {
+        uint64_t a_planes[4], b_planes[4], result_planes[4], flags[4];
+        for (int bit = 0; bit < 4; ++bit) {
+            a_planes[bit] = operand_a->plane[bit][word];
+            b_planes[bit] = operand_b->plane[bit][word];
+        }
+        alu_slice_word_core(op, a_planes, b_planes, result_planes, flags);
+        for (int bit = 0; bit < 4; ++bit) {
+            out->result.plane[bit][word] = result_planes[bit];
+        }
+        out->zero_flags[word] = flags[0];
+        out->carry_flags[word] = flags[1];
+        out->negative_flags[word] = flags[2];
+        out->overflow_flags[word] = flags[3];
+    }
+}
+#endif
@@ -0,0 +1,69 @@
+#include "alu/alu_lut.h"
+
+/*
+ * Tables are expanded by the preprocessor: ALU_LUT_TABLE256(OP) emits
+ * OP(a, b) for a, b in 0..15 in index order (a << 4) | b, and
+ * ALU_LUT_TABLE16(OP) emits OP(a) for a in 0..15. Each OP is the alu.c
+ * formula folded into one packed entry.
+ */
+
+#define ALU_LUT_PACK(result, zero, carry, negative, overflow)        \
+    (uint8_t)(((result) & 0x0Fu) |                                    \
+              (((zero) & 1u) << ALU_LUT_ZERO_BIT) |                   \
+              (((carry) & 1u) << ALU_LUT_CARRY_BIT) |                 \
+              (((negative) & 1u) << ALU_LUT_NEGATIVE_BIT) |           \
+              (((overflow) & 1u) << ALU_LUT_OVERFLOW_BIT))
+
+/* Flags of a logic op or shift: Z and N from the result, V clear. */
+#define ALU_LUT_LOGIC(result, carry) \
+    ALU_LUT_PACK((result), ((result) & 0x0Fu) == 0u, (carry), ((result) >> 3) & 1u, 0u)
+
+#define ALU_LUT_ADD_RESULT(a, b) (((a) + (b)) & 0x0Fu)
+#define ALU_LUT_ADD(a, b)                                                          \
+    ALU_LUT_PACK(ALU_LUT_ADD_RESULT(a, b),                                         \
+                 ALU_LUT_ADD_RESULT(a, b) == 0u,                                   \
+                 ((a) + (b)) >> 4,                                                 \
+                 ALU_LUT_ADD_RESULT(a, b) >> 3,                                    \
+                 ((~((a) ^ (b)) & ((a) ^ ALU_LUT_ADD_RESULT(a, b))) >> 3) & 1u)
+
+#define ALU_LUT_SUB_RESULT(a, b) (((a) - (b)) & 0x0Fu)
+#define ALU_LUT_SUB(a, b)                                                          \
+    ALU_LUT_PACK(ALU_LUT_SUB_RESULT(a, b),                                         \
+                 ALU_LUT_SUB_RESULT(a, b) == 0u,                                   \
+                 (a) >= (b),                                                       \
+                 ALU_LUT_SUB_RESULT(a, b) >> 3,                                    \
+                 ((((a) ^ (b)) & ((a) ^ ALU_LUT_SUB_RESULT(a, b))) >> 3) & 1u)
+
+#define ALU_LUT_AND(a, b) ALU_LUT_LOGIC((a) & (b), 0u)
+#define ALU_LUT_OR(a, b) ALU_LUT_LOGIC((a) | (b), 0u)
+#define ALU_LUT_XOR(a, b) ALU_LUT_LOGIC((a) ^ (b), 0u)
+#define ALU_LUT_NOT(a) ALU_LUT_LOGIC(~(a) & 0x0Fu, 0u)
+#define ALU_LUT_SHL(a) ALU_LUT_LOGIC(((a) << 1) & 0x0Fu, (a) >> 3)
+#define ALU_LUT_SHR(a) ALU_LUT_LOGIC((a) >> 1, (a) & 1u)
+
+#define ALU_LUT_TABLE16(OP)                                                    \
+    OP(0u), OP(1u), OP(2u), OP(3u), OP(4u), OP(5u), OP(6u), OP(7u),            \
+    OP(8u), OP(9u), OP(10u), OP(11u), OP(12u), OP(13u), OP(14u), OP(15u)
+
+#define ALU_LUT_ROW(OP, a)                                                     \
+    OP(a, 0u), OP(a, 1u), OP(a, 2u), OP(a, 3u),                                \
+    OP(a, 4u), OP(a, 5u), OP(a, 6u), OP(a, 7u),                                \
+    OP(a, 8u), OP(a, 9u), OP(a, 10u), OP(a, 11u),                             \
+    OP(a, 12u), OP(a, 13u), OP(a, 14u), OP(a, 15u)
+
+#define ALU_LUT_TABLE256(OP)                                                   \
+    ALU_LUT_ROW(OP, 0u), ALU_LUT_ROW(OP, 1u), ALU_LUT_ROW(OP, 2u),             \
+    ALU_LUT_ROW(OP, 3u), ALU_LUT_ROW(OP, 4u), ALU_LUT_ROW(OP, 5u),             \
+    ALU_LUT_ROW(OP, 6u), ALU_LUT_ROW(OP, 7u), ALU_LUT_ROW(OP, 8u),             \
+    ALU_LUT_ROW(OP, 9u), ALU_LUT_ROW(OP, 10u), ALU_LUT_ROW(OP, 11u),           \
+    ALU_LUT_ROW(OP, 12u), ALU_LUT_ROW(OP, 13u), ALU_LUT_ROW(OP, 14u),          \
+    ALU_LUT_ROW(OP, 15u)
+
+const uint8_t alu_lut_add_table[256] = {ALU_LUT_TABLE256(ALU_LUT_ADD)};
+const uint8_t alu_lut_sub_table[256] = {ALU_LUT_TABLE256(ALU_LUT_SUB)};
+const uint8_t alu_lut_and_table[256] = {ALU_LUT_TABLE256(ALU_LUT_AND)};
+const uint8_t alu_lut_or_table[256] = {ALU_LUT_TABLE256(ALU_LUT_OR)};
+const uint8_t alu_lut_xor_table[256] = {ALU_LUT_TABLE256(ALU_LUT_XOR)};
+const uint8_t alu_lut_not_table[16] = {ALU_LUT_TABLE16(ALU_LUT_NOT)};
+const uint8_t alu_lut_shl_table[16] = {ALU_LUT_TABLE16(ALU_LUT_SHL)};
+const uint8_t alu_lut_shr_table[16] = {ALU_LUT_TABLE16(ALU_LUT_SHR)};
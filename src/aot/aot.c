@@ -0,0 +1,480 @@
+#include "aot/aot.h"
+
+#include <ctype.h>
+#include <string.h>
+
+#include "isa/isa.h"
+#include "vm/vm.h"
+
+/*
+ * Inline ALU used by generated code. Operands are always 4-bit values, so
+ * each helper is branch-free and computes the same AluResult as alu.c; flags
+ * that are never read are removed by the host compiler.
+ */
+static const char giga_aot_alu_prelude[] =
+    "static inline AluResult giga_aot_flags(uint8_t result, uint8_t carry, uint8_t overflow) {\n"
+    "    AluResult flags;\n"
+    "    flags.result = result;\n"
+    "    flags.zero_flag = (uint8_t)(result == 0);\n"
+    "    flags.carry_flag = carry;\n"
+    "    flags.negative_flag = (uint8_t)(result >> 3);\n"
+    "    flags.overflow_flag = overflow;\n"
+    "    return flags;\n"
+    "}\n"
+    "\n"
+    "static inline AluResult giga_aot_add(uint8_t a, uint8_t b) {\n"
+    "    uint8_t sum = (uint8_t)(a + b);\n"
+    "    uint8_t result = (uint8_t)(sum & 0x0Fu);\n"
+    "    return giga_aot_flags(result, (uint8_t)(sum >> 4),\n"
+    "                          (uint8_t)(((~(a ^ b) & (a ^ result)) >> 3) & 1u));\n"
+    "}\n"
+    "\n"
+    "static inline AluResult giga_aot_sub(uint8_t a, uint8_t b) {\n"
+    "    uint8_t result = (uint8_t)((a - b) & 0x0Fu);\n"
+    "    return giga_aot_flags(result, (uint8_t)(a >= b),\n"
+    "                          (uint8_t)((((a ^ b) & (a ^ result)) >> 3) & 1u));\n"
+    "}\n"
+    "\n"
+    "static inline AluResult giga_aot_adc(uint8_t a, uint8_t b, uint8_t carry) {\n"
+    "    uint8_t sum = (uint8_t)(a + b + (carry != 0));\n"
+    "    uint8_t result = (uint8_t)(sum & 0x0Fu);\n"
+    "    return giga_aot_flags(result, (uint8_t)(sum >> 4),\n"
+    "                          (uint8_t)(((~(a ^ b) & (a ^ result)) >> 3) & 1u));\n"
+    "}\n"
+    "\n"
+    "static inline AluResult giga_aot_sbc(uint8_t a, uint8_t b, uint8_t carry) {\n"
+    "    return giga_aot_adc(a, (uint8_t)(~b & 0x0Fu), carry);\n"
+    "}\n"
+    "\n"
+    "static inline AluResult giga_aot_and(uint8_t a, uint8_t b) { return giga_aot_flags((uint8_t)(a & b), 0, 0); }\n"
+    "static inline AluResult giga_aot_or(uint8_t a, uint8_t b) { return giga_aot_flags((uint8_t)(a | b), 0, 0); }\n"
+    "static inline AluResult giga_aot_xor(uint8_t a, uint8_t b) { return giga_aot_flags((uint8_t)(a ^ b), 0, 0); }\n"
+    "static inline AluResult giga_aot_not(uint8_t a) { return giga_aot_flags((uint8_t)(~a & 0x0Fu), 0, 0); }\n"
+    "static inline AluResult giga_aot_shl(uint8_t a) { return giga_aot_flags((uint8_t)((a << 1) & 0x0Fu), (uint8_t)(a >> 3), 0); }\n"
+    "static inline AluResult giga_aot_shr(uint8_t a) { return giga_aot_flags((uint8_t)(a >> 1), (uint8_t)(a & 1u), 0); }\n"
+    "\n";
+
+static int giga_aot_valid_identifier(const char *name) {
+    if (name == NULL || !(isalpha((unsigned char)name[0]) || name[0] == '_')) {
+        return 0;
+    }
+    for (const char *cursor = name; *cursor != '\0'; ++cursor) {
+        if (!(isalnum((unsigned char)*cursor) || *cursor == '_')) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static uint8_t giga_aot_reg(uint8_t field) {
+    return (uint8_t)(field & (GIGA_VM_REGISTER_COUNT - 1u));
+}
+
+static uint16_t giga_aot_jump_target(GigaInstruction instruction) {
+    return (uint16_t)(instruction.raw & 0x0FFFu);
+}
+
+static uint16_t giga_aot_store_address(GigaInstruction instruction) {
+    return (uint16_t)((instruction.dest_reg << 4) | instruction.imm4);
+}
+
+static int giga_aot_is_self_modifying_store(GigaInstruction instruction, size_t word_count) {
+    return instruction.opcode == GIGA_OP_ST && giga_aot_store_address(instruction) < word_count * 2u;
+}
+
+static int giga_aot_is_branch(GigaInstruction instruction) {
+    return instruction.opcode == GIGA_OP_EXT && GIGA_EXT_IS_BRANCH(instruction.dest_reg);
+}
+
+/* Conditional branches keep their target in [7:0]. */
+static uint16_t giga_aot_branch_target(GigaInstruction instruction) {
+    return (uint16_t)(instruction.raw & 0x00FFu);
+}
+
+static int giga_aot_is_defined(GigaInstruction instruction) {
+    return instruction.opcode != GIGA_OP_EXT || giga_aot_is_branch(instruction) ||
+           instruction.dest_reg == GIGA_EXT_ADC || instruction.dest_reg == GIGA_EXT_SBC ||
+           instruction.dest_reg == GIGA_EXT_CMP || instruction.dest_reg == GIGA_EXT_BANK ||
+           instruction.dest_reg == GIGA_EXT_BANKI || instruction.dest_reg == GIGA_EXT_IN ||
+           instruction.dest_reg == GIGA_EXT_OUT;
+}
+
+/*
+ * BANK, or BANKI with a bank other than 0. Translated code only runs in
+ * bank 0, so BANKI 0 is a no-op there.
+ */
+static int giga_aot_selects_bank(GigaInstruction instruction) {
+    return instruction.opcode == GIGA_OP_EXT &&
+           (instruction.dest_reg == GIGA_EXT_BANK ||
+            (instruction.dest_reg == GIGA_EXT_BANKI && (instruction.raw & 0x00FFu) != 0));
+}
+
+/* IN or OUT. Translated code has no port access; the interpreter does it. */
+static int giga_aot_uses_port(GigaInstruction instruction) {
+    return instruction.opcode == GIGA_OP_EXT &&
+           (instruction.dest_reg == GIGA_EXT_IN || instruction.dest_reg == GIGA_EXT_OUT);
+}
+
+/* Instructions after which control never falls through. */
+static int giga_aot_never_falls_through(GigaInstruction instruction, size_t word_count) {
+    return instruction.opcode == GIGA_OP_JMP ||
+           instruction.opcode == GIGA_OP_HALT ||
+           !giga_aot_is_defined(instruction) ||
+           giga_aot_is_self_modifying_store(instruction, word_count) ||
+           giga_aot_selects_bank(instruction) ||
+           giga_aot_uses_port(instruction);
+}
+
+/* Instructions that end a block: the above, and conditional branches. */
+static int giga_aot_ends_block(GigaInstruction instruction, size_t word_count) {
+    return giga_aot_never_falls_through(instruction, word_count) || giga_aot_is_branch(instruction);
+}
+
+/* C condition on the generated `flags` under which a branch is taken. */
+static const char *giga_aot_branch_condition(GigaInstruction instruction) {
+    switch (instruction.dest_reg) {
+        case GIGA_EXT_JZ: return "flags.zero_flag";
+        case GIGA_EXT_JNZ: return "!flags.zero_flag";
+        case GIGA_EXT_JC: return "flags.carry_flag";
+        default: return "flags.negative_flag";
+    }
+}
+
+/*
+ * Whether generated code charges the instruction a step. giga_vm_run charges
+ * every fetch, including HALT and undefined opcodes; a self-modifying store
+ * a bank switch and port access are left to the interpreter, which charges
+ * them there.
+ */
+static int giga_aot_charged_inline(GigaInstruction instruction, size_t word_count) {
+    return !giga_aot_is_self_modifying_store(instruction, word_count) && !giga_aot_selects_bank(instruction) &&
+           !giga_aot_uses_port(instruction);
+}
+
+static void giga_aot_emit_alu(FILE *output, const char *helper, GigaInstruction instruction, int binary) {
+    uint8_t dest = giga_aot_reg(instruction.dest_reg);
+    if (binary) {
+        fprintf(output, "    flags = giga_aot_%s(r%u, r%u);\n", helper, dest, giga_aot_reg(instruction.src_reg));
+    } else {
+        fprintf(output, "    flags = giga_aot_%s(r%u);\n", helper, dest);
+    }
+    fprintf(output, "    r%u = flags.result;\n", dest);
+}
+
+static void giga_aot_emit_instruction(FILE *output, GigaInstruction instruction, size_t pc, size_t word_count) {
+    uint8_t dest = giga_aot_reg(instruction.dest_reg);
+    uint8_t src = giga_aot_reg(instruction.src_reg);
+
+    switch (instruction.opcode) {
+        case GIGA_OP_NOP:
+            break;
+        case GIGA_OP_MOV:
+            fprintf(output, "    r%u = r%u;\n", dest, src);
+            break;
+        case GIGA_OP_MOVI:
+            fprintf(output, "    r%u = %u;\n", dest, instruction.imm4);
+            break;
+        case GIGA_OP_ADD:
+            giga_aot_emit_alu(output, "add", instruction, 1);
+            break;
+        case GIGA_OP_SUB:
+            giga_aot_emit_alu(output, "sub", instruction, 1);
+            break;
+        case GIGA_OP_AND:
+            giga_aot_emit_alu(output, "and", instruction, 1);
+            break;
+        case GIGA_OP_OR:
+            giga_aot_emit_alu(output, "or", instruction, 1);
+            break;
+        case GIGA_OP_XOR:
+            giga_aot_emit_alu(output, "xor", instruction, 1);
+            break;
+        case GIGA_OP_NOT:
+            giga_aot_emit_alu(output, "not", instruction, 0);
+            break;
+        case GIGA_OP_SHL:
+            giga_aot_emit_alu(output, "shl", instruction, 0);
+            break;
+        case GIGA_OP_SHR:
+            giga_aot_emit_alu(output, "shr", instruction, 0);
+            break;
+        case GIGA_OP_LD:
+            fprintf(output, "    r%u = (uint8_t)(memory[0x%02X] & 0x0Fu);\n",
+                    dest, (unsigned)((instruction.src_reg << 4) | instruction.imm4));
+            break;
+        case GIGA_OP_ST:
+            if (giga_aot_is_self_modifying_store(instruction, word_count)) {
+                fprintf(output, "    pc = %zu; /* store into the program region */\n", pc);
+                fprintf(output, "    goto giga_aot_interpret;\n");
+            } else {
+                unsigned address = (unsigned)giga_aot_store_address(instruction);
+                fprintf(output, "    memory[0x%02X] = r%u;\n", address, src);
+                fprintf(output, "    state->dirty_blocks |= 0x%04Xu;\n", (unsigned)GIGA_VM_DIRTY_BIT(address));
+            }
+            break;
+        case GIGA_OP_JMP: {
+            uint16_t target = giga_aot_jump_target(instruction);
+            if (target < word_count) {
+                fprintf(output, "    goto giga_aot_L%u;\n", target);
+            } else {
+                fprintf(output, "    pc = %u;\n", target);
+                fprintf(output, "    status = GIGA_VM_STATUS_PC_OUT_OF_RANGE;\n");
+                fprintf(output, "    goto giga_aot_exit;\n");
+            }
+            break;
+        }
+        case GIGA_OP_EXT:
+            if (giga_aot_is_branch(instruction)) {
+                uint16_t target = giga_aot_branch_target(instruction);
+                fprintf(output, "    if (%s) {\n", giga_aot_branch_condition(instruction));
+                if (target < word_count) {
+                    fprintf(output, "        goto giga_aot_L%u;\n", target);
+                } else {
+                    fprintf(output, "        pc = %u;\n", target);
+                    fprintf(output, "        status = GIGA_VM_STATUS_PC_OUT_OF_RANGE;\n");
+                    fprintf(output, "        goto giga_aot_exit;\n");
+                }
+                fprintf(output, "    }\n");
+                break;
+            }
+            if (giga_aot_selects_bank(instruction)) {
+                fprintf(output, "    pc = %zu; /* bank switch */\n", pc);
+                fprintf(output, "    goto giga_aot_interpret;\n");
+                break;
+            }
+            if (giga_aot_uses_port(instruction)) {
+                fprintf(output, "    pc = %zu; /* port access */\n", pc);
+                fprintf(output, "    goto giga_aot_interpret;\n");
+                break;
+            }
+            if (instruction.dest_reg == GIGA_EXT_BANKI) {
+                break; /* BANKI 0 */
+            }
+            if (instruction.dest_reg == GIGA_EXT_CMP) {
+                /* flags only; registers in [7:4] and [3:0] */
+                fprintf(output, "    flags = giga_aot_sub(r%u, r%u);\n", giga_aot_reg(instruction.src_reg),
+                        giga_aot_reg(instruction.imm4));
+                break;
+            }
+            if (giga_aot_is_defined(instruction)) {
+                /* registers in [7:4] and [3:0]; the carry comes from the previous flags */
+                uint8_t ext_dest = giga_aot_reg(instruction.src_reg);
+                fprintf(output, "    flags = giga_aot_%s(r%u, r%u, flags.carry_flag);\n",
+                        instruction.dest_reg == GIGA_EXT_ADC ? "adc" : "sbc", ext_dest,
+                        giga_aot_reg(instruction.imm4));
+                fprintf(output, "    r%u = flags.result;\n", ext_dest);
+                break;
+            }
+            fprintf(output, "    pc = %zu;\n", pc);
+            fprintf(output, "    status = GIGA_VM_STATUS_INVALID_OPCODE;\n");
+            fprintf(output, "    goto giga_aot_exit;\n");
+            break;
+        case GIGA_OP_HALT:
+            fprintf(output, "    pc = %zu;\n", pc);
+            fprintf(output, "    status = GIGA_VM_STATUS_HALTED;\n");
+            fprintf(output, "    goto giga_aot_exit;\n");
+            break;
+        default:
+            fprintf(output, "    pc = %zu;\n", pc);
+            fprintf(output, "    status = GIGA_VM_STATUS_INVALID_OPCODE;\n");
+            fprintf(output, "    goto giga_aot_exit;\n");
+            break;
+    }
+}
+
+int giga_aot_write_header(const char *function_name, FILE *output) {
+    if (!giga_aot_valid_identifier(function_name) || output == NULL) {
+        return -1;
+    }
+    fprintf(output,
+            "/* Generated by giga_aot. Do not edit. */\n"
+            "#ifndef GIGA_AOT_%s_H\n"
+            "#define GIGA_AOT_%s_H\n"
+            "\n"
+            "#include \"vm/vm.h\"\n"
+            "\n"
+            "extern const uint16_t %s_program[];\n"
+            "extern const size_t %s_program_words;\n"
+            "\n"
+            "/** Load the translated program into state (giga_vm_load_program). */\n"
+            "int %s_load(GigaVmState *state);\n"
+            "\n"
+            "/** Run the translated program; same results as giga_vm_run. */\n"
+            "GigaVmStatus %s(GigaVmState *state, uint64_t max_steps);\n"
+            "\n"
+            "#endif\n",
+            function_name, function_name, function_name, function_name, function_name, function_name);
+    return ferror(output) ? -2 : 0;
+}
+
+int giga_aot_translate(const uint16_t *program_words,
+                       size_t word_count,
+                       const char *function_name,
+                       FILE *output) {
+    if (program_words == NULL || output == NULL || word_count == 0 ||
+        word_count > GIGA_VM_MAX_PROGRAM_WORDS || !giga_aot_valid_identifier(function_name)) {
+        return -1;
+    }
+
+    GigaInstruction instructions[GIGA_VM_MAX_PROGRAM_WORDS];
+    uint8_t is_leader[GIGA_VM_MAX_PROGRAM_WORDS + 1];
+    memset(is_leader, 0, sizeof(is_leader));
+    is_leader[0] = 1;
+
+    int needs_exit = 0;
+    int uses_memory = 0;
+    int modifies_code = 0;
+    for (size_t pc = 0; pc < word_count; ++pc) {
+        GigaInstruction instruction = giga_decode_instruction(program_words[pc]);
+        instructions[pc] = instruction;
+        if (instruction.opcode == GIGA_OP_JMP || giga_aot_is_branch(instruction)) {
+            uint16_t target = (instruction.opcode == GIGA_OP_JMP) ? giga_aot_jump_target(instruction)
+                                                                  : giga_aot_branch_target(instruction);
+            if (target < word_count) {
+                is_leader[target] = 1;
+            } else {
+                needs_exit = 1;
+            }
+        }
+        if (instruction.opcode == GIGA_OP_HALT || !giga_aot_is_defined(instruction)) {
+            needs_exit = 1;
+        }
+        if (instruction.opcode == GIGA_OP_LD || instruction.opcode == GIGA_OP_ST) {
+            uses_memory = 1;
+        }
+        if (giga_aot_is_self_modifying_store(instruction, word_count)) {
+            modifies_code = 1;
+        }
+        if (giga_aot_ends_block(instruction, word_count)) {
+            is_leader[pc + 1] = 1;
+        }
+    }
+
+    fprintf(output, "/* Generated by giga_aot. Do not edit. */\n");
+    if (modifies_code) {
+        fprintf(output, "#include <string.h>\n\n");
+    }
+    fprintf(output, "#include \"vm/vm.h\"\n\n");
+    fputs(giga_aot_alu_prelude, output);
+
+    fprintf(output, "const uint16_t %s_program[] = {", function_name);
+    for (size_t pc = 0; pc < word_count; ++pc) {
+        fprintf(output, "%s0x%04X", (pc % 8 == 0) ? "\n    " : " ", program_words[pc]);
+        fputc(pc + 1 < word_count ? ',' : '\n', output);
+    }
+    fprintf(output, "};\n");
+    fprintf(output, "const size_t %s_program_words = %zu;\n\n", function_name, word_count);
+
+    if (modifies_code) {
+        fprintf(output, "static const uint8_t %s_image[] = {", function_name);
+        for (size_t pc = 0; pc < word_count; ++pc) {
+            fprintf(output, "%s0x%02X, 0x%02X", (pc % 6 == 0) ? "\n    " : " ",
+                    program_words[pc] & 0xFFu, program_words[pc] >> 8);
+            fputc(pc + 1 < word_count ? ',' : '\n', output);
+        }
+        fprintf(output, "};\n\n");
+    }
+
+    fprintf(output,
+            "int %s_load(GigaVmState *state) {\n"
+            "    return giga_vm_load_program(state, %s_program, %s_program_words);\n"
+            "}\n\n",
+            function_name, function_name, function_name);
+
+    fprintf(output, "GigaVmStatus %s(GigaVmState *state, uint64_t max_steps) {\n", function_name);
+    fprintf(output, "    if (state == NULL) {\n        return GIGA_VM_STATUS_INVALID_STATE;\n    }\n");
+    for (unsigned reg = 0; reg < GIGA_VM_REGISTER_COUNT; ++reg) {
+        fprintf(output, "    uint8_t r%u = state->registers[%u];\n", reg, reg);
+    }
+    fprintf(output,
+            "    AluResult flags = {0, state->flags_zero, state->flags_carry,\n"
+            "                       state->flags_negative, state->flags_overflow};\n"
+            "    uint8_t *memory = state->memory;\n"
+            "    uint64_t remaining_steps = max_steps;\n"
+            "    uint16_t pc = state->program_counter;\n");
+    if (needs_exit) {
+        fprintf(output, "    GigaVmStatus status;\n");
+    }
+    if (!uses_memory) {
+        fprintf(output, "    (void)memory;\n");
+    }
+
+    /*
+     * The program can rewrite itself, and the interpreter keeps running the
+     * rewritten words; only enter translated code while memory still holds
+     * the words it was translated from, and LD/ST address bank 0.
+     */
+    fprintf(output, "    if (state->loaded_program_words != %zu || state->data_bank != 0", word_count);
+    if (modifies_code) {
+        fprintf(output, " ||\n        memcmp(memory, %s_image, sizeof(%s_image)) != 0",
+                function_name, function_name);
+    }
+    fprintf(output, ") {\n        goto giga_aot_interpret;\n    }\n");
+
+    fprintf(output, "\n    switch (pc) {\n");
+    for (size_t pc = 0; pc < word_count; ++pc) {
+        if (is_leader[pc]) {
+            fprintf(output, "        case %zu: goto giga_aot_L%zu;\n", pc, pc);
+        }
+    }
+    fprintf(output, "        default: goto giga_aot_interpret;\n    }\n");
+
+    for (size_t pc = 0; pc < word_count; ++pc) {
+        if (is_leader[pc]) {
+            size_t block_steps = 0;
+            size_t scan = pc;
+            do {
+                block_steps += giga_aot_charged_inline(instructions[scan], word_count) ? 1u : 0u;
+                if (giga_aot_ends_block(instructions[scan], word_count)) {
+                    break;
+                }
+                ++scan;
+            } while (scan < word_count && !is_leader[scan]);
+
+            fprintf(output, "\ngiga_aot_L%zu:\n", pc);
+            if (block_steps > 0) {
+                fprintf(output,
+                        "    if (remaining_steps < %zu) {\n"
+                        "        pc = %zu;\n"
+                        "        goto giga_aot_interpret;\n"
+                        "    }\n"
+                        "    remaining_steps -= %zu;\n",
+                        block_steps, pc, block_steps);
+            }
+        }
+        giga_aot_emit_instruction(output, instructions[pc], pc, word_count);
+    }
+    if (!giga_aot_never_falls_through(instructions[word_count - 1], word_count)) {
+        /* running off the end: the interpreter reports it (or the step limit) */
+        fprintf(output, "    pc = %zu;\n    goto giga_aot_interpret;\n", word_count);
+    }
+
+    fprintf(output, "\ngiga_aot_interpret:\n");
+    for (unsigned reg = 0; reg < GIGA_VM_REGISTER_COUNT; ++reg) {
+        fprintf(output, "    state->registers[%u] = r%u;\n", reg, reg);
+    }
+    fprintf(output,
+            "    state->flags_zero = flags.zero_flag;\n"
+            "    state->flags_carry = flags.carry_flag;\n"
+            "    state->flags_negative = flags.negative_flag;\n"
+            "    state->flags_overflow = flags.overflow_flag;\n"
+            "    state->program_counter = pc;\n"
+            "    return giga_vm_run(state, remaining_steps);\n");
+
+    if (needs_exit) {
+        fprintf(output, "\ngiga_aot_exit:\n");
+        for (unsigned reg = 0; reg < GIGA_VM_REGISTER_COUNT; ++reg) {
+            fprintf(output, "    state->registers[%u] = r%u;\n", reg, reg);
+        }
+        fprintf(output,
+                "    state->flags_zero = flags.zero_flag;\n"
+                "    state->flags_carry = flags.carry_flag;\n"
+                "    state->flags_negative = flags.negative_flag;\n"
+                "    state->flags_overflow = flags.overflow_flag;\n"
+                "    state->program_counter = pc;\n"
+                "    return status;\n");
+    }
+    fprintf(output, "}\n");
+
+    return ferror(output) ? -2 : 0;
+}
@@ -0,0 +1,189 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "assembler/assembler.h"
+#include "aot/aot.h"
+#include "vm/vm.h"
+
+typedef struct {
+    const char *input_path;
+    const char *output_path;
+    const char *header_path;
+    const char *function_name;
+} GigaAotOptions;
+
+static void giga_aot_print_usage(const char *program_name) {
+    fprintf(stderr,
+            "usage: %s [--function NAME] [--output out.c] [--header out.h] program.{asm,bin}\n"
+            "  --function NAME  name of the generated C function (default giga_program)\n"
+            "  --output FILE    write the translation unit to FILE (default stdout)\n"
+            "  --header FILE    also write a header declaring the generated functions\n"
+            "Inputs ending in .bin are read as little-endian 16-bit instruction words;\n"
+            "anything else is assembled.\n",
+            program_name);
+}
+
+static int giga_aot_parse_options(int argc, char **argv, GigaAotOptions *options) {
+    options->input_path = NULL;
+    options->output_path = NULL;
+    options->header_path = NULL;
+    options->function_name = "giga_program";
+
+    for (int index = 1; index < argc; ++index) {
+        const char *argument = argv[index];
+        if (strcmp(argument, "--function") == 0 && index + 1 < argc) {
+            options->function_name = argv[++index];
+        } else if (strcmp(argument, "--output") == 0 && index + 1 < argc) {
+            options->output_path = argv[++index];
+        } else if (strcmp(argument, "--header") == 0 && index + 1 < argc) {
+            options->header_path = argv[++index];
+        } else if (argument[0] == '-' || options->input_path != NULL) {
+            return 1;
+        } else {
+            options->input_path = argument;
+        }
+    }
+    return options->input_path == NULL ? 1 : 0;
+}
+
+static char *giga_aot_read_file(const char *path, size_t *out_length) {
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        return NULL;
+    }
+    if (fseek(file, 0, SEEK_END) != 0) {
+        fclose(file);
+        return NULL;
+    }
+    long file_size = ftell(file);
+    if (file_size < 0 || fseek(file, 0, SEEK_SET) != 0) {
+        fclose(file);
+        return NULL;
+    }
+    char *buffer = (char *)malloc((size_t)file_size + 1u);
+    if (buffer == NULL) {
+        fclose(file);
+        return NULL;
+    }
+    size_t read_length = fread(buffer, 1, (size_t)file_size, file);
+    fclose(file);
+    buffer[read_length] = '\0';
+    *out_length = read_length;
+    return buffer;
+}
+
+static int giga_aot_has_suffix(const char *text, const char *suffix) {
+    size_t text_length = strlen(text);
+    size_t suffix_length = strlen(suffix);
+    return text_length >= suffix_length && strcmp(text + text_length - suffix_length, suffix) == 0;
+}
+
+/* Decode raw little-endian words, matching giga_vm_load_program's layout. */
+static int giga_aot_words_from_binary(const char *bytes, size_t length,
+                                      uint16_t *words, size_t *out_word_count) {
+    if (length == 0 || length % 2u != 0 || length / 2u > GIGA_VM_MAX_PROGRAM_WORDS) {
+        return 1;
+    }
+    for (size_t index = 0; index < length / 2u; ++index) {
+        words[index] = (uint16_t)((uint8_t)bytes[2u * index] |
+                                  ((uint16_t)(uint8_t)bytes[2u * index + 1u] << 8));
+    }
+    *out_word_count = length / 2u;
+    return 0;
+}
+
+static int giga_aot_words_from_source(const char *path, const char *source, size_t length,
+                                      uint16_t *words, size_t *out_word_count) {
+    GigaLexer lexer;
+    giga_lexer_init(&lexer, source, length);
+    GigaParser parser;
+    giga_parser_init(&parser, &lexer);
+    if (giga_parser_parse(&parser) != 0) {
+        fprintf(stderr, "%s:%zu:%zu: error: %s\n", path,
+                parser.error_line, parser.error_column, parser.error_message);
+        giga_parser_free(&parser);
+        return 1;
+    }
+
+    /* giga_assemble leaves it untouched for an empty program, which the word count check reports */
+    GigaAssemblerResult assembled = {0};
+    int result = 0;
+    if (giga_assemble(parser.first_statement, &assembled) != 0 && assembled.has_error) {
+        fprintf(stderr, "%s:%zu:%zu: error: %s\n", path,
+                assembled.error_line, assembled.error_column, assembled.error_message);
+        result = 1;
+    } else if (assembled.word_count == 0 || assembled.word_count > GIGA_VM_MAX_PROGRAM_WORDS) {
+        fprintf(stderr, "%s: error: program must have 1..%d instructions\n",
+                path, GIGA_VM_MAX_PROGRAM_WORDS);
+        result = 1;
+    } else {
+        memcpy(words, assembled.bytecode, assembled.word_count * sizeof(uint16_t));
+        *out_word_count = assembled.word_count;
+    }
+    giga_assembler_free(&assembled);
+    giga_parser_free(&parser);
+    return result;
+}
+
+static int giga_aot_write_file(const char *path, const char *function_name,
+                               const uint16_t *words, size_t word_count, int header) {
+    FILE *output = (path == NULL) ? stdout : fopen(path, "w");
+    if (output == NULL) {
+        fprintf(stderr, "error: cannot write %s\n", path);
+        return 1;
+    }
+    int result = header ? giga_aot_write_header(function_name, output)
+                        : giga_aot_translate(words, word_count, function_name, output);
+    if (output != stdout && fclose(output) != 0) {
+        result = 1;
+    }
+    if (result != 0) {
+        fprintf(stderr, "error: failed to write %s\n", path == NULL ? "<stdout>" : path);
+    }
+    return result;
+}
+
+int main(int argc, char **argv) {
+    GigaAotOptions options;
+    if (giga_aot_parse_options(argc, argv, &options) != 0) {
+        giga_aot_print_usage(argv[0]);
+        return 2;
+    }
+
+    size_t input_length = 0;
+    char *input = giga_aot_read_file(options.input_path, &input_length);
+    if (input == NULL) {
+        fprintf(stderr, "error: cannot read %s\n", options.input_path);
+        return 1;
+    }
+
+    uint16_t words[GIGA_VM_MAX_PROGRAM_WORDS];
+    size_t word_count = 0;
+    int result;
+    if (giga_aot_has_suffix(options.input_path, ".bin")) {
+        result = giga_aot_words_from_binary(input, input_length, words, &word_count);
+        if (result != 0) {
+            fprintf(stderr, "%s: error: expected 1..%d little-endian 16-bit words\n",
+                    options.input_path, GIGA_VM_MAX_PROGRAM_WORDS);
+        }
+    } else {
+        result = giga_aot_words_from_source(options.input_path, input, input_length,
+                                            words, &word_count);
+    }
+    free(input);
+    if (result != 0) {
+        return 1;
+    }
+
+    if (giga_aot_write_file(options.output_path, options.function_name, words, word_count, 0) != 0) {
+        return 1;
+    }
+    if (options.header_path != NULL &&
+        giga_aot_write_file(options.header_path, options.function_name, words, word_count, 1) != 0) {
+        return 1;
+    }
+    return 0;
+}
@@ -50,11 +50,65 @@ static void label_table_free(void) {
     label_table = NULL;
 }
 
+static int mnemonic_to_ext_opcode(const char *mnemonic, size_t length, GigaExtOpcode *out_ext_opcode) {
+    if (length == 3 && strncmp(mnemonic, "ADC", 3) == 0) {
+        *out_ext_opcode = GIGA_EXT_ADC;
+        return 1;
+    }
+    if (length == 3 && strncmp(mnemonic, "SBC", 3) == 0) {
+        *out_ext_opcode = GIGA_EXT_SBC;
+        return 1;
+    }
+    if (length == 3 && strncmp(mnemonic, "CMP", 3) == 0) {
+        *out_ext_opcode = GIGA_EXT_CMP;
+        return 1;
+    }
+    if (length == 4 && strncmp(mnemonic, "BANK", 4) == 0) {
+        *out_ext_opcode = GIGA_EXT_BANK;
+        return 1;
+    }
+    if (length == 5 && strncmp(mnemonic, "BANKI", 5) == 0) {
+        *out_ext_opcode = GIGA_EXT_BANKI;
+        return 1;
+    }
+    if (length == 2 && strncmp(mnemonic, "IN", 2) == 0) {
+        *out_ext_opcode = GIGA_EXT_IN;
+        return 1;
+    }
+    if (length == 3 && strncmp(mnemonic, "OUT", 3) == 0) {
+        *out_ext_opcode = GIGA_EXT_OUT;
+        return 1;
+    }
+    if (length == 2 && strncmp(mnemonic, "JZ", 2) == 0) {
+        *out_ext_opcode = GIGA_EXT_JZ;
+        return 1;
+    }
+    if (length == 3 && strncmp(mnemonic, "JNZ", 3) == 0) {
+        *out_ext_opcode = GIGA_EXT_JNZ;
+        return 1;
+    }
+    if (length == 2 && strncmp(mnemonic, "JC", 2) == 0) {
+        *out_ext_opcode = GIGA_EXT_JC;
+        return 1;
+    }
+    if (length == 2 && strncmp(mnemonic, "JN", 2) == 0) {
+        *out_ext_opcode = GIGA_EXT_JN;
+        return 1;
+    }
+    return 0;
+}
+
 static int mnemonic_to_opcode(const char *mnemonic, size_t length, GigaOpcode *out_opcode) {
     if (mnemonic == NULL || out_opcode == NULL) {
         return 0;
     }
 
+    GigaExtOpcode ext_opcode;
+    if (mnemonic_to_ext_opcode(mnemonic, length, &ext_opcode)) {
+        *out_opcode = GIGA_OP_EXT;
+        return 1;
+    }
+
     if (length == 3 && strncmp(mnemonic, "NOP", 3) == 0) {
         *out_opcode = GIGA_OP_NOP;
         return 1;
@@ -136,40 +190,157 @@ static uint16_t encode_instruction(GigaOpcode opcode, uint8_t dest_reg, uint8_t
                       (uint16_t)imm4);
 }
 
-static int assemble_pass1(GigaStatement *statements, GigaAssemblerResult *result) {
-    uint16_t instruction_address = 0;
-    GigaStatement *stmt = statements;
+/*
+ * Conditional branches take one to three words. One word reaches targets
+ * below 256 by address and any target within -128..127 words of the next
+ * word by offset (GIGA_EXT_JZR..JNR); others become a short branch around
+ * a JMP. JZ and JNZ invert into a branch over the JMP; JC and JN have no
+ * inverse, so they branch to the JMP and a second JMP skips it:
+ *
+ *     JNZ  +2              JC   +2
+ *     JMP  target          JMP  +3
+ *                          JMP  target
+ */
 
-    while (stmt != NULL) {
-        if (stmt->statement_type == GIGA_STMT_LABEL) {
-            const GigaParsedLabel *label = &stmt->data.label;
-            label_table_add(label->label_name, label->label_name_length, instruction_address);
-        } else if (stmt->statement_type == GIGA_STMT_INSTRUCTION) {
-            instruction_address++;
-            if (instruction_address >= GIGA_ASSEMBLER_MAX_WORDS) {
-                assembler_error(result, "Program too large", stmt->data.instruction.source_line, stmt->data.instruction.source_column);
-                return 1;
+/* Condition of a conditional branch (GIGA_EXT_JZ..JN), or -1 for other instructions. */
+static int instruction_branch_condition(const GigaParsedInstruction *inst) {
+    GigaExtOpcode ext_opcode;
+    if (!mnemonic_to_ext_opcode(inst->mnemonic_text, inst->mnemonic_length, &ext_opcode) ||
+        !GIGA_EXT_IS_BRANCH(ext_opcode)) {
+        return -1;
+    }
+    return (int)ext_opcode;
+}
+
+/* Target of a branch's label or immediate operand; 0xFFFF if it has none. */
+static uint16_t instruction_branch_target(const GigaParsedInstruction *inst) {
+    if (inst->operand_count < 1) {
+        return 0xFFFF;
+    }
+    if (inst->operands[0].operand_type == GIGA_OPERAND_LABEL) {
+        return label_table_find(inst->operands[0].value.label_name, inst->operands[0].label_name_length);
+    }
+    if (inst->operands[0].operand_type == GIGA_OPERAND_IMMEDIATE) {
+        return inst->operands[0].value.immediate_value;
+    }
+    return 0xFFFF;
+}
+
+static uint8_t branch_length(GigaExtOpcode condition, uint16_t address, uint16_t target) {
+    long offset = (long)target - ((long)address + 1);
+    if (target <= 0xFF || (offset >= -128 && offset <= 127)) {
+        return 1;
+    }
+    return (condition == GIGA_EXT_JZ || condition == GIGA_EXT_JNZ) ? 2 : 3;
+}
+
+/* One-word branch at address; the target must be in reach (branch_length 1). */
+static uint16_t encode_branch(GigaExtOpcode condition, uint16_t address, uint16_t target) {
+    uint8_t sub_opcode = (uint8_t)condition;
+    uint8_t low = (uint8_t)target;
+    if (target > 0xFF) {
+        sub_opcode = (uint8_t)(condition + (GIGA_EXT_JZR - GIGA_EXT_JZ));
+        low = (uint8_t)(target - (address + 1u));
+    }
+    /* sub-opcode in the dest field, target or offset in the low byte */
+    return encode_instruction(GIGA_OP_EXT, sub_opcode, (low >> 4) & 0x0F, low & 0x0F);
+}
+
+static uint16_t encode_jmp(uint16_t target) {
+    return encode_instruction(GIGA_OP_JMP, (target >> 8) & 0x0F, (target >> 4) & 0x0F, target & 0x0F);
+}
+
+/* Branch in the given number of words at address; 0 if a JMP it needs cannot reach. */
+static int encode_branch_words(GigaExtOpcode condition, uint16_t address, uint16_t target, uint8_t length,
+                               uint16_t *words) {
+    if (length == 1) {
+        words[0] = encode_branch(condition, address, target);
+        return 1;
+    }
+    uint16_t skip = (uint16_t)(address + 3u);
+    if (target > 0x0FFF || (length == 3 && skip > 0x0FFF)) {
+        return 0;
+    }
+    if (length == 2) {
+        GigaExtOpcode inverse = (condition == GIGA_EXT_JZ) ? GIGA_EXT_JNZ : GIGA_EXT_JZ;
+        words[0] = encode_branch(inverse, address, (uint16_t)(address + 2u));
+        words[1] = encode_jmp(target);
+    } else {
+        words[0] = encode_branch(condition, address, (uint16_t)(address + 2u));
+        words[1] = encode_jmp(skip);
+        words[2] = encode_jmp(target);
+    }
+    return 1;
+}
+
+/*
+ * Lay out the program: label addresses and the length of each instruction
+ * in instruction_words. Branches start at one word and are lengthened while
+ * any cannot reach its target; lengths only grow, so this settles.
+ */
+static int assemble_pass1(GigaStatement *statements, uint8_t *instruction_words, GigaAssemblerResult *result) {
+    for (;;) {
+        size_t instruction_address = 0;
+        size_t instruction_index = 0;
+        label_table_free();
+        for (GigaStatement *stmt = statements; stmt != NULL; stmt = stmt->next_statement) {
+            if (stmt->statement_type == GIGA_STMT_LABEL) {
+                const GigaParsedLabel *label = &stmt->data.label;
+                label_table_add(label->label_name, label->label_name_length, (uint16_t)instruction_address);
+            } else if (stmt->statement_type == GIGA_STMT_INSTRUCTION) {
+                instruction_address += instruction_words[instruction_index++];
+                if (instruction_address > GIGA_ASSEMBLER_MAX_WORDS) {
+                    assembler_error(result, "Program too large", stmt->data.instruction.source_line, stmt->data.instruction.source_column);
+                    return 1;
+                }
             }
         }
-        stmt = stmt->next_statement;
-    }
 
-    return 0;
+        int grew = 0;
+        size_t branch_address = 0;
+        instruction_index = 0;
+        for (GigaStatement *stmt = statements; stmt != NULL; stmt = stmt->next_statement) {
+            if (stmt->statement_type != GIGA_STMT_INSTRUCTION) {
+                continue;
+            }
+            const GigaParsedInstruction *inst = &stmt->data.instruction;
+            int condition = instruction_branch_condition(inst);
+            uint16_t target = (condition >= 0) ? instruction_branch_target(inst) : 0xFFFF;
+            uint8_t length = instruction_words[instruction_index];
+            if (target != 0xFFFF) {
+                uint8_t needed = branch_length((GigaExtOpcode)condition, (uint16_t)branch_address, target);
+                if (needed > length) {
+                    instruction_words[instruction_index] = needed;
+                    grew = 1;
+                }
+            }
+            branch_address += length;
+            ++instruction_index;
+        }
+        if (!grew) {
+            result->word_count = instruction_address; /* pass 2 sizes its arrays from this */
+            return 0;
+        }
+    }
 }
 
-static int assemble_pass2(GigaStatement *statements, GigaAssemblerResult *result) {
-    result->bytecode = (uint16_t *)calloc(GIGA_ASSEMBLER_MAX_WORDS, sizeof(uint16_t));
-    if (result->bytecode == NULL) {
+static int assemble_pass2(GigaStatement *statements, const uint8_t *instruction_words, GigaAssemblerResult *result) {
+    size_t capacity = result->word_count ? result->word_count : 1u;
+    result->bytecode = (uint16_t *)calloc(capacity, sizeof(uint16_t));
+    result->source_lines = (size_t *)calloc(capacity, sizeof(size_t));
+    if (result->bytecode == NULL || result->source_lines == NULL) {
         assembler_error(result, "Out of memory", 0, 0);
         return 1;
     }
 
     result->word_count = 0;
+    size_t instruction_index = 0;
     GigaStatement *stmt = statements;
 
     while (stmt != NULL) {
         if (stmt->statement_type == GIGA_STMT_INSTRUCTION) {
             const GigaParsedInstruction *inst = &stmt->data.instruction;
+            size_t emitted = 0; /* words a case wrote itself */
             GigaOpcode opcode;
             if (!mnemonic_to_opcode(inst->mnemonic_text, inst->mnemonic_length, &opcode)) {
                 assembler_error(result, "Unknown mnemonic", inst->source_line, inst->source_column);
@@ -220,6 +391,102 @@ static int assemble_pass2(GigaStatement *statements, GigaAssemblerResult *result
                     src_reg = inst->operands[1].value.register_index;
                     break;
 
+                case GIGA_OP_EXT: {
+                    GigaExtOpcode ext_opcode = GIGA_EXT_ADC;
+                    mnemonic_to_ext_opcode(inst->mnemonic_text, inst->mnemonic_length, &ext_opcode);
+                    if (GIGA_EXT_IS_BRANCH(ext_opcode)) {
+                        if (inst->operand_count < 1) {
+                            assembler_error(result, "Branch requires 1 operand", inst->source_line, inst->source_column);
+                            return 1;
+                        }
+                        uint16_t target;
+                        if (inst->operands[0].operand_type == GIGA_OPERAND_LABEL) {
+                            target = label_table_find(inst->operands[0].value.label_name,
+                                                      inst->operands[0].label_name_length);
+                            if (target == 0xFFFF) {
+                                assembler_error(result, "Undefined label", inst->source_line, inst->source_column);
+                                return 1;
+                            }
+                        } else if (inst->operands[0].operand_type == GIGA_OPERAND_IMMEDIATE) {
+                            target = inst->operands[0].value.immediate_value;
+                        } else {
+                            assembler_error(result, "Branch operand must be label or immediate", inst->source_line, inst->source_column);
+                            return 1;
+                        }
+                        uint8_t length = instruction_words[instruction_index];
+                        if (!encode_branch_words(ext_opcode, (uint16_t)result->word_count, target, length,
+                                                 result->bytecode + result->word_count)) {
+                            assembler_error(result, "Branch target out of range", inst->source_line, inst->source_column);
+                            return 1;
+                        }
+                        emitted = length;
+                        break;
+                    }
+                    if (ext_opcode == GIGA_EXT_BANK) {
+                        if (inst->operand_count < 1) {
+                            assembler_error(result, "BANK requires 1 operand", inst->source_line, inst->source_column);
+                            return 1;
+                        }
+                        if (inst->operands[0].operand_type != GIGA_OPERAND_REGISTER) {
+                            assembler_error(result, "BANK operand must be register", inst->source_line, inst->source_column);
+                            return 1;
+                        }
+                        dest_reg = (uint8_t)ext_opcode;
+                        src_reg = inst->operands[0].value.register_index;
+                        break;
+                    }
+                    if (ext_opcode == GIGA_EXT_BANKI) {
+                        if (inst->operand_count < 1) {
+                            assembler_error(result, "BANKI requires 1 operand", inst->source_line, inst->source_column);
+                            return 1;
+                        }
+                        if (inst->operands[0].operand_type != GIGA_OPERAND_IMMEDIATE) {
+                            assembler_error(result, "BANKI operand must be immediate", inst->source_line, inst->source_column);
+                            return 1;
+                        }
+                        /* bank number in the low byte, like a branch target */
+                        uint8_t bank = inst->operands[0].value.immediate_value;
+                        dest_reg = (uint8_t)ext_opcode;
+                        src_reg = (bank >> 4) & 0x0F;
+                        imm4 = bank & 0x0F;
+                        break;
+                    }
+                    if (ext_opcode == GIGA_EXT_IN || ext_opcode == GIGA_EXT_OUT) {
+                        /* IN Rd, port and OUT port, Rs: the port takes the place of a register */
+                        size_t reg_index = (ext_opcode == GIGA_EXT_IN) ? 0 : 1;
+                        if (inst->operand_count < 2) {
+                            assembler_error(result, "Instruction requires 2 operands", inst->source_line, inst->source_column);
+                            return 1;
+                        }
+                        if (inst->operands[reg_index].operand_type != GIGA_OPERAND_REGISTER ||
+                            inst->operands[1 - reg_index].operand_type != GIGA_OPERAND_IMMEDIATE) {
+                            assembler_error(result, "Port operand must be immediate and the other a register",
+                                            inst->source_line, inst->source_column);
+                            return 1;
+                        }
+                        dest_reg = (uint8_t)ext_opcode;
+                        src_reg = (reg_index == 0) ? inst->operands[0].value.register_index
+                                                   : inst->operands[0].value.immediate_value;
+                        imm4 = (reg_index == 0) ? inst->operands[1].value.immediate_value
+                                                : inst->operands[1].value.register_index;
+                        break;
+                    }
+                    if (inst->operand_count < 2) {
+                        assembler_error(result, "Instruction requires 2 operands", inst->source_line, inst->source_column);
+                        return 1;
+                    }
+                    if (inst->operands[0].operand_type != GIGA_OPERAND_REGISTER ||
+                        inst->operands[1].operand_type != GIGA_OPERAND_REGISTER) {
+                        assembler_error(result, "Operands must be registers", inst->source_line, inst->source_column);
+                        return 1;
+                    }
+                    /* sub-opcode in the dest field, registers in the two below */
+                    dest_reg = (uint8_t)ext_opcode;
+                    src_reg = inst->operands[0].value.register_index;
+                    imm4 = inst->operands[1].value.register_index;
+                    break;
+                }
+
                 case GIGA_OP_NOT:
                 case GIGA_OP_SHL:
                 case GIGA_OP_SHR:
@@ -282,6 +549,11 @@ static int assemble_pass2(GigaStatement *statements, GigaAssemblerResult *result
                             assembler_error(result, "Undefined label", inst->source_line, inst->source_column);
                             return 1;
                         }
+                        if (target > 0x0FFF) {
+                            /* a label after the last of 4096 words */
+                            assembler_error(result, "JMP target out of range", inst->source_line, inst->source_column);
+                            return 1;
+                        }
                         dest_reg = (target >> 8) & 0x0F;
                         src_reg = (target >> 4) & 0x0F;
                         imm4 = target & 0x0F;
@@ -304,7 +576,14 @@ static int assemble_pass2(GigaStatement *statements, GigaAssemblerResult *result
                     return 1;
             }
 
-            result->bytecode[result->word_count++] = encode_instruction(opcode, dest_reg, src_reg, imm4);
+            if (emitted == 0) {
+                result->bytecode[result->word_count] = encode_instruction(opcode, dest_reg, src_reg, imm4);
+                emitted = 1;
+            }
+            for (size_t word = 0; word < emitted; ++word) {
+                result->source_lines[result->word_count++] = inst->source_line;
+            }
+            ++instruction_index;
         }
 
         stmt = stmt->next_statement;
@@ -313,6 +592,37 @@ static int assemble_pass2(GigaStatement *statements, GigaAssemblerResult *result
     return 0;
 }
 
+/* Labels in source order, addressed as in pass 1. */
+static int assemble_collect_labels(GigaStatement *statements, const uint8_t *instruction_words,
+                                   GigaAssemblerResult *result) {
+    size_t label_count = 0;
+    for (GigaStatement *stmt = statements; stmt != NULL; stmt = stmt->next_statement) {
+        label_count += (stmt->statement_type == GIGA_STMT_LABEL);
+    }
+    if (label_count == 0) {
+        return 0;
+    }
+    result->labels = (GigaAssemblerLabel *)calloc(label_count, sizeof(GigaAssemblerLabel));
+    if (result->labels == NULL) {
+        assembler_error(result, "Out of memory", 0, 0);
+        return 1;
+    }
+
+    uint16_t instruction_address = 0;
+    size_t instruction_index = 0;
+    for (GigaStatement *stmt = statements; stmt != NULL; stmt = stmt->next_statement) {
+        if (stmt->statement_type == GIGA_STMT_LABEL) {
+            GigaAssemblerLabel *label = &result->labels[result->label_count++];
+            label->name = stmt->data.label.label_name;
+            label->name_length = stmt->data.label.label_name_length;
+            label->address = instruction_address;
+        } else if (stmt->statement_type == GIGA_STMT_INSTRUCTION) {
+            instruction_address += instruction_words[instruction_index++];
+        }
+    }
+    return 0;
+}
+
 int giga_assemble(GigaStatement *statements, GigaAssemblerResult *result) {
     if (statements == NULL || result == NULL) {
         return 1;
@@ -320,6 +630,9 @@ int giga_assemble(GigaStatement *statements, GigaAssemblerResult *result) {
 
     result->bytecode = NULL;
     result->word_count = 0;
+    result->source_lines = NULL;
+    result->labels = NULL;
+    result->label_count = 0;
     result->has_error = 0;
     result->error_message = NULL;
     result->error_line = 0;
@@ -327,19 +640,31 @@ int giga_assemble(GigaStatement *statements, GigaAssemblerResult *result) {
 
     label_table_free();
 
-    if (assemble_pass1(statements, result) != 0) {
-        return 1;
+    /* words per instruction, one until pass 1 lengthens a branch */
+    size_t instruction_count = 0;
+    for (GigaStatement *stmt = statements; stmt != NULL; stmt = stmt->next_statement) {
+        instruction_count += (stmt->statement_type == GIGA_STMT_INSTRUCTION);
     }
-
-    if (assemble_pass2(statements, result) != 0) {
-        if (result->bytecode != NULL) {
-            free(result->bytecode);
-            result->bytecode = NULL;
-        }
+    uint8_t *instruction_words = (uint8_t *)malloc(instruction_count ? instruction_count : 1u);
+    if (instruction_words == NULL) {
+        assembler_error(result, "Out of memory", 0, 0);
         return 1;
     }
+    memset(instruction_words, 1, instruction_count);
 
-    return 0;
+    int status = 0;
+    if (assemble_pass1(statements, instruction_words, result) != 0) {
+        status = 1;
+    } else if (assemble_pass2(statements, instruction_words, result) != 0 ||
+               assemble_collect_labels(statements, instruction_words, result) != 0) {
+        free(result->bytecode);
+        result->bytecode = NULL;
+        free(result->source_lines);
+        result->source_lines = NULL;
+        status = 1;
+    }
+    free(instruction_words);
+    return status;
 }
 
 void giga_assembler_free(GigaAssemblerResult *result) {
@@ -350,6 +675,11 @@ void giga_assembler_free(GigaAssemblerResult *result) {
         free(result->bytecode);
         result->bytecode = NULL;
     }
+    free(result->source_lines);
+    result->source_lines = NULL;
+    free(result->labels);
+    result->labels = NULL;
+    result->label_count = 0;
     result->word_count = 0;
     label_table_free();
 }
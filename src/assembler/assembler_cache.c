@@ -0,0 +1,490 @@
+#define _DEFAULT_SOURCE
+
+#include "assembler/assembler_cache.h"
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define GIGA_ASSEMBLER_CACHE_MAGIC "GAC\x1a"
+#define GIGA_ASSEMBLER_CACHE_FORMAT 2u
+#define GIGA_ASSEMBLER_CACHE_BYTE_ORDER 0x0102u
+#define GIGA_ASSEMBLER_CACHE_SUFFIX ".gac"
+#define GIGA_ASSEMBLER_CACHE_TEMPORARY ".gac." /* then six mkstemp characters */
+
+/*
+ * Entry layout: the header, then word_count source lines (uint32_t), then
+ * label_count labels, then word_count instruction words, then the
+ * source_length bytes of source text. All host-endian; entries from a host
+ * of the other byte order fail the byte_order check. The hash only names
+ * the entry: a hit needs the stored source to equal the source looked up,
+ * so colliding sources never share an entry.
+ */
+typedef struct {
+    char magic[4];                     /* GIGA_ASSEMBLER_CACHE_MAGIC */
+    uint16_t format;                   /* GIGA_ASSEMBLER_CACHE_FORMAT */
+    uint16_t byte_order;               /* GIGA_ASSEMBLER_CACHE_BYTE_ORDER as written */
+    uint32_t assembler_version;        /* GIGA_ASSEMBLER_VERSION */
+    uint32_t word_count;
+    uint32_t label_count;
+    uint32_t reserved;                 /* zero */
+    uint64_t source_hash;              /* giga_assembler_hash of the source, seeded with the version */
+    uint64_t source_length;
+    uint64_t payload_hash;             /* giga_assembler_hash of everything after the header */
+} GigaAssemblerCacheHeader;
+
+typedef struct {
+    uint32_t name_offset;              /* into the source text */
+    uint32_t name_length;
+    uint32_t address;
+} GigaAssemblerCacheLabel;
+
+_Static_assert(sizeof(GigaAssemblerCacheHeader) == 48, "cache header layout changed");
+_Static_assert(sizeof(GigaAssemblerCacheLabel) == 12, "cache label layout changed");
+
+struct GigaAssemblerCache {
+    char *directory;
+    _Atomic uint64_t hits;
+    _Atomic uint64_t misses;
+    _Atomic uint64_t write_failures;
+};
+
+/* ---- XXH64 ---- */
+
+#define GIGA_HASH_PRIME1 0x9E3779B185EBCA87u
+#define GIGA_HASH_PRIME2 0xC2B2AE3D27D4EB4Fu
+#define GIGA_HASH_PRIME3 0x165667B19E3779F9u
+#define GIGA_HASH_PRIME4 0x85EBCA77C2B2AE63u
+#define GIGA_HASH_PRIME5 0x27D4EB2F165667C5u
+
+static inline uint64_t giga_hash_rotl(uint64_t value, unsigned bits) {
+    return (value << bits) | (value >> (64u - bits));
+}
+
+/* Little-endian loads; compilers turn these into single loads on x86 and ARM. */
+static inline uint64_t giga_hash_read64(const uint8_t *bytes) {
+    uint64_t value = 0;
+    for (unsigned index = 0; index < 8u; ++index) {
+        value |= (uint64_t)bytes[index] << (8u * index);
+    }
+    return value;
+}
+
+static inline uint64_t giga_hash_read32(const uint8_t *bytes) {
+    return (uint64_t)bytes[0] | ((uint64_t)bytes[1] << 8) | ((uint64_t)bytes[2] << 16) |
+           ((uint64_t)bytes[3] << 24);
+}
+
+static inline uint64_t giga_hash_round(uint64_t accumulator, uint64_t input) {
+    accumulator += input * GIGA_HASH_PRIME2;
+    return giga_hash_rotl(accumulator, 31) * GIGA_HASH_PRIME1;
+}
+
+static inline uint64_t giga_hash_merge(uint64_t hash, uint64_t accumulator) {
+    hash ^= giga_hash_round(0, accumulator);
+    return hash * GIGA_HASH_PRIME1 + GIGA_HASH_PRIME4;
+}
+
+uint64_t giga_assembler_hash(const void *bytes, size_t length, uint64_t seed) {
+    const uint8_t *input = (const uint8_t *)bytes;
+    const uint8_t *end = input + length;
+    uint64_t hash;
+
+    if (length >= 32u) {
+        /* four independent lanes over 32-byte stripes */
+        uint64_t lane1 = seed + GIGA_HASH_PRIME1 + GIGA_HASH_PRIME2;
+        uint64_t lane2 = seed + GIGA_HASH_PRIME2;
+        uint64_t lane3 = seed;
+        uint64_t lane4 = seed - GIGA_HASH_PRIME1;
+        const uint8_t *last_stripe = end - 32u;
+        do {
+            lane1 = giga_hash_round(lane1, giga_hash_read64(input));
+            lane2 = giga_hash_round(lane2, giga_hash_read64(input + 8));
+            lane3 = giga_hash_round(lane3, giga_hash_read64(input + 16));
+            lane4 = giga_hash_round(lane4, giga_hash_read64(input + 24));
+            input += 32;
+        } while (input <= last_stripe);
+        hash = giga_hash_rotl(lane1, 1) + giga_hash_rotl(lane2, 7) + giga_hash_rotl(lane3, 12) +
+               giga_hash_rotl(lane4, 18);
+        hash = giga_hash_merge(hash, lane1);
+        hash = giga_hash_merge(hash, lane2);
+        hash = giga_hash_merge(hash, lane3);
+        hash = giga_hash_merge(hash, lane4);
+    } else {
+        hash = seed + GIGA_HASH_PRIME5;
+    }
+    hash += (uint64_t)length;
+
+    while (end - input >= 8) {
+        hash ^= giga_hash_round(0, giga_hash_read64(input));
+        hash = giga_hash_rotl(hash, 27) * GIGA_HASH_PRIME1 + GIGA_HASH_PRIME4;
+        input += 8;
+    }
+    if (end - input >= 4) {
+        hash ^= giga_hash_read32(input) * GIGA_HASH_PRIME1;
+        hash = giga_hash_rotl(hash, 23) * GIGA_HASH_PRIME2 + GIGA_HASH_PRIME3;
+        input += 4;
+    }
+    while (input < end) {
+        hash ^= *input++ * GIGA_HASH_PRIME5;
+        hash = giga_hash_rotl(hash, 11) * GIGA_HASH_PRIME1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= GIGA_HASH_PRIME2;
+    hash ^= hash >> 29;
+    hash *= GIGA_HASH_PRIME3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+/* ---- cache ---- */
+
+GigaAssemblerCache *giga_assembler_cache_open(const char *directory) {
+    if (directory == NULL || directory[0] == '\0') {
+        return NULL;
+    }
+    if (mkdir(directory, 0777) != 0 && errno != EEXIST) {
+        return NULL;
+    }
+    struct stat info;
+    if (stat(directory, &info) != 0 || !S_ISDIR(info.st_mode)) {
+        return NULL;
+    }
+    GigaAssemblerCache *cache = (GigaAssemblerCache *)calloc(1, sizeof(*cache));
+    size_t length = strlen(directory);
+    char *copy = (char *)malloc(length + 1u);
+    if (cache == NULL || copy == NULL) {
+        free(cache);
+        free(copy);
+        return NULL;
+    }
+    memcpy(copy, directory, length + 1u);
+    cache->directory = copy;
+    atomic_init(&cache->hits, 0);
+    atomic_init(&cache->misses, 0);
+    atomic_init(&cache->write_failures, 0);
+    return cache;
+}
+
+void giga_assembler_cache_close(GigaAssemblerCache *cache) {
+    if (cache == NULL) {
+        return;
+    }
+    free(cache->directory);
+    free(cache);
+}
+
+void giga_assembler_cache_stats(const GigaAssemblerCache *cache, GigaAssemblerCacheStats *stats) {
+    if (stats == NULL) {
+        return;
+    }
+    memset(stats, 0, sizeof(*stats));
+    if (cache == NULL) {
+        return;
+    }
+    GigaAssemblerCache *counters = (GigaAssemblerCache *)cache; /* atomic loads take non-const pointers */
+    stats->hits = atomic_load_explicit(&counters->hits, memory_order_relaxed);
+    stats->misses = atomic_load_explicit(&counters->misses, memory_order_relaxed);
+    stats->write_failures = atomic_load_explicit(&counters->write_failures, memory_order_relaxed);
+}
+
+/* <directory>/<16 hex digits>.gac; the caller frees the path. */
+static char *giga_assembler_cache_path(const GigaAssemblerCache *cache, uint64_t source_hash) {
+    size_t length = strlen(cache->directory) + 1u + 16u + sizeof(GIGA_ASSEMBLER_CACHE_SUFFIX);
+    char *path = (char *)malloc(length);
+    if (path != NULL) {
+        snprintf(path, length, "%s/%016llx%s", cache->directory, (unsigned long long)source_hash,
+                 GIGA_ASSEMBLER_CACHE_SUFFIX);
+    }
+    return path;
+}
+
+/* Size of an entry's payload; -1 if the counts are out of range. */
+static int giga_assembler_cache_payload_bytes(uint64_t word_count, uint64_t label_count, uint64_t source_length,
+                                              size_t *out_bytes) {
+    if (word_count > GIGA_ASSEMBLER_MAX_WORDS || label_count > UINT32_MAX / sizeof(GigaAssemblerCacheLabel) ||
+        source_length > SIZE_MAX / 2u) {
+        return -1;
+    }
+    *out_bytes = (size_t)word_count * (sizeof(uint32_t) + sizeof(uint16_t)) +
+                 (size_t)label_count * sizeof(GigaAssemblerCacheLabel) + (size_t)source_length;
+    return 0;
+}
+
+/* Read the whole file at path; NULL if it is missing, unreadable or shorter than minimum_bytes. */
+static uint8_t *giga_assembler_cache_read(const char *path, size_t minimum_bytes, size_t *out_bytes) {
+    int descriptor = open(path, O_RDONLY);
+    if (descriptor < 0) {
+        return NULL;
+    }
+    struct stat info;
+    uint8_t *bytes = NULL;
+    if (fstat(descriptor, &info) == 0 && S_ISREG(info.st_mode) && (uint64_t)info.st_size >= minimum_bytes &&
+        (uint64_t)info.st_size <= SIZE_MAX) {
+        size_t size = (size_t)info.st_size;
+        bytes = (uint8_t *)malloc(size);
+        size_t done = 0;
+        while (bytes != NULL && done < size) {
+            ssize_t count = read(descriptor, bytes + done, size - done);
+            if (count <= 0) {
+                if (count < 0 && errno == EINTR) {
+                    continue;
+                }
+                free(bytes);
+                bytes = NULL;
+                break;
+            }
+            done += (size_t)count;
+        }
+        *out_bytes = size;
+    }
+    close(descriptor);
+    return bytes;
+}
+
+/* Fill result from the entry at path; 0 on a hit, -1 if the entry is missing or does not match. */
+static int giga_assembler_cache_load(const char *path, const char *source, size_t length, uint64_t source_hash,
+                                     GigaAssemblerResult *result) {
+    size_t file_bytes = 0;
+    uint8_t *file = giga_assembler_cache_read(path, sizeof(GigaAssemblerCacheHeader), &file_bytes);
+    if (file == NULL) {
+        return -1;
+    }
+    GigaAssemblerCacheHeader header;
+    memcpy(&header, file, sizeof(header));
+    const uint8_t *payload = file + sizeof(header);
+    size_t payload_bytes = 0;
+    if (giga_assembler_cache_payload_bytes(header.word_count, header.label_count, header.source_length,
+                                           &payload_bytes) != 0 ||
+        memcmp(header.magic, GIGA_ASSEMBLER_CACHE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.format != GIGA_ASSEMBLER_CACHE_FORMAT || header.byte_order != GIGA_ASSEMBLER_CACHE_BYTE_ORDER ||
+        header.assembler_version != GIGA_ASSEMBLER_VERSION || header.source_hash != source_hash ||
+        header.source_length != length ||
+        file_bytes != sizeof(header) + payload_bytes ||
+        memcmp(payload + payload_bytes - length, source, length) != 0 ||
+        giga_assembler_hash(payload, payload_bytes, source_hash) != header.payload_hash) {
+        free(file);
+        return -1;
+    }
+
+    size_t word_count = header.word_count;
+    size_t label_count = header.label_count;
+    result->bytecode = (uint16_t *)malloc((word_count + 1u) * sizeof(uint16_t));
+    result->source_lines = (size_t *)malloc((word_count + 1u) * sizeof(size_t));
+    result->labels = (GigaAssemblerLabel *)malloc((label_count + 1u) * sizeof(GigaAssemblerLabel));
+    if (result->bytecode == NULL || result->source_lines == NULL || result->labels == NULL) {
+        giga_assembler_free(result);
+        free(file);
+        return -1;
+    }
+    const uint8_t *lines = payload;
+    const uint8_t *labels = lines + word_count * sizeof(uint32_t);
+    const uint8_t *words = labels + label_count * sizeof(GigaAssemblerCacheLabel);
+    for (size_t index = 0; index < word_count; ++index) {
+        uint32_t line;
+        memcpy(&line, lines + index * sizeof(line), sizeof(line));
+        result->source_lines[index] = line;
+    }
+    for (size_t index = 0; index < label_count; ++index) {
+        GigaAssemblerCacheLabel label;
+        memcpy(&label, labels + index * sizeof(label), sizeof(label));
+        if ((uint64_t)label.name_offset + label.name_length > length || label.address > word_count) {
+            giga_assembler_free(result);
+            free(file);
+            return -1;
+        }
+        result->labels[index].name = source + label.name_offset;
+        result->labels[index].name_length = label.name_length;
+        result->labels[index].address = (uint16_t)label.address;
+    }
+    memcpy(result->bytecode, words, word_count * sizeof(uint16_t));
+    result->word_count = word_count;
+    result->label_count = label_count;
+    free(file);
+    return 0;
+}
+
+/* Write result as the entry at path, through a temporary file; 0 on success. */
+static int giga_assembler_cache_store(const GigaAssemblerCache *cache, const char *path, const char *source,
+                                      size_t length, uint64_t source_hash, const GigaAssemblerResult *result) {
+    size_t payload_bytes = 0;
+    if (giga_assembler_cache_payload_bytes(result->word_count, result->label_count, length, &payload_bytes) != 0) {
+        return -1;
+    }
+    uint8_t *file = (uint8_t *)calloc(1, sizeof(GigaAssemblerCacheHeader) + payload_bytes);
+    if (file == NULL) {
+        return -1;
+    }
+    uint8_t *lines = file + sizeof(GigaAssemblerCacheHeader);
+    uint8_t *labels = lines + result->word_count * sizeof(uint32_t);
+    uint8_t *words = labels + result->label_count * sizeof(GigaAssemblerCacheLabel);
+    for (size_t index = 0; index < result->word_count; ++index) {
+        uint32_t line = (result->source_lines[index] > UINT32_MAX) ? UINT32_MAX
+                                                                   : (uint32_t)result->source_lines[index];
+        memcpy(lines + index * sizeof(line), &line, sizeof(line));
+    }
+    for (size_t index = 0; index < result->label_count; ++index) {
+        const GigaAssemblerLabel *label = &result->labels[index];
+        if (label->name < source || label->name_length > length ||
+            (size_t)(label->name - source) > length - label->name_length) {
+            free(file);
+            return -1; /* names must point into this source */
+        }
+        GigaAssemblerCacheLabel stored = {
+            .name_offset = (uint32_t)(label->name - source),
+            .name_length = (uint32_t)label->name_length,
+            .address = label->address
+        };
+        memcpy(labels + index * sizeof(stored), &stored, sizeof(stored));
+    }
+    memcpy(words, result->bytecode, result->word_count * sizeof(uint16_t));
+    memcpy(words + result->word_count * sizeof(uint16_t), source, length);
+
+    GigaAssemblerCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, GIGA_ASSEMBLER_CACHE_MAGIC, sizeof(header.magic));
+    header.format = GIGA_ASSEMBLER_CACHE_FORMAT;
+    header.byte_order = GIGA_ASSEMBLER_CACHE_BYTE_ORDER;
+    header.assembler_version = GIGA_ASSEMBLER_VERSION;
+    header.word_count = (uint32_t)result->word_count;
+    header.label_count = (uint32_t)result->label_count;
+    header.source_hash = source_hash;
+    header.source_length = length;
+    header.payload_hash = giga_assembler_hash(lines, payload_bytes, source_hash);
+    memcpy(file, &header, sizeof(header));
+
+    /* a unique temporary beside the entry, renamed over it, so readers see no partial entry */
+    size_t temporary_length = strlen(cache->directory) + sizeof("/" GIGA_ASSEMBLER_CACHE_TEMPORARY "XXXXXX");
+    char *temporary = (char *)malloc(temporary_length);
+    if (temporary == NULL) {
+        free(file);
+        return -1;
+    }
+    snprintf(temporary, temporary_length, "%s/" GIGA_ASSEMBLER_CACHE_TEMPORARY "XXXXXX", cache->directory);
+    int status = -1;
+    int descriptor = mkstemp(temporary);
+    if (descriptor >= 0) {
+        size_t file_bytes = sizeof(header) + payload_bytes;
+        size_t done = 0;
+        while (done < file_bytes) {
+            ssize_t count = write(descriptor, file + done, file_bytes - done);
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count <= 0) {
+                break;
+            }
+            done += (size_t)count;
+        }
+        /* mkstemp creates 0600; entries are as shareable as the directory */
+        if (close(descriptor) == 0 && done == file_bytes && chmod(temporary, 0644) == 0 &&
+            rename(temporary, path) == 0) {
+            status = 0;
+        } else {
+            unlink(temporary);
+        }
+    }
+    free(temporary);
+    free(file);
+    return status;
+}
+
+/* Lex, parse and assemble source into result, reporting parse errors there too. */
+static int giga_assembler_cache_build(const char *source, size_t length, GigaAssemblerResult *result) {
+    GigaLexer lexer;
+    giga_lexer_init(&lexer, source, length);
+    GigaParser parser;
+    giga_parser_init(&parser, &lexer);
+    int status = 0;
+    if (giga_parser_parse(&parser) != 0) {
+        result->has_error = 1;
+        result->error_message = parser.error_message;
+        result->error_line = parser.error_line;
+        result->error_column = parser.error_column;
+        status = 1;
+    } else if (giga_assemble(parser.first_statement, result) != 0) {
+        if (!result->has_error) {
+            result->has_error = 1; /* giga_assemble refuses an empty program without a message */
+            result->error_message = "program has no statements";
+        }
+        status = 1;
+    }
+    giga_parser_free(&parser);
+    return status;
+}
+
+int giga_assembler_cache_assemble(GigaAssemblerCache *cache, const char *source, size_t length,
+                                  GigaAssemblerResult *result) {
+    if (result == NULL) {
+        return 1;
+    }
+    memset(result, 0, sizeof(*result));
+    if (source == NULL) {
+        result->has_error = 1;
+        result->error_message = "no source";
+        return 1;
+    }
+    if (cache == NULL) {
+        return giga_assembler_cache_build(source, length, result);
+    }
+
+    uint64_t source_hash = giga_assembler_hash(source, length, GIGA_ASSEMBLER_VERSION);
+    char *path = giga_assembler_cache_path(cache, source_hash);
+    if (path != NULL && giga_assembler_cache_load(path, source, length, source_hash, result) == 0) {
+        atomic_fetch_add_explicit(&cache->hits, 1, memory_order_relaxed);
+        free(path);
+        return 0;
+    }
+    atomic_fetch_add_explicit(&cache->misses, 1, memory_order_relaxed);
+    memset(result, 0, sizeof(*result));
+    int status = giga_assembler_cache_build(source, length, result);
+    if (status == 0 && (path == NULL || giga_assembler_cache_store(cache, path, source, length, source_hash,
+                                                                   result) != 0)) {
+        atomic_fetch_add_explicit(&cache->write_failures, 1, memory_order_relaxed);
+    }
+    free(path);
+    return status;
+}
+
+long giga_assembler_cache_clear(GigaAssemblerCache *cache) {
+    if (cache == NULL) {
+        return -1;
+    }
+    DIR *directory = opendir(cache->directory);
+    if (directory == NULL) {
+        return -1;
+    }
+    long removed = 0;
+    size_t suffix_length = sizeof(GIGA_ASSEMBLER_CACHE_SUFFIX) - 1u;
+    size_t temporary_length = sizeof(GIGA_ASSEMBLER_CACHE_TEMPORARY) - 1u;
+    struct dirent *entry;
+    while ((entry = readdir(directory)) != NULL) {
+        size_t name_length = strlen(entry->d_name);
+        int is_entry = name_length > suffix_length &&
+                       strcmp(entry->d_name + name_length - suffix_length, GIGA_ASSEMBLER_CACHE_SUFFIX) == 0;
+        /* left by a store that crashed or was interrupted before its rename */
+        int is_temporary = strncmp(entry->d_name, GIGA_ASSEMBLER_CACHE_TEMPORARY, temporary_length) == 0;
+        if (!is_entry && !is_temporary) {
+            continue;
+        }
+        size_t path_length = strlen(cache->directory) + 1u + name_length + 1u;
+        char *path = (char *)malloc(path_length);
+        if (path == NULL) {
+            break;
+        }
+        snprintf(path, path_length, "%s/%s", cache->directory, entry->d_name);
+        removed += (unlink(path) == 0 && is_entry);
+        free(path);
+    }
+    closedir(directory);
+    return removed;
+}
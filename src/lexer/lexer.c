@@ -1,14 +1,191 @@
 #include "lexer/lexer.h"
 
-#include <ctype.h>
+#include <stdint.h>
 #include <string.h>
 
-static int giga_lexer_is_identifier_start(int character) {
-    return (character == '_') || isalpha(character);
+/*
+ * Character classes are plain ASCII range tests (what <ctype.h> gives in the
+ * "C" locale), so the scalar tests and the vector blocks below agree byte
+ * for byte. Bytes of 0x80 and above belong to no class.
+ */
+typedef enum {
+    GIGA_LEXER_CLASS_SPACE = 0,  /* ' ', \t, \v, \f, \r; not \n */
+    GIGA_LEXER_CLASS_IDENTIFIER, /* [A-Za-z0-9_] */
+    GIGA_LEXER_CLASS_DIGIT,      /* [0-9] */
+    GIGA_LEXER_CLASS_HEX_DIGIT,  /* [0-9A-Fa-f] */
+    GIGA_LEXER_CLASS_COMMENT     /* anything but \n and NUL */
+} GigaLexerClass;
+
+static inline int giga_lexer_is_digit(int character) {
+    return (unsigned)(character - '0') < 10u;
+}
+
+static inline int giga_lexer_is_alpha(int character) {
+    return (unsigned)((character | 0x20) - 'a') < 26u;
+}
+
+static inline int giga_lexer_is_identifier_start(int character) {
+    return (character == '_') || giga_lexer_is_alpha(character);
+}
+
+static inline int giga_lexer_in_class(int character, GigaLexerClass class_kind) {
+    switch (class_kind) {
+        case GIGA_LEXER_CLASS_SPACE:
+            return character == ' ' || character == '\t' || character == '\r' || character == '\f' ||
+                   character == '\v';
+        case GIGA_LEXER_CLASS_IDENTIFIER:
+            return character == '_' || giga_lexer_is_alpha(character) || giga_lexer_is_digit(character);
+        case GIGA_LEXER_CLASS_DIGIT:
+            return giga_lexer_is_digit(character);
+        case GIGA_LEXER_CLASS_COMMENT:
+            return character != '\n' && character != '\0';
+        default:
+            return giga_lexer_is_digit(character) || (unsigned)((character | 0x20) - 'a') < 6u;
+    }
+}
+
+/* ---- vector blocks: one bit per byte of the block that is in the class ---- */
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define GIGA_LEXER_BLOCK 32u
+#define GIGA_LEXER_VEC __m256i
+#define GIGA_LEXER_LOAD(pointer) _mm256_loadu_si256((const __m256i *)(const void *)(pointer))
+#define GIGA_LEXER_SET1(value) _mm256_set1_epi8((char)(value))
+#define GIGA_LEXER_EQ(left, right) _mm256_cmpeq_epi8((left), (right))
+#define GIGA_LEXER_GT(left, right) _mm256_cmpgt_epi8((left), (right))
+#define GIGA_LEXER_OR(left, right) _mm256_or_si256((left), (right))
+#define GIGA_LEXER_AND(left, right) _mm256_and_si256((left), (right))
+#define GIGA_LEXER_MASK(vector) ((uint32_t)_mm256_movemask_epi8(vector))
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define GIGA_LEXER_BLOCK 16u
+#define GIGA_LEXER_VEC __m128i
+#define GIGA_LEXER_LOAD(pointer) _mm_loadu_si128((const __m128i *)(const void *)(pointer))
+#define GIGA_LEXER_SET1(value) _mm_set1_epi8((char)(value))
+#define GIGA_LEXER_EQ(left, right) _mm_cmpeq_epi8((left), (right))
+#define GIGA_LEXER_GT(left, right) _mm_cmpgt_epi8((left), (right))
+#define GIGA_LEXER_OR(left, right) _mm_or_si128((left), (right))
+#define GIGA_LEXER_AND(left, right) _mm_and_si128((left), (right))
+#define GIGA_LEXER_MASK(vector) ((uint32_t)_mm_movemask_epi8(vector))
+#endif
+
+#ifdef GIGA_LEXER_BLOCK
+
+/* Bytes classified at once and kept in the lexer; one bit each in a uint64_t. */
+#define GIGA_LEXER_WINDOW 64u
+
+#define GIGA_LEXER_BLOCK_BITS ((GIGA_LEXER_BLOCK == 32u) ? 0xFFFFFFFFu : ((1u << GIGA_LEXER_BLOCK) - 1u))
+
+/* Bytes in [low, high]; signed compares, so bytes of 0x80 and above never match. */
+static inline GIGA_LEXER_VEC giga_lexer_block_range(GIGA_LEXER_VEC bytes, int low, int high) {
+    return GIGA_LEXER_AND(GIGA_LEXER_GT(bytes, GIGA_LEXER_SET1(low - 1)),
+                          GIGA_LEXER_GT(GIGA_LEXER_SET1(high + 1), bytes));
+}
+
+static inline uint32_t giga_lexer_block_mask(const char *block, GigaLexerClass class_kind) {
+    GIGA_LEXER_VEC bytes = GIGA_LEXER_LOAD(block);
+    GIGA_LEXER_VEC digits = giga_lexer_block_range(bytes, '0', '9');
+    GIGA_LEXER_VEC folded = GIGA_LEXER_OR(bytes, GIGA_LEXER_SET1(0x20)); /* A-Z to a-z */
+    switch (class_kind) {
+        case GIGA_LEXER_CLASS_SPACE: {
+            /* \t..\r is 9..13; drop \n (10) */
+            GIGA_LEXER_VEC controls = giga_lexer_block_range(bytes, '\t', '\r');
+            GIGA_LEXER_VEC spaces = GIGA_LEXER_OR(controls, GIGA_LEXER_EQ(bytes, GIGA_LEXER_SET1(' ')));
+            return GIGA_LEXER_MASK(spaces) & ~GIGA_LEXER_MASK(GIGA_LEXER_EQ(bytes, GIGA_LEXER_SET1('\n')));
+        }
+        case GIGA_LEXER_CLASS_IDENTIFIER: {
+            GIGA_LEXER_VEC letters = giga_lexer_block_range(folded, 'a', 'z');
+            GIGA_LEXER_VEC underscores = GIGA_LEXER_EQ(bytes, GIGA_LEXER_SET1('_'));
+            return GIGA_LEXER_MASK(GIGA_LEXER_OR(GIGA_LEXER_OR(letters, digits), underscores));
+        }
+        case GIGA_LEXER_CLASS_DIGIT:
+            return GIGA_LEXER_MASK(digits);
+        case GIGA_LEXER_CLASS_COMMENT:
+            return ~GIGA_LEXER_MASK(GIGA_LEXER_OR(GIGA_LEXER_EQ(bytes, GIGA_LEXER_SET1('\n')),
+                                                  GIGA_LEXER_EQ(bytes, GIGA_LEXER_SET1(0))));
+        default:
+            return GIGA_LEXER_MASK(GIGA_LEXER_OR(digits, giga_lexer_block_range(folded, 'a', 'f')));
+    }
+}
+
+/*
+ * Classify the GIGA_LEXER_WINDOW bytes at index, which must be at a token
+ * boundary, into the lexer's window masks. A token starts at each byte that
+ * is neither a space nor inside a comment, unless it continues the
+ * identifier or number before it. Returns 0 when the window starts with a
+ * comment that runs past it.
+ */
+static inline int giga_lexer_load_window(GigaLexer *lexer, size_t index) {
+    uint64_t space = 0, word = 0, digit = 0, line_end = 0, semicolon = 0;
+    for (unsigned part = 0; part < GIGA_LEXER_WINDOW / GIGA_LEXER_BLOCK; ++part) {
+        GIGA_LEXER_VEC bytes = GIGA_LEXER_LOAD(lexer->buffer + index + part * GIGA_LEXER_BLOCK);
+        GIGA_LEXER_VEC digits = giga_lexer_block_range(bytes, '0', '9');
+        GIGA_LEXER_VEC letters = giga_lexer_block_range(GIGA_LEXER_OR(bytes, GIGA_LEXER_SET1(0x20)), 'a', 'z');
+        GIGA_LEXER_VEC underscores = GIGA_LEXER_EQ(bytes, GIGA_LEXER_SET1('_'));
+        GIGA_LEXER_VEC controls = giga_lexer_block_range(bytes, '\t', '\r');
+        GIGA_LEXER_VEC spaces = GIGA_LEXER_OR(controls, GIGA_LEXER_EQ(bytes, GIGA_LEXER_SET1(' ')));
+        uint64_t newlines = GIGA_LEXER_MASK(GIGA_LEXER_EQ(bytes, GIGA_LEXER_SET1('\n')));
+        unsigned shift = part * GIGA_LEXER_BLOCK;
+        space |= (uint64_t)(GIGA_LEXER_MASK(spaces) & ~newlines) << shift;
+        line_end |= (newlines | GIGA_LEXER_MASK(GIGA_LEXER_EQ(bytes, GIGA_LEXER_SET1(0)))) << shift;
+        semicolon |= (uint64_t)GIGA_LEXER_MASK(GIGA_LEXER_EQ(bytes, GIGA_LEXER_SET1(';'))) << shift;
+        digit |= (uint64_t)GIGA_LEXER_MASK(digits) << shift;
+        word |= (uint64_t)GIGA_LEXER_MASK(GIGA_LEXER_OR(GIGA_LEXER_OR(letters, digits), underscores)) << shift;
+    }
+
+    /* a word run starts a token, and so does a letter ending a number run */
+    uint64_t word_starts = word & ~(word << 1);
+    uint64_t number_ends = (digit + (word_starts & digit)) & ~digit;
+    uint64_t starts = word_starts | (number_ends & word) | ~(word | space);
+
+    /* comments run from ';' to the next \n or NUL; a cut-off one ends the window */
+    size_t end = GIGA_LEXER_WINDOW;
+    while (semicolon != 0) {
+        unsigned first = (unsigned)__builtin_ctzll(semicolon);
+        uint64_t ends = line_end >> first;
+        if (ends == 0) {
+            starts &= ~(~0ull << first);
+            end = first;
+            break;
+        }
+        unsigned last = first + (unsigned)__builtin_ctzll(ends);
+        starts &= ~((~0ull << first) & ~(~0ull << last));
+        semicolon &= ~0ull << last;
+    }
+
+    lexer->window_index = index;
+    lexer->window_end = index + end;
+    lexer->window_starts = starts;
+    lexer->window_word = word;
+    lexer->window_digit = digit;
+    return end != 0;
 }
 
-static int giga_lexer_is_identifier_continue(int character) {
-    return (character == '_') || isalnum(character);
+#endif /* GIGA_LEXER_BLOCK */
+
+/* End of the run of class_kind bytes starting at index. */
+static inline size_t giga_lexer_span(const GigaLexer *lexer, size_t index, GigaLexerClass class_kind) {
+    const char *buffer = lexer->buffer;
+    size_t length = lexer->buffer_length;
+    /* most runs are empty or a byte long; settle those without a block */
+    if (index >= length || !giga_lexer_in_class((unsigned char)buffer[index], class_kind)) {
+        return index;
+    }
+    ++index;
+#ifdef GIGA_LEXER_BLOCK
+    while (length - index >= GIGA_LEXER_BLOCK) {
+        uint32_t outside = ~giga_lexer_block_mask(buffer + index, class_kind) & GIGA_LEXER_BLOCK_BITS;
+        if (outside != 0) {
+            return index + (size_t)__builtin_ctz(outside);
+        }
+        index += GIGA_LEXER_BLOCK;
+    }
+#endif
+    while (index < length && giga_lexer_in_class((unsigned char)buffer[index], class_kind)) {
+        ++index;
+    }
+    return index;
 }
 
 void giga_lexer_init(GigaLexer *lexer, const char *buffer, size_t buffer_length) {
@@ -19,7 +196,12 @@ void giga_lexer_init(GigaLexer *lexer, const char *buffer, size_t buffer_length)
     lexer->buffer_length = buffer_length;
     lexer->current_index = 0;
     lexer->line_number = 1;
-    lexer->column_number = 1;
+    lexer->line_start_index = 0;
+    lexer->window_index = 0;
+    lexer->window_end = 0;
+    lexer->window_starts = 0; /* no window yet */
+    lexer->window_word = 0;
+    lexer->window_digit = 0;
 }
 
 static int giga_lexer_peek(const GigaLexer *lexer) {
@@ -29,40 +211,18 @@ static int giga_lexer_peek(const GigaLexer *lexer) {
     return (unsigned char)lexer->buffer[lexer->current_index];
 }
 
-static int giga_lexer_advance(GigaLexer *lexer) {
-    if (lexer->current_index >= lexer->buffer_length) {
-        return 0;
-    }
-    int character = (unsigned char)lexer->buffer[lexer->current_index++];
-    if (character == '\n') {
-        lexer->line_number += 1;
-        lexer->column_number = 1;
-    } else {
-        lexer->column_number += 1;
-    }
-    return character;
-}
-
+/* Comments run to the newline, which stays for the NEWLINE token, or to a NUL, which ends the input. */
 static void giga_lexer_skip_spaces_and_comments(GigaLexer *lexer) {
     for (;;) {
-        int character = giga_lexer_peek(lexer);
-        while (character == ' ' || character == '\t' || character == '\r' || character == '\f' || character == '\v') {
-            giga_lexer_advance(lexer);
-            character = giga_lexer_peek(lexer);
+        lexer->current_index = giga_lexer_span(lexer, lexer->current_index, GIGA_LEXER_CLASS_SPACE);
+        if (giga_lexer_peek(lexer) != ';') {
+            return;
         }
-
-        if (character == ';') {
-            while (character != 0 && character != '\n') {
-                giga_lexer_advance(lexer);
-                character = giga_lexer_peek(lexer);
-            }
-            continue;
-        }
-        break;
+        lexer->current_index = giga_lexer_span(lexer, lexer->current_index, GIGA_LEXER_CLASS_COMMENT);
     }
 }
 
-static GigaToken giga_lexer_make_token(GigaLexer *lexer,
+static GigaToken giga_lexer_make_token(const GigaLexer *lexer,
                                        GigaTokenKind kind,
                                        size_t start_index,
                                        size_t start_line,
@@ -76,114 +236,166 @@ static GigaToken giga_lexer_make_token(GigaLexer *lexer,
     return token;
 }
 
+#ifdef GIGA_LEXER_BLOCK
+
+/*
+ * Kind of the token a byte starts when the window path can finish it, or
+ * GIGA_TOKEN_EOF to leave the byte to the general path (NUL, directives
+ * and the spaces and ';' that are skipped before a token starts).
+ */
+#define _ GIGA_TOKEN_EOF
+#define I GIGA_TOKEN_IDENTIFIER
+#define N GIGA_TOKEN_NUMBER
+#define C GIGA_TOKEN_COMMA
+#define K GIGA_TOKEN_COLON
+#define L GIGA_TOKEN_NEWLINE
+#define U GIGA_TOKEN_UNKNOWN
+static const uint8_t giga_lexer_window_kinds[256] = {
+    _, U, U, U, U, U, U, U, U, _, L, _, _, _, U, U,
+    U, U, U, U, U, U, U, U, U, U, U, U, U, U, U, U,
+    _, U, U, U, U, U, U, U, U, U, U, U, C, U, _, U,
+    N, N, N, N, N, N, N, N, N, N, K, _, U, U, U, U,
+    U, I, I, I, I, I, I, I, I, I, I, I, I, I, I, I,
+    I, I, I, I, I, I, I, I, I, I, I, U, U, U, U, I,
+    U, I, I, I, I, I, I, I, I, I, I, I, I, I, I, I,
+    I, I, I, I, I, I, I, I, I, I, I, U, U, U, U, U,
+    U, U, U, U, U, U, U, U, U, U, U, U, U, U, U, U,
+    U, U, U, U, U, U, U, U, U, U, U, U, U, U, U, U,
+    U, U, U, U, U, U, U, U, U, U, U, U, U, U, U, U,
+    U, U, U, U, U, U, U, U, U, U, U, U, U, U, U, U,
+    U, U, U, U, U, U, U, U, U, U, U, U, U, U, U, U,
+    U, U, U, U, U, U, U, U, U, U, U, U, U, U, U, U,
+    U, U, U, U, U, U, U, U, U, U, U, U, U, U, U, U,
+    U, U, U, U, U, U, U, U, U, U, U, U, U, U, U, U,
+};
+#undef _
+#undef I
+#undef N
+#undef C
+#undef K
+#undef L
+#undef U
+
+/*
+ * The common token from the classified window: an identifier, a decimal
+ * number or a one-byte token at the window's next token start. Spaces and
+ * comments never have token starts, so they cost nothing here, and the
+ * next start is found by clearing the lowest bit rather than by waiting
+ * on this token's length. A token that may run past the window reloads the
+ * window at its first byte. Returns 0 when the general path is needed
+ * (directives, hex numbers, runs longer than a window, the last bytes of
+ * the buffer), with current_index at the byte it should start from.
+ */
+static inline int giga_lexer_window_token(GigaLexer *lexer, GigaToken *token) {
+    for (;;) {
+        uint64_t starts = lexer->window_starts;
+        if (starts == 0) {
+            /* the general path may have moved past the window's end */
+            size_t index = (lexer->window_end > lexer->current_index) ? lexer->window_end : lexer->current_index;
+            lexer->current_index = index;
+            if (lexer->buffer_length - index < GIGA_LEXER_WINDOW || !giga_lexer_load_window(lexer, index)) {
+                lexer->window_end = 0;
+                return 0;
+            }
+            continue;
+        }
+        size_t start = (size_t)__builtin_ctzll(starts);
+        const char *buffer = lexer->buffer + lexer->window_index;
+        int character = (unsigned char)buffer[start];
+        GigaTokenKind kind = (GigaTokenKind)giga_lexer_window_kinds[character];
+
+        /* a number is its digits, an identifier its word bytes, anything else one byte */
+        uint64_t run_mask = ((lexer->window_digit >> start) & 1u) ? lexer->window_digit : lexer->window_word;
+        size_t run = (size_t)__builtin_ctzll(~(run_mask >> start) | (1ull << 63));
+        run += (run == 0);
+        size_t start_index = lexer->window_index + start;
+        if (start + run >= GIGA_LEXER_WINDOW - 1u || kind == GIGA_TOKEN_EOF ||
+            (character == '0' && (buffer[start + 1u] | 0x20) == 'x')) {
+            /* reload the window here for a run that may cross it, else leave it to the general path */
+            int reload = (start + run >= GIGA_LEXER_WINDOW - 1u && start != 0 && kind != GIGA_TOKEN_EOF);
+            lexer->current_index = start_index;
+            lexer->window_starts = 0;
+            lexer->window_end = 0;
+            if (reload) {
+                continue;
+            }
+            return 0;
+        }
+
+        size_t end_index = start_index + run;
+        int newline = (kind == GIGA_TOKEN_NEWLINE);
+        token->kind = kind;
+        token->text_begin = lexer->buffer + start_index;
+        token->text_length = run;
+        token->line_number = lexer->line_number;
+        token->column_number = start_index - lexer->line_start_index + 1u;
+        lexer->window_starts = starts & (starts - 1u);
+        lexer->current_index = end_index;
+        lexer->line_number += (size_t)newline;
+        lexer->line_start_index = newline ? end_index : lexer->line_start_index;
+        return 1;
+    }
+}
+
+#endif /* GIGA_LEXER_BLOCK */
+
 GigaToken giga_lexer_next_token(GigaLexer *lexer) {
     GigaToken token;
-    memset(&token, 0, sizeof(token));
-
     if (lexer == NULL || lexer->buffer == NULL) {
+        memset(&token, 0, sizeof(token));
         token.kind = GIGA_TOKEN_EOF;
         return token;
     }
 
+#ifdef GIGA_LEXER_BLOCK
+    if (giga_lexer_window_token(lexer, &token)) {
+        return token;
+    }
+#endif
+    memset(&token, 0, sizeof(token));
     giga_lexer_skip_spaces_and_comments(lexer);
 
     size_t start_index = lexer->current_index;
     size_t start_line = lexer->line_number;
-    size_t start_column = lexer->column_number;
+    size_t start_column = start_index - lexer->line_start_index + 1u;
 
     int character = giga_lexer_peek(lexer);
     if (character == 0 || lexer->current_index >= lexer->buffer_length) {
         token.kind = GIGA_TOKEN_EOF;
         token.text_begin = NULL;
         token.text_length = 0;
-        token.line_number = lexer->line_number;
-        token.column_number = lexer->column_number;
+        token.line_number = start_line;
+        token.column_number = start_column;
         return token;
     }
 
+    GigaTokenKind kind;
+    size_t end_index = start_index + 1u;
     if (character == '\n') {
-        giga_lexer_advance(lexer);
-        return giga_lexer_make_token(lexer,
-                                     GIGA_TOKEN_NEWLINE,
-                                     start_index,
-                                     start_line,
-                                     start_column);
-    }
-
-    if (character == ',') {
-        giga_lexer_advance(lexer);
-        return giga_lexer_make_token(lexer,
-                                     GIGA_TOKEN_COMMA,
-                                     start_index,
-                                     start_line,
-                                     start_column);
-    }
-    if (character == ':') {
-        giga_lexer_advance(lexer);
-        return giga_lexer_make_token(lexer,
-                                     GIGA_TOKEN_COLON,
-                                     start_index,
-                                     start_line,
-                                     start_column);
-    }
-
-    if (character == '.') {
-        giga_lexer_advance(lexer);
-        while (giga_lexer_is_identifier_continue(giga_lexer_peek(lexer))) {
-            giga_lexer_advance(lexer);
-        }
-        return giga_lexer_make_token(lexer,
-                                     GIGA_TOKEN_DIRECTIVE,
-                                     start_index,
-                                     start_line,
-                                     start_column);
-    }
-
-    if (isdigit(character)) {
-        giga_lexer_advance(lexer);
-        if (lexer->current_index - start_index == 1 &&
-            lexer->buffer[start_index] == '0') {
-            int next_character = giga_lexer_peek(lexer);
-            if (next_character == 'x' || next_character == 'X') {
-                giga_lexer_advance(lexer);
-                while (isxdigit(giga_lexer_peek(lexer))) {
-                    giga_lexer_advance(lexer);
-                }
-                return giga_lexer_make_token(lexer,
-                                             GIGA_TOKEN_NUMBER,
-                                             start_index,
-                                             start_line,
-                                             start_column);
-            }
-        }
-        while (isdigit(giga_lexer_peek(lexer))) {
-            giga_lexer_advance(lexer);
-        }
-        return giga_lexer_make_token(lexer,
-                                     GIGA_TOKEN_NUMBER,
-                                     start_index,
-                                     start_line,
-                                     start_column);
-    }
-
-    if (giga_lexer_is_identifier_start(character)) {
-        giga_lexer_advance(lexer);
-        while (giga_lexer_is_identifier_continue(giga_lexer_peek(lexer))) {
-            giga_lexer_advance(lexer);
+        kind = GIGA_TOKEN_NEWLINE;
+        lexer->line_number += 1;
+        lexer->line_start_index = end_index;
+    } else if (character == ',') {
+        kind = GIGA_TOKEN_COMMA;
+    } else if (character == ':') {
+        kind = GIGA_TOKEN_COLON;
+    } else if (character == '.') {
+        kind = GIGA_TOKEN_DIRECTIVE;
+        end_index = giga_lexer_span(lexer, end_index, GIGA_LEXER_CLASS_IDENTIFIER);
+    } else if (giga_lexer_is_digit(character)) {
+        kind = GIGA_TOKEN_NUMBER;
+        if (character == '0' && end_index < lexer->buffer_length &&
+            (lexer->buffer[end_index] == 'x' || lexer->buffer[end_index] == 'X')) {
+            end_index = giga_lexer_span(lexer, end_index + 1u, GIGA_LEXER_CLASS_HEX_DIGIT);
+        } else {
+            end_index = giga_lexer_span(lexer, end_index, GIGA_LEXER_CLASS_DIGIT);
         }
-        return giga_lexer_make_token(lexer,
-                                     GIGA_TOKEN_IDENTIFIER,
-                                     start_index,
-                                     start_line,
-                                     start_column);
+    } else if (giga_lexer_is_identifier_start(character)) {
+        kind = GIGA_TOKEN_IDENTIFIER;
+        end_index = giga_lexer_span(lexer, end_index, GIGA_LEXER_CLASS_IDENTIFIER);
+    } else {
+        kind = GIGA_TOKEN_UNKNOWN;
     }
-
-    giga_lexer_advance(lexer);
-    return giga_lexer_make_token(lexer,
-                                 GIGA_TOKEN_UNKNOWN,
-                                 start_index,
-                                 start_line,
-                                 start_column);
+    lexer->current_index = end_index;
+    return giga_lexer_make_token(lexer, kind, start_index, start_line, start_column);
 }
-
-
@@ -1,7 +1,584 @@
+#include <inttypes.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
-int main(void) {
-    puts("Giga-ALU (v0.1.0) - 4-bit ALU virtual machine");
+#include "assembler/assembler.h"
+#include "assembler/assembler_cache.h"
+#include "vm/vm.h"
+#include "vm/vm_banks.h"
+#include "vm/vm_image.h"
+#include "vm/vm_jit.h"
+#include "vm/vm_profile.h"
+#include "runner/runner.h"
+
+/* Hot blocks listed by --profile. */
+#define GIGA_CLI_PROFILE_BLOCKS 10u
+
+typedef struct {
+    const char *program_path;
+    uint64_t max_steps;
+    int fuse_superinstructions;
+    int use_jit;
+    int profile;
+    int counters;
+    int harvard;
+    const char *image_path;
+    const char *cache_path;
+    GigaAssemblerCache *cache;         /* opened from cache_path, or NULL */
+    int batch_mode;
+    size_t thread_count;
+    int pin_threads;
+} GigaCliOptions;
+
+static void giga_cli_print_usage(const char *program_name) {
+    fprintf(stderr,
+            "usage: %s [--no-fuse] [--jit | --profile | --counters | --harvard] [--cache DIR]\n"
+            "              [--max-steps N] program.asm\n"
+            "       %s [--no-fuse] --emit-image program.gbc program.asm\n"
+            "       %s [--max-steps N] program.gbc\n"
+            "       %s --batch [--threads N] [--pin] [--no-fuse] [--counters] [--cache DIR] [--max-steps N] manifest\n"
+            "  --no-fuse      run the predecoded program without superinstructions\n"
+            "  --jit          translate basic blocks to native code when supported\n"
+            "  --profile      count executions per instruction and print hot blocks\n"
+            "  --counters     print the VM performance counters (per job with --batch)\n"
+            "  --harvard      run from a separate instruction store of up to 4096 words,\n"
+            "                 leaving all of VM memory for data\n"
+            "  --emit-image F write the assembled program as a .gbc image to F and exit;\n"
+            "                 a program.gbc argument runs such an image in Harvard mode\n"
+            "  --cache DIR    reuse programs assembled earlier from the same source,\n"
+            "                 kept in DIR (created if missing)\n"
+            "  --max-steps N  stop after N retired instructions\n"
+            "  --batch        run every job listed in the manifest on a worker pool;\n"
+            "                 each line is `program.asm [max_steps]` (paths relative\n"
+            "                 to the manifest, # starts a comment)\n"
+            "  --threads N    worker threads for --batch (default: one per CPU)\n"
+            "  --pin          pin --batch workers to CPUs\n",
+            program_name, program_name, program_name, program_name);
+}
+
+static int giga_cli_is_image(const char *path) {
+    size_t length = strlen(path);
+    return length >= 4 && strcmp(path + length - 4, ".gbc") == 0;
+}
+
+static int giga_cli_parse_options(int argc, char **argv, GigaCliOptions *options) {
+    options->program_path = NULL;
+    options->max_steps = UINT64_MAX;
+    options->fuse_superinstructions = 1;
+    options->use_jit = 0;
+    options->profile = 0;
+    options->counters = 0;
+    options->harvard = 0;
+    options->image_path = NULL;
+    options->cache_path = NULL;
+    options->cache = NULL;
+    options->batch_mode = 0;
+    options->thread_count = 0;
+    options->pin_threads = 0;
+
+    for (int index = 1; index < argc; ++index) {
+        const char *argument = argv[index];
+        if (strcmp(argument, "--no-fuse") == 0) {
+            options->fuse_superinstructions = 0;
+        } else if (strcmp(argument, "--jit") == 0) {
+            options->use_jit = 1;
+        } else if (strcmp(argument, "--profile") == 0) {
+            options->profile = 1;
+        } else if (strcmp(argument, "--counters") == 0) {
+            options->counters = 1;
+        } else if (strcmp(argument, "--harvard") == 0) {
+            options->harvard = 1;
+        } else if (strcmp(argument, "--emit-image") == 0 && index + 1 < argc) {
+            options->image_path = argv[++index];
+        } else if (strcmp(argument, "--cache") == 0 && index + 1 < argc) {
+            options->cache_path = argv[++index];
+        } else if (strcmp(argument, "--max-steps") == 0 && index + 1 < argc) {
+            options->max_steps = strtoull(argv[++index], NULL, 10);
+        } else if (strcmp(argument, "--batch") == 0) {
+            options->batch_mode = 1;
+        } else if (strcmp(argument, "--threads") == 0 && index + 1 < argc) {
+            options->thread_count = (size_t)strtoull(argv[++index], NULL, 10);
+        } else if (strcmp(argument, "--pin") == 0) {
+            options->pin_threads = 1;
+        } else if (argument[0] == '-' || options->program_path != NULL) {
+            return 1;
+        } else {
+            options->program_path = argument;
+        }
+    }
+    if (options->use_jit && options->profile) {
+        return 1; /* the profile is taken by the interpreter */
+    }
+    if (options->counters && (options->use_jit || options->profile)) {
+        return 1; /* only the interpreter keeps counters */
+    }
+    if (options->program_path != NULL && giga_cli_is_image(options->program_path)) {
+        options->harvard = 1; /* images always run from their own code */
+    }
+    if (options->harvard && (options->use_jit || options->profile || options->counters || options->batch_mode)) {
+        return 1; /* instruction stores only run in the interpreter */
+    }
+    if (options->image_path != NULL && (options->harvard || options->batch_mode)) {
+        return 1;
+    }
+    return options->program_path == NULL ? 1 : 0;
+}
+
+/* Counters as space-separated name=value fields, without a newline. */
+static void giga_cli_print_counters(const GigaVmCounters *counters) {
+    static const char *const alu_names[GIGA_VM_COUNTER_ALU_KINDS] = {
+        "add", "sub", "and", "or", "xor", "not", "shl", "shr", "adc", "sbc", "cmp"
+    };
+    printf(" retired=%" PRIu64, counters->retired);
+    for (size_t kind = 0; kind < GIGA_VM_COUNTER_ALU_KINDS; ++kind) {
+        printf(" %s=%" PRIu64, alu_names[kind], counters->alu_ops[kind]);
+    }
+    printf(" ld=%" PRIu64 " st=%" PRIu64 " jmp=%" PRIu64 " code_writes=%" PRIu64 " flag_reads=%" PRIu64,
+           counters->loads, counters->stores, counters->taken_jumps, counters->code_writes,
+           counters->flag_reads);
+}
+
+static void giga_cli_add_counters(GigaVmCounters *total, const GigaVmCounters *counters) {
+    total->retired += counters->retired;
+    for (size_t kind = 0; kind < GIGA_VM_COUNTER_ALU_KINDS; ++kind) {
+        total->alu_ops[kind] += counters->alu_ops[kind];
+    }
+    total->loads += counters->loads;
+    total->stores += counters->stores;
+    total->taken_jumps += counters->taken_jumps;
+    total->code_writes += counters->code_writes;
+    total->flag_reads += counters->flag_reads;
+}
+
+static char *giga_cli_read_file(const char *path, size_t *out_length) {
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        return NULL;
+    }
+    if (fseek(file, 0, SEEK_END) != 0) {
+        fclose(file);
+        return NULL;
+    }
+    long file_size = ftell(file);
+    if (file_size < 0 || fseek(file, 0, SEEK_SET) != 0) {
+        fclose(file);
+        return NULL;
+    }
+    char *buffer = (char *)malloc((size_t)file_size + 1u);
+    if (buffer == NULL) {
+        fclose(file);
+        return NULL;
+    }
+    size_t read_length = fread(buffer, 1, (size_t)file_size, file);
+    fclose(file);
+    buffer[read_length] = '\0';
+    *out_length = read_length;
+    return buffer;
+}
+
+static const char *giga_cli_status_name(GigaVmStatus status) {
+    switch (status) {
+        case GIGA_VM_STATUS_RUNNING:
+            return "running";
+        case GIGA_VM_STATUS_HALTED:
+            return "halted";
+        case GIGA_VM_STATUS_STEP_LIMIT:
+            return "step limit reached";
+        case GIGA_VM_STATUS_PC_OUT_OF_RANGE:
+            return "PC out of range";
+        case GIGA_VM_STATUS_INVALID_OPCODE:
+            return "invalid opcode";
+        case GIGA_VM_STATUS_INVALID_STATE:
+            return "invalid state";
+        case GIGA_VM_STATUS_BANK_FAULT:
+            return "bank fault";
+        case GIGA_VM_STATUS_IO_WAIT:
+            return "I/O wait";
+        case GIGA_VM_STATUS_PORT_FAULT:
+            return "port fault";
+    }
+    return "unknown";
+}
+
+static void giga_cli_print_state(const GigaVmState *state, GigaVmStatus status) {
+    printf("status: %s\n", giga_cli_status_name(status));
+    printf("pc: %u\n", state->program_counter);
+    if (state->data_bank != 0) {
+        printf("bank: %u\n", state->data_bank);
+    }
+    for (size_t index = 0; index < GIGA_VM_REGISTER_COUNT; ++index) {
+        printf("R%zu=%u%s", index, state->registers[index],
+               (index + 1 < GIGA_VM_REGISTER_COUNT) ? " " : "\n");
+    }
+    printf("flags: Z=%u C=%u N=%u V=%u\n",
+           state->flags_zero, state->flags_carry,
+           state->flags_negative, state->flags_overflow);
+}
+
+/* Write an assembled program, labels and line table included, as a .gbc image. */
+static int giga_cli_write_image(const char *image_path, const GigaAssemblerResult *assembled, int fuse) {
+    GigaVmImageLabel *labels = (GigaVmImageLabel *)calloc(assembled->label_count + 1u, sizeof(GigaVmImageLabel));
+    if (labels == NULL) {
+        fprintf(stderr, "error: out of memory\n");
+        return 1;
+    }
+    for (size_t index = 0; index < assembled->label_count; ++index) {
+        labels[index].name = assembled->labels[index].name;
+        labels[index].name_length = assembled->labels[index].name_length;
+        labels[index].address = assembled->labels[index].address;
+    }
+    GigaVmImageSource source = {
+        .words = assembled->bytecode,
+        .word_count = assembled->word_count,
+        .labels = labels,
+        .label_count = assembled->label_count,
+        .source_lines = assembled->source_lines,
+        .fuse = fuse
+    };
+    int result = giga_vm_image_write(image_path, &source);
+    free(labels);
+    if (result != 0) {
+        fprintf(stderr, "error: cannot write %s\n", image_path);
+        return 1;
+    }
+    printf("wrote %s (%zu words)\n", image_path, assembled->word_count);
     return 0;
 }
 
+/*
+ * Assemble the file at path, through cache unless it is NULL, into words (at most max_words), and the source
+ * line of each word into source_lines unless it is NULL. Also writes a .gbc
+ * image to image_path unless it is NULL.
+ */
+static int giga_cli_assemble_file(GigaAssemblerCache *cache, const char *path, size_t max_words, uint16_t *words, size_t *source_lines,
+                                  size_t *out_word_count, const char *image_path, int fuse) {
+    size_t source_length = 0;
+    char *source = giga_cli_read_file(path, &source_length);
+    if (source == NULL) {
+        fprintf(stderr, "error: cannot read %s\n", path);
+        return 1;
+    }
+
+    GigaAssemblerResult assembled;
+    int result = 0;
+    if (giga_assembler_cache_assemble(cache, source, source_length, &assembled) != 0) {
+        fprintf(stderr, "%s:%zu:%zu: error: %s\n", path,
+                assembled.error_line, assembled.error_column, assembled.error_message);
+        result = 1;
+    } else if (assembled.word_count > max_words) {
+        fprintf(stderr, "%s: error: program does not fit in VM memory\n", path);
+        result = 1;
+    } else {
+        memcpy(words, assembled.bytecode, assembled.word_count * sizeof(uint16_t));
+        if (source_lines != NULL) {
+            memcpy(source_lines, assembled.source_lines, assembled.word_count * sizeof(size_t));
+        }
+        *out_word_count = assembled.word_count;
+        if (image_path != NULL) {
+            result = giga_cli_write_image(image_path, &assembled, fuse);
+        }
+    }
+
+    giga_assembler_free(&assembled);
+    free(source);
+    return result;
+}
+
+typedef struct {
+    char *path;
+    uint16_t words[GIGA_VM_MAX_PROGRAM_WORDS];
+    size_t word_count;
+} GigaCliProgram;
+
+/* Resolve a manifest entry relative to the manifest's directory. */
+static char *giga_cli_manifest_path(const char *manifest_path, const char *entry, size_t entry_length) {
+    const char *slash = strrchr(manifest_path, '/');
+    size_t prefix_length = (entry[0] == '/' || slash == NULL) ? 0 : (size_t)(slash - manifest_path) + 1u;
+    char *path = (char *)malloc(prefix_length + entry_length + 1u);
+    if (path != NULL) {
+        memcpy(path, manifest_path, prefix_length);
+        memcpy(path + prefix_length, entry, entry_length);
+        path[prefix_length + entry_length] = '\0';
+    }
+    return path;
+}
+
+static int giga_cli_run_batch(const GigaCliOptions *options) {
+    size_t manifest_length = 0;
+    char *manifest = giga_cli_read_file(options->program_path, &manifest_length);
+    if (manifest == NULL) {
+        fprintf(stderr, "error: cannot read %s\n", options->program_path);
+        return 1;
+    }
+
+    GigaCliProgram *programs = NULL;
+    size_t program_count = 0;
+    GigaRunnerJob *jobs = NULL;
+    size_t *job_programs = NULL;
+    size_t job_count = 0;
+    size_t job_capacity = 0;
+    int result = 0;
+
+    size_t line_number = 0;
+    for (char *line = manifest; line != NULL && result == 0;) {
+        char *next_line = strchr(line, '\n');
+        if (next_line != NULL) {
+            *next_line++ = '\0';
+        }
+        ++line_number;
+        char *comment = strchr(line, '#');
+        if (comment != NULL) {
+            *comment = '\0';
+        }
+
+        char *entry = line + strspn(line, " \t\r");
+        size_t entry_length = strcspn(entry, " \t\r");
+        line = next_line;
+        if (entry_length == 0) {
+            continue;
+        }
+        uint64_t max_steps = options->max_steps;
+        char *steps_text = entry + entry_length + strspn(entry + entry_length, " \t\r");
+        if (*steps_text != '\0') {
+            max_steps = strtoull(steps_text, NULL, 10);
+        }
+
+        char *path = giga_cli_manifest_path(options->program_path, entry, entry_length);
+        if (path == NULL) {
+            result = 1;
+            break;
+        }
+        size_t program_index = 0;
+        while (program_index < program_count && strcmp(programs[program_index].path, path) != 0) {
+            ++program_index;
+        }
+        if (program_index == program_count) {
+            GigaCliProgram *grown = (GigaCliProgram *)realloc(programs, (program_count + 1u) * sizeof(*programs));
+            if (grown == NULL) {
+                free(path);
+                result = 1;
+                break;
+            }
+            programs = grown;
+            programs[program_count].path = path;
+            if (giga_cli_assemble_file(options->cache, path, GIGA_VM_MAX_PROGRAM_WORDS, programs[program_count].words, NULL,
+                                       &programs[program_count].word_count, NULL, 0) != 0) {
+                fprintf(stderr, "%s:%zu: error: job program failed to assemble\n",
+                        options->program_path, line_number);
+                free(path);
+                result = 1;
+                break;
+            }
+            ++program_count;
+        } else {
+            free(path);
+        }
+
+        if (job_count == job_capacity) {
+            job_capacity = job_capacity ? job_capacity * 2u : 64u;
+            GigaRunnerJob *grown_jobs = (GigaRunnerJob *)realloc(jobs, job_capacity * sizeof(*jobs));
+            size_t *grown_programs = (size_t *)realloc(job_programs, job_capacity * sizeof(*job_programs));
+            if (grown_jobs != NULL) {
+                jobs = grown_jobs;
+            }
+            if (grown_programs != NULL) {
+                job_programs = grown_programs;
+            }
+            if (grown_jobs == NULL || grown_programs == NULL) {
+                result = 1;
+                break;
+            }
+        }
+        job_programs[job_count] = program_index;
+        jobs[job_count].max_steps = max_steps;
+        jobs[job_count].initial_registers = NULL;
+        jobs[job_count].initial_state = NULL;
+        ++job_count;
+    }
+
+    GigaRunnerResult *results = NULL;
+    GigaRunner *runner = NULL;
+    if (result == 0 && job_count > 0) {
+        /* programs[] is final now, so the word pointers stay valid */
+        for (size_t index = 0; index < job_count; ++index) {
+            jobs[index].program_words = programs[job_programs[index]].words;
+            jobs[index].word_count = programs[job_programs[index]].word_count;
+        }
+
+        GigaRunnerOptions runner_options;
+        giga_runner_default_options(&runner_options);
+        runner_options.thread_count = options->thread_count;
+        runner_options.pin_threads = options->pin_threads;
+        runner_options.fuse_superinstructions = options->fuse_superinstructions;
+        results = (GigaRunnerResult *)malloc(job_count * sizeof(*results));
+        runner = giga_runner_create(&runner_options);
+        if (results == NULL || runner == NULL || giga_runner_run(runner, jobs, job_count, results) != 0) {
+            fprintf(stderr, "error: cannot start the batch runner\n");
+            result = 1;
+        }
+    }
+
+    int job_failed = 0;
+    GigaVmCounters total_counters;
+    memset(&total_counters, 0, sizeof(total_counters));
+    for (size_t index = 0; result == 0 && index < job_count; ++index) {
+        const GigaRunnerResult *job_result = &results[index];
+        printf("%zu %s: %s pc=%u", index, programs[job_programs[index]].path,
+               giga_cli_status_name(job_result->status), job_result->program_counter);
+        for (size_t reg = 0; reg < GIGA_VM_REGISTER_COUNT; ++reg) {
+            printf(" R%zu=%u", reg, job_result->registers[reg]);
+        }
+        printf(" Z=%u C=%u N=%u V=%u", job_result->flags_zero, job_result->flags_carry,
+               job_result->flags_negative, job_result->flags_overflow);
+        if (options->counters) {
+            giga_cli_print_counters(&job_result->counters);
+            giga_cli_add_counters(&total_counters, &job_result->counters);
+        }
+        putchar('\n');
+        if (job_result->status != GIGA_VM_STATUS_HALTED && job_result->status != GIGA_VM_STATUS_STEP_LIMIT) {
+            job_failed = 1;
+        }
+    }
+
+    if (result == 0 && options->counters) {
+        printf("total:");
+        giga_cli_print_counters(&total_counters);
+        putchar('\n');
+    }
+
+    giga_runner_destroy(runner);
+    free(results);
+    for (size_t index = 0; index < program_count; ++index) {
+        free(programs[index].path);
+    }
+    free(programs);
+    free(jobs);
+    free(job_programs);
+    free(manifest);
+    return (result != 0 || job_failed) ? 1 : 0;
+}
+
+/* Run a .gbc image straight from its mapping. */
+static int giga_cli_run_image(const GigaCliOptions *options) {
+    GigaVmImage image;
+    int result = giga_vm_image_open(options->program_path, &image);
+    if (result != 0) {
+        fprintf(stderr, "error: %s: %s\n", options->program_path,
+                (result == -3) ? "not a valid image for this build" : "cannot open");
+        return 1;
+    }
+
+    static GigaVmState state;
+    giga_vm_load_image(&state, &image);
+    GigaVmBanks *banks = giga_vm_banks_create(GIGA_VM_BANK_COUNT);
+    if (banks == NULL) {
+        fprintf(stderr, "warning: banked memory unavailable, only bank 0 can be selected\n");
+    }
+    giga_vm_attach_banks(&state, banks);
+    GigaVmStatus status = giga_vm_run_image(&state, &image, options->max_steps);
+    giga_cli_print_state(&state, status);
+    giga_vm_banks_destroy(banks);
+    giga_vm_image_close(&image);
+    return (status == GIGA_VM_STATUS_HALTED || status == GIGA_VM_STATUS_STEP_LIMIT) ? 0 : 1;
+}
+
+/* Everything after option parsing: assemble or map the program, then run it. */
+static int giga_cli_run(const GigaCliOptions *options) {
+    if (options->batch_mode) {
+        return giga_cli_run_batch(options);
+    }
+
+    if (giga_cli_is_image(options->program_path)) {
+        return giga_cli_run_image(options);
+    }
+
+    static uint16_t program[GIGA_VM_MAX_CODE_WORDS];
+    static size_t source_lines[GIGA_VM_MAX_CODE_WORDS];
+    size_t word_count = 0;
+    size_t max_words = (options->harvard || options->image_path != NULL) ? GIGA_VM_MAX_CODE_WORDS
+                                                                       : GIGA_VM_MAX_PROGRAM_WORDS;
+    if (giga_cli_assemble_file(options->cache, options->program_path, max_words, program, source_lines, &word_count,
+                               options->image_path, options->fuse_superinstructions) != 0) {
+        return 1;
+    }
+    if (options->image_path != NULL) {
+        return 0;
+    }
+
+    static GigaVmState state;
+    static GigaVmCode code;
+    giga_vm_init(&state);
+    if (options->harvard) {
+        giga_vm_code_init(&code, program, word_count);
+        if (options->fuse_superinstructions) {
+            giga_vm_code_fuse(&code);
+        }
+    } else {
+        giga_vm_load_program(&state, program, word_count);
+        if (options->fuse_superinstructions) {
+            giga_vm_fuse_superinstructions(&state);
+        }
+    }
+    /* reserved up front; only banks the program stores to take memory */
+    GigaVmBanks *banks = giga_vm_banks_create(GIGA_VM_BANK_COUNT);
+    if (banks == NULL) {
+        fprintf(stderr, "warning: banked memory unavailable, only bank 0 can be selected\n");
+    }
+    giga_vm_attach_banks(&state, banks);
+
+    if (options->profile) {
+        static GigaVmProfile profile;
+        giga_vm_profile_reset(&profile);
+        GigaVmStatus status = giga_vm_run_profiled(&state, options->max_steps, &profile);
+        giga_cli_print_state(&state, status);
+        giga_vm_profile_write_report(&profile, &state, source_lines, GIGA_CLI_PROFILE_BLOCKS, stdout);
+        giga_vm_banks_destroy(banks);
+        return (status == GIGA_VM_STATUS_HALTED || status == GIGA_VM_STATUS_STEP_LIMIT) ? 0 : 1;
+    }
+
+    GigaVmJit *jit = NULL;
+    if (options->use_jit) {
+        jit = giga_vm_jit_create();
+        if (jit == NULL) {
+            fprintf(stderr, "warning: JIT unavailable, using the interpreter\n");
+        }
+    }
+
+    GigaVmStatus status = options->harvard ? giga_vm_run_code(&state, &code, options->max_steps)
+                                          : giga_vm_jit_run(jit, &state, options->max_steps);
+    giga_cli_print_state(&state, status);
+    if (options->counters) {
+        GigaVmCounters counters;
+        giga_vm_counters(&state, &counters);
+        printf("counters:");
+        giga_cli_print_counters(&counters);
+        putchar('\n');
+    }
+    giga_vm_jit_destroy(jit);
+    giga_vm_banks_destroy(banks);
+    return (status == GIGA_VM_STATUS_HALTED || status == GIGA_VM_STATUS_STEP_LIMIT) ? 0 : 1;
+}
+
+int main(int argc, char **argv) {
+    puts("Giga-ALU (v0.1.0) - 4-bit ALU virtual machine");
+    if (argc < 2) {
+        return 0;
+    }
+
+    GigaCliOptions options;
+    if (giga_cli_parse_options(argc, argv, &options) != 0) {
+        giga_cli_print_usage(argv[0]);
+        return 2;
+    }
+    if (options.cache_path != NULL) {
+        options.cache = giga_assembler_cache_open(options.cache_path);
+        if (options.cache == NULL) {
+            fprintf(stderr, "warning: cannot use cache directory %s, assembling every program\n",
+                    options.cache_path);
+        }
+    }
+    int status = giga_cli_run(&options);
+    giga_assembler_cache_close(options.cache);
+    return status;
+}
@@ -0,0 +1,325 @@
+#define _GNU_SOURCE
+
+#include "runner/runner.h"
+#include "vm/vm_banks.h"
+#include "vm/vm_ports.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define GIGA_RUNNER_CACHE_LINE 64
+
+/*
+ * A worker's deque: the half-open job range [begin, end) packed as
+ * (begin << 32) | end. The owner advances begin, thieves lower end; both
+ * with compare-and-swap. Ranges only shrink or move to another deque, so a
+ * stale value can never compare equal again (no ABA).
+ */
+typedef struct {
+    alignas(GIGA_RUNNER_CACHE_LINE) _Atomic uint64_t range;
+} GigaRunnerDeque;
+
+typedef struct {
+    alignas(GIGA_RUNNER_CACHE_LINE) GigaVmState state; /* reused for every job */
+    GigaVmBanks *banks;                 /* state's banks 1 and up, cleared after each job */
+    GigaRunner *runner;
+    size_t index;
+    uint32_t random_state;
+    pthread_t thread;
+} GigaRunnerWorker;
+
+struct GigaRunner {
+    GigaRunnerOptions options;
+    size_t thread_count;
+    GigaRunnerDeque *deques;
+    GigaRunnerWorker *workers;
+    size_t started_threads;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t start_condition;
+    pthread_cond_t done_condition;
+    uint64_t generation;                /* incremented per batch */
+    size_t busy_workers;
+    int shutting_down;
+
+    const GigaRunnerJob *jobs;
+    GigaRunnerResult *results;
+};
+
+static inline uint64_t giga_runner_pack(uint32_t begin, uint32_t end) {
+    return ((uint64_t)begin << 32) | end;
+}
+
+static inline uint32_t giga_runner_begin(uint64_t range) {
+    return (uint32_t)(range >> 32);
+}
+
+static inline uint32_t giga_runner_end(uint64_t range) {
+    return (uint32_t)range;
+}
+
+/* Take the next job index from the front of the worker's own range. */
+static int giga_runner_pop(GigaRunnerDeque *deque, uint32_t *out_index) {
+    uint64_t range = atomic_load_explicit(&deque->range, memory_order_relaxed);
+    for (;;) {
+        uint32_t begin = giga_runner_begin(range);
+        uint32_t end = giga_runner_end(range);
+        if (begin >= end) {
+            return 0;
+        }
+        if (atomic_compare_exchange_weak_explicit(&deque->range, &range,
+                                                  giga_runner_pack(begin + 1u, end),
+                                                  memory_order_acquire, memory_order_relaxed)) {
+            *out_index = begin;
+            return 1;
+        }
+    }
+}
+
+/* Move the back half of a victim's range into the (empty) own deque. */
+static int giga_runner_steal(GigaRunner *runner, GigaRunnerWorker *worker) {
+    size_t count = runner->thread_count;
+    worker->random_state = worker->random_state * 1664525u + 1013904223u;
+    size_t start = (size_t)(worker->random_state >> 8) % count;
+
+    for (size_t offset = 0; offset < count; ++offset) {
+        size_t victim = (start + offset) % count;
+        if (victim == worker->index) {
+            continue;
+        }
+        GigaRunnerDeque *deque = &runner->deques[victim];
+        uint64_t range = atomic_load_explicit(&deque->range, memory_order_relaxed);
+        for (;;) {
+            uint32_t begin = giga_runner_begin(range);
+            uint32_t end = giga_runner_end(range);
+            if (begin >= end) {
+                break;
+            }
+            uint32_t middle = begin + (end - begin) / 2u; /* a single job is taken whole */
+            if (atomic_compare_exchange_weak_explicit(&deque->range, &range,
+                                                      giga_runner_pack(begin, middle),
+                                                      memory_order_acquire, memory_order_relaxed)) {
+                atomic_store_explicit(&runner->deques[worker->index].range,
+                                      giga_runner_pack(middle, end), memory_order_release);
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+static void giga_runner_execute(GigaRunner *runner, GigaRunnerWorker *worker, uint32_t index) {
+    const GigaRunnerJob *job = &runner->jobs[index];
+    GigaRunnerResult *result = &runner->results[index];
+    GigaVmState *state = &worker->state;
+
+    if (job->initial_state != NULL) {
+        *state = *job->initial_state;
+    } else {
+        giga_vm_init(state);
+        if (giga_vm_load_program(state, job->program_words, job->word_count) != 0) {
+            memset(result, 0, sizeof(*result));
+            result->status = GIGA_VM_STATUS_INVALID_STATE;
+            return;
+        }
+        if (job->initial_registers != NULL) {
+            memcpy(state->registers, job->initial_registers, sizeof(state->registers));
+        }
+    }
+    giga_vm_attach_banks(state, worker->banks);
+    giga_vm_attach_ports(state, NULL); /* rings take one producer and one consumer; jobs run in parallel */
+    if (runner->options.fuse_superinstructions) {
+        giga_vm_fuse_superinstructions(state);
+    }
+
+    giga_vm_counters_reset(state);
+    result->status = giga_vm_run(state, job->max_steps);
+    result->program_counter = state->program_counter;
+    memcpy(result->registers, state->registers, sizeof(result->registers));
+    result->flags_zero = state->flags_zero;
+    result->flags_carry = state->flags_carry;
+    result->flags_negative = state->flags_negative;
+    result->flags_overflow = state->flags_overflow;
+    giga_vm_counters(state, &result->counters);
+    giga_vm_banks_clear(worker->banks);
+}
+
+static void giga_runner_pin(size_t worker_index) {
+#if defined(__linux__)
+    long cpu_count = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpu_count <= 0) {
+        return;
+    }
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET((int)(worker_index % (size_t)cpu_count), &cpus);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+#else
+    (void)worker_index;
+#endif
+}
+
+static void *giga_runner_worker_main(void *argument) {
+    GigaRunnerWorker *worker = (GigaRunnerWorker *)argument;
+    GigaRunner *runner = worker->runner;
+    GigaRunnerDeque *own = &runner->deques[worker->index];
+    uint64_t seen_generation = 0;
+
+    if (runner->options.pin_threads) {
+        giga_runner_pin(worker->index);
+    }
+
+    for (;;) {
+        pthread_mutex_lock(&runner->mutex);
+        while (!runner->shutting_down && runner->generation == seen_generation) {
+            pthread_cond_wait(&runner->start_condition, &runner->mutex);
+        }
+        if (runner->shutting_down) {
+            pthread_mutex_unlock(&runner->mutex);
+            return NULL;
+        }
+        seen_generation = runner->generation;
+        pthread_mutex_unlock(&runner->mutex);
+
+        uint32_t index;
+        for (;;) {
+            while (giga_runner_pop(own, &index)) {
+                giga_runner_execute(runner, worker, index);
+            }
+            if (!giga_runner_steal(runner, worker)) {
+                break;
+            }
+        }
+
+        pthread_mutex_lock(&runner->mutex);
+        if (--runner->busy_workers == 0) {
+            pthread_cond_signal(&runner->done_condition);
+        }
+        pthread_mutex_unlock(&runner->mutex);
+    }
+}
+
+void giga_runner_default_options(GigaRunnerOptions *options) {
+    if (options == NULL) {
+        return;
+    }
+    options->thread_count = 0;
+    options->pin_threads = 0;
+    options->fuse_superinstructions = 1;
+}
+
+GigaRunner *giga_runner_create(const GigaRunnerOptions *options) {
+    GigaRunner *runner = (GigaRunner *)calloc(1, sizeof(GigaRunner));
+    if (runner == NULL) {
+        return NULL;
+    }
+    if (options != NULL) {
+        runner->options = *options;
+    } else {
+        giga_runner_default_options(&runner->options);
+    }
+
+    size_t thread_count = runner->options.thread_count;
+    if (thread_count == 0) {
+        long cpu_count = sysconf(_SC_NPROCESSORS_ONLN);
+        thread_count = (cpu_count > 0) ? (size_t)cpu_count : 1u;
+    }
+    runner->thread_count = thread_count;
+
+    runner->deques = (GigaRunnerDeque *)aligned_alloc(
+        GIGA_RUNNER_CACHE_LINE, thread_count * sizeof(GigaRunnerDeque));
+    runner->workers = (GigaRunnerWorker *)aligned_alloc(
+        GIGA_RUNNER_CACHE_LINE, thread_count * sizeof(GigaRunnerWorker));
+    if (runner->deques == NULL || runner->workers == NULL) {
+        free(runner->deques);
+        free(runner->workers);
+        free(runner);
+        return NULL;
+    }
+    pthread_mutex_init(&runner->mutex, NULL);
+    pthread_cond_init(&runner->start_condition, NULL);
+    pthread_cond_init(&runner->done_condition, NULL);
+
+    for (size_t index = 0; index < thread_count; ++index) {
+        atomic_init(&runner->deques[index].range, 0);
+        GigaRunnerWorker *worker = &runner->workers[index];
+        worker->runner = runner;
+        worker->index = index;
+        worker->random_state = 0x9E3779B9u * (uint32_t)(index + 1u);
+        worker->banks = giga_vm_banks_create(GIGA_VM_BANK_COUNT);
+        if (worker->banks == NULL) {
+            giga_runner_destroy(runner);
+            return NULL;
+        }
+        if (pthread_create(&worker->thread, NULL, giga_runner_worker_main, worker) != 0) {
+            giga_vm_banks_destroy(worker->banks);
+            giga_runner_destroy(runner);
+            return NULL;
+        }
+        runner->started_threads = index + 1u;
+    }
+    return runner;
+}
+
+void giga_runner_destroy(GigaRunner *runner) {
+    if (runner == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&runner->mutex);
+    runner->shutting_down = 1;
+    pthread_cond_broadcast(&runner->start_condition);
+    pthread_mutex_unlock(&runner->mutex);
+    for (size_t index = 0; index < runner->started_threads; ++index) {
+        pthread_join(runner->workers[index].thread, NULL);
+        giga_vm_banks_destroy(runner->workers[index].banks);
+    }
+
+    pthread_cond_destroy(&runner->done_condition);
+    pthread_cond_destroy(&runner->start_condition);
+    pthread_mutex_destroy(&runner->mutex);
+    free(runner->workers);
+    free(runner->deques);
+    free(runner);
+}
+
+size_t giga_runner_thread_count(const GigaRunner *runner) {
+    return (runner == NULL) ? 0 : runner->thread_count;
+}
+
+int giga_runner_run(GigaRunner *runner,
+                    const GigaRunnerJob *jobs,
+                    size_t job_count,
+                    GigaRunnerResult *results) {
+    if (runner == NULL || (job_count > 0 && (jobs == NULL || results == NULL)) ||
+        job_count > UINT32_MAX) {
+        return -1;
+    }
+    if (job_count == 0) {
+        return 0;
+    }
+
+    runner->jobs = jobs;
+    runner->results = results;
+    size_t thread_count = runner->thread_count;
+    for (size_t index = 0; index < thread_count; ++index) {
+        uint32_t begin = (uint32_t)(job_count * index / thread_count);
+        uint32_t end = (uint32_t)(job_count * (index + 1u) / thread_count);
+        atomic_store_explicit(&runner->deques[index].range, giga_runner_pack(begin, end),
+                              memory_order_relaxed);
+    }
+
+    pthread_mutex_lock(&runner->mutex);
+    runner->busy_workers = thread_count;
+    ++runner->generation;
+    pthread_cond_broadcast(&runner->start_condition);
+    while (runner->busy_workers > 0) {
+        pthread_cond_wait(&runner->done_condition, &runner->mutex);
+    }
+    pthread_mutex_unlock(&runner->mutex);
+    return 0;
+}
@@ -1,7 +1,72 @@
 #include "vm/vm.h"
+#include "vm/vm_banks.h"
+#include "vm/vm_ports.h"
+#include "vm/vm_image.h"
+#include "vm/vm_trace.h"
+#include "vm/vm_profile.h"
+#include "alu/alu_lut.h"
 
+#include <stdatomic.h>
+#include <stdlib.h>
 #include <string.h>
 
+#ifdef GIGA_VM_USE_ALU_LUT
+/* Table ALU: one byte load per operation, bit-identical to alu_*. */
+#define GIGA_VM_ALU(op) alu_lut_##op
+#else
+#define GIGA_VM_ALU(op) alu_##op
+#endif
+
+/*
+ * Run-loop handler indices stored in GigaVmDecodedInstruction.handler.
+ * Indices 0x0-0xF match GigaOpcode so plain instructions decode directly;
+ * the extra handlers cover cases the predecoder resolves ahead of time.
+ */
+enum {
+    GIGA_VM_HANDLER_INVALID = 0xE,        /* undefined opcode */
+    GIGA_VM_HANDLER_JMP_OUT = 0x10,       /* JMP whose target is past the program */
+    GIGA_VM_HANDLER_DECODE,               /* invalidated entry, re-decode from memory */
+    GIGA_VM_HANDLER_END,                  /* sentinel after the last program word */
+    GIGA_VM_HANDLER_ADC,                  /* GIGA_OP_EXT / GIGA_EXT_ADC */
+    GIGA_VM_HANDLER_SBC,                  /* GIGA_OP_EXT / GIGA_EXT_SBC */
+    GIGA_VM_HANDLER_CMP,                  /* GIGA_OP_EXT / GIGA_EXT_CMP */
+    GIGA_VM_HANDLER_BRANCH,               /* GIGA_OP_EXT / GIGA_EXT_JZ..JN; sub-opcode in imm4 */
+    GIGA_VM_HANDLER_BRANCH_OUT,           /* branch whose target is past the program */
+    GIGA_VM_HANDLER_BANK,                 /* GIGA_OP_EXT / GIGA_EXT_BANK */
+    GIGA_VM_HANDLER_BANK_IMM,             /* GIGA_OP_EXT / GIGA_EXT_BANKI; bank in operand */
+    GIGA_VM_HANDLER_IN,                   /* GIGA_OP_EXT / GIGA_EXT_IN; port in operand */
+    GIGA_VM_HANDLER_OUT,                  /* GIGA_OP_EXT / GIGA_EXT_OUT; port in operand */
+    GIGA_VM_HANDLER_MOVI_ADD,             /* fused MOVI; ADD */
+    GIGA_VM_HANDLER_LD_ADD_ST,            /* fused LD; ADD; ST */
+    GIGA_VM_HANDLER_SHL_SHL,              /* fused SHL; SHL on the same register */
+    GIGA_VM_HANDLER_CMP_BRANCH,           /* fused CMP; branch */
+    GIGA_VM_HANDLER_COUNT
+};
+
+#define GIGA_VM_FIRST_FUSED_HANDLER GIGA_VM_HANDLER_MOVI_ADD
+
+/* Longest superinstruction, in words. */
+#define GIGA_VM_MAX_FUSED_WORDS 3
+
+static inline size_t giga_vm_fused_length(uint8_t handler) {
+    switch (handler) {
+        case GIGA_VM_HANDLER_MOVI_ADD:
+        case GIGA_VM_HANDLER_SHL_SHL:
+        case GIGA_VM_HANDLER_CMP_BRANCH:
+            return 2;
+        case GIGA_VM_HANDLER_LD_ADD_ST:
+            return 3;
+        default:
+            return 1;
+    }
+}
+
+/* dirty_blocks bits covering memory addresses [0, byte_count). */
+static inline uint16_t giga_vm_block_mask(size_t byte_count) {
+    size_t block_count = (byte_count + GIGA_VM_DIRTY_BLOCK_SIZE - 1u) / GIGA_VM_DIRTY_BLOCK_SIZE;
+    return (uint16_t)((1u << block_count) - 1u);
+}
+
 GigaInstruction giga_decode_instruction(uint16_t raw_word) {
     GigaInstruction instruction;
     instruction.raw = raw_word;
@@ -23,7 +88,178 @@ void giga_vm_init(GigaVmState *state) {
     state->flags_overflow = 0;
     state->program_counter = 0;
     memset(state->memory, 0, sizeof(state->memory));
+    state->data_bank = 0;
+    state->banks = NULL;
+    state->ports = NULL;
     state->loaded_program_words = 0;
+    state->snapshot_id = 0;
+    state->dirty_blocks = giga_vm_block_mask(GIGA_VM_MEMORY_SIZE);
+    memset(state->decoded, 0, sizeof(state->decoded));
+    state->decoded[0].handler = GIGA_VM_HANDLER_END;
+    state->decoded[0].base_handler = GIGA_VM_HANDLER_END;
+    memset(state->block_edges, 0, sizeof(state->block_edges));
+    memset(&state->counters, 0, sizeof(state->counters));
+}
+
+static void giga_vm_decode_entry(uint16_t raw_word, size_t word_count, GigaVmDecodedInstruction *entry) {
+    GigaInstruction instruction = giga_decode_instruction(raw_word);
+
+    entry->handler = (uint8_t)instruction.opcode;
+    entry->dest_reg = (uint8_t)(instruction.dest_reg & (GIGA_VM_REGISTER_COUNT - 1u));
+    entry->src_reg = (uint8_t)(instruction.src_reg & (GIGA_VM_REGISTER_COUNT - 1u));
+    entry->imm4 = instruction.imm4;
+    entry->operand = 0;
+
+    switch (instruction.opcode) {
+        case GIGA_OP_LD:
+            entry->operand = (uint16_t)((instruction.src_reg << 4) | instruction.imm4);
+            break;
+        case GIGA_OP_ST:
+            entry->operand = (uint16_t)((instruction.dest_reg << 4) | instruction.imm4);
+            break;
+        case GIGA_OP_JMP:
+            entry->operand = (uint16_t)(raw_word & 0x0FFFu);
+            if (entry->operand >= word_count) {
+                entry->handler = GIGA_VM_HANDLER_JMP_OUT;
+            }
+            break;
+        case GIGA_OP_EXT:
+            /* sub-opcode in [11:8], registers in [7:4] and [3:0] */
+            entry->dest_reg = (uint8_t)(instruction.src_reg & (GIGA_VM_REGISTER_COUNT - 1u));
+            entry->src_reg = (uint8_t)(instruction.imm4 & (GIGA_VM_REGISTER_COUNT - 1u));
+            if (instruction.dest_reg == GIGA_EXT_ADC) {
+                entry->handler = GIGA_VM_HANDLER_ADC;
+            } else if (instruction.dest_reg == GIGA_EXT_SBC) {
+                entry->handler = GIGA_VM_HANDLER_SBC;
+            } else if (instruction.dest_reg == GIGA_EXT_CMP) {
+                entry->handler = GIGA_VM_HANDLER_CMP;
+            } else if (instruction.dest_reg == GIGA_EXT_BANK) {
+                entry->handler = GIGA_VM_HANDLER_BANK;
+            } else if (instruction.dest_reg == GIGA_EXT_BANKI) {
+                entry->operand = (uint16_t)(raw_word & 0x00FFu);
+                entry->handler = GIGA_VM_HANDLER_BANK_IMM;
+            } else if (instruction.dest_reg == GIGA_EXT_IN) {
+                entry->operand = instruction.imm4;
+                entry->handler = GIGA_VM_HANDLER_IN;
+            } else if (instruction.dest_reg == GIGA_EXT_OUT) {
+                entry->operand = instruction.src_reg;
+                entry->handler = GIGA_VM_HANDLER_OUT;
+            } else if (GIGA_EXT_IS_BRANCH(instruction.dest_reg)) {
+                /* target in [7:0]; the sub-opcode picks the condition */
+                entry->imm4 = instruction.dest_reg;
+                entry->operand = (uint16_t)(raw_word & 0x00FFu);
+                entry->handler = (entry->operand >= word_count) ? GIGA_VM_HANDLER_BRANCH_OUT
+                                                                : GIGA_VM_HANDLER_BRANCH;
+            } else {
+                entry->handler = GIGA_VM_HANDLER_INVALID;
+            }
+            break;
+        default:
+            break;
+    }
+    entry->base_handler = entry->handler;
+}
+
+static inline uint16_t giga_vm_memory_word(const uint8_t *memory, size_t word_index) {
+    return (uint16_t)(((uint16_t)memory[word_index * 2u + 1u] << 8) | memory[word_index * 2u]);
+}
+
+/*
+ * Add the executions recorded in block_edges to counters and clear the edges.
+ * A running sum of the edges is the number of times each word retired; the
+ * word's base_handler says what it counts as. Must run before any
+ * base_handler changes, and only while no run has a block open.
+ */
+static void giga_vm_fold_counters(GigaVmState *state) {
+    GigaVmCounters *counters = &state->counters;
+    const size_t word_count = state->loaded_program_words;
+    uint64_t executions = 0;
+
+    for (size_t pc = 0; pc < word_count; ++pc) {
+        executions += state->block_edges[pc];
+        if (executions == 0) {
+            continue;
+        }
+        const GigaVmDecodedInstruction *entry = &state->decoded[pc];
+        counters->retired += executions;
+        switch (entry->base_handler) {
+            case GIGA_OP_ADD:
+            case GIGA_OP_SUB:
+            case GIGA_OP_AND:
+            case GIGA_OP_OR:
+            case GIGA_OP_XOR:
+            case GIGA_OP_NOT:
+            case GIGA_OP_SHL:
+            case GIGA_OP_SHR:
+                counters->alu_ops[GIGA_VM_COUNTER_ADD + (entry->base_handler - GIGA_OP_ADD)] += executions;
+                break;
+            case GIGA_VM_HANDLER_ADC:
+            case GIGA_VM_HANDLER_SBC:
+                counters->alu_ops[(entry->base_handler == GIGA_VM_HANDLER_ADC) ? GIGA_VM_COUNTER_ADC
+                                                                               : GIGA_VM_COUNTER_SBC] += executions;
+                counters->flag_reads += executions;
+                break;
+            case GIGA_VM_HANDLER_CMP:
+                counters->alu_ops[GIGA_VM_COUNTER_CMP] += executions;
+                break;
+            case GIGA_VM_HANDLER_BRANCH:
+            case GIGA_VM_HANDLER_BRANCH_OUT:
+                /* taken branches are counted as they happen */
+                counters->flag_reads += executions;
+                break;
+            case GIGA_OP_LD:
+                counters->loads += executions;
+                break;
+            case GIGA_OP_ST:
+                /* code_writes depend on the bank, so the run loop counts them */
+                counters->stores += executions;
+                break;
+            case GIGA_OP_JMP:
+            case GIGA_VM_HANDLER_JMP_OUT:
+                counters->taken_jumps += executions;
+                break;
+            default:
+                break;
+        }
+    }
+    memset(state->block_edges, 0, sizeof(state->block_edges));
+}
+
+static void giga_vm_predecode_word(GigaVmState *state, size_t word_index) {
+    giga_vm_fold_counters(state);
+    giga_vm_decode_entry(giga_vm_memory_word(state->memory, word_index), state->loaded_program_words,
+                         &state->decoded[word_index]);
+}
+
+/* Stop sequential execution past the last word. */
+static void giga_vm_decode_end(GigaVmDecodedInstruction *decoded, size_t word_count) {
+    memset(&decoded[word_count], 0, sizeof(decoded[word_count]));
+    decoded[word_count].handler = GIGA_VM_HANDLER_END;
+    decoded[word_count].base_handler = GIGA_VM_HANDLER_END;
+}
+
+/* Decode a whole program image and terminate it with the END sentinel. */
+static void giga_vm_predecode_program(const uint8_t *memory, size_t word_count,
+                                      GigaVmDecodedInstruction *decoded) {
+    for (size_t index = 0; index < word_count; ++index) {
+        giga_vm_decode_entry(giga_vm_memory_word(memory, index), word_count, &decoded[index]);
+    }
+    giga_vm_decode_end(decoded, word_count);
+}
+
+/*
+ * Mark the entry for word_index for re-decode, together with any earlier
+ * superinstruction whose fused handler reads it.
+ */
+static inline void giga_vm_invalidate_word(GigaVmDecodedInstruction *decoded, size_t word_index) {
+    decoded[word_index].handler = GIGA_VM_HANDLER_DECODE;
+    for (size_t back = 1; back < GIGA_VM_MAX_FUSED_WORDS && back <= word_index; ++back) {
+        GigaVmDecodedInstruction *earlier = &decoded[word_index - back];
+        if (earlier->handler >= GIGA_VM_FIRST_FUSED_HANDLER &&
+            giga_vm_fused_length(earlier->handler) > back) {
+            earlier->handler = GIGA_VM_HANDLER_DECODE;
+        }
+    }
 }
 
 int giga_vm_load_program(GigaVmState *state,
@@ -39,6 +275,7 @@ int giga_vm_load_program(GigaVmState *state,
         return -2;
     }
 
+    giga_vm_fold_counters(state); /* before the old program's entries go */
     for (size_t index = 0; index < word_count; ++index) {
         uint16_t raw_word = program_words[index];
         size_t byte_address = index * 2u;
@@ -48,9 +285,78 @@ int giga_vm_load_program(GigaVmState *state,
 
     state->loaded_program_words = word_count;
     state->program_counter = 0;
+    state->snapshot_id = 0; /* a new program: the next restore copies everything */
+    giga_vm_predecode_program(state->memory, word_count, state->decoded);
     return 0;
 }
 
+static size_t giga_vm_fuse_decoded(GigaVmDecodedInstruction *decoded, size_t word_count) {
+    size_t fused_count = 0;
+
+    for (size_t index = 0; index + 1 < word_count; ++index) {
+        GigaVmDecodedInstruction *first = &decoded[index];
+        const GigaVmDecodedInstruction *second = &decoded[index + 1];
+
+        if (index + 2 < word_count &&
+            first->handler == GIGA_OP_LD &&
+            second->handler == GIGA_OP_ADD &&
+            decoded[index + 2].handler == GIGA_OP_ST) {
+            first->handler = GIGA_VM_HANDLER_LD_ADD_ST;
+        } else if (first->handler == GIGA_VM_HANDLER_CMP && second->handler == GIGA_VM_HANDLER_BRANCH) {
+            first->handler = GIGA_VM_HANDLER_CMP_BRANCH;
+        } else if (first->handler == GIGA_OP_MOVI && second->handler == GIGA_OP_ADD) {
+            first->handler = GIGA_VM_HANDLER_MOVI_ADD;
+        } else if (first->handler == GIGA_OP_SHL && second->handler == GIGA_OP_SHL &&
+                   first->dest_reg == second->dest_reg) {
+            first->handler = GIGA_VM_HANDLER_SHL_SHL;
+        } else {
+            continue;
+        }
+        ++fused_count;
+    }
+
+    return fused_count;
+}
+
+size_t giga_vm_fuse_superinstructions(GigaVmState *state) {
+    if (state == NULL) {
+        return 0;
+    }
+    return giga_vm_fuse_decoded(state->decoded, state->loaded_program_words);
+}
+
+void giga_vm_invalidate_code(GigaVmState *state, size_t byte_address) {
+    if (state == NULL || byte_address >= state->loaded_program_words * 2u) {
+        return;
+    }
+    state->dirty_blocks |= GIGA_VM_DIRTY_BIT(byte_address);
+    giga_vm_invalidate_word(state->decoded, byte_address / 2u);
+}
+
+void giga_vm_mark_dirty(GigaVmState *state, size_t byte_address) {
+    if (state == NULL) {
+        return;
+    }
+    state->dirty_blocks |= GIGA_VM_DIRTY_BIT(byte_address % GIGA_VM_MEMORY_SIZE);
+}
+
+int giga_vm_counters(GigaVmState *state, GigaVmCounters *out) {
+    if (state == NULL || out == NULL) {
+        return -1;
+    }
+    giga_vm_fold_counters(state);
+    *out = state->counters;
+    return 0;
+}
+
+void giga_vm_counters_reset(GigaVmState *state) {
+    if (state == NULL) {
+        return;
+    }
+    memset(state->block_edges, 0, sizeof(state->block_edges));
+    memset(&state->counters, 0, sizeof(state->counters));
+}
+
 int giga_vm_fetch_word(const GigaVmState *state, uint16_t *out_word) {
     if (state == NULL || out_word == NULL) {
         return -1;
@@ -68,3 +374,1323 @@ int giga_vm_fetch_word(const GigaVmState *state, uint16_t *out_word) {
 }
 
 
+
+#if defined(__GNUC__) && !defined(GIGA_VM_SWITCH_DISPATCH)
+#define GIGA_VM_THREADED_DISPATCH 1
+#else
+#define GIGA_VM_THREADED_DISPATCH 0
+#endif
+
+static inline void giga_vm_set_flags(GigaVmState *state, AluResult alu_result) {
+    state->flags_zero = alu_result.zero_flag;
+    state->flags_carry = alu_result.carry_flag;
+    state->flags_negative = alu_result.negative_flag;
+    state->flags_overflow = alu_result.overflow_flag;
+}
+
+/*
+ * Lazy flags: ALU handlers only record the opcode that last wrote the flags
+ * and its input operands; the four flag bytes are derived from that when
+ * something reads them (ADC/SBC read the carry, and the run loop
+ * materializes all four on exit). GIGA_OP_NOP as the kind means flags_* in
+ * the state are already current.
+ */
+typedef struct {
+    uint8_t kind;       /* handler index of the last ALU op, or GIGA_OP_NOP */
+    uint8_t operand_a;  /* first operand (the only one for unary ops) */
+    uint8_t operand_b;  /* second operand of binary ops */
+    uint8_t carry_in;   /* incoming carry of ADC/SBC */
+} GigaVmLazyFlags;
+
+#define GIGA_VM_RECORD_FLAGS(op, a, b)                                         \
+    do {                                                                       \
+        lazy_flags.kind = (op);                                                \
+        lazy_flags.operand_a = (a);                                            \
+        lazy_flags.operand_b = (b);                                            \
+    } while (0)
+
+#define GIGA_VM_RECORD_CARRY_FLAGS(op, a, b, carry)                            \
+    do {                                                                       \
+        GIGA_VM_RECORD_FLAGS(op, a, b);                                        \
+        lazy_flags.carry_in = (carry);                                         \
+    } while (0)
+
+/* Flags described by lazy_flags; returns 0 when the state already holds them. */
+static inline int giga_vm_evaluate_flags(GigaVmLazyFlags lazy_flags, AluResult *flags) {
+    uint8_t operand_a = lazy_flags.operand_a;
+    uint8_t operand_b = lazy_flags.operand_b;
+    switch (lazy_flags.kind) {
+        case GIGA_OP_ADD: *flags = GIGA_VM_ALU(add)(operand_a, operand_b); return 1;
+        case GIGA_OP_SUB: *flags = GIGA_VM_ALU(sub)(operand_a, operand_b); return 1;
+        case GIGA_OP_AND: *flags = GIGA_VM_ALU(and)(operand_a, operand_b); return 1;
+        case GIGA_OP_OR:  *flags = GIGA_VM_ALU(or)(operand_a, operand_b); return 1;
+        case GIGA_OP_XOR: *flags = GIGA_VM_ALU(xor)(operand_a, operand_b); return 1;
+        case GIGA_OP_NOT: *flags = GIGA_VM_ALU(not)(operand_a); return 1;
+        case GIGA_OP_SHL: *flags = GIGA_VM_ALU(shl)(operand_a); return 1;
+        case GIGA_OP_SHR: *flags = GIGA_VM_ALU(shr)(operand_a); return 1;
+        /* no tables for the carry-in forms */
+        case GIGA_VM_HANDLER_ADC: *flags = alu_adc(operand_a, operand_b, lazy_flags.carry_in); return 1;
+        case GIGA_VM_HANDLER_SBC: *flags = alu_sbc(operand_a, operand_b, lazy_flags.carry_in); return 1;
+        default: return 0;
+    }
+}
+
+/* Carry flag alone, for ADC/SBC; saved_carry is the state's when nothing is pending. */
+static inline uint8_t giga_vm_lazy_carry(GigaVmLazyFlags lazy_flags, uint8_t saved_carry) {
+    unsigned operand_a = lazy_flags.operand_a & 0x0Fu;
+    unsigned operand_b = lazy_flags.operand_b & 0x0Fu;
+    switch (lazy_flags.kind) {
+        case GIGA_OP_ADD: return (uint8_t)((operand_a + operand_b) >> 4);
+        case GIGA_OP_SUB: return (uint8_t)(operand_a >= operand_b);
+        case GIGA_OP_AND:
+        case GIGA_OP_OR:
+        case GIGA_OP_XOR:
+        case GIGA_OP_NOT: return 0;
+        case GIGA_OP_SHL: return (uint8_t)(operand_a >> 3);
+        case GIGA_OP_SHR: return (uint8_t)(operand_a & 1u);
+        case GIGA_VM_HANDLER_ADC: return (uint8_t)((operand_a + operand_b + lazy_flags.carry_in) >> 4);
+        case GIGA_VM_HANDLER_SBC: return (uint8_t)((operand_a + (operand_b ^ 0x0Fu) + lazy_flags.carry_in) >> 4);
+        default: return (uint8_t)(saved_carry != 0);
+    }
+}
+
+/* Result nibble of the ALU op lazy_flags describes, or -1 when the state holds the flags. */
+static inline int giga_vm_lazy_result(GigaVmLazyFlags lazy_flags) {
+    unsigned operand_a = lazy_flags.operand_a & 0x0Fu;
+    unsigned operand_b = lazy_flags.operand_b & 0x0Fu;
+    switch (lazy_flags.kind) {
+        case GIGA_OP_ADD: return (int)((operand_a + operand_b) & 0x0Fu);
+        case GIGA_OP_SUB: return (int)((operand_a - operand_b) & 0x0Fu);
+        case GIGA_OP_AND: return (int)(operand_a & operand_b);
+        case GIGA_OP_OR:  return (int)(operand_a | operand_b);
+        case GIGA_OP_XOR: return (int)(operand_a ^ operand_b);
+        case GIGA_OP_NOT: return (int)(~operand_a & 0x0Fu);
+        case GIGA_OP_SHL: return (int)((operand_a << 1) & 0x0Fu);
+        case GIGA_OP_SHR: return (int)(operand_a >> 1);
+        case GIGA_VM_HANDLER_ADC: return (int)((operand_a + operand_b + lazy_flags.carry_in) & 0x0Fu);
+        case GIGA_VM_HANDLER_SBC: return (int)((operand_a + (operand_b ^ 0x0Fu) + lazy_flags.carry_in) & 0x0Fu);
+        default: return -1;
+    }
+}
+
+/*
+ * Condition of branch sub-opcode `branch` (GIGA_EXT_JZ..JN), read from
+ * lazy_flags or, when nothing is pending, from the saved flag bytes.
+ */
+static inline int giga_vm_lazy_condition(GigaVmLazyFlags lazy_flags, uint8_t branch, uint8_t saved_zero,
+                                         uint8_t saved_carry, uint8_t saved_negative) {
+    if (branch == GIGA_EXT_JC) {
+        return giga_vm_lazy_carry(lazy_flags, saved_carry);
+    }
+    int result = giga_vm_lazy_result(lazy_flags);
+    switch (branch) {
+        case GIGA_EXT_JZ: return (result < 0) ? saved_zero != 0 : result == 0;
+        case GIGA_EXT_JNZ: return (result < 0) ? saved_zero == 0 : result != 0;
+        default: return (result < 0) ? saved_negative != 0 : (result >> 3) & 1;
+    }
+}
+
+/* Condition of branch sub-opcode `branch` right after CMP a, b. */
+static inline int giga_vm_compare_condition(uint8_t operand_a, uint8_t operand_b, uint8_t branch) {
+    operand_a &= 0x0Fu;
+    operand_b &= 0x0Fu;
+    switch (branch) {
+        case GIGA_EXT_JZ: return operand_a == operand_b;
+        case GIGA_EXT_JNZ: return operand_a != operand_b;
+        case GIGA_EXT_JC: return operand_a >= operand_b;
+        default: return (int)((((unsigned)operand_a - operand_b) >> 3) & 1u);
+    }
+}
+
+/*
+ * Point `instruction` at the predecoded entry for pc and advance pc. The
+ * entry after the last program word is an END sentinel, so sequential
+ * execution needs no bounds check; only the step budget is tested.
+ */
+#define GIGA_VM_FETCH()                                                        \
+    do {                                                                       \
+        if (remaining_steps == 0) {                                            \
+            status = GIGA_VM_STATUS_STEP_LIMIT;                                \
+            goto vm_exit;                                                      \
+        }                                                                      \
+        instruction = GIGA_VM_ENTRY(program_counter);                          \
+        ++program_counter;                                                     \
+        --remaining_steps;                                                     \
+    } while (0)
+
+#if GIGA_VM_THREADED_DISPATCH
+#define GIGA_VM_LOOP_BEGIN() GIGA_VM_NEXT();
+#define GIGA_VM_LOOP_END()
+#define GIGA_VM_HANDLER(index, label) label:
+#define GIGA_VM_DISPATCH(index) goto *dispatch_table[(index)]
+#define GIGA_VM_NEXT()                                                         \
+    do {                                                                       \
+        GIGA_VM_FETCH();                                                       \
+        GIGA_VM_DISPATCH(instruction->handler);                                \
+    } while (0)
+#else
+#define GIGA_VM_LOOP_BEGIN()                                                   \
+    for (;;) {                                                                 \
+        GIGA_VM_FETCH();                                                       \
+        handler_index = instruction->handler;                                  \
+    vm_dispatch:                                                               \
+        switch (handler_index) {
+#define GIGA_VM_LOOP_END()                                                     \
+            default:                                                           \
+                goto op_invalid;                                               \
+        }                                                                      \
+    }
+#define GIGA_VM_HANDLER(index, label) case index:
+#define GIGA_VM_DISPATCH(index)                                                \
+    do {                                                                       \
+        handler_index = (index);                                               \
+        goto vm_dispatch;                                                      \
+    } while (0)
+#define GIGA_VM_NEXT() continue
+#endif
+
+/*
+ * Superinstruction prologue: run the first word alone when the step budget
+ * cannot cover the whole sequence, otherwise charge the extra words.
+ */
+#define GIGA_VM_FUSED_BEGIN(word_count)                                        \
+    do {                                                                       \
+        if (remaining_steps < (word_count) - 1u) {                             \
+            GIGA_VM_DISPATCH(instruction->base_handler);                       \
+        }                                                                      \
+        remaining_steps -= (word_count) - 1u;                                  \
+        program_counter = (uint16_t)(program_counter + (word_count) - 1u);     \
+    } while (0)
+
+#define GIGA_VM_DEST() GIGA_VM_REG(instruction->dest_reg)
+#define GIGA_VM_SRC() GIGA_VM_REG(instruction->src_reg)
+#define GIGA_VM_SET_DEST(value) GIGA_VM_SET_REG(instruction->dest_reg, (value))
+
+/* Bytes LD and ST address in a bank, or NULL when the state has no such bank. */
+static inline uint8_t *giga_vm_bank_bytes(GigaVmState *state, uint16_t bank) {
+    return (bank == 0) ? state->memory : giga_vm_banks_data(state->banks, bank);
+}
+
+/* Whether the bank a run would start in is missing. */
+static inline int giga_vm_bank_missing(const GigaVmState *state) {
+    return state->data_bank != 0 && state->data_bank >= giga_vm_banks_count(state->banks);
+}
+
+/* BANK/BANKI for GigaVmState runs. Returns 0, selecting nothing, if the bank is missing. */
+static inline int giga_vm_select_bank(GigaVmState *state, uint16_t bank, uint8_t **data) {
+    uint8_t *bytes = giga_vm_bank_bytes(state, bank);
+    if (bytes == NULL) {
+        return 0;
+    }
+    state->data_bank = bank;
+    *data = bytes;
+    return 1;
+}
+
+/*
+ * IN and OUT retry a full or empty ring this many times before stopping
+ * with GIGA_VM_STATUS_IO_WAIT, so a host streaming from another thread
+ * rarely forces the run to return.
+ */
+#define GIGA_VM_PORT_SPINS 1024u
+
+static inline void giga_vm_port_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+/* IN for GigaVmState runs: 1 with a nibble, 0 if the port stayed empty, -1 without ports. */
+static inline int giga_vm_port_in(GigaVmPorts *ports, uint16_t port, uint8_t *value) {
+    if (ports == NULL) {
+        return -1;
+    }
+    GigaVmRing *ring = &ports->input[port];
+    for (unsigned spin = 0; !giga_vm_ring_pop(ring, value); ++spin) {
+        if (spin == GIGA_VM_PORT_SPINS) {
+            return 0;
+        }
+        giga_vm_port_relax();
+    }
+    *value &= 0x0Fu;
+    return 1;
+}
+
+/* OUT for GigaVmState runs: 1 once queued, 0 if the port stayed full, -1 without ports. */
+static inline int giga_vm_port_out(GigaVmPorts *ports, uint16_t port, uint8_t value) {
+    if (ports == NULL) {
+        return -1;
+    }
+    GigaVmRing *ring = &ports->output[port];
+    for (unsigned spin = 0; !giga_vm_ring_push(ring, value); ++spin) {
+        if (spin == GIGA_VM_PORT_SPINS) {
+            return 0;
+        }
+        giga_vm_port_relax();
+    }
+    return 1;
+}
+
+/* ---- run loop over GigaVmState ---- */
+
+#define GIGA_VM_RUN_FN giga_vm_run_state
+#define GIGA_VM_RUN_PARAMS GigaVmState *state, uint64_t max_steps
+#define GIGA_VM_RUN_SETUP                                                      \
+    uint8_t *registers = state->registers;                                     \
+    uint8_t *data = giga_vm_bank_bytes(state, state->data_bank);               \
+    GigaVmDecodedInstruction *decoded = state->decoded;                        \
+    const size_t word_count = state->loaded_program_words;                     \
+    uint16_t program_counter = state->program_counter;                         \
+    uint16_t dirty_blocks = state->dirty_blocks;                               \
+    uint64_t *block_edges = state->block_edges;                                \
+    if (program_counter <= word_count) {                                       \
+        ++block_edges[program_counter]; /* a block starts here */              \
+    }
+#define GIGA_VM_ENTRY(pc) (&decoded[(pc)])
+#define GIGA_VM_REG(index) registers[(index)]
+#define GIGA_VM_SET_REG(index, value) (registers[(index)] = (value))
+#define GIGA_VM_LOAD(address) ((uint8_t)(data[(address)] & 0x0Fu))
+/* a banked store also sets bank 0's dirty bit, which only costs a copy on restore */
+#define GIGA_VM_STORE(address, value)                                          \
+    do {                                                                       \
+        uint16_t store_address = (address);                                    \
+        data[store_address] = (value);                                         \
+        dirty_blocks |= GIGA_VM_DIRTY_BIT(store_address);                      \
+        if (store_address < program_bytes && data == state->memory) {          \
+            /* self-modifying store: re-decode that word when it next runs */  \
+            ++state->counters.code_writes;                                     \
+            giga_vm_invalidate_word(decoded, store_address / 2u);              \
+        }                                                                      \
+    } while (0)
+#define GIGA_VM_SELECT_BANK(bank) giga_vm_select_bank(state, (bank), &data)
+#define GIGA_VM_PORT_IN(port, value) giga_vm_port_in(state->ports, (port), (value))
+#define GIGA_VM_PORT_OUT(port, value) giga_vm_port_out(state->ports, (port), (value))
+/* close the open block before pc so the fold sees no partial block */
+#define GIGA_VM_REDECODE(pc)                                                   \
+    do {                                                                       \
+        --block_edges[(pc)];                                                   \
+        giga_vm_predecode_word(state, (pc));                                   \
+        ++block_edges[(pc)];                                                   \
+    } while (0)
+#define GIGA_VM_SAVED_ZERO state->flags_zero
+#define GIGA_VM_SAVED_CARRY state->flags_carry
+#define GIGA_VM_SAVED_NEGATIVE state->flags_negative
+#define GIGA_VM_TRACE_JUMP(target)                                             \
+    (--block_edges[program_counter], ++block_edges[(target)])
+#define GIGA_VM_TRACE_TAKEN() (++state->counters.taken_jumps)
+#define GIGA_VM_RUN_FINISH                                                     \
+    {                                                                          \
+        AluResult flags;                                                       \
+        if (giga_vm_evaluate_flags(lazy_flags, &flags)) {                      \
+            giga_vm_set_flags(state, flags);                                   \
+        }                                                                      \
+        if (state->program_counter <= word_count) {                            \
+            /* the block ends after the last retired word */                   \
+            size_t block_end = program_counter;                                \
+            if (status == GIGA_VM_STATUS_HALTED) {                             \
+                block_end = (size_t)program_counter + 1u;                      \
+            } else if (status == GIGA_VM_STATUS_PC_OUT_OF_RANGE &&             \
+                       (instruction->base_handler == GIGA_VM_HANDLER_JMP_OUT ||  \
+                        instruction->base_handler == GIGA_VM_HANDLER_BRANCH_OUT)) { \
+                block_end = (size_t)(instruction - decoded) + 1u;              \
+            }                                                                  \
+            --block_edges[block_end];                                          \
+        }                                                                      \
+        state->program_counter = program_counter;                              \
+        state->dirty_blocks = dirty_blocks;                                    \
+    }
+#include "vm_run_loop.inc"
+#undef GIGA_VM_RUN_FN
+#undef GIGA_VM_RUN_PARAMS
+#undef GIGA_VM_RUN_SETUP
+#undef GIGA_VM_ENTRY
+#undef GIGA_VM_REG
+#undef GIGA_VM_SET_REG
+#undef GIGA_VM_LOAD
+#undef GIGA_VM_STORE
+#undef GIGA_VM_SELECT_BANK
+#undef GIGA_VM_PORT_IN
+#undef GIGA_VM_PORT_OUT
+#undef GIGA_VM_REDECODE
+#undef GIGA_VM_SAVED_ZERO
+#undef GIGA_VM_SAVED_CARRY
+#undef GIGA_VM_SAVED_NEGATIVE
+#undef GIGA_VM_RUN_FINISH
+
+GigaVmStatus giga_vm_run(GigaVmState *state, uint64_t max_steps) {
+    if (state == NULL) {
+        return GIGA_VM_STATUS_INVALID_STATE;
+    }
+    if (giga_vm_bank_missing(state)) {
+        return GIGA_VM_STATUS_BANK_FAULT;
+    }
+    return giga_vm_run_state(state, max_steps);
+}
+
+GigaVmStatus giga_vm_step(GigaVmState *state) {
+    GigaVmStatus status = giga_vm_run(state, 1);
+    return (status == GIGA_VM_STATUS_STEP_LIMIT) ? GIGA_VM_STATUS_RUNNING : status;
+}
+
+/* ---- separate instruction memory ---- */
+
+/* also runs images, whose entries live in a read-only file mapping */
+#define GIGA_VM_RUN_FN giga_vm_run_state_code
+#define GIGA_VM_RUN_PARAMS                                                     \
+    GigaVmState *state, const GigaVmDecodedInstruction *code_decoded, size_t code_words, uint64_t max_steps
+#define GIGA_VM_RUN_SETUP                                                      \
+    uint8_t *registers = state->registers;                                     \
+    uint8_t *data = giga_vm_bank_bytes(state, state->data_bank);               \
+    const GigaVmDecodedInstruction *decoded = code_decoded;                    \
+    const size_t word_count = code_words;                                      \
+    uint16_t program_counter = state->program_counter;                         \
+    uint16_t dirty_blocks = state->dirty_blocks;
+#define GIGA_VM_ENTRY(pc) (&decoded[(pc)])
+#define GIGA_VM_REG(index) registers[(index)]
+#define GIGA_VM_SET_REG(index, value) (registers[(index)] = (value))
+#define GIGA_VM_LOAD(address) ((uint8_t)(data[(address)] & 0x0Fu))
+/* memory holds no code, so a store needs no invalidation */
+#define GIGA_VM_STORE(address, value)                                          \
+    do {                                                                       \
+        uint16_t store_address = (address);                                    \
+        data[store_address] = (value);                                         \
+        dirty_blocks |= GIGA_VM_DIRTY_BIT(store_address);                      \
+    } while (0)
+#define GIGA_VM_SELECT_BANK(bank) giga_vm_select_bank(state, (bank), &data)
+#define GIGA_VM_PORT_IN(port, value) giga_vm_port_in(state->ports, (port), (value))
+#define GIGA_VM_PORT_OUT(port, value) giga_vm_port_out(state->ports, (port), (value))
+#define GIGA_VM_REDECODE(pc) ((void)(pc)) /* code entries are never invalidated */
+#define GIGA_VM_SAVED_ZERO state->flags_zero
+#define GIGA_VM_SAVED_CARRY state->flags_carry
+#define GIGA_VM_SAVED_NEGATIVE state->flags_negative
+#define GIGA_VM_RUN_FINISH                                                     \
+    {                                                                          \
+        AluResult flags;                                                       \
+        if (giga_vm_evaluate_flags(lazy_flags, &flags)) {                      \
+            giga_vm_set_flags(state, flags);                                   \
+        }                                                                      \
+        state->program_counter = program_counter;                              \
+        state->dirty_blocks = dirty_blocks;                                    \
+    }
+#include "vm_run_loop.inc"
+#undef GIGA_VM_RUN_FN
+#undef GIGA_VM_RUN_PARAMS
+#undef GIGA_VM_RUN_SETUP
+#undef GIGA_VM_ENTRY
+#undef GIGA_VM_REG
+#undef GIGA_VM_SET_REG
+#undef GIGA_VM_LOAD
+#undef GIGA_VM_STORE
+#undef GIGA_VM_SELECT_BANK
+#undef GIGA_VM_PORT_IN
+#undef GIGA_VM_PORT_OUT
+#undef GIGA_VM_REDECODE
+#undef GIGA_VM_SAVED_ZERO
+#undef GIGA_VM_SAVED_CARRY
+#undef GIGA_VM_SAVED_NEGATIVE
+#undef GIGA_VM_RUN_FINISH
+
+/*
+ * Entry for the word at pc of an instruction store. Relative branches
+ * become ordinary branches to their absolute target, so the run loop,
+ * fusion and images never see the difference.
+ */
+static void giga_vm_decode_code_entry(uint16_t raw_word, size_t pc, size_t word_count,
+                                      GigaVmDecodedInstruction *entry) {
+    giga_vm_decode_entry(raw_word, word_count, entry);
+    GigaInstruction instruction = giga_decode_instruction(raw_word);
+    if (instruction.opcode != GIGA_OP_EXT || !GIGA_EXT_IS_RELATIVE_BRANCH(instruction.dest_reg)) {
+        return;
+    }
+    /* a target before word 0 wraps to a PC past the program, like a JMP out */
+    entry->imm4 = (uint8_t)GIGA_EXT_RELATIVE_CONDITION(instruction.dest_reg);
+    entry->operand = (uint16_t)(pc + 1u + (size_t)(int8_t)(raw_word & 0x00FFu));
+    entry->handler = (entry->operand >= word_count) ? GIGA_VM_HANDLER_BRANCH_OUT : GIGA_VM_HANDLER_BRANCH;
+    entry->base_handler = entry->handler;
+}
+
+int giga_vm_code_init(GigaVmCode *code, const uint16_t *program_words, size_t word_count) {
+    if (code == NULL || program_words == NULL) {
+        return -1;
+    }
+    if (word_count > GIGA_VM_MAX_CODE_WORDS) {
+        return -2;
+    }
+
+    memcpy(code->words, program_words, word_count * sizeof(uint16_t));
+    code->word_count = word_count;
+    for (size_t index = 0; index < word_count; ++index) {
+        giga_vm_decode_code_entry(code->words[index], index, word_count, &code->decoded[index]);
+    }
+    giga_vm_decode_end(code->decoded, word_count);
+    return 0;
+}
+
+size_t giga_vm_code_fuse(GigaVmCode *code) {
+    if (code == NULL) {
+        return 0;
+    }
+    return giga_vm_fuse_decoded(code->decoded, code->word_count);
+}
+
+GigaVmStatus giga_vm_run_code(GigaVmState *state, const GigaVmCode *code, uint64_t max_steps) {
+    if (state == NULL || code == NULL) {
+        return GIGA_VM_STATUS_INVALID_STATE;
+    }
+    if (giga_vm_bank_missing(state)) {
+        return GIGA_VM_STATUS_BANK_FAULT;
+    }
+    return giga_vm_run_state_code(state, code->decoded, code->word_count, max_steps);
+}
+
+/* ---- bytecode images ---- */
+
+/* Whether an unfused entry only leads the run loop where giga_vm_decode_entry could. */
+static int giga_vm_image_entry_valid(const GigaVmDecodedInstruction *entry, size_t word_count) {
+    if (entry->dest_reg >= GIGA_VM_REGISTER_COUNT || entry->src_reg >= GIGA_VM_REGISTER_COUNT) {
+        return 0;
+    }
+    switch (entry->base_handler) {
+        case GIGA_OP_LD:
+        case GIGA_OP_ST:
+            return entry->operand < GIGA_VM_MEMORY_SIZE;
+        case GIGA_OP_JMP:
+        case GIGA_VM_HANDLER_BRANCH:
+            return entry->operand <= word_count; /* word_count is the sentinel */
+        case GIGA_VM_HANDLER_BANK_IMM:
+            return entry->operand < GIGA_VM_BANK_COUNT;
+        case GIGA_VM_HANDLER_IN:
+        case GIGA_VM_HANDLER_OUT:
+            return entry->operand < GIGA_VM_PORT_COUNT;
+        case GIGA_VM_HANDLER_DECODE:
+            return 0; /* nothing re-decodes image entries */
+        default:
+            return entry->base_handler < GIGA_VM_FIRST_FUSED_HANDLER;
+    }
+}
+
+int giga_vm_image_decoded_valid(const GigaVmDecodedInstruction *decoded, size_t word_count) {
+    if (decoded == NULL || word_count > GIGA_VM_MAX_CODE_WORDS ||
+        decoded[word_count].handler != GIGA_VM_HANDLER_END ||
+        decoded[word_count].base_handler != GIGA_VM_HANDLER_END) {
+        return 0;
+    }
+    for (size_t index = 0; index < word_count; ++index) {
+        const GigaVmDecodedInstruction *entry = &decoded[index];
+        if (!giga_vm_image_entry_valid(entry, word_count)) {
+            return 0;
+        }
+        if (entry->handler == entry->base_handler) {
+            continue;
+        }
+        /* a superinstruction reads the entries after it as giga_vm_fuse_decoded matched them */
+        size_t length = giga_vm_fused_length(entry->handler);
+        if (length < 2u || index + length > word_count) {
+            return 0;
+        }
+        const GigaVmDecodedInstruction *next = entry + 1;
+        int matches;
+        switch (entry->handler) {
+            case GIGA_VM_HANDLER_MOVI_ADD:
+                matches = entry->base_handler == GIGA_OP_MOVI && next->base_handler == GIGA_OP_ADD;
+                break;
+            case GIGA_VM_HANDLER_LD_ADD_ST:
+                matches = entry->base_handler == GIGA_OP_LD && next->base_handler == GIGA_OP_ADD &&
+                          next[1].base_handler == GIGA_OP_ST;
+                break;
+            case GIGA_VM_HANDLER_SHL_SHL:
+                matches = entry->base_handler == GIGA_OP_SHL && next->base_handler == GIGA_OP_SHL;
+                break;
+            default: /* GIGA_VM_HANDLER_CMP_BRANCH */
+                matches = entry->base_handler == GIGA_VM_HANDLER_CMP && next->base_handler == GIGA_VM_HANDLER_BRANCH;
+                break;
+        }
+        if (!matches) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+GigaVmStatus giga_vm_run_image(GigaVmState *state, const GigaVmImage *image, uint64_t max_steps) {
+    if (state == NULL || image == NULL || image->decoded == NULL) {
+        return GIGA_VM_STATUS_INVALID_STATE;
+    }
+    if (giga_vm_bank_missing(state)) {
+        return GIGA_VM_STATUS_BANK_FAULT;
+    }
+    return giga_vm_run_state_code(state, image->decoded, image->word_count, max_steps);
+}
+
+/* ---- packed instances ---- */
+
+static inline void giga_vm_packed_set_nibble(uint8_t *memory, size_t address, uint8_t value) {
+    uint8_t shift = (uint8_t)(4u * (address % 2u));
+    memory[address / 2u] = (uint8_t)((memory[address / 2u] & ~(0x0Fu << shift)) | ((value & 0x0Fu) << shift));
+}
+
+static inline int giga_vm_packed_byte_written(const GigaVmPackedState *state, size_t address) {
+    return (state->code_written[address / 8u] >> (address % 8u)) & 1u;
+}
+
+/* Full byte at a program address: the shared image unless a store replaced it. */
+static inline uint8_t giga_vm_packed_code_byte(const GigaVmPackedState *state, const GigaVmProgram *program,
+                                               size_t address) {
+    return giga_vm_packed_byte_written(state, address) ? giga_vm_packed_load(state, address)
+                                                       : program->image[address];
+}
+
+/*
+ * Entry for pc once the instance has written into its program: the shared
+ * entry without fusion, re-decoded if either of its bytes was overwritten.
+ */
+static const GigaVmDecodedInstruction *giga_vm_packed_entry(const GigaVmPackedState *state,
+                                                            const GigaVmProgram *program,
+                                                            size_t pc,
+                                                            GigaVmDecodedInstruction *scratch) {
+    *scratch = program->decoded[pc];
+    scratch->handler = scratch->base_handler;
+    if (pc < program->word_count &&
+        (giga_vm_packed_byte_written(state, pc * 2u) || giga_vm_packed_byte_written(state, pc * 2u + 1u))) {
+        uint16_t raw_word = (uint16_t)(((uint16_t)giga_vm_packed_code_byte(state, program, pc * 2u + 1u) << 8) |
+                                       giga_vm_packed_code_byte(state, program, pc * 2u));
+        giga_vm_decode_entry(raw_word, program->word_count, scratch);
+    }
+    return scratch;
+}
+
+static inline uint8_t giga_vm_pack_flags(AluResult flags) {
+    return (uint8_t)((flags.zero_flag ? GIGA_VM_PACKED_FLAG_ZERO : 0u) |
+                     (flags.carry_flag ? GIGA_VM_PACKED_FLAG_CARRY : 0u) |
+                     (flags.negative_flag ? GIGA_VM_PACKED_FLAG_NEGATIVE : 0u) |
+                     (flags.overflow_flag ? GIGA_VM_PACKED_FLAG_OVERFLOW : 0u));
+}
+
+#define GIGA_VM_RUN_FN giga_vm_run_packed
+#define GIGA_VM_RUN_PARAMS GigaVmPackedState *state, const GigaVmProgram *program, uint64_t max_steps
+#define GIGA_VM_RUN_SETUP                                                      \
+    uint8_t registers[GIGA_VM_REGISTER_COUNT];                                 \
+    for (size_t reg = 0; reg < GIGA_VM_REGISTER_COUNT; ++reg) {                \
+        registers[reg] = giga_vm_packed_register(state, reg);                  \
+    }                                                                          \
+    uint8_t *memory = state->memory;                                           \
+    const GigaVmDecodedInstruction *decoded = program->decoded;                \
+    const size_t word_count = program->word_count;                             \
+    uint16_t program_counter = state->program_counter;                         \
+    int code_modified = state->code_modified;                                  \
+    GigaVmDecodedInstruction scratch;
+#define GIGA_VM_ENTRY(pc)                                                      \
+    (code_modified ? giga_vm_packed_entry(state, program, (pc), &scratch) : &decoded[(pc)])
+#define GIGA_VM_REG(index) registers[(index)]
+#define GIGA_VM_SET_REG(index, value) (registers[(index)] = (value))
+#define GIGA_VM_LOAD(address) \
+    ((uint8_t)((memory[(address) / 2u] >> (4u * ((address) % 2u))) & 0x0Fu))
+#define GIGA_VM_STORE(address, value)                                          \
+    do {                                                                       \
+        uint16_t store_address = (address);                                   \
+        giga_vm_packed_set_nibble(memory, store_address, (value));             \
+        if (store_address < program_bytes) {                                   \
+            state->code_written[store_address / 8u] |= (uint8_t)(1u << (store_address % 8u)); \
+            code_modified = 1;                                                 \
+        }                                                                      \
+    } while (0)
+#define GIGA_VM_SELECT_BANK(bank) ((bank) == 0) /* packed instances only have bank 0 */
+#define GIGA_VM_PORT_IN(port, value) ((void)(value), -1) /* and no ports */
+#define GIGA_VM_PORT_OUT(port, value) ((void)(value), -1)
+#define GIGA_VM_REDECODE(pc) ((void)(pc)) /* shared entries are never invalidated */
+#define GIGA_VM_SAVED_ZERO giga_vm_packed_flag(state, GIGA_VM_PACKED_FLAG_ZERO)
+#define GIGA_VM_SAVED_CARRY giga_vm_packed_flag(state, GIGA_VM_PACKED_FLAG_CARRY)
+#define GIGA_VM_SAVED_NEGATIVE giga_vm_packed_flag(state, GIGA_VM_PACKED_FLAG_NEGATIVE)
+#define GIGA_VM_RUN_FINISH                                                     \
+    {                                                                          \
+        AluResult flags;                                                       \
+        if (giga_vm_evaluate_flags(lazy_flags, &flags)) {                      \
+            state->flags = giga_vm_pack_flags(flags);                          \
+        }                                                                      \
+        for (size_t reg = 0; reg < GIGA_VM_REGISTER_COUNT; ++reg) {            \
+            giga_vm_packed_set_register(state, reg, registers[reg]);           \
+        }                                                                      \
+        state->program_counter = program_counter;                              \
+        state->code_modified = (uint8_t)code_modified;                         \
+    }
+#include "vm_run_loop.inc"
+#undef GIGA_VM_RUN_FN
+#undef GIGA_VM_RUN_PARAMS
+#undef GIGA_VM_RUN_SETUP
+#undef GIGA_VM_ENTRY
+#undef GIGA_VM_REG
+#undef GIGA_VM_SET_REG
+#undef GIGA_VM_LOAD
+#undef GIGA_VM_STORE
+#undef GIGA_VM_SELECT_BANK
+#undef GIGA_VM_PORT_IN
+#undef GIGA_VM_PORT_OUT
+#undef GIGA_VM_REDECODE
+#undef GIGA_VM_SAVED_ZERO
+#undef GIGA_VM_SAVED_CARRY
+#undef GIGA_VM_SAVED_NEGATIVE
+#undef GIGA_VM_RUN_FINISH
+
+int giga_vm_program_init(GigaVmProgram *program, const uint16_t *program_words, size_t word_count) {
+    if (program == NULL || program_words == NULL) {
+        return -1;
+    }
+    if (word_count * 2u > GIGA_VM_MEMORY_SIZE) {
+        return -2;
+    }
+
+    memset(program->image, 0, sizeof(program->image));
+    for (size_t index = 0; index < word_count; ++index) {
+        program->image[index * 2u] = (uint8_t)(program_words[index] & 0xFFu);
+        program->image[index * 2u + 1u] = (uint8_t)((program_words[index] >> 8) & 0xFFu);
+    }
+    program->word_count = word_count;
+    giga_vm_predecode_program(program->image, word_count, program->decoded);
+    return 0;
+}
+
+size_t giga_vm_program_fuse(GigaVmProgram *program) {
+    if (program == NULL) {
+        return 0;
+    }
+    return giga_vm_fuse_decoded(program->decoded, program->word_count);
+}
+
+void giga_vm_packed_init(GigaVmPackedState *state, const GigaVmProgram *program) {
+    if (state == NULL || program == NULL) {
+        return;
+    }
+    memset(state, 0, sizeof(*state));
+    for (size_t address = 0; address < GIGA_VM_MEMORY_SIZE; ++address) {
+        giga_vm_packed_set_nibble(state->memory, address, program->image[address]);
+    }
+}
+
+void giga_vm_packed_store(GigaVmPackedState *state, const GigaVmProgram *program,
+                          size_t address, uint8_t value) {
+    if (state == NULL || program == NULL) {
+        return;
+    }
+    address %= GIGA_VM_MEMORY_SIZE;
+    giga_vm_packed_set_nibble(state->memory, address, value);
+    if (address < program->word_count * 2u) {
+        state->code_written[address / 8u] |= (uint8_t)(1u << (address % 8u));
+        state->code_modified = 1;
+    }
+}
+
+GigaVmStatus giga_vm_packed_run(GigaVmPackedState *state, const GigaVmProgram *program,
+                                uint64_t max_steps) {
+    if (state == NULL || program == NULL) {
+        return GIGA_VM_STATUS_INVALID_STATE;
+    }
+    return giga_vm_run_packed(state, program, max_steps);
+}
+
+int giga_vm_packed_unpack(const GigaVmPackedState *state, const GigaVmProgram *program,
+                          GigaVmState *out) {
+    if (state == NULL || program == NULL || out == NULL) {
+        return -1;
+    }
+    giga_vm_init(out);
+    for (size_t index = 0; index < GIGA_VM_REGISTER_COUNT; ++index) {
+        out->registers[index] = giga_vm_packed_register(state, index);
+    }
+    out->flags_zero = giga_vm_packed_flag(state, GIGA_VM_PACKED_FLAG_ZERO);
+    out->flags_carry = giga_vm_packed_flag(state, GIGA_VM_PACKED_FLAG_CARRY);
+    out->flags_negative = giga_vm_packed_flag(state, GIGA_VM_PACKED_FLAG_NEGATIVE);
+    out->flags_overflow = giga_vm_packed_flag(state, GIGA_VM_PACKED_FLAG_OVERFLOW);
+    out->program_counter = state->program_counter;
+
+    size_t program_bytes = program->word_count * 2u;
+    for (size_t address = 0; address < GIGA_VM_MEMORY_SIZE; ++address) {
+        out->memory[address] = (address < program_bytes) ? giga_vm_packed_code_byte(state, program, address)
+                                                         : giga_vm_packed_load(state, address);
+    }
+    out->loaded_program_words = program->word_count;
+    giga_vm_predecode_program(out->memory, program->word_count, out->decoded);
+    return 0;
+}
+
+int giga_vm_packed_pack(const GigaVmState *state, const GigaVmProgram *program,
+                        GigaVmPackedState *out) {
+    if (state == NULL || program == NULL || out == NULL) {
+        return -1;
+    }
+    if (state->loaded_program_words != program->word_count) {
+        return -2;
+    }
+    if (state->data_bank != 0) {
+        return -3;
+    }
+    memset(out, 0, sizeof(*out));
+    for (size_t index = 0; index < GIGA_VM_REGISTER_COUNT; ++index) {
+        giga_vm_packed_set_register(out, index, state->registers[index]);
+    }
+    AluResult flags = {0, state->flags_zero, state->flags_carry, state->flags_negative, state->flags_overflow};
+    out->flags = giga_vm_pack_flags(flags);
+    out->program_counter = state->program_counter;
+
+    size_t program_bytes = program->word_count * 2u;
+    for (size_t address = 0; address < GIGA_VM_MEMORY_SIZE; ++address) {
+        giga_vm_packed_set_nibble(out->memory, address, state->memory[address]);
+        if (address < program_bytes && state->memory[address] != program->image[address]) {
+            out->code_written[address / 8u] |= (uint8_t)(1u << (address % 8u));
+            out->code_modified = 1;
+        }
+    }
+    return 0;
+}
+
+/* ---- snapshots and copy-on-write forks ---- */
+
+struct GigaVmSnapshot {
+    GigaVmState state;          /* captured state; no GIGA_VM_HANDLER_DECODE entries */
+    atomic_uint references;
+};
+
+static atomic_uint_fast64_t giga_vm_next_snapshot_id = 1;
+
+GigaVmSnapshot *giga_vm_snapshot_take(GigaVmState *state) {
+    if (state == NULL) {
+        return NULL;
+    }
+    GigaVmSnapshot *snapshot = (GigaVmSnapshot *)malloc(sizeof(*snapshot));
+    if (snapshot == NULL) {
+        return NULL;
+    }
+
+    GigaVmState *copy = &snapshot->state;
+    *copy = *state;
+    /* forks fall back to base_handler, so it must describe the current word */
+    for (size_t index = 0; index < copy->loaded_program_words; ++index) {
+        if (copy->decoded[index].handler == GIGA_VM_HANDLER_DECODE) {
+            giga_vm_predecode_word(copy, index);
+        }
+    }
+
+    uint64_t id = atomic_fetch_add_explicit(&giga_vm_next_snapshot_id, 1u, memory_order_relaxed);
+    copy->snapshot_id = id;
+    copy->dirty_blocks = 0;
+    state->snapshot_id = id;
+    state->dirty_blocks = 0;
+    atomic_init(&snapshot->references, 1u);
+    return snapshot;
+}
+
+void giga_vm_snapshot_release(GigaVmSnapshot *snapshot) {
+    if (snapshot != NULL &&
+        atomic_fetch_sub_explicit(&snapshot->references, 1u, memory_order_acq_rel) == 1u) {
+        free(snapshot);
+    }
+}
+
+int giga_vm_snapshot_restore(GigaVmState *state, const GigaVmSnapshot *snapshot) {
+    if (state == NULL || snapshot == NULL) {
+        return -1;
+    }
+    const GigaVmState *source = &snapshot->state;
+    if (state->snapshot_id != source->snapshot_id) {
+        /* counters are not part of the snapshot */
+        giga_vm_fold_counters(state);
+        GigaVmCounters counters = state->counters;
+        GigaVmBanks *banks = state->banks;
+        GigaVmPorts *ports = state->ports;
+        *state = *source;
+        memset(state->block_edges, 0, sizeof(state->block_edges));
+        state->counters = counters;
+        state->banks = banks;
+        state->ports = ports;
+        return 0;
+    }
+
+    memcpy(state->registers, source->registers, sizeof(state->registers));
+    state->flags_zero = source->flags_zero;
+    state->flags_carry = source->flags_carry;
+    state->flags_negative = source->flags_negative;
+    state->flags_overflow = source->flags_overflow;
+    state->program_counter = source->program_counter;
+    state->data_bank = source->data_bank;
+
+    size_t word_count = source->loaded_program_words;
+    if ((state->dirty_blocks & giga_vm_block_mask(word_count * 2u)) != 0) {
+        giga_vm_fold_counters(state); /* predecoded entries are about to change */
+    }
+    for (size_t block = 0; block < GIGA_VM_DIRTY_BLOCK_COUNT; ++block) {
+        if (((state->dirty_blocks >> block) & 1u) == 0) {
+            continue;
+        }
+        size_t start = block * GIGA_VM_DIRTY_BLOCK_SIZE;
+        memcpy(&state->memory[start], &source->memory[start], GIGA_VM_DIRTY_BLOCK_SIZE);
+
+        size_t first_word = start / 2u;
+        if (first_word < word_count) {
+            /* the block's own entries plus superinstructions reaching into it */
+            size_t end_word = first_word + GIGA_VM_DIRTY_BLOCK_SIZE / 2u;
+            size_t from = (first_word >= GIGA_VM_MAX_FUSED_WORDS - 1u) ? first_word - (GIGA_VM_MAX_FUSED_WORDS - 1u) : 0;
+            if (end_word > word_count) {
+                end_word = word_count;
+            }
+            memcpy(&state->decoded[from], &source->decoded[from], (end_word - from) * sizeof(state->decoded[0]));
+        }
+    }
+    state->dirty_blocks = 0;
+    return 0;
+}
+
+int giga_vm_fork(GigaVmFork *child, GigaVmSnapshot *snapshot) {
+    if (child == NULL || snapshot == NULL) {
+        return -1;
+    }
+    if (snapshot->state.data_bank != 0) {
+        return -2;
+    }
+    atomic_fetch_add_explicit(&snapshot->references, 1u, memory_order_relaxed);
+
+    const GigaVmState *parent = &snapshot->state;
+    child->snapshot = snapshot;
+    memcpy(child->registers, parent->registers, sizeof(child->registers));
+    child->flags_zero = parent->flags_zero;
+    child->flags_carry = parent->flags_carry;
+    child->flags_negative = parent->flags_negative;
+    child->flags_overflow = parent->flags_overflow;
+    child->program_counter = parent->program_counter;
+    child->dirty_blocks = 0;
+    return 0;
+}
+
+void giga_vm_fork_release(GigaVmFork *child) {
+    if (child == NULL) {
+        return;
+    }
+    giga_vm_snapshot_release(child->snapshot);
+    child->snapshot = NULL;
+}
+
+/* Give the child its own copy of the block holding address. */
+static inline void giga_vm_fork_copy_block(GigaVmFork *child, const uint8_t *parent_memory, size_t address) {
+    size_t start = address - address % GIGA_VM_DIRTY_BLOCK_SIZE;
+    memcpy(&child->memory[start], &parent_memory[start], GIGA_VM_DIRTY_BLOCK_SIZE);
+}
+
+uint8_t giga_vm_fork_load(const GigaVmFork *child, size_t address) {
+    if (child == NULL || child->snapshot == NULL) {
+        return 0;
+    }
+    address %= GIGA_VM_MEMORY_SIZE;
+    const uint8_t *memory = (child->dirty_blocks & GIGA_VM_DIRTY_BIT(address)) ? child->memory
+                                                                               : child->snapshot->state.memory;
+    return (uint8_t)(memory[address] & 0x0Fu);
+}
+
+void giga_vm_fork_store(GigaVmFork *child, size_t address, uint8_t value) {
+    if (child == NULL || child->snapshot == NULL) {
+        return;
+    }
+    address %= GIGA_VM_MEMORY_SIZE;
+    if ((child->dirty_blocks & GIGA_VM_DIRTY_BIT(address)) == 0) {
+        giga_vm_fork_copy_block(child, child->snapshot->state.memory, address);
+        child->dirty_blocks |= GIGA_VM_DIRTY_BIT(address);
+    }
+    child->memory[address] = value;
+}
+
+/*
+ * Entry for pc once the child has written into its program: the parent's
+ * entry without fusion, re-decoded from the child's copy if its block is
+ * private.
+ */
+static const GigaVmDecodedInstruction *giga_vm_fork_entry(const GigaVmFork *child, const GigaVmState *parent,
+                                                          uint16_t dirty_blocks, size_t pc,
+                                                          GigaVmDecodedInstruction *scratch) {
+    *scratch = parent->decoded[pc];
+    scratch->handler = scratch->base_handler;
+    if (pc < parent->loaded_program_words && (dirty_blocks & GIGA_VM_DIRTY_BIT(pc * 2u))) {
+        giga_vm_decode_entry(giga_vm_memory_word(child->memory, pc), parent->loaded_program_words, scratch);
+    }
+    return scratch;
+}
+
+#define GIGA_VM_RUN_FN giga_vm_run_fork
+#define GIGA_VM_RUN_PARAMS GigaVmFork *child, uint64_t max_steps
+#define GIGA_VM_RUN_SETUP                                                      \
+    const GigaVmState *parent = &child->snapshot->state;                       \
+    uint8_t *registers = child->registers;                                     \
+    const GigaVmDecodedInstruction *decoded = parent->decoded;                 \
+    const size_t word_count = parent->loaded_program_words;                    \
+    const uint16_t code_blocks = giga_vm_block_mask(word_count * 2u);          \
+    uint16_t program_counter = child->program_counter;                         \
+    uint16_t dirty_blocks = child->dirty_blocks;                               \
+    const uint8_t *blocks[GIGA_VM_DIRTY_BLOCK_COUNT];                          \
+    for (size_t block = 0; block < GIGA_VM_DIRTY_BLOCK_COUNT; ++block) {       \
+        const uint8_t *owner = ((dirty_blocks >> block) & 1u) ? child->memory : parent->memory; \
+        blocks[block] = owner + block * GIGA_VM_DIRTY_BLOCK_SIZE;              \
+    }                                                                          \
+    GigaVmDecodedInstruction scratch;
+#define GIGA_VM_ENTRY(pc)                                                      \
+    ((dirty_blocks & code_blocks) ? giga_vm_fork_entry(child, parent, dirty_blocks, (pc), &scratch) \
+                                  : &decoded[(pc)])
+#define GIGA_VM_REG(index) registers[(index)]
+#define GIGA_VM_SET_REG(index, value) (registers[(index)] = (value))
+#define GIGA_VM_LOAD(address)                                                  \
+    ((uint8_t)(blocks[(address) / GIGA_VM_DIRTY_BLOCK_SIZE][(address) % GIGA_VM_DIRTY_BLOCK_SIZE] & 0x0Fu))
+#define GIGA_VM_STORE(address, value)                                          \
+    do {                                                                       \
+        uint16_t store_address = (address);                                    \
+        if ((dirty_blocks & GIGA_VM_DIRTY_BIT(store_address)) == 0) {          \
+            /* first write to this block: copy it out of the parent */         \
+            giga_vm_fork_copy_block(child, parent->memory, store_address);     \
+            dirty_blocks |= GIGA_VM_DIRTY_BIT(store_address);                  \
+            blocks[store_address / GIGA_VM_DIRTY_BLOCK_SIZE] =                 \
+                &child->memory[store_address - store_address % GIGA_VM_DIRTY_BLOCK_SIZE]; \
+        }                                                                      \
+        child->memory[store_address] = (value);                                \
+    } while (0)
+#define GIGA_VM_SELECT_BANK(bank) ((bank) == 0) /* forks only have bank 0 */
+#define GIGA_VM_PORT_IN(port, value) ((void)(value), -1) /* and no ports */
+#define GIGA_VM_PORT_OUT(port, value) ((void)(value), -1)
+#define GIGA_VM_REDECODE(pc) ((void)(pc)) /* parent entries are never invalidated */
+#define GIGA_VM_SAVED_ZERO child->flags_zero
+#define GIGA_VM_SAVED_CARRY child->flags_carry
+#define GIGA_VM_SAVED_NEGATIVE child->flags_negative
+#define GIGA_VM_RUN_FINISH                                                     \
+    {                                                                          \
+        AluResult flags;                                                       \
+        if (giga_vm_evaluate_flags(lazy_flags, &flags)) {                      \
+            child->flags_zero = flags.zero_flag;                               \
+            child->flags_carry = flags.carry_flag;                             \
+            child->flags_negative = flags.negative_flag;                       \
+            child->flags_overflow = flags.overflow_flag;                       \
+        }                                                                      \
+        child->program_counter = program_counter;                              \
+        child->dirty_blocks = dirty_blocks;                                    \
+    }
+#include "vm_run_loop.inc"
+#undef GIGA_VM_RUN_FN
+#undef GIGA_VM_RUN_PARAMS
+#undef GIGA_VM_RUN_SETUP
+#undef GIGA_VM_ENTRY
+#undef GIGA_VM_REG
+#undef GIGA_VM_SET_REG
+#undef GIGA_VM_LOAD
+#undef GIGA_VM_STORE
+#undef GIGA_VM_SELECT_BANK
+#undef GIGA_VM_PORT_IN
+#undef GIGA_VM_PORT_OUT
+#undef GIGA_VM_REDECODE
+#undef GIGA_VM_SAVED_ZERO
+#undef GIGA_VM_SAVED_CARRY
+#undef GIGA_VM_SAVED_NEGATIVE
+#undef GIGA_VM_RUN_FINISH
+
+GigaVmStatus giga_vm_fork_run(GigaVmFork *child, uint64_t max_steps) {
+    if (child == NULL || child->snapshot == NULL) {
+        return GIGA_VM_STATUS_INVALID_STATE;
+    }
+    return giga_vm_run_fork(child, max_steps);
+}
+
+int giga_vm_fork_unpack(const GigaVmFork *child, GigaVmState *out) {
+    if (child == NULL || child->snapshot == NULL || out == NULL) {
+        return -1;
+    }
+    const GigaVmState *parent = &child->snapshot->state;
+    giga_vm_init(out);
+    memcpy(out->registers, child->registers, sizeof(out->registers));
+    out->flags_zero = child->flags_zero;
+    out->flags_carry = child->flags_carry;
+    out->flags_negative = child->flags_negative;
+    out->flags_overflow = child->flags_overflow;
+    out->program_counter = child->program_counter;
+    for (size_t address = 0; address < GIGA_VM_MEMORY_SIZE; ++address) {
+        out->memory[address] = (child->dirty_blocks & GIGA_VM_DIRTY_BIT(address)) ? child->memory[address]
+                                                                                  : parent->memory[address];
+    }
+    out->loaded_program_words = parent->loaded_program_words;
+    giga_vm_predecode_program(out->memory, out->loaded_program_words, out->decoded);
+    return 0;
+}
+
+/* ---- traced runs ---- */
+
+_Static_assert(ALU_LUT_ZERO_BIT == 4 && ALU_LUT_CARRY_BIT == 5 && ALU_LUT_NEGATIVE_BIT == 6 &&
+               ALU_LUT_OVERFLOW_BIT == 7 && GIGA_VM_PACKED_FLAG_ZERO == 1u && GIGA_VM_PACKED_FLAG_CARRY == 2u &&
+               GIGA_VM_PACKED_FLAG_NEGATIVE == 4u && GIGA_VM_PACKED_FLAG_OVERFLOW == 8u,
+               "ALU table flags must shift down to GIGA_VM_PACKED_FLAG_* bits");
+
+/*
+ * GIGA_VM_PACKED_FLAG_* bits of the ALU op lazy_flags describes. Each
+ * handler has just set the kind, so this folds to one table load.
+ */
+static inline uint8_t giga_vm_trace_flags(GigaVmLazyFlags lazy_flags) {
+    uint8_t pair = alu_lut_binary_index(lazy_flags.operand_a, lazy_flags.operand_b);
+    uint8_t single = (uint8_t)(lazy_flags.operand_a & 0x0Fu);
+    switch (lazy_flags.kind) {
+        case GIGA_OP_ADD: return (uint8_t)(alu_lut_add_table[pair] >> 4);
+        case GIGA_OP_SUB: return (uint8_t)(alu_lut_sub_table[pair] >> 4);
+        case GIGA_OP_AND: return (uint8_t)(alu_lut_and_table[pair] >> 4);
+        case GIGA_OP_OR:  return (uint8_t)(alu_lut_or_table[pair] >> 4);
+        case GIGA_OP_XOR: return (uint8_t)(alu_lut_xor_table[pair] >> 4);
+        case GIGA_OP_NOT: return (uint8_t)(alu_lut_not_table[single] >> 4);
+        case GIGA_OP_SHL: return (uint8_t)(alu_lut_shl_table[single] >> 4);
+        case GIGA_OP_SHR: return (uint8_t)(alu_lut_shr_table[single] >> 4);
+        default: {
+            AluResult flags;
+            giga_vm_evaluate_flags(lazy_flags, &flags);
+            return giga_vm_pack_flags(flags);
+        }
+    }
+}
+
+/* Entry for pc with fusion undone, so every word retires (and is recorded) on its own. */
+static inline const GigaVmDecodedInstruction *giga_vm_trace_entry(const GigaVmDecodedInstruction *decoded,
+                                                                  uint16_t pc,
+                                                                  GigaVmDecodedInstruction *scratch) {
+    const GigaVmDecodedInstruction *entry = &decoded[pc];
+    if (entry->handler < GIGA_VM_FIRST_FUSED_HANDLER) {
+        return entry;
+    }
+    *scratch = *entry;
+    scratch->handler = scratch->base_handler;
+    return scratch;
+}
+
+/* Record encoders; the format is described in vm_trace.h. */
+#define GIGA_VM_TRACE_NOP()                                                    \
+    do {                                                                       \
+        *trace_out++ = GIGA_VM_TRACE_TAG_NOP;                                  \
+    } while (0)
+#define GIGA_VM_TRACE_REG(index)                                               \
+    do {                                                                       \
+        *trace_out++ = (uint8_t)(((index) << 4) | (registers[(index)] & 0x0Fu)); \
+    } while (0)
+#define GIGA_VM_TRACE_ALU(index)                                               \
+    do {                                                                       \
+        trace_out[0] = (uint8_t)(GIGA_VM_TRACE_TAG_ALU | giga_vm_trace_flags(lazy_flags)); \
+        trace_out[1] = (uint8_t)(((index) << 4) | (registers[(index)] & 0x0Fu)); \
+        trace_out += 2;                                                        \
+    } while (0)
+#define GIGA_VM_TRACE_FLAGS()                                                  \
+    do {                                                                       \
+        trace_out[0] = GIGA_VM_TRACE_TAG_FLAGS;                                \
+        trace_out[1] = giga_vm_trace_flags(lazy_flags);                        \
+        trace_out += 2;                                                        \
+    } while (0)
+#define GIGA_VM_TRACE_STORE(address)                                           \
+    do {                                                                       \
+        trace_out[0] = GIGA_VM_TRACE_TAG_STORE;                                \
+        trace_out[1] = (uint8_t)(address);                                     \
+        trace_out[2] = memory[(address)];                                      \
+        trace_out += 3;                                                        \
+    } while (0)
+#define GIGA_VM_TRACE_JUMP(target)                                             \
+    do {                                                                       \
+        int32_t delta = (int32_t)(target) - (int32_t)program_counter;          \
+        uint32_t zigzag = ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31);    \
+        *trace_out++ = GIGA_VM_TRACE_TAG_JUMP;                                 \
+        while (zigzag >= 0x80u) {                                              \
+            *trace_out++ = (uint8_t)(zigzag | 0x80u);                          \
+            zigzag >>= 7;                                                      \
+        }                                                                      \
+        *trace_out++ = (uint8_t)zigzag;                                        \
+    } while (0)
+
+#define GIGA_VM_RUN_FN giga_vm_run_state_traced
+#define GIGA_VM_RUN_PARAMS GigaVmState *state, uint64_t max_steps, uint8_t **records, uint64_t *retired
+#define GIGA_VM_RUN_SETUP                                                      \
+    uint8_t *registers = state->registers;                                     \
+    uint8_t *memory = state->memory;                                           \
+    GigaVmDecodedInstruction *decoded = state->decoded;                        \
+    const size_t word_count = state->loaded_program_words;                     \
+    uint16_t program_counter = state->program_counter;                         \
+    uint16_t dirty_blocks = state->dirty_blocks;                               \
+    uint8_t *trace_out = *records;                                             \
+    GigaVmDecodedInstruction scratch;
+#define GIGA_VM_ENTRY(pc) giga_vm_trace_entry(decoded, (pc), &scratch)
+#define GIGA_VM_REG(index) registers[(index)]
+#define GIGA_VM_SET_REG(index, value) (registers[(index)] = (value))
+#define GIGA_VM_LOAD(address) ((uint8_t)(memory[(address)] & 0x0Fu))
+#define GIGA_VM_STORE(address, value)                                          \
+    do {                                                                       \
+        uint16_t store_address = (address);                                    \
+        memory[store_address] = (value);                                       \
+        dirty_blocks |= GIGA_VM_DIRTY_BIT(store_address);                      \
+        if (store_address < program_bytes) {                                   \
+            giga_vm_invalidate_word(decoded, store_address / 2u);              \
+        }                                                                      \
+    } while (0)
+#define GIGA_VM_SELECT_BANK(bank) ((bank) == 0) /* records only describe bank 0 */
+#define GIGA_VM_PORT_IN(port, value) giga_vm_port_in(state->ports, (port), (value))
+#define GIGA_VM_PORT_OUT(port, value) giga_vm_port_out(state->ports, (port), (value))
+#define GIGA_VM_REDECODE(pc) giga_vm_predecode_word(state, (pc))
+#define GIGA_VM_SAVED_ZERO state->flags_zero
+#define GIGA_VM_SAVED_CARRY state->flags_carry
+#define GIGA_VM_SAVED_NEGATIVE state->flags_negative
+#define GIGA_VM_RUN_FINISH                                                     \
+    {                                                                          \
+        AluResult flags;                                                       \
+        if (giga_vm_evaluate_flags(lazy_flags, &flags)) {                      \
+            giga_vm_set_flags(state, flags);                                   \
+        }                                                                      \
+        state->program_counter = program_counter;                              \
+        state->dirty_blocks = dirty_blocks;                                    \
+        *records = trace_out;                                                  \
+        /* HALT and errors use up a step but leave a stop record instead */ \
+        *retired = max_steps - remaining_steps;                                \
+        if (status != GIGA_VM_STATUS_STEP_LIMIT && *retired > 0) {             \
+            --*retired;                                                        \
+        }                                                                      \
+    }
+#include "vm_run_loop.inc"
+#undef GIGA_VM_RUN_FN
+#undef GIGA_VM_RUN_PARAMS
+#undef GIGA_VM_RUN_SETUP
+#undef GIGA_VM_ENTRY
+#undef GIGA_VM_REG
+#undef GIGA_VM_SET_REG
+#undef GIGA_VM_LOAD
+#undef GIGA_VM_STORE
+#undef GIGA_VM_SELECT_BANK
+#undef GIGA_VM_PORT_IN
+#undef GIGA_VM_PORT_OUT
+#undef GIGA_VM_REDECODE
+#undef GIGA_VM_SAVED_ZERO
+#undef GIGA_VM_SAVED_CARRY
+#undef GIGA_VM_SAVED_NEGATIVE
+#undef GIGA_VM_RUN_FINISH
+
+GigaVmStatus giga_vm_run_traced(GigaVmState *state, uint64_t max_steps, uint8_t *records,
+                                size_t *record_bytes, uint64_t *retired) {
+    if (state == NULL || records == NULL) {
+        return GIGA_VM_STATUS_INVALID_STATE;
+    }
+    uint8_t *out = records;
+    uint64_t retired_count = 0;
+    GigaVmStatus status = (state->data_bank == 0) ? giga_vm_run_state_traced(state, max_steps, &out, &retired_count)
+                                                  : GIGA_VM_STATUS_BANK_FAULT;
+    if (status != GIGA_VM_STATUS_STEP_LIMIT) {
+        out[0] = GIGA_VM_TRACE_TAG_STOP;
+        out[1] = (uint8_t)status;
+        out[2] = (uint8_t)(state->program_counter & 0xFFu);
+        out[3] = (uint8_t)(state->program_counter >> 8);
+        out += GIGA_VM_TRACE_STOP_BYTES;
+    }
+    if (record_bytes != NULL) {
+        *record_bytes = (size_t)(out - records);
+    }
+    if (retired != NULL) {
+        *retired = retired_count;
+    }
+    return status;
+}
+
+/* ---- profiled runs ---- */
+
+/* GigaOpcode counted for each base handler. */
+static const uint8_t giga_vm_profile_opcodes[GIGA_VM_HANDLER_COUNT] = {
+    GIGA_OP_NOP, GIGA_OP_MOV, GIGA_OP_MOVI, GIGA_OP_ADD,
+    GIGA_OP_SUB, GIGA_OP_AND, GIGA_OP_OR,   GIGA_OP_XOR,
+    GIGA_OP_NOT, GIGA_OP_SHL, GIGA_OP_SHR,  GIGA_OP_LD,
+    GIGA_OP_ST,  GIGA_OP_JMP, GIGA_OP_EXT,  GIGA_OP_HALT,
+    [GIGA_VM_HANDLER_JMP_OUT] = GIGA_OP_JMP,
+    [GIGA_VM_HANDLER_ADC] = GIGA_OP_EXT,
+    [GIGA_VM_HANDLER_SBC] = GIGA_OP_EXT,
+    [GIGA_VM_HANDLER_CMP] = GIGA_OP_EXT,
+    [GIGA_VM_HANDLER_BRANCH] = GIGA_OP_EXT,
+    [GIGA_VM_HANDLER_BRANCH_OUT] = GIGA_OP_EXT,
+    [GIGA_VM_HANDLER_BANK] = GIGA_OP_EXT,
+    [GIGA_VM_HANDLER_BANK_IMM] = GIGA_OP_EXT,
+    [GIGA_VM_HANDLER_IN] = GIGA_OP_EXT,
+    [GIGA_VM_HANDLER_OUT] = GIGA_OP_EXT
+};
+
+/*
+ * Entry for pc in a profiled run, counted once: invalidated entries are
+ * re-decoded here rather than by op_decode, and fusion is undone.
+ */
+static inline const GigaVmDecodedInstruction *giga_vm_profile_entry(GigaVmState *state, GigaVmProfile *profile,
+                                                                    uint16_t pc,
+                                                                    GigaVmDecodedInstruction *scratch) {
+    const GigaVmDecodedInstruction *entry = &state->decoded[pc];
+    if (entry->handler == GIGA_VM_HANDLER_DECODE) {
+        giga_vm_predecode_word(state, pc);
+    } else if (entry->handler >= GIGA_VM_FIRST_FUSED_HANDLER) {
+        *scratch = *entry;
+        scratch->handler = scratch->base_handler;
+        entry = scratch;
+    }
+    if (pc < state->loaded_program_words) { /* not the end-of-program sentinel, which retires nothing */
+        ++profile->pc_counts[pc];
+        ++profile->opcode_counts[giga_vm_profile_opcodes[entry->base_handler]];
+    }
+    return entry;
+}
+
+#define GIGA_VM_TRACE_JUMP(target) (++profile->jump_counts[program_counter - 1u])
+
+#define GIGA_VM_RUN_FN giga_vm_run_state_profiled
+#define GIGA_VM_RUN_PARAMS GigaVmState *state, uint64_t max_steps, GigaVmProfile *profile
+#define GIGA_VM_RUN_SETUP                                                      \
+    uint8_t *registers = state->registers;                                     \
+    uint8_t *data = giga_vm_bank_bytes(state, state->data_bank);               \
+    GigaVmDecodedInstruction *decoded = state->decoded;                        \
+    const size_t word_count = state->loaded_program_words;                     \
+    uint16_t program_counter = state->program_counter;                         \
+    uint16_t dirty_blocks = state->dirty_blocks;                               \
+    GigaVmDecodedInstruction scratch;
+#define GIGA_VM_ENTRY(pc) giga_vm_profile_entry(state, profile, (pc), &scratch)
+#define GIGA_VM_REG(index) registers[(index)]
+#define GIGA_VM_SET_REG(index, value) (registers[(index)] = (value))
+#define GIGA_VM_LOAD(address) ((uint8_t)(data[(address)] & 0x0Fu))
+#define GIGA_VM_STORE(address, value)                                          \
+    do {                                                                       \
+        uint16_t store_address = (address);                                    \
+        data[store_address] = (value);                                         \
+        dirty_blocks |= GIGA_VM_DIRTY_BIT(store_address);                      \
+        if (store_address < program_bytes && data == state->memory) {          \
+            giga_vm_invalidate_word(decoded, store_address / 2u);              \
+        }                                                                      \
+    } while (0)
+#define GIGA_VM_SELECT_BANK(bank) giga_vm_select_bank(state, (bank), &data)
+#define GIGA_VM_PORT_IN(port, value) giga_vm_port_in(state->ports, (port), (value))
+#define GIGA_VM_PORT_OUT(port, value) giga_vm_port_out(state->ports, (port), (value))
+#define GIGA_VM_REDECODE(pc) giga_vm_predecode_word(state, (pc))
+#define GIGA_VM_SAVED_ZERO state->flags_zero
+#define GIGA_VM_SAVED_CARRY state->flags_carry
+#define GIGA_VM_SAVED_NEGATIVE state->flags_negative
+#define GIGA_VM_RUN_FINISH                                                     \
+    {                                                                          \
+        AluResult flags;                                                       \
+        if (giga_vm_evaluate_flags(lazy_flags, &flags)) {                      \
+            giga_vm_set_flags(state, flags);                                   \
+        }                                                                      \
+        state->program_counter = program_counter;                              \
+        state->dirty_blocks = dirty_blocks;                                    \
+    }
+#include "vm_run_loop.inc"
+#undef GIGA_VM_RUN_FN
+#undef GIGA_VM_RUN_PARAMS
+#undef GIGA_VM_RUN_SETUP
+#undef GIGA_VM_ENTRY
+#undef GIGA_VM_REG
+#undef GIGA_VM_SET_REG
+#undef GIGA_VM_LOAD
+#undef GIGA_VM_STORE
+#undef GIGA_VM_SELECT_BANK
+#undef GIGA_VM_PORT_IN
+#undef GIGA_VM_PORT_OUT
+#undef GIGA_VM_REDECODE
+#undef GIGA_VM_SAVED_ZERO
+#undef GIGA_VM_SAVED_CARRY
+#undef GIGA_VM_SAVED_NEGATIVE
+#undef GIGA_VM_RUN_FINISH
+
+GigaVmStatus giga_vm_run_profiled(GigaVmState *state, uint64_t max_steps, GigaVmProfile *profile) {
+    if (state == NULL || profile == NULL) {
+        return GIGA_VM_STATUS_INVALID_STATE;
+    }
+    if (giga_vm_bank_missing(state)) {
+        return GIGA_VM_STATUS_BANK_FAULT;
+    }
+    return giga_vm_run_state_profiled(state, max_steps, profile);
+}
@@ -0,0 +1,98 @@
+#define _DEFAULT_SOURCE
+
+#include "vm/vm_banks.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/* Reserve address space only; pages are backed when first written. */
+#ifdef MAP_NORESERVE
+#define GIGA_VM_BANKS_MAP_FLAGS (MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE)
+#else
+#define GIGA_VM_BANKS_MAP_FLAGS (MAP_PRIVATE | MAP_ANONYMOUS)
+#endif
+
+struct GigaVmBanks {
+    uint8_t *mapping;               /* bank b at (b - 1) * GIGA_VM_MEMORY_SIZE */
+    size_t mapping_bytes;
+    size_t bank_count;              /* bank 0 included */
+    int touched;                    /* a bank was handed out since the last clear */
+};
+
+GigaVmBanks *giga_vm_banks_create(size_t bank_count) {
+    if (bank_count < 2u || bank_count > GIGA_VM_BANK_COUNT) {
+        return NULL;
+    }
+    GigaVmBanks *banks = (GigaVmBanks *)calloc(1, sizeof(*banks));
+    if (banks == NULL) {
+        return NULL;
+    }
+    banks->bank_count = bank_count;
+    banks->mapping_bytes = (bank_count - 1u) * GIGA_VM_MEMORY_SIZE;
+    void *mapping = mmap(NULL, banks->mapping_bytes, PROT_READ | PROT_WRITE, GIGA_VM_BANKS_MAP_FLAGS, -1, 0);
+    if (mapping == MAP_FAILED) {
+        free(banks);
+        return NULL;
+    }
+    banks->mapping = (uint8_t *)mapping;
+    return banks;
+}
+
+void giga_vm_banks_destroy(GigaVmBanks *banks) {
+    if (banks == NULL) {
+        return;
+    }
+    munmap(banks->mapping, banks->mapping_bytes);
+    free(banks);
+}
+
+size_t giga_vm_banks_count(const GigaVmBanks *banks) {
+    return (banks != NULL) ? banks->bank_count : 0u;
+}
+
+uint8_t *giga_vm_banks_data(GigaVmBanks *banks, size_t bank) {
+    if (banks == NULL || bank == 0 || bank >= banks->bank_count) {
+        return NULL;
+    }
+    banks->touched = 1;
+    return banks->mapping + (bank - 1u) * GIGA_VM_MEMORY_SIZE;
+}
+
+void giga_vm_banks_clear(GigaVmBanks *banks) {
+    if (banks == NULL || !banks->touched) {
+        return;
+    }
+    /* private anonymous pages read back as zero once dropped */
+    if (madvise(banks->mapping, banks->mapping_bytes, MADV_DONTNEED) != 0) {
+        memset(banks->mapping, 0, banks->mapping_bytes);
+    }
+    banks->touched = 0;
+}
+
+size_t giga_vm_banks_resident_bytes(const GigaVmBanks *banks) {
+    if (banks == NULL) {
+        return 0;
+    }
+    size_t page_bytes = (size_t)sysconf(_SC_PAGESIZE);
+    size_t page_count = (banks->mapping_bytes + page_bytes - 1u) / page_bytes;
+    unsigned char *residency = (unsigned char *)malloc(page_count);
+    if (residency == NULL || mincore(banks->mapping, banks->mapping_bytes, residency) != 0) {
+        free(residency);
+        return page_count * page_bytes; /* unknown: assume all of it */
+    }
+    size_t resident = 0;
+    for (size_t page = 0; page < page_count; ++page) {
+        resident += residency[page] & 1u;
+    }
+    free(residency);
+    return resident * page_bytes;
+}
+
+void giga_vm_attach_banks(GigaVmState *state, GigaVmBanks *banks) {
+    if (state == NULL) {
+        return;
+    }
+    state->banks = banks;
+}
@@ -0,0 +1,680 @@
+#include "vm/vm_batch.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define GIGA_VM_BATCH_X86 1
+#include <immintrin.h>
+#else
+#define GIGA_VM_BATCH_X86 0
+#endif
+
+typedef struct {
+    void (*move_row)(GigaVmBatch *batch, uint8_t *dest, const uint8_t *src, uint8_t value_mask);
+    void (*move_imm)(GigaVmBatch *batch, uint8_t *dest, uint8_t immediate);
+    void (*alu)(GigaVmBatch *batch, GigaOpcode opcode, uint8_t dest_reg, uint8_t src_reg);
+} GigaVmBatchKernelTable;
+
+static inline int giga_vm_batch_lane_active(const GigaVmBatch *batch, size_t lane) {
+    return (int)((batch->active_mask[lane / 64u] >> (lane % 64u)) & 1u);
+}
+
+static inline uint8_t giga_vm_batch_flag(const uint64_t *bits, size_t lane) {
+    return (uint8_t)((bits[lane / 64u] >> (lane % 64u)) & 1u);
+}
+
+static inline void giga_vm_batch_set_flag(uint64_t *bits, size_t lane, uint8_t value) {
+    uint64_t bit = (uint64_t)1u << (lane % 64u);
+    bits[lane / 64u] = value ? (bits[lane / 64u] | bit) : (bits[lane / 64u] & ~bit);
+}
+
+static void giga_vm_batch_set_active(GigaVmBatch *batch, size_t lane, int active) {
+    giga_vm_batch_set_flag(batch->active_mask, lane, (uint8_t)(active != 0));
+    batch->lane_mask[lane] = active ? 0xFFu : 0x00u;
+}
+
+/* ---- scalar kernel: one lane at a time, through alu_* ---- */
+
+static void giga_vm_batch_scalar_move_row(GigaVmBatch *batch, uint8_t *dest, const uint8_t *src,
+                                          uint8_t value_mask) {
+    for (size_t lane = 0; lane < batch->lane_count; ++lane) {
+        if (batch->lane_mask[lane]) {
+            dest[lane] = (uint8_t)(src[lane] & value_mask);
+        }
+    }
+}
+
+static void giga_vm_batch_scalar_move_imm(GigaVmBatch *batch, uint8_t *dest, uint8_t immediate) {
+    for (size_t lane = 0; lane < batch->lane_count; ++lane) {
+        if (batch->lane_mask[lane]) {
+            dest[lane] = immediate;
+        }
+    }
+}
+
+static void giga_vm_batch_scalar_alu(GigaVmBatch *batch, GigaOpcode opcode, uint8_t dest_reg,
+                                     uint8_t src_reg) {
+    uint8_t *dest = batch->registers + (size_t)dest_reg * batch->lane_stride;
+    const uint8_t *src = batch->registers + (size_t)src_reg * batch->lane_stride;
+    for (size_t lane = 0; lane < batch->lane_count; ++lane) {
+        if (!batch->lane_mask[lane]) {
+            continue;
+        }
+        AluResult flags;
+        switch (opcode) {
+            case GIGA_OP_ADD: flags = alu_add(dest[lane], src[lane]); break;
+            case GIGA_OP_SUB: flags = alu_sub(dest[lane], src[lane]); break;
+            case GIGA_OP_AND: flags = alu_and(dest[lane], src[lane]); break;
+            case GIGA_OP_OR:  flags = alu_or(dest[lane], src[lane]); break;
+            case GIGA_OP_XOR: flags = alu_xor(dest[lane], src[lane]); break;
+            case GIGA_OP_NOT: flags = alu_not(dest[lane]); break;
+            case GIGA_OP_SHL: flags = alu_shl(dest[lane]); break;
+            case GIGA_OP_SHR: flags = alu_shr(dest[lane]); break;
+            default: return;
+        }
+        dest[lane] = flags.result;
+        giga_vm_batch_set_flag(batch->flags_zero, lane, flags.zero_flag);
+        giga_vm_batch_set_flag(batch->flags_carry, lane, flags.carry_flag);
+        giga_vm_batch_set_flag(batch->flags_negative, lane, flags.negative_flag);
+        giga_vm_batch_set_flag(batch->flags_overflow, lane, flags.overflow_flag);
+    }
+}
+
+/*
+ * ADC/SBC read each lane's carry and CMP only writes flags, so every kernel
+ * runs them one lane at a time.
+ */
+static void giga_vm_batch_ext_alu(GigaVmBatch *batch, GigaExtOpcode ext_opcode, uint8_t dest_reg,
+                                  uint8_t src_reg) {
+    uint8_t *dest = batch->registers + (size_t)dest_reg * batch->lane_stride;
+    const uint8_t *src = batch->registers + (size_t)src_reg * batch->lane_stride;
+    for (size_t lane = 0; lane < batch->lane_count; ++lane) {
+        if (!batch->lane_mask[lane]) {
+            continue;
+        }
+        uint8_t carry_in = giga_vm_batch_flag(batch->flags_carry, lane);
+        AluResult flags;
+        if (ext_opcode == GIGA_EXT_CMP) {
+            flags = alu_sub(dest[lane], src[lane]);
+        } else {
+            flags = (ext_opcode == GIGA_EXT_ADC) ? alu_adc(dest[lane], src[lane], carry_in)
+                                                 : alu_sbc(dest[lane], src[lane], carry_in);
+            dest[lane] = flags.result;
+        }
+        giga_vm_batch_set_flag(batch->flags_zero, lane, flags.zero_flag);
+        giga_vm_batch_set_flag(batch->flags_carry, lane, flags.carry_flag);
+        giga_vm_batch_set_flag(batch->flags_negative, lane, flags.negative_flag);
+        giga_vm_batch_set_flag(batch->flags_overflow, lane, flags.overflow_flag);
+    }
+}
+
+static const GigaVmBatchKernelTable giga_vm_batch_scalar_kernel = {
+    giga_vm_batch_scalar_move_row,
+    giga_vm_batch_scalar_move_imm,
+    giga_vm_batch_scalar_alu,
+};
+
+#if GIGA_VM_BATCH_X86
+
+/* ---- SSE2 kernel: 16 lanes per vector, baseline on x86-64 ---- */
+
+#define GIGA_BATCH_FN(name) giga_vm_batch_sse2_##name
+#define GIGA_BATCH_TARGET
+#define GIGA_BATCH_WIDTH 16u
+#define GIGA_BATCH_VEC __m128i
+#define GIGA_BATCH_LOAD(pointer) _mm_loadu_si128((const __m128i *)(const void *)(pointer))
+#define GIGA_BATCH_STORE(pointer, value) _mm_storeu_si128((__m128i *)(void *)(pointer), (value))
+#define GIGA_BATCH_SET1(value) _mm_set1_epi8((char)(value))
+#define GIGA_BATCH_AND(a, b) _mm_and_si128((a), (b))
+#define GIGA_BATCH_OR(a, b) _mm_or_si128((a), (b))
+#define GIGA_BATCH_XOR(a, b) _mm_xor_si128((a), (b))
+#define GIGA_BATCH_ANDNOT(a, b) _mm_andnot_si128((a), (b))
+#define GIGA_BATCH_ADD(a, b) _mm_add_epi8((a), (b))
+#define GIGA_BATCH_SUB(a, b) _mm_sub_epi8((a), (b))
+#define GIGA_BATCH_CMPEQ(a, b) _mm_cmpeq_epi8((a), (b))
+#define GIGA_BATCH_MAX(a, b) _mm_max_epu8((a), (b))
+#define GIGA_BATCH_SLLI16(a, count) _mm_slli_epi16((a), (count))
+#define GIGA_BATCH_SRLI16(a, count) _mm_srli_epi16((a), (count))
+#define GIGA_BATCH_MOVEMASK(a) _mm_movemask_epi8(a)
+#include "vm_batch_kernel.inc"
+#undef GIGA_BATCH_FN
+#undef GIGA_BATCH_TARGET
+#undef GIGA_BATCH_WIDTH
+#undef GIGA_BATCH_VEC
+#undef GIGA_BATCH_LOAD
+#undef GIGA_BATCH_STORE
+#undef GIGA_BATCH_SET1
+#undef GIGA_BATCH_AND
+#undef GIGA_BATCH_OR
+#undef GIGA_BATCH_XOR
+#undef GIGA_BATCH_ANDNOT
+#undef GIGA_BATCH_ADD
+#undef GIGA_BATCH_SUB
+#undef GIGA_BATCH_CMPEQ
+#undef GIGA_BATCH_MAX
+#undef GIGA_BATCH_SLLI16
+#undef GIGA_BATCH_SRLI16
+#undef GIGA_BATCH_MOVEMASK
+
+static const GigaVmBatchKernelTable giga_vm_batch_sse2_kernel = {
+    giga_vm_batch_sse2_move_row,
+    giga_vm_batch_sse2_move_imm,
+    giga_vm_batch_sse2_alu,
+};
+
+/* ---- AVX2 kernel: 32 lanes per vector, selected when the CPU has AVX2 ---- */
+
+#define GIGA_BATCH_FN(name) giga_vm_batch_avx2_##name
+#define GIGA_BATCH_TARGET __attribute__((target("avx2")))
+#define GIGA_BATCH_WIDTH 32u
+#define GIGA_BATCH_VEC __m256i
+#define GIGA_BATCH_LOAD(pointer) _mm256_loadu_si256((const __m256i *)(const void *)(pointer))
+#define GIGA_BATCH_STORE(pointer, value) _mm256_storeu_si256((__m256i *)(void *)(pointer), (value))
+#define GIGA_BATCH_SET1(value) _mm256_set1_epi8((char)(value))
+#define GIGA_BATCH_AND(a, b) _mm256_and_si256((a), (b))
+#define GIGA_BATCH_OR(a, b) _mm256_or_si256((a), (b))
+#define GIGA_BATCH_XOR(a, b) _mm256_xor_si256((a), (b))
+#define GIGA_BATCH_ANDNOT(a, b) _mm256_andnot_si256((a), (b))
+#define GIGA_BATCH_ADD(a, b) _mm256_add_epi8((a), (b))
+#define GIGA_BATCH_SUB(a, b) _mm256_sub_epi8((a), (b))
+#define GIGA_BATCH_CMPEQ(a, b) _mm256_cmpeq_epi8((a), (b))
+#define GIGA_BATCH_MAX(a, b) _mm256_max_epu8((a), (b))
+#define GIGA_BATCH_SLLI16(a, count) _mm256_slli_epi16((a), (count))
+#define GIGA_BATCH_SRLI16(a, count) _mm256_srli_epi16((a), (count))
+#define GIGA_BATCH_MOVEMASK(a) _mm256_movemask_epi8(a)
+#include "vm_batch_kernel.inc"
+#undef GIGA_BATCH_FN
+#undef GIGA_BATCH_TARGET
+#undef GIGA_BATCH_WIDTH
+#undef GIGA_BATCH_VEC
+#undef GIGA_BATCH_LOAD
+#undef GIGA_BATCH_STORE
+#undef GIGA_BATCH_SET1
+#undef GIGA_BATCH_AND
+#undef GIGA_BATCH_OR
+#undef GIGA_BATCH_XOR
+#undef GIGA_BATCH_ANDNOT
+#undef GIGA_BATCH_ADD
+#undef GIGA_BATCH_SUB
+#undef GIGA_BATCH_CMPEQ
+#undef GIGA_BATCH_MAX
+#undef GIGA_BATCH_SLLI16
+#undef GIGA_BATCH_SRLI16
+#undef GIGA_BATCH_MOVEMASK
+
+static const GigaVmBatchKernelTable giga_vm_batch_avx2_kernel = {
+    giga_vm_batch_avx2_move_row,
+    giga_vm_batch_avx2_move_imm,
+    giga_vm_batch_avx2_alu,
+};
+
+#endif /* GIGA_VM_BATCH_X86 */
+
+static int giga_vm_batch_kernel_supported(GigaVmBatchKernel kernel) {
+    switch (kernel) {
+        case GIGA_VM_BATCH_KERNEL_SCALAR:
+            return 1;
+#if GIGA_VM_BATCH_X86
+        case GIGA_VM_BATCH_KERNEL_SSE2:
+            return 1;
+        case GIGA_VM_BATCH_KERNEL_AVX2:
+            return __builtin_cpu_supports("avx2") ? 1 : 0;
+#endif
+        default:
+            return 0;
+    }
+}
+
+static const GigaVmBatchKernelTable *giga_vm_batch_kernel_table(GigaVmBatchKernel kernel) {
+#if GIGA_VM_BATCH_X86
+    if (kernel == GIGA_VM_BATCH_KERNEL_AVX2) {
+        return &giga_vm_batch_avx2_kernel;
+    }
+    if (kernel == GIGA_VM_BATCH_KERNEL_SSE2) {
+        return &giga_vm_batch_sse2_kernel;
+    }
+#endif
+    (void)kernel;
+    return &giga_vm_batch_scalar_kernel;
+}
+
+GigaVmBatchKernel giga_vm_batch_best_kernel(void) {
+    if (giga_vm_batch_kernel_supported(GIGA_VM_BATCH_KERNEL_AVX2)) {
+        return GIGA_VM_BATCH_KERNEL_AVX2;
+    }
+    if (giga_vm_batch_kernel_supported(GIGA_VM_BATCH_KERNEL_SSE2)) {
+        return GIGA_VM_BATCH_KERNEL_SSE2;
+    }
+    return GIGA_VM_BATCH_KERNEL_SCALAR;
+}
+
+int giga_vm_batch_set_kernel(GigaVmBatch *batch, GigaVmBatchKernel kernel) {
+    if (batch == NULL || !giga_vm_batch_kernel_supported(kernel)) {
+        return -1;
+    }
+    batch->kernel = kernel;
+    return 0;
+}
+
+static void giga_vm_batch_decode_word(GigaVmBatch *batch, size_t word_index, uint16_t raw_word) {
+    batch->instructions[word_index] = giga_decode_instruction(raw_word);
+}
+
+static uint8_t giga_vm_batch_program_byte(const GigaVmBatch *batch, size_t byte_address) {
+    uint16_t raw_word = batch->instructions[byte_address / 2u].raw;
+    return (uint8_t)((byte_address % 2u) ? (raw_word >> 8) : (raw_word & 0xFFu));
+}
+
+int giga_vm_batch_init(GigaVmBatch *batch,
+                       size_t lane_count,
+                       const uint16_t *program_words,
+                       size_t word_count) {
+    if (batch == NULL || lane_count == 0 || (program_words == NULL && word_count > 0)) {
+        return -1;
+    }
+    if (word_count > GIGA_VM_MAX_PROGRAM_WORDS) {
+        return -2;
+    }
+
+    memset(batch, 0, sizeof(*batch));
+    size_t stride = (lane_count + 63u) & ~(size_t)63u;
+    size_t mask_words = stride / 64u;
+    batch->lane_count = lane_count;
+    batch->lane_stride = stride;
+    batch->registers = (uint8_t *)calloc(GIGA_VM_REGISTER_COUNT * stride, 1);
+    batch->memory = (uint8_t *)calloc(GIGA_VM_MEMORY_SIZE * stride, 1);
+    batch->flags_zero = (uint64_t *)calloc(mask_words, sizeof(uint64_t));
+    batch->flags_carry = (uint64_t *)calloc(mask_words, sizeof(uint64_t));
+    batch->flags_negative = (uint64_t *)calloc(mask_words, sizeof(uint64_t));
+    batch->flags_overflow = (uint64_t *)calloc(mask_words, sizeof(uint64_t));
+    batch->active_mask = (uint64_t *)calloc(mask_words, sizeof(uint64_t));
+    batch->lane_mask = (uint8_t *)calloc(stride, 1);
+    batch->program_counter = (uint16_t *)calloc(stride, sizeof(uint16_t));
+    batch->status = (uint8_t *)calloc(stride, 1);
+    batch->lane_budget = (uint64_t *)calloc(stride, sizeof(uint64_t));
+    batch->scratch = (GigaVmState *)malloc(sizeof(GigaVmState));
+    if (batch->registers == NULL || batch->memory == NULL || batch->flags_zero == NULL ||
+        batch->flags_carry == NULL || batch->flags_negative == NULL || batch->flags_overflow == NULL ||
+        batch->active_mask == NULL || batch->lane_mask == NULL || batch->program_counter == NULL ||
+        batch->status == NULL || batch->lane_budget == NULL || batch->scratch == NULL) {
+        giga_vm_batch_free(batch);
+        return -3;
+    }
+
+    batch->word_count = word_count;
+    for (size_t index = 0; index < word_count; ++index) {
+        giga_vm_batch_decode_word(batch, index, program_words[index]);
+        memset(batch->memory + (index * 2u) * stride, program_words[index] & 0xFFu, lane_count);
+        memset(batch->memory + (index * 2u + 1u) * stride, program_words[index] >> 8, lane_count);
+    }
+    for (size_t lane = 0; lane < lane_count; ++lane) {
+        giga_vm_batch_set_active(batch, lane, 1);
+    }
+    batch->kernel = giga_vm_batch_best_kernel();
+    return 0;
+}
+
+void giga_vm_batch_free(GigaVmBatch *batch) {
+    if (batch == NULL) {
+        return;
+    }
+    free(batch->registers);
+    free(batch->memory);
+    free(batch->flags_zero);
+    free(batch->flags_carry);
+    free(batch->flags_negative);
+    free(batch->flags_overflow);
+    free(batch->active_mask);
+    free(batch->lane_mask);
+    free(batch->program_counter);
+    free(batch->status);
+    free(batch->lane_budget);
+    free(batch->scratch);
+    memset(batch, 0, sizeof(*batch));
+}
+
+int giga_vm_batch_set_lane(GigaVmBatch *batch, size_t lane, const GigaVmState *state) {
+    if (batch == NULL || state == NULL || lane >= batch->lane_count ||
+        state->loaded_program_words != batch->word_count || state->data_bank != 0) {
+        return -1;
+    }
+
+    size_t stride = batch->lane_stride;
+    for (size_t reg = 0; reg < GIGA_VM_REGISTER_COUNT; ++reg) {
+        batch->registers[reg * stride + lane] = state->registers[reg];
+    }
+    for (size_t address = 0; address < GIGA_VM_MEMORY_SIZE; ++address) {
+        batch->memory[address * stride + lane] = state->memory[address];
+    }
+    giga_vm_batch_set_flag(batch->flags_zero, lane, state->flags_zero);
+    giga_vm_batch_set_flag(batch->flags_carry, lane, state->flags_carry);
+    giga_vm_batch_set_flag(batch->flags_negative, lane, state->flags_negative);
+    giga_vm_batch_set_flag(batch->flags_overflow, lane, state->flags_overflow);
+    batch->program_counter[lane] = state->program_counter;
+    batch->status[lane] = (uint8_t)GIGA_VM_STATUS_RUNNING;
+
+    int in_step = state->program_counter == batch->shared_program_counter;
+    for (size_t address = 0; in_step && address < batch->word_count * 2u; ++address) {
+        in_step = state->memory[address] == giga_vm_batch_program_byte(batch, address);
+    }
+    giga_vm_batch_set_active(batch, lane, in_step);
+    return 0;
+}
+
+int giga_vm_batch_get_lane(const GigaVmBatch *batch, size_t lane, GigaVmState *state) {
+    if (batch == NULL || state == NULL || lane >= batch->lane_count) {
+        return -1;
+    }
+
+    size_t stride = batch->lane_stride;
+    uint16_t program_words[GIGA_VM_MAX_PROGRAM_WORDS];
+    for (size_t index = 0; index < batch->word_count; ++index) {
+        program_words[index] = (uint16_t)(batch->memory[(index * 2u) * stride + lane] |
+                                          (batch->memory[(index * 2u + 1u) * stride + lane] << 8));
+    }
+
+    /* load the lane's own code so the scalar state is predecoded from it */
+    giga_vm_init(state);
+    giga_vm_load_program(state, program_words, batch->word_count);
+    for (size_t reg = 0; reg < GIGA_VM_REGISTER_COUNT; ++reg) {
+        state->registers[reg] = batch->registers[reg * stride + lane];
+    }
+    for (size_t address = batch->word_count * 2u; address < GIGA_VM_MEMORY_SIZE; ++address) {
+        state->memory[address] = batch->memory[address * stride + lane];
+    }
+    state->flags_zero = giga_vm_batch_flag(batch->flags_zero, lane);
+    state->flags_carry = giga_vm_batch_flag(batch->flags_carry, lane);
+    state->flags_negative = giga_vm_batch_flag(batch->flags_negative, lane);
+    state->flags_overflow = giga_vm_batch_flag(batch->flags_overflow, lane);
+    state->program_counter = batch->program_counter[lane];
+    return 0;
+}
+
+/* First lane of the lock-step group, or lane_count when it is empty. */
+static size_t giga_vm_batch_first_active(const GigaVmBatch *batch) {
+    size_t first_lane = 0;
+    while (first_lane < batch->lane_count && !batch->lane_mask[first_lane]) {
+        ++first_lane;
+    }
+    return first_lane;
+}
+
+/*
+ * After a lock-step ST into the program region: the lock-step group keeps
+ * the byte written by its first active lane (adopting it into the shared
+ * program), and lanes that wrote anything else leave lock-step with
+ * `remaining` steps still to run from `pc`.
+ */
+static void giga_vm_batch_code_store(GigaVmBatch *batch, uint16_t address, uint16_t pc,
+                                     uint64_t remaining) {
+    const uint8_t *row = batch->memory + (size_t)address * batch->lane_stride;
+    size_t first_lane = giga_vm_batch_first_active(batch);
+    if (first_lane == batch->lane_count) {
+        return;
+    }
+
+    uint8_t kept = row[first_lane];
+    if (kept != giga_vm_batch_program_byte(batch, address)) {
+        uint16_t raw_word = batch->instructions[address / 2u].raw;
+        raw_word = (address % 2u) ? (uint16_t)((raw_word & 0x00FFu) | (kept << 8))
+                                  : (uint16_t)((raw_word & 0xFF00u) | kept);
+        giga_vm_batch_decode_word(batch, address / 2u, raw_word);
+    }
+    for (size_t lane = first_lane + 1u; lane < batch->lane_count; ++lane) {
+        if (batch->lane_mask[lane] && row[lane] != kept) {
+            giga_vm_batch_set_active(batch, lane, 0);
+            batch->program_counter[lane] = pc;
+            batch->lane_budget[lane] = remaining;
+        }
+    }
+}
+
+static uint8_t giga_vm_batch_condition(const GigaVmBatch *batch, GigaExtOpcode branch, size_t lane) {
+    switch (branch) {
+        case GIGA_EXT_JZ: return giga_vm_batch_flag(batch->flags_zero, lane);
+        case GIGA_EXT_JNZ: return (uint8_t)!giga_vm_batch_flag(batch->flags_zero, lane);
+        case GIGA_EXT_JC: return giga_vm_batch_flag(batch->flags_carry, lane);
+        default: return giga_vm_batch_flag(batch->flags_negative, lane);
+    }
+}
+
+/*
+ * Conditional branch at pc: the lock-step group follows its first active
+ * lane, and lanes whose condition differs leave lock-step before the
+ * branch with `remaining` steps (the branch's own included) to run from
+ * pc. Returns whether the group takes the branch.
+ */
+static int giga_vm_batch_branch(GigaVmBatch *batch, GigaExtOpcode branch, uint16_t pc, uint64_t remaining) {
+    size_t first_lane = giga_vm_batch_first_active(batch);
+    if (first_lane == batch->lane_count) {
+        return 0;
+    }
+
+    uint8_t taken = giga_vm_batch_condition(batch, branch, first_lane);
+    for (size_t lane = first_lane + 1u; lane < batch->lane_count; ++lane) {
+        if (batch->lane_mask[lane] && giga_vm_batch_condition(batch, branch, lane) != taken) {
+            giga_vm_batch_set_active(batch, lane, 0);
+            batch->program_counter[lane] = pc;
+            batch->lane_budget[lane] = remaining;
+        }
+    }
+    return taken;
+}
+
+/* Whether BANK R<dest_reg> selects bank 0 in a lane. */
+static int giga_vm_batch_bank_zero(const GigaVmBatch *batch, uint8_t dest_reg, size_t lane) {
+    const uint8_t *registers = batch->registers;
+    uint8_t bank = 0;
+    for (uint8_t offset = 0; offset < 3u; ++offset) {
+        bank |= registers[(size_t)((dest_reg + offset) % GIGA_VM_REGISTER_COUNT) * batch->lane_stride + lane];
+    }
+    return (bank & 0x0Fu) == 0;
+}
+
+/*
+ * BANK at pc: lanes only have bank 0, so the lock-step group follows its
+ * first active lane into bank 0 or a fault, and lanes that disagree leave
+ * lock-step like an untaken branch. Returns whether the group stays in bank 0.
+ */
+static int giga_vm_batch_bank(GigaVmBatch *batch, uint8_t dest_reg, uint16_t pc, uint64_t remaining) {
+    size_t first_lane = giga_vm_batch_first_active(batch);
+    if (first_lane == batch->lane_count) {
+        return 1;
+    }
+
+    int bank_zero = giga_vm_batch_bank_zero(batch, dest_reg, first_lane);
+    for (size_t lane = first_lane + 1u; lane < batch->lane_count; ++lane) {
+        if (batch->lane_mask[lane] && giga_vm_batch_bank_zero(batch, dest_reg, lane) != bank_zero) {
+            giga_vm_batch_set_active(batch, lane, 0);
+            batch->program_counter[lane] = pc;
+            batch->lane_budget[lane] = remaining;
+        }
+    }
+    return bank_zero;
+}
+
+static int giga_vm_batch_any_active(const GigaVmBatch *batch) {
+    for (size_t word = 0; word < batch->lane_stride / 64u; ++word) {
+        if (batch->active_mask[word] != 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Run the lock-step lanes; mirrors giga_vm_run instruction for instruction. */
+static void giga_vm_batch_run_lockstep(GigaVmBatch *batch, uint64_t max_steps) {
+    const GigaVmBatchKernelTable *kernel = giga_vm_batch_kernel_table(batch->kernel);
+    const size_t stride = batch->lane_stride;
+    const size_t word_count = batch->word_count;
+    uint8_t *registers = batch->registers;
+    uint16_t pc = batch->shared_program_counter;
+    uint64_t remaining_steps = max_steps;
+    GigaVmStatus status;
+
+    if (pc > word_count) {
+        status = GIGA_VM_STATUS_PC_OUT_OF_RANGE;
+        goto lockstep_exit;
+    }
+
+    for (;;) {
+        if (remaining_steps == 0) {
+            status = GIGA_VM_STATUS_STEP_LIMIT;
+            break;
+        }
+        if (pc == word_count) {
+            status = GIGA_VM_STATUS_PC_OUT_OF_RANGE;
+            break;
+        }
+        --remaining_steps;
+        const GigaInstruction instruction = batch->instructions[pc++];
+        uint8_t *dest = registers + (size_t)(instruction.dest_reg & (GIGA_VM_REGISTER_COUNT - 1u)) * stride;
+        uint8_t *src = registers + (size_t)(instruction.src_reg & (GIGA_VM_REGISTER_COUNT - 1u)) * stride;
+
+        switch (instruction.opcode) {
+            case GIGA_OP_NOP:
+                break;
+            case GIGA_OP_MOV:
+                kernel->move_row(batch, dest, src, 0xFFu);
+                break;
+            case GIGA_OP_MOVI:
+                kernel->move_imm(batch, dest, instruction.imm4);
+                break;
+            case GIGA_OP_ADD:
+            case GIGA_OP_SUB:
+            case GIGA_OP_AND:
+            case GIGA_OP_OR:
+            case GIGA_OP_XOR:
+            case GIGA_OP_NOT:
+            case GIGA_OP_SHL:
+            case GIGA_OP_SHR:
+                kernel->alu(batch, instruction.opcode,
+                            (uint8_t)(instruction.dest_reg & (GIGA_VM_REGISTER_COUNT - 1u)),
+                            (uint8_t)(instruction.src_reg & (GIGA_VM_REGISTER_COUNT - 1u)));
+                break;
+            case GIGA_OP_LD: {
+                size_t address = (size_t)((instruction.src_reg << 4) | instruction.imm4);
+                kernel->move_row(batch, dest, batch->memory + address * stride, 0x0Fu);
+                break;
+            }
+            case GIGA_OP_ST: {
+                uint16_t address = (uint16_t)((instruction.dest_reg << 4) | instruction.imm4);
+                kernel->move_row(batch, batch->memory + (size_t)address * stride, src, 0xFFu);
+                if (address < word_count * 2u) {
+                    giga_vm_batch_code_store(batch, address, pc, remaining_steps);
+                }
+                break;
+            }
+            case GIGA_OP_JMP: {
+                uint16_t target = (uint16_t)(instruction.raw & 0x0FFFu);
+                pc = target;
+                if (target >= word_count) {
+                    status = GIGA_VM_STATUS_PC_OUT_OF_RANGE;
+                    goto lockstep_exit;
+                }
+                break;
+            }
+            case GIGA_OP_EXT:
+                if (GIGA_EXT_IS_BRANCH(instruction.dest_reg)) {
+                    /* target in [7:0] */
+                    uint16_t target = (uint16_t)(instruction.raw & 0x00FFu);
+                    if (!giga_vm_batch_branch(batch, (GigaExtOpcode)instruction.dest_reg, (uint16_t)(pc - 1u),
+                                              remaining_steps + 1u)) {
+                        break;
+                    }
+                    pc = target;
+                    if (target >= word_count) {
+                        status = GIGA_VM_STATUS_PC_OUT_OF_RANGE;
+                        goto lockstep_exit;
+                    }
+                    break;
+                }
+                if (instruction.dest_reg == GIGA_EXT_BANK || instruction.dest_reg == GIGA_EXT_BANKI) {
+                    int bank_zero = (instruction.dest_reg == GIGA_EXT_BANKI)
+                                        ? (instruction.raw & 0x00FFu) == 0
+                                        : giga_vm_batch_bank(batch,
+                                                             (uint8_t)(instruction.src_reg & (GIGA_VM_REGISTER_COUNT - 1u)),
+                                                             (uint16_t)(pc - 1u), remaining_steps + 1u);
+                    if (!bank_zero) {
+                        --pc;
+                        status = GIGA_VM_STATUS_BANK_FAULT;
+                        goto lockstep_exit;
+                    }
+                    break;
+                }
+                if (instruction.dest_reg == GIGA_EXT_IN || instruction.dest_reg == GIGA_EXT_OUT) {
+                    --pc;
+                    status = GIGA_VM_STATUS_PORT_FAULT;
+                    goto lockstep_exit;
+                }
+                /* sub-opcode in [11:8], registers in [7:4] and [3:0] */
+                if (instruction.dest_reg != GIGA_EXT_ADC && instruction.dest_reg != GIGA_EXT_SBC &&
+                    instruction.dest_reg != GIGA_EXT_CMP) {
+                    --pc;
+                    status = GIGA_VM_STATUS_INVALID_OPCODE;
+                    goto lockstep_exit;
+                }
+                giga_vm_batch_ext_alu(batch, (GigaExtOpcode)instruction.dest_reg,
+                                      (uint8_t)(instruction.src_reg & (GIGA_VM_REGISTER_COUNT - 1u)),
+                                      (uint8_t)(instruction.imm4 & (GIGA_VM_REGISTER_COUNT - 1u)));
+                break;
+            case GIGA_OP_HALT:
+                --pc;
+                status = GIGA_VM_STATUS_HALTED;
+                goto lockstep_exit;
+            default:
+                --pc;
+                status = GIGA_VM_STATUS_INVALID_OPCODE;
+                goto lockstep_exit;
+        }
+    }
+
+lockstep_exit:
+    batch->shared_program_counter = pc;
+    for (size_t lane = 0; lane < batch->lane_count; ++lane) {
+        if (batch->lane_mask[lane]) {
+            batch->program_counter[lane] = pc;
+            batch->status[lane] = (uint8_t)status;
+        }
+    }
+}
+
+/* Run one lane that has left lock-step through the scalar interpreter. */
+static void giga_vm_batch_run_lane(GigaVmBatch *batch, size_t lane, uint64_t max_steps) {
+    GigaVmState *state = batch->scratch;
+    size_t stride = batch->lane_stride;
+    giga_vm_batch_get_lane(batch, lane, state);
+    batch->status[lane] = (uint8_t)giga_vm_run(state, max_steps);
+
+    for (size_t reg = 0; reg < GIGA_VM_REGISTER_COUNT; ++reg) {
+        batch->registers[reg * stride + lane] = state->registers[reg];
+    }
+    for (size_t address = 0; address < GIGA_VM_MEMORY_SIZE; ++address) {
+        batch->memory[address * stride + lane] = state->memory[address];
+    }
+    giga_vm_batch_set_flag(batch->flags_zero, lane, state->flags_zero);
+    giga_vm_batch_set_flag(batch->flags_carry, lane, state->flags_carry);
+    giga_vm_batch_set_flag(batch->flags_negative, lane, state->flags_negative);
+    giga_vm_batch_set_flag(batch->flags_overflow, lane, state->flags_overflow);
+    batch->program_counter[lane] = state->program_counter;
+}
+
+int giga_vm_batch_run(GigaVmBatch *batch, uint64_t max_steps) {
+    if (batch == NULL || batch->registers == NULL) {
+        return -1;
+    }
+
+    for (size_t lane = 0; lane < batch->lane_count; ++lane) {
+        batch->lane_budget[lane] = giga_vm_batch_lane_active(batch, lane) ? 0 : max_steps;
+    }
+    if (giga_vm_batch_any_active(batch)) {
+        giga_vm_batch_run_lockstep(batch, max_steps);
+    }
+    for (size_t lane = 0; lane < batch->lane_count; ++lane) {
+        if (!giga_vm_batch_lane_active(batch, lane)) {
+            giga_vm_batch_run_lane(batch, lane, batch->lane_budget[lane]);
+        }
+    }
+    return 0;
+}
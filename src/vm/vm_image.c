@@ -0,0 +1,282 @@
+#define _DEFAULT_SOURCE
+
+#include "vm/vm_image.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+_Static_assert(sizeof(GigaVmImageHeader) == 128, "GigaVmImageHeader is part of the file format");
+_Static_assert(sizeof(GigaVmImageSymbol) == 12, "GigaVmImageSymbol is part of the file format");
+
+static uint64_t giga_vm_image_align(uint64_t offset) {
+    return (offset + GIGA_VM_IMAGE_ALIGN - 1u) & ~(uint64_t)(GIGA_VM_IMAGE_ALIGN - 1u);
+}
+
+/* Lay the sections out after the header; returns the file size. */
+static uint64_t giga_vm_image_layout(GigaVmImageHeader *header, const uint64_t *section_bytes) {
+    uint64_t offset = giga_vm_image_align(sizeof(*header));
+    for (size_t kind = 0; kind < GIGA_VM_IMAGE_SECTION_COUNT; ++kind) {
+        header->sections[kind].offset = offset;
+        header->sections[kind].bytes = section_bytes[kind];
+        offset = giga_vm_image_align(offset + section_bytes[kind]);
+    }
+    return offset;
+}
+
+int giga_vm_image_write(const char *path, const GigaVmImageSource *source) {
+    if (path == NULL || source == NULL || source->words == NULL || source->word_count > GIGA_VM_MAX_CODE_WORDS ||
+        source->data_bytes > GIGA_VM_MEMORY_SIZE || (source->data == NULL && source->data_bytes != 0) ||
+        (source->labels == NULL && source->label_count != 0) || source->label_count > UINT32_MAX) {
+        return -1;
+    }
+
+    size_t names_bytes = 0;
+    for (size_t index = 0; index < source->label_count; ++index) {
+        if (source->labels[index].name == NULL || source->labels[index].address > source->word_count) {
+            return -1;
+        }
+        names_bytes += source->labels[index].name_length + 1u;
+    }
+    if (names_bytes > UINT32_MAX) {
+        return -1;
+    }
+
+    GigaVmImageHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, GIGA_VM_IMAGE_MAGIC, sizeof(header.magic));
+    header.version = GIGA_VM_IMAGE_VERSION;
+    header.byte_order = GIGA_VM_IMAGE_BYTE_ORDER;
+    header.decode_abi = GIGA_VM_DECODE_ABI;
+    header.flags = source->fuse ? GIGA_VM_IMAGE_FUSED : 0u;
+    header.word_count = (uint32_t)source->word_count;
+    header.symbol_count = (uint32_t)source->label_count;
+    uint64_t section_bytes[GIGA_VM_IMAGE_SECTION_COUNT] = {
+        [GIGA_VM_IMAGE_CODE] = source->word_count * sizeof(uint16_t),
+        [GIGA_VM_IMAGE_DECODED] = (source->word_count + 1u) * sizeof(GigaVmDecodedInstruction),
+        [GIGA_VM_IMAGE_DATA] = source->data_bytes,
+        [GIGA_VM_IMAGE_SYMBOLS] = source->label_count * sizeof(GigaVmImageSymbol),
+        [GIGA_VM_IMAGE_NAMES] = names_bytes,
+        [GIGA_VM_IMAGE_LINES] = (source->source_lines != NULL) ? source->word_count * sizeof(uint32_t) : 0u
+    };
+    header.file_bytes = giga_vm_image_layout(&header, section_bytes);
+
+    /* build the whole file in memory; images are at most a few hundred KiB */
+    uint8_t *file = (uint8_t *)calloc(1, (size_t)header.file_bytes);
+    GigaVmCode *code = (GigaVmCode *)calloc(1, sizeof(*code)); /* zero padding keeps files reproducible */
+    if (file == NULL || code == NULL) {
+        free(file);
+        free(code);
+        return -2;
+    }
+    giga_vm_code_init(code, source->words, source->word_count);
+    if (source->fuse) {
+        giga_vm_code_fuse(code);
+    }
+    memcpy(file, &header, sizeof(header));
+    memcpy(file + header.sections[GIGA_VM_IMAGE_CODE].offset, source->words,
+           (size_t)section_bytes[GIGA_VM_IMAGE_CODE]);
+    memcpy(file + header.sections[GIGA_VM_IMAGE_DECODED].offset, code->decoded,
+           (size_t)section_bytes[GIGA_VM_IMAGE_DECODED]);
+    free(code);
+    if (source->data_bytes != 0) {
+        memcpy(file + header.sections[GIGA_VM_IMAGE_DATA].offset, source->data, source->data_bytes);
+    }
+    GigaVmImageSymbol *symbols = (GigaVmImageSymbol *)(file + header.sections[GIGA_VM_IMAGE_SYMBOLS].offset);
+    char *names = (char *)(file + header.sections[GIGA_VM_IMAGE_NAMES].offset);
+    size_t name_offset = 0;
+    for (size_t index = 0; index < source->label_count; ++index) {
+        const GigaVmImageLabel *label = &source->labels[index];
+        symbols[index].name_offset = (uint32_t)name_offset;
+        symbols[index].name_length = (uint32_t)label->name_length;
+        symbols[index].address = label->address;
+        memcpy(names + name_offset, label->name, label->name_length);
+        name_offset += label->name_length + 1u; /* calloc left the NUL */
+    }
+    if (source->source_lines != NULL) {
+        uint32_t *lines = (uint32_t *)(file + header.sections[GIGA_VM_IMAGE_LINES].offset);
+        for (size_t index = 0; index < source->word_count; ++index) {
+            lines[index] = (source->source_lines[index] > UINT32_MAX) ? UINT32_MAX
+                                                                      : (uint32_t)source->source_lines[index];
+        }
+    }
+
+    /*
+     * write a fresh file beside the target and rename it, so readers see the
+     * old file or the whole new one and concurrent writers never share one
+     */
+    size_t path_length = strlen(path);
+    char *temporary = (char *)malloc(path_length + 8u);
+    if (temporary == NULL) {
+        free(file);
+        return -2;
+    }
+    snprintf(temporary, path_length + 8u, "%s.XXXXXX", path);
+    int result = -2;
+    int descriptor = mkstemp(temporary);
+    if (descriptor >= 0) {
+        size_t done = 0;
+        while (done < header.file_bytes) {
+            ssize_t count = write(descriptor, file + done, (size_t)header.file_bytes - done);
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count <= 0) {
+                break;
+            }
+            done += (size_t)count;
+        }
+        /* mkstemp creates 0600; images are as readable as other build outputs */
+        int written = done == header.file_bytes && fchmod(descriptor, 0644) == 0;
+        if (close(descriptor) == 0 && written && rename(temporary, path) == 0) {
+            result = 0;
+        } else {
+            unlink(temporary);
+        }
+    }
+    free(temporary);
+    free(file);
+    return result;
+}
+
+/* A section lies inside the file, aligned, and holds count items of item_bytes. */
+static int giga_vm_image_section_valid(const GigaVmImageSection *section, uint64_t file_bytes, uint64_t count,
+                                       size_t item_bytes) {
+    return section->offset % GIGA_VM_IMAGE_ALIGN == 0 && section->offset >= sizeof(GigaVmImageHeader) &&
+           section->offset <= file_bytes && section->bytes <= file_bytes - section->offset &&
+           section->bytes == count * item_bytes;
+}
+
+int giga_vm_image_view(const void *bytes, size_t byte_count, GigaVmImage *image) {
+    if (bytes == NULL || image == NULL || ((uintptr_t)bytes % GIGA_VM_IMAGE_ALIGN) != 0) {
+        return -1;
+    }
+    memset(image, 0, sizeof(*image));
+
+    const uint8_t *base = (const uint8_t *)bytes;
+    const GigaVmImageHeader *header = (const GigaVmImageHeader *)bytes;
+    if (byte_count < sizeof(*header) || memcmp(header->magic, GIGA_VM_IMAGE_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != GIGA_VM_IMAGE_VERSION || header->byte_order != GIGA_VM_IMAGE_BYTE_ORDER ||
+        header->decode_abi != GIGA_VM_DECODE_ABI || header->file_bytes != byte_count ||
+        header->word_count > GIGA_VM_MAX_CODE_WORDS) {
+        return -3;
+    }
+    const GigaVmImageSection *sections = header->sections;
+    uint64_t line_count = (sections[GIGA_VM_IMAGE_LINES].bytes != 0) ? header->word_count : 0u;
+    if (!giga_vm_image_section_valid(&sections[GIGA_VM_IMAGE_CODE], byte_count, header->word_count,
+                                     sizeof(uint16_t)) ||
+        !giga_vm_image_section_valid(&sections[GIGA_VM_IMAGE_DECODED], byte_count, header->word_count + 1u,
+                                     sizeof(GigaVmDecodedInstruction)) ||
+        !giga_vm_image_section_valid(&sections[GIGA_VM_IMAGE_DATA], byte_count,
+                                     sections[GIGA_VM_IMAGE_DATA].bytes, 1u) ||
+        sections[GIGA_VM_IMAGE_DATA].bytes > GIGA_VM_MEMORY_SIZE ||
+        !giga_vm_image_section_valid(&sections[GIGA_VM_IMAGE_SYMBOLS], byte_count, header->symbol_count,
+                                     sizeof(GigaVmImageSymbol)) ||
+        !giga_vm_image_section_valid(&sections[GIGA_VM_IMAGE_NAMES], byte_count,
+                                     sections[GIGA_VM_IMAGE_NAMES].bytes, 1u) ||
+        !giga_vm_image_section_valid(&sections[GIGA_VM_IMAGE_LINES], byte_count, line_count, sizeof(uint32_t))) {
+        return -3;
+    }
+
+    const GigaVmDecodedInstruction *decoded =
+        (const GigaVmDecodedInstruction *)(base + sections[GIGA_VM_IMAGE_DECODED].offset);
+    if (!giga_vm_image_decoded_valid(decoded, header->word_count)) {
+        return -3;
+    }
+
+    image->header = header;
+    image->words = (const uint16_t *)(base + sections[GIGA_VM_IMAGE_CODE].offset);
+    image->word_count = header->word_count;
+    image->decoded = decoded;
+    image->data = base + sections[GIGA_VM_IMAGE_DATA].offset;
+    image->data_bytes = (size_t)sections[GIGA_VM_IMAGE_DATA].bytes;
+    image->symbols = (const GigaVmImageSymbol *)(base + sections[GIGA_VM_IMAGE_SYMBOLS].offset);
+    image->symbol_count = header->symbol_count;
+    image->names = (const char *)(base + sections[GIGA_VM_IMAGE_NAMES].offset);
+    image->names_bytes = (size_t)sections[GIGA_VM_IMAGE_NAMES].bytes;
+    image->lines = (line_count != 0) ? (const uint32_t *)(base + sections[GIGA_VM_IMAGE_LINES].offset) : NULL;
+    return 0;
+}
+
+int giga_vm_image_open(const char *path, GigaVmImage *image) {
+    if (path == NULL || image == NULL) {
+        return -1;
+    }
+    memset(image, 0, sizeof(*image));
+
+    int descriptor = open(path, O_RDONLY);
+    if (descriptor < 0) {
+        return -2;
+    }
+    struct stat info;
+    if (fstat(descriptor, &info) != 0) {
+        close(descriptor);
+        return -2;
+    }
+    if (info.st_size < (off_t)sizeof(GigaVmImageHeader)) {
+        close(descriptor);
+        return -3;
+    }
+    size_t mapping_bytes = (size_t)info.st_size;
+    void *mapping = mmap(NULL, mapping_bytes, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    close(descriptor);
+    if (mapping == MAP_FAILED) {
+        return -2;
+    }
+
+    int result = giga_vm_image_view(mapping, mapping_bytes, image);
+    if (result != 0) {
+        munmap(mapping, mapping_bytes);
+        return result;
+    }
+    image->mapping = mapping;
+    image->mapping_bytes = mapping_bytes;
+    return 0;
+}
+
+void giga_vm_image_close(GigaVmImage *image) {
+    if (image == NULL) {
+        return;
+    }
+    if (image->mapping != NULL) {
+        munmap(image->mapping, image->mapping_bytes);
+    }
+    memset(image, 0, sizeof(*image));
+}
+
+long giga_vm_image_find_symbol(const GigaVmImage *image, const char *name) {
+    if (image == NULL || name == NULL) {
+        return -1;
+    }
+    size_t name_length = strlen(name);
+    for (size_t index = 0; index < image->symbol_count; ++index) {
+        const GigaVmImageSymbol *symbol = &image->symbols[index];
+        if (symbol->name_length == name_length && symbol->name_offset <= image->names_bytes &&
+            name_length <= image->names_bytes - symbol->name_offset &&
+            memcmp(image->names + symbol->name_offset, name, name_length) == 0) {
+            return (long)symbol->address;
+        }
+    }
+    return -1;
+}
+
+size_t giga_vm_image_source_line(const GigaVmImage *image, size_t pc) {
+    if (image == NULL || image->lines == NULL || pc >= image->word_count) {
+        return 0;
+    }
+    return image->lines[pc];
+}
+
+int giga_vm_load_image(GigaVmState *state, const GigaVmImage *image) {
+    if (state == NULL || image == NULL) {
+        return -1;
+    }
+    giga_vm_init(state);
+    memcpy(state->memory, image->data, image->data_bytes);
+    return 0;
+}
@@ -0,0 +1,680 @@
+#define _DEFAULT_SOURCE
+
+#include "vm/vm_jit.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) && defined(__unix__) && !defined(GIGA_VM_DISABLE_JIT)
+#define GIGA_VM_JIT_SUPPORTED 1
+#include <sys/mman.h>
+#else
+#define GIGA_VM_JIT_SUPPORTED 0
+#endif
+
+#if GIGA_VM_JIT_SUPPORTED
+
+/* Size of the executable code cache. */
+#define GIGA_JIT_CODE_CAPACITY (256u * 1024u)
+
+/* Longest translated block, in instructions. */
+#define GIGA_JIT_MAX_BLOCK_WORDS 64u
+
+/* Worst-case bytes emitted for one block, including exits. */
+#define GIGA_JIT_MAX_BLOCK_BYTES (GIGA_JIT_MAX_BLOCK_WORDS * 24u + 64u)
+
+/* Maximum JMP sites waiting for their target block to be compiled. */
+#define GIGA_JIT_MAX_PENDING_SITES 512u
+
+/* Program-changing stores tolerated before the JIT gives up on a program. */
+#define GIGA_JIT_MAX_FLUSHES 8u
+
+/* Steps interpreted at a time while a data bank other than 0 is selected. */
+#define GIGA_JIT_BANKED_SLICE 4096u
+
+/* Host register numbers. */
+enum {
+    GIGA_X86_RAX = 0,
+    GIGA_X86_RCX = 1,
+    GIGA_X86_RDX = 2,
+    GIGA_X86_RBX = 3,
+    GIGA_X86_RBP = 5,
+    GIGA_X86_RSI = 6,
+    GIGA_X86_RDI = 7,
+    GIGA_X86_R8 = 8
+};
+
+/*
+ * Register usage inside translated code:
+ *   r8d-r15d  VM registers R0-R7 (always masked to 4 bits)
+ *   rdi       GigaJitContext *
+ *   rsi       state->memory
+ *   rbx       remaining step budget
+ *   ebp       lazy flag kind (GigaOpcode of the last flag-setting op, 0 = none)
+ *   ecx, edx  operands of that op
+ *   eax       exit code: reason << 16 | pc
+ */
+#define GIGA_JIT_VM_REG(index) (GIGA_X86_R8 + (index))
+
+typedef struct {
+    uint32_t registers[GIGA_VM_REGISTER_COUNT];
+    uint64_t remaining_steps;
+    uint32_t flag_kind;
+    uint32_t flag_operand_a;
+    uint32_t flag_operand_b;
+} GigaJitContext;
+
+_Static_assert(offsetof(GigaJitContext, flag_operand_b) < 128, "context fields must use disp8");
+
+/* Exit reasons returned in bits [31:16] of eax. */
+enum {
+    GIGA_JIT_EXIT_LOOKUP = 1,     /* continue at pc: find or compile its block */
+    GIGA_JIT_EXIT_INTERPRET = 2,  /* run the instruction at pc in the interpreter */
+    GIGA_JIT_EXIT_BUDGET = 3      /* fewer steps left than the block at pc needs */
+};
+
+typedef uint32_t (*GigaJitEntry)(GigaJitContext *context, uint8_t *memory, const void *block);
+
+typedef struct {
+    size_t site_offset;
+    uint16_t target_pc;
+} GigaJitPendingSite;
+
+struct GigaVmJit {
+    uint8_t *code;
+    size_t code_used;
+    size_t epilogue_offset;
+    size_t trampoline_size;
+
+    /* offset of the compiled block starting at each pc, 0 when not compiled */
+    size_t block_offsets[GIGA_VM_MAX_PROGRAM_WORDS + 1];
+    uint8_t interpret_only[GIGA_VM_MAX_PROGRAM_WORDS + 1];
+
+    GigaJitPendingSite pending_sites[GIGA_JIT_MAX_PENDING_SITES];
+    size_t pending_count;
+
+    /* program the cache was built for */
+    uint8_t program_bytes[GIGA_VM_MEMORY_SIZE];
+    size_t program_words;
+    unsigned flush_count;
+    int disabled;
+};
+
+/* ------------------------------------------------------------------------ */
+/* x86-64 encoding helpers                                                  */
+/* ------------------------------------------------------------------------ */
+
+static inline void giga_jit_emit8(GigaVmJit *jit, uint8_t byte) {
+    jit->code[jit->code_used++] = byte;
+}
+
+static inline void giga_jit_emit32(GigaVmJit *jit, uint32_t value) {
+    memcpy(&jit->code[jit->code_used], &value, sizeof(value));
+    jit->code_used += sizeof(value);
+}
+
+static inline void giga_jit_emit_rex(GigaVmJit *jit, int wide, int reg, int rm) {
+    uint8_t rex = (uint8_t)(0x40 | (wide ? 0x08 : 0) | ((reg & 8) ? 0x04 : 0) | ((rm & 8) ? 0x01 : 0));
+    if (rex != 0x40) {
+        giga_jit_emit8(jit, rex);
+    }
+}
+
+/* <opcode> r/m32(dst), r32(src), e.g. 0x01 ADD, 0x89 MOV */
+static void giga_jit_emit_rr(GigaVmJit *jit, uint8_t opcode, int dst, int src) {
+    giga_jit_emit_rex(jit, 0, src, dst);
+    giga_jit_emit8(jit, opcode);
+    giga_jit_emit8(jit, (uint8_t)(0xC0 | ((src & 7) << 3) | (dst & 7)));
+}
+
+/* 0x83 /ext r/m32, imm8 */
+static void giga_jit_emit_ri8(GigaVmJit *jit, int extension, int dst, uint8_t imm) {
+    giga_jit_emit_rex(jit, 0, 0, dst);
+    giga_jit_emit8(jit, 0x83);
+    giga_jit_emit8(jit, (uint8_t)(0xC0 | (extension << 3) | (dst & 7)));
+    giga_jit_emit8(jit, imm);
+}
+
+static void giga_jit_emit_mov_imm32(GigaVmJit *jit, int dst, uint32_t imm) {
+    giga_jit_emit_rex(jit, 0, 0, dst);
+    giga_jit_emit8(jit, (uint8_t)(0xB8 | (dst & 7)));
+    giga_jit_emit32(jit, imm);
+}
+
+/* mov r32, [rdi + disp8] / mov [rdi + disp8], r32 (wide = 64-bit) */
+static void giga_jit_emit_context_access(GigaVmJit *jit, int store, int wide, int reg, uint8_t disp) {
+    giga_jit_emit_rex(jit, wide, reg, GIGA_X86_RDI);
+    giga_jit_emit8(jit, store ? 0x89 : 0x8B);
+    giga_jit_emit8(jit, (uint8_t)(0x40 | ((reg & 7) << 3) | GIGA_X86_RDI));
+    giga_jit_emit8(jit, disp);
+}
+
+/* movzx r32, byte [rsi + disp32] */
+static void giga_jit_emit_load_byte(GigaVmJit *jit, int dst, uint32_t address) {
+    giga_jit_emit_rex(jit, 0, dst, GIGA_X86_RSI);
+    giga_jit_emit8(jit, 0x0F);
+    giga_jit_emit8(jit, 0xB6);
+    giga_jit_emit8(jit, (uint8_t)(0x80 | ((dst & 7) << 3) | GIGA_X86_RSI));
+    giga_jit_emit32(jit, address);
+}
+
+/* mov byte [rsi + disp32], r8 (only used with r8b-r15b) */
+static void giga_jit_emit_store_byte(GigaVmJit *jit, int src, uint32_t address) {
+    giga_jit_emit_rex(jit, 0, src, GIGA_X86_RSI);
+    giga_jit_emit8(jit, 0x88);
+    giga_jit_emit8(jit, (uint8_t)(0x80 | ((src & 7) << 3) | GIGA_X86_RSI));
+    giga_jit_emit32(jit, address);
+}
+
+/*
+ * or word [rsi + disp32], imm16: set the GigaVmState::dirty_blocks bit for a
+ * store, addressed relative to state->memory, which rsi points at.
+ */
+static void giga_jit_emit_mark_dirty(GigaVmJit *jit, uint32_t address) {
+    uint32_t displacement = (uint32_t)(offsetof(GigaVmState, dirty_blocks) - offsetof(GigaVmState, memory));
+    uint16_t bit = GIGA_VM_DIRTY_BIT(address);
+    giga_jit_emit8(jit, 0x66);
+    giga_jit_emit8(jit, 0x81);
+    giga_jit_emit8(jit, (uint8_t)(0x80 | (1 << 3) | GIGA_X86_RSI));
+    giga_jit_emit32(jit, displacement);
+    giga_jit_emit8(jit, (uint8_t)(bit & 0xFFu));
+    giga_jit_emit8(jit, (uint8_t)(bit >> 8));
+}
+
+/* jmp rel32 to an absolute code offset */
+static void giga_jit_emit_jmp(GigaVmJit *jit, size_t target_offset) {
+    giga_jit_emit8(jit, 0xE9);
+    giga_jit_emit32(jit, (uint32_t)((int64_t)target_offset - (int64_t)(jit->code_used + 4u)));
+}
+
+static void giga_jit_patch_jmp(GigaVmJit *jit, size_t site_offset, size_t target_offset) {
+    int32_t displacement = (int32_t)((int64_t)target_offset - (int64_t)(site_offset + 5u));
+    jit->code[site_offset] = 0xE9;
+    memcpy(&jit->code[site_offset + 1u], &displacement, sizeof(displacement));
+}
+
+/* mov eax, reason << 16 | pc; jmp epilogue */
+static void giga_jit_emit_exit(GigaVmJit *jit, uint32_t reason, uint16_t pc) {
+    giga_jit_emit_mov_imm32(jit, GIGA_X86_RAX, (reason << 16) | pc);
+    giga_jit_emit_jmp(jit, jit->epilogue_offset);
+}
+
+/* ------------------------------------------------------------------------ */
+/* Code cache                                                               */
+/* ------------------------------------------------------------------------ */
+
+static int giga_jit_set_writable(GigaVmJit *jit, int writable) {
+    int protection = writable ? (PROT_READ | PROT_WRITE) : (PROT_READ | PROT_EXEC);
+    return mprotect(jit->code, GIGA_JIT_CODE_CAPACITY, protection);
+}
+
+/*
+ * Trampoline at offset 0: save callee-saved registers, load the VM context
+ * into host registers and jump to the block in rdx. The epilogue stores the
+ * context back and returns the exit code left in eax.
+ */
+static void giga_jit_emit_trampoline(GigaVmJit *jit) {
+    static const uint8_t saves[] = {0x53, 0x55, 0x41, 0x54, 0x41, 0x55, 0x41, 0x56, 0x41, 0x57};
+    static const uint8_t restores[] = {0x41, 0x5F, 0x41, 0x5E, 0x41, 0x5D, 0x41, 0x5C, 0x5D, 0x5B, 0xC3};
+
+    jit->code_used = 0;
+    memcpy(jit->code, saves, sizeof(saves));
+    jit->code_used += sizeof(saves);
+    for (int index = 0; index < GIGA_VM_REGISTER_COUNT; ++index) {
+        giga_jit_emit_context_access(jit, 0, 0, GIGA_JIT_VM_REG(index),
+                                     (uint8_t)(offsetof(GigaJitContext, registers) + 4u * (unsigned)index));
+    }
+    giga_jit_emit_context_access(jit, 0, 1, GIGA_X86_RBX, offsetof(GigaJitContext, remaining_steps));
+    giga_jit_emit_context_access(jit, 0, 0, GIGA_X86_RBP, offsetof(GigaJitContext, flag_kind));
+    giga_jit_emit_context_access(jit, 0, 0, GIGA_X86_RCX, offsetof(GigaJitContext, flag_operand_a));
+    /* rdx holds the block address, so move it aside before loading operand b */
+    giga_jit_emit8(jit, 0x48);                               /* mov rax, rdx */
+    giga_jit_emit_rr(jit, 0x89, GIGA_X86_RAX, GIGA_X86_RDX);
+    giga_jit_emit_context_access(jit, 0, 0, GIGA_X86_RDX, offsetof(GigaJitContext, flag_operand_b));
+    giga_jit_emit8(jit, 0xFF);                               /* jmp rax */
+    giga_jit_emit8(jit, 0xE0);
+
+    jit->epilogue_offset = jit->code_used;
+    for (int index = 0; index < GIGA_VM_REGISTER_COUNT; ++index) {
+        giga_jit_emit_context_access(jit, 1, 0, GIGA_JIT_VM_REG(index),
+                                     (uint8_t)(offsetof(GigaJitContext, registers) + 4u * (unsigned)index));
+    }
+    giga_jit_emit_context_access(jit, 1, 1, GIGA_X86_RBX, offsetof(GigaJitContext, remaining_steps));
+    giga_jit_emit_context_access(jit, 1, 0, GIGA_X86_RBP, offsetof(GigaJitContext, flag_kind));
+    giga_jit_emit_context_access(jit, 1, 0, GIGA_X86_RCX, offsetof(GigaJitContext, flag_operand_a));
+    giga_jit_emit_context_access(jit, 1, 0, GIGA_X86_RDX, offsetof(GigaJitContext, flag_operand_b));
+    memcpy(&jit->code[jit->code_used], restores, sizeof(restores));
+    jit->code_used += sizeof(restores);
+    jit->trampoline_size = jit->code_used;
+}
+
+static void giga_jit_flush(GigaVmJit *jit) {
+    memset(jit->block_offsets, 0, sizeof(jit->block_offsets));
+    memset(jit->interpret_only, 0, sizeof(jit->interpret_only));
+    jit->pending_count = 0;
+    jit->code_used = jit->trampoline_size;
+}
+
+/*
+ * Rebuild the cache when @p state holds a different program than the one
+ * it was compiled from.
+ */
+static void giga_jit_sync_program(GigaVmJit *jit, const GigaVmState *state) {
+    size_t program_bytes = state->loaded_program_words * 2u;
+    if (jit->program_words == state->loaded_program_words &&
+        memcmp(jit->program_bytes, state->memory, program_bytes) == 0) {
+        return;
+    }
+    giga_jit_flush(jit);
+    memcpy(jit->program_bytes, state->memory, program_bytes);
+    jit->program_words = state->loaded_program_words;
+    jit->flush_count = 0;
+    jit->disabled = 0;
+}
+
+/* ------------------------------------------------------------------------ */
+/* Translation                                                              */
+/* ------------------------------------------------------------------------ */
+
+static inline GigaInstruction giga_jit_read_instruction(const GigaVmJit *jit, size_t pc) {
+    uint16_t raw_word = (uint16_t)(((uint16_t)jit->program_bytes[pc * 2u + 1u] << 8) |
+                                   jit->program_bytes[pc * 2u]);
+    return giga_decode_instruction(raw_word);
+}
+
+static int giga_jit_sets_flags(GigaOpcode opcode) {
+    return opcode >= GIGA_OP_ADD && opcode <= GIGA_OP_SHR;
+}
+
+/*
+ * Instructions translated inline. Anything else ends the block with an
+ * interpreter exit.
+ */
+static int giga_jit_translatable(const GigaVmJit *jit, GigaInstruction instruction) {
+    switch (instruction.opcode) {
+        case GIGA_OP_NOP:
+        case GIGA_OP_MOV:
+        case GIGA_OP_MOVI:
+        case GIGA_OP_ADD:
+        case GIGA_OP_SUB:
+        case GIGA_OP_AND:
+        case GIGA_OP_OR:
+        case GIGA_OP_XOR:
+        case GIGA_OP_NOT:
+        case GIGA_OP_SHL:
+        case GIGA_OP_SHR:
+        case GIGA_OP_LD:
+            return 1;
+        case GIGA_OP_ST:
+            return (size_t)((instruction.dest_reg << 4) | instruction.imm4) >= jit->program_words * 2u;
+        case GIGA_OP_JMP:
+            return (instruction.raw & 0x0FFFu) < jit->program_words;
+        default:
+            return 0;
+    }
+}
+
+static void giga_jit_emit_instruction(GigaVmJit *jit, GigaInstruction instruction, int record_flags) {
+    int dest = GIGA_JIT_VM_REG(instruction.dest_reg & (GIGA_VM_REGISTER_COUNT - 1u));
+    int src = GIGA_JIT_VM_REG(instruction.src_reg & (GIGA_VM_REGISTER_COUNT - 1u));
+
+    if (record_flags) {
+        giga_jit_emit_rr(jit, 0x89, GIGA_X86_RCX, dest);
+        giga_jit_emit_rr(jit, 0x89, GIGA_X86_RDX, src);
+        giga_jit_emit_mov_imm32(jit, GIGA_X86_RBP, (uint32_t)instruction.opcode);
+    }
+
+    switch (instruction.opcode) {
+        case GIGA_OP_MOV:
+            giga_jit_emit_rr(jit, 0x89, dest, src);
+            break;
+        case GIGA_OP_MOVI:
+            giga_jit_emit_mov_imm32(jit, dest, instruction.imm4);
+            break;
+        case GIGA_OP_ADD:
+            giga_jit_emit_rr(jit, 0x01, dest, src);
+            giga_jit_emit_ri8(jit, 4, dest, 0x0F);
+            break;
+        case GIGA_OP_SUB:
+            giga_jit_emit_rr(jit, 0x29, dest, src);
+            giga_jit_emit_ri8(jit, 4, dest, 0x0F);
+            break;
+        case GIGA_OP_AND:
+            giga_jit_emit_rr(jit, 0x21, dest, src);
+            break;
+        case GIGA_OP_OR:
+            giga_jit_emit_rr(jit, 0x09, dest, src);
+            break;
+        case GIGA_OP_XOR:
+            giga_jit_emit_rr(jit, 0x31, dest, src);
+            break;
+        case GIGA_OP_NOT:
+            giga_jit_emit_ri8(jit, 6, dest, 0x0F);
+            break;
+        case GIGA_OP_SHL:
+            giga_jit_emit_rr(jit, 0x01, dest, dest);
+            giga_jit_emit_ri8(jit, 4, dest, 0x0F);
+            break;
+        case GIGA_OP_SHR:
+            giga_jit_emit_rex(jit, 0, 0, dest);
+            giga_jit_emit8(jit, 0xD1);
+            giga_jit_emit8(jit, (uint8_t)(0xE8 | (dest & 7)));
+            break;
+        case GIGA_OP_LD:
+            giga_jit_emit_load_byte(jit, dest, (uint32_t)((instruction.src_reg << 4) | instruction.imm4));
+            giga_jit_emit_ri8(jit, 4, dest, 0x0F);
+            break;
+        case GIGA_OP_ST: {
+            uint32_t address = (uint32_t)((instruction.dest_reg << 4) | instruction.imm4);
+            giga_jit_emit_store_byte(jit, src, address);
+            giga_jit_emit_mark_dirty(jit, address);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+/*
+ * Emit a jump to target_pc: direct when the target is compiled, otherwise a
+ * lookup exit that is patched into a direct jump once it is.
+ */
+static int giga_jit_emit_chain(GigaVmJit *jit, uint16_t target_pc) {
+    if (jit->block_offsets[target_pc] != 0) {
+        giga_jit_emit_jmp(jit, jit->block_offsets[target_pc]);
+        return 0;
+    }
+    if (jit->pending_count >= GIGA_JIT_MAX_PENDING_SITES) {
+        return -1;
+    }
+    jit->pending_sites[jit->pending_count].site_offset = jit->code_used;
+    jit->pending_sites[jit->pending_count].target_pc = target_pc;
+    ++jit->pending_count;
+    giga_jit_emit_exit(jit, GIGA_JIT_EXIT_LOOKUP, target_pc);
+    return 0;
+}
+
+/*
+ * Translate the block starting at pc. Returns its code offset, or 0 when the
+ * first instruction must be interpreted or the cache is full.
+ */
+static size_t giga_jit_compile_block(GigaVmJit *jit, uint16_t start_pc) {
+    /* find the block extent and its last flag-setting instruction */
+    size_t end_pc = start_pc;
+    size_t last_flag_pc = SIZE_MAX;
+    int ends_with_jump = 0;
+    while (end_pc < jit->program_words && end_pc - start_pc < GIGA_JIT_MAX_BLOCK_WORDS) {
+        GigaInstruction instruction = giga_jit_read_instruction(jit, end_pc);
+        if (!giga_jit_translatable(jit, instruction)) {
+            break;
+        }
+        if (giga_jit_sets_flags(instruction.opcode)) {
+            last_flag_pc = end_pc;
+        }
+        ++end_pc;
+        if (instruction.opcode == GIGA_OP_JMP) {
+            ends_with_jump = 1;
+            break;
+        }
+    }
+
+    uint32_t block_steps = (uint32_t)(end_pc - start_pc);
+    if (block_steps == 0) {
+        return 0;
+    }
+    if (jit->code_used + GIGA_JIT_MAX_BLOCK_BYTES > GIGA_JIT_CODE_CAPACITY) {
+        return 0;
+    }
+
+    size_t block_offset = jit->code_used;
+
+    /* sub rbx, block_steps; jb budget_exit */
+    giga_jit_emit8(jit, 0x48);
+    giga_jit_emit8(jit, 0x81);
+    giga_jit_emit8(jit, 0xEB);
+    giga_jit_emit32(jit, block_steps);
+    giga_jit_emit8(jit, 0x0F);
+    giga_jit_emit8(jit, 0x82);
+    size_t budget_branch = jit->code_used;
+    giga_jit_emit32(jit, 0);
+
+    GigaInstruction last_instruction = giga_jit_read_instruction(jit, start_pc);
+    for (size_t pc = start_pc; pc < end_pc; ++pc) {
+        last_instruction = giga_jit_read_instruction(jit, pc);
+        if (last_instruction.opcode != GIGA_OP_JMP) {
+            giga_jit_emit_instruction(jit, last_instruction, pc == last_flag_pc);
+        }
+    }
+
+    int chain_result = 0;
+    if (ends_with_jump) {
+        chain_result = giga_jit_emit_chain(jit, (uint16_t)(last_instruction.raw & 0x0FFFu));
+    } else if (end_pc - start_pc == GIGA_JIT_MAX_BLOCK_WORDS && end_pc < jit->program_words) {
+        chain_result = giga_jit_emit_chain(jit, (uint16_t)end_pc);
+    } else {
+        giga_jit_emit_exit(jit, GIGA_JIT_EXIT_INTERPRET, (uint16_t)end_pc);
+    }
+    if (chain_result != 0) {
+        jit->code_used = block_offset;
+        return 0;
+    }
+
+    /* budget_exit: add rbx, block_steps; exit at start_pc */
+    int32_t displacement = (int32_t)(jit->code_used - (budget_branch + 4u));
+    memcpy(&jit->code[budget_branch], &displacement, sizeof(displacement));
+    giga_jit_emit8(jit, 0x48);
+    giga_jit_emit8(jit, 0x81);
+    giga_jit_emit8(jit, 0xC3);
+    giga_jit_emit32(jit, block_steps);
+    giga_jit_emit_exit(jit, GIGA_JIT_EXIT_BUDGET, start_pc);
+
+    jit->block_offsets[start_pc] = block_offset;
+
+    /* link jumps that were waiting for this block */
+    size_t kept = 0;
+    for (size_t index = 0; index < jit->pending_count; ++index) {
+        if (jit->pending_sites[index].target_pc == start_pc) {
+            giga_jit_patch_jmp(jit, jit->pending_sites[index].site_offset, block_offset);
+        } else {
+            jit->pending_sites[kept++] = jit->pending_sites[index];
+        }
+    }
+    jit->pending_count = kept;
+
+    return block_offset;
+}
+
+/* ------------------------------------------------------------------------ */
+/* Execution                                                                */
+/* ------------------------------------------------------------------------ */
+
+static void giga_jit_materialize_flags(GigaVmState *state, const GigaJitContext *context) {
+    uint8_t operand_a = (uint8_t)context->flag_operand_a;
+    uint8_t operand_b = (uint8_t)context->flag_operand_b;
+    AluResult flags;
+    switch ((GigaOpcode)context->flag_kind) {
+        case GIGA_OP_ADD: flags = alu_add(operand_a, operand_b); break;
+        case GIGA_OP_SUB: flags = alu_sub(operand_a, operand_b); break;
+        case GIGA_OP_AND: flags = alu_and(operand_a, operand_b); break;
+        case GIGA_OP_OR:  flags = alu_or(operand_a, operand_b); break;
+        case GIGA_OP_XOR: flags = alu_xor(operand_a, operand_b); break;
+        case GIGA_OP_NOT: flags = alu_not(operand_a); break;
+        case GIGA_OP_SHL: flags = alu_shl(operand_a); break;
+        case GIGA_OP_SHR: flags = alu_shr(operand_a); break;
+        default: return;
+    }
+    state->flags_zero = flags.zero_flag;
+    state->flags_carry = flags.carry_flag;
+    state->flags_negative = flags.negative_flag;
+    state->flags_overflow = flags.overflow_flag;
+}
+
+static uint32_t giga_jit_enter(GigaVmJit *jit, GigaVmState *state, size_t block_offset, uint64_t *remaining_steps) {
+    GigaJitContext context;
+    for (size_t index = 0; index < GIGA_VM_REGISTER_COUNT; ++index) {
+        context.registers[index] = state->registers[index];
+    }
+    context.remaining_steps = *remaining_steps;
+    context.flag_kind = 0;
+    context.flag_operand_a = 0;
+    context.flag_operand_b = 0;
+
+    GigaJitEntry entry;
+    void *trampoline = jit->code;
+    memcpy(&entry, &trampoline, sizeof(entry));
+    uint32_t exit_code = entry(&context, state->memory, jit->code + block_offset);
+
+    for (size_t index = 0; index < GIGA_VM_REGISTER_COUNT; ++index) {
+        state->registers[index] = (uint8_t)context.registers[index];
+    }
+    giga_jit_materialize_flags(state, &context);
+    *remaining_steps = context.remaining_steps;
+    return exit_code;
+}
+
+int giga_vm_jit_available(void) {
+    return 1;
+}
+
+GigaVmJit *giga_vm_jit_create(void) {
+    GigaVmJit *jit = (GigaVmJit *)calloc(1, sizeof(GigaVmJit));
+    if (jit == NULL) {
+        return NULL;
+    }
+    void *pages = mmap(NULL, GIGA_JIT_CODE_CAPACITY, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (pages == MAP_FAILED) {
+        free(jit);
+        return NULL;
+    }
+    jit->code = (uint8_t *)pages;
+    giga_jit_emit_trampoline(jit);
+    giga_jit_flush(jit);
+    if (giga_jit_set_writable(jit, 0) != 0) {
+        giga_vm_jit_destroy(jit);
+        return NULL;
+    }
+    return jit;
+}
+
+void giga_vm_jit_destroy(GigaVmJit *jit) {
+    if (jit == NULL) {
+        return;
+    }
+    if (jit->code != NULL) {
+        munmap(jit->code, GIGA_JIT_CODE_CAPACITY);
+    }
+    free(jit);
+}
+
+/*
+ * Code offset of the block starting at pc, compiling it on first use.
+ * Returns 0 when the instruction at pc has to be interpreted.
+ */
+static size_t giga_jit_lookup_block(GigaVmJit *jit, uint16_t pc) {
+    size_t block_offset = jit->block_offsets[pc];
+    if (block_offset != 0 || jit->interpret_only[pc]) {
+        return block_offset;
+    }
+    if (giga_jit_set_writable(jit, 1) != 0) {
+        return 0;
+    }
+    if (jit->code_used + GIGA_JIT_MAX_BLOCK_BYTES > GIGA_JIT_CODE_CAPACITY ||
+        jit->pending_count >= GIGA_JIT_MAX_PENDING_SITES) {
+        giga_jit_flush(jit);
+    }
+    block_offset = giga_jit_compile_block(jit, pc);
+    giga_jit_set_writable(jit, 0);
+    if (block_offset == 0) {
+        jit->interpret_only[pc] = 1;
+    }
+    return block_offset;
+}
+
+/* After interpreted steps: a self-modifying store drops every translation of the old code. */
+static void giga_jit_check_program(GigaVmJit *jit, const GigaVmState *state) {
+    if (memcmp(jit->program_bytes, state->memory, jit->program_words * 2u) != 0) {
+        memcpy(jit->program_bytes, state->memory, jit->program_words * 2u);
+        giga_jit_flush(jit);
+        if (++jit->flush_count > GIGA_JIT_MAX_FLUSHES) {
+            jit->disabled = 1;
+        }
+    }
+}
+
+GigaVmStatus giga_vm_jit_run(GigaVmJit *jit, GigaVmState *state, uint64_t max_steps) {
+    if (jit == NULL || state == NULL) {
+        return giga_vm_run(state, max_steps);
+    }
+
+    giga_jit_sync_program(jit, state);
+    uint64_t remaining_steps = max_steps;
+
+    for (;;) {
+        if (state->data_bank != 0) {
+            /* translated LD/ST address bank 0, so interpret until the program selects it again */
+            uint64_t slice = (remaining_steps < GIGA_JIT_BANKED_SLICE) ? remaining_steps : GIGA_JIT_BANKED_SLICE;
+            GigaVmStatus status = giga_vm_run(state, slice);
+            if (status != GIGA_VM_STATUS_STEP_LIMIT || slice == remaining_steps) {
+                return status;
+            }
+            remaining_steps -= slice;
+            giga_jit_check_program(jit, state);
+            continue;
+        }
+
+        uint16_t pc = state->program_counter;
+        if (jit->disabled || pc >= jit->program_words) {
+            return giga_vm_run(state, remaining_steps);
+        }
+
+        size_t block_offset = giga_jit_lookup_block(jit, pc);
+        if (block_offset != 0) {
+            uint32_t exit_code = giga_jit_enter(jit, state, block_offset, &remaining_steps);
+            state->program_counter = (uint16_t)(exit_code & 0xFFFFu);
+            uint32_t reason = exit_code >> 16;
+            if (reason == GIGA_JIT_EXIT_BUDGET) {
+                return giga_vm_run(state, remaining_steps);
+            }
+            if (reason == GIGA_JIT_EXIT_LOOKUP) {
+                continue;
+            }
+            if (state->program_counter >= jit->program_words) {
+                continue;
+            }
+        }
+
+        /* interpret the instruction at the current pc */
+        if (remaining_steps == 0) {
+            return GIGA_VM_STATUS_STEP_LIMIT;
+        }
+        GigaVmStatus status = giga_vm_step(state);
+        --remaining_steps;
+        if (status != GIGA_VM_STATUS_RUNNING) {
+            return status;
+        }
+        giga_jit_check_program(jit, state);
+    }
+}
+
+#else /* !GIGA_VM_JIT_SUPPORTED */
+
+int giga_vm_jit_available(void) {
+    return 0;
+}
+
+GigaVmJit *giga_vm_jit_create(void) {
+    return NULL;
+}
+
+void giga_vm_jit_destroy(GigaVmJit *jit) {
+    (void)jit;
+}
+
+GigaVmStatus giga_vm_jit_run(GigaVmJit *jit, GigaVmState *state, uint64_t max_steps) {
+    (void)jit;
+    return giga_vm_run(state, max_steps);
+}
+
+#endif /* GIGA_VM_JIT_SUPPORTED */
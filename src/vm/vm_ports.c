@@ -0,0 +1,70 @@
+#define _DEFAULT_SOURCE
+
+#include "vm/vm_ports.h"
+
+#include <stdlib.h>
+#include <sys/mman.h>
+
+/* Reserve address space only; pages are backed when first written. */
+#ifdef MAP_NORESERVE
+#define GIGA_VM_PORTS_MAP_FLAGS (MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE)
+#else
+#define GIGA_VM_PORTS_MAP_FLAGS (MAP_PRIVATE | MAP_ANONYMOUS)
+#endif
+
+static void giga_vm_ring_init(GigaVmRing *ring, uint8_t *data, size_t capacity) {
+    ring->data = data;
+    ring->mask = capacity - 1u;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    ring->cached_tail = 0;
+    ring->cached_head = 0;
+}
+
+GigaVmPorts *giga_vm_ports_create(size_t capacity) {
+    if (capacity < 2u || (capacity & (capacity - 1u)) != 0 ||
+        capacity > SIZE_MAX / (2u * GIGA_VM_PORT_COUNT)) {
+        return NULL;
+    }
+    GigaVmPorts *ports = NULL;
+    if (posix_memalign((void **)&ports, 64, sizeof(*ports)) != 0) {
+        return NULL;
+    }
+    ports->mapping_bytes = 2u * GIGA_VM_PORT_COUNT * capacity;
+    void *mapping = mmap(NULL, ports->mapping_bytes, PROT_READ | PROT_WRITE, GIGA_VM_PORTS_MAP_FLAGS, -1, 0);
+    if (mapping == MAP_FAILED) {
+        free(ports);
+        return NULL;
+    }
+    ports->mapping = (uint8_t *)mapping;
+    for (size_t port = 0; port < GIGA_VM_PORT_COUNT; ++port) {
+        giga_vm_ring_init(&ports->input[port], ports->mapping + (2u * port) * capacity, capacity);
+        giga_vm_ring_init(&ports->output[port], ports->mapping + (2u * port + 1u) * capacity, capacity);
+    }
+    return ports;
+}
+
+void giga_vm_ports_destroy(GigaVmPorts *ports) {
+    if (ports == NULL) {
+        return;
+    }
+    munmap(ports->mapping, ports->mapping_bytes);
+    free(ports);
+}
+
+void giga_vm_ports_reset(GigaVmPorts *ports) {
+    if (ports == NULL) {
+        return;
+    }
+    for (size_t port = 0; port < GIGA_VM_PORT_COUNT; ++port) {
+        giga_vm_ring_init(&ports->input[port], ports->input[port].data, ports->input[port].mask + 1u);
+        giga_vm_ring_init(&ports->output[port], ports->output[port].data, ports->output[port].mask + 1u);
+    }
+}
+
+void giga_vm_attach_ports(GigaVmState *state, GigaVmPorts *ports) {
+    if (state == NULL) {
+        return;
+    }
+    state->ports = ports;
+}
@@ -0,0 +1,151 @@
+#include "vm/vm_profile.h"
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *const giga_vm_profile_opcode_names[GIGA_VM_PROFILE_OPCODE_SLOTS] = {
+    "NOP", "MOV", "MOVI", "ADD", "SUB", "AND", "OR", "XOR",
+    "NOT", "SHL", "SHR", "LD", "ST", "JMP", "EXT", "HALT"
+};
+
+void giga_vm_profile_reset(GigaVmProfile *profile) {
+    if (profile != NULL) {
+        memset(profile, 0, sizeof(*profile));
+    }
+}
+
+static GigaInstruction giga_vm_profile_word(const GigaVmState *state, size_t pc) {
+    return giga_decode_instruction((uint16_t)(((uint16_t)state->memory[pc * 2u + 1u] << 8) |
+                                              state->memory[pc * 2u]));
+}
+
+/* Target of a JMP or conditional branch word, or -1 for other instructions. */
+static long giga_vm_profile_jump_target(GigaInstruction instruction) {
+    if (instruction.opcode == GIGA_OP_JMP) {
+        return (long)(instruction.raw & 0x0FFFu);
+    }
+    if (instruction.opcode == GIGA_OP_EXT && GIGA_EXT_IS_BRANCH(instruction.dest_reg)) {
+        return (long)(instruction.raw & 0x00FFu);
+    }
+    return -1;
+}
+
+static int giga_vm_profile_compare_blocks(const void *left, const void *right) {
+    const GigaVmHotBlock *a = (const GigaVmHotBlock *)left;
+    const GigaVmHotBlock *b = (const GigaVmHotBlock *)right;
+    if (a->instruction_count != b->instruction_count) {
+        return (a->instruction_count < b->instruction_count) ? 1 : -1;
+    }
+    return (int)a->first_pc - (int)b->first_pc;
+}
+
+size_t giga_vm_profile_hot_blocks(const GigaVmProfile *profile, const GigaVmState *state,
+                                  GigaVmHotBlock *blocks, size_t max_blocks) {
+    if (profile == NULL || state == NULL || blocks == NULL) {
+        return 0;
+    }
+    size_t word_count = state->loaded_program_words;
+
+    uint8_t jump_target[GIGA_VM_MAX_PROGRAM_WORDS] = {0};
+    for (size_t pc = 0; pc < word_count; ++pc) {
+        long target = giga_vm_profile_jump_target(giga_vm_profile_word(state, pc));
+        if (target >= 0 && (size_t)target < word_count) {
+            jump_target[target] = 1;
+        }
+    }
+
+    GigaVmHotBlock found[GIGA_VM_MAX_PROGRAM_WORDS];
+    size_t found_count = 0;
+    int block_open = 0;
+    for (size_t pc = 0; pc < word_count; ++pc) {
+        uint64_t count = profile->pc_counts[pc];
+        GigaVmHotBlock *current = &found[found_count - (block_open ? 1u : 0u)];
+        if (block_open && (jump_target[pc] || count != current->entry_count)) {
+            block_open = 0;
+        }
+        if (count != 0) {
+            if (!block_open) {
+                current = &found[found_count++];
+                current->first_pc = (uint16_t)pc;
+                current->entry_count = count;
+                current->instruction_count = 0;
+                block_open = 1;
+            }
+            current->last_pc = (uint16_t)pc;
+            current->instruction_count += count;
+        }
+
+        GigaInstruction instruction = giga_vm_profile_word(state, pc);
+        if (instruction.opcode == GIGA_OP_HALT || giga_vm_profile_jump_target(instruction) >= 0) {
+            block_open = 0;
+        }
+    }
+
+    qsort(found, found_count, sizeof(found[0]), giga_vm_profile_compare_blocks);
+    if (found_count > max_blocks) {
+        found_count = max_blocks;
+    }
+    memcpy(blocks, found, found_count * sizeof(found[0]));
+    return found_count;
+}
+
+/* " (line a)" or " (lines a-b)" for a range of words, nothing without lines. */
+static void giga_vm_profile_write_lines(const size_t *source_lines, size_t first_pc, size_t last_pc, FILE *output) {
+    if (source_lines == NULL) {
+        return;
+    }
+    if (source_lines[first_pc] == source_lines[last_pc]) {
+        fprintf(output, " (line %zu)", source_lines[first_pc]);
+    } else {
+        fprintf(output, " (lines %zu-%zu)", source_lines[first_pc], source_lines[last_pc]);
+    }
+}
+
+int giga_vm_profile_write_report(const GigaVmProfile *profile, const GigaVmState *state,
+                                 const size_t *source_lines, size_t max_blocks, FILE *output) {
+    if (profile == NULL || state == NULL || output == NULL) {
+        return -1;
+    }
+    size_t word_count = state->loaded_program_words;
+    uint64_t total = 0;
+    for (size_t pc = 0; pc < word_count; ++pc) {
+        total += profile->pc_counts[pc];
+    }
+
+    GigaVmHotBlock blocks[GIGA_VM_MAX_PROGRAM_WORDS];
+    size_t block_count = giga_vm_profile_hot_blocks(profile, state, blocks,
+                                                    max_blocks < GIGA_VM_MAX_PROGRAM_WORDS ? max_blocks
+                                                                                           : GIGA_VM_MAX_PROGRAM_WORDS);
+    fprintf(output, "profile: %" PRIu64 " instructions\n", total);
+    fprintf(output, "hot blocks:\n");
+    for (size_t index = 0; index < block_count; ++index) {
+        const GigaVmHotBlock *block = &blocks[index];
+        double share = (total != 0) ? 100.0 * (double)block->instruction_count / (double)total : 0.0;
+        fprintf(output, "  %2zu. pc %u-%u: %" PRIu64 " instructions (%.1f%%), entered %" PRIu64 "x",
+                index + 1u, block->first_pc, block->last_pc, block->instruction_count, share,
+                block->entry_count);
+        giga_vm_profile_write_lines(source_lines, block->first_pc, block->last_pc, output);
+        fputc('\n', output);
+    }
+
+    fprintf(output, "taken jumps:\n");
+    for (size_t pc = 0; pc < word_count; ++pc) {
+        if (profile->jump_counts[pc] == 0) {
+            continue;
+        }
+        fprintf(output, "  pc %zu -> %ld: %" PRIu64, pc, giga_vm_profile_jump_target(giga_vm_profile_word(state, pc)),
+                profile->jump_counts[pc]);
+        giga_vm_profile_write_lines(source_lines, pc, pc, output);
+        fputc('\n', output);
+    }
+
+    fprintf(output, "opcodes:\n");
+    for (size_t opcode = 0; opcode < GIGA_VM_PROFILE_OPCODE_SLOTS; ++opcode) {
+        if (profile->opcode_counts[opcode] != 0) {
+            fprintf(output, "  %-4s %" PRIu64 "\n", giga_vm_profile_opcode_names[opcode],
+                    profile->opcode_counts[opcode]);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,564 @@
+#define _DEFAULT_SOURCE
+
+#include "vm/vm_trace.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* Records encoded in memory before one copy into the mapped ring. */
+#define GIGA_VM_TRACE_BATCH_BYTES (64u * 1024u)
+
+/* Smallest traced run worth starting before the batch is flushed. */
+#define GIGA_VM_TRACE_MIN_CHUNK 1024u
+
+/* Fault the whole ring in up front so flushes never take page faults. */
+#ifdef MAP_POPULATE
+#define GIGA_VM_TRACE_MAP_FLAGS (MAP_SHARED | MAP_POPULATE)
+#else
+#define GIGA_VM_TRACE_MAP_FLAGS MAP_SHARED
+#endif
+
+/* Longest JMP varint: a zigzag-encoded 32-bit delta. */
+#define GIGA_VM_TRACE_MAX_VARINT_BYTES 5u
+
+static const char giga_vm_trace_magic[8] = {'G', 'I', 'G', 'A', 'T', 'R', 'C', '1'};
+
+/*
+ * File layout: this header, keyframe_slots index entries, then the ring.
+ * Header and index use host byte order. Record bytes live at stream offset
+ * o, in ring[o % capacity]; only the last capacity bytes before
+ * written_bytes are present.
+ */
+typedef struct {
+    char magic[8];
+    uint64_t capacity;              /* ring size in bytes */
+    uint64_t keyframe_slots;        /* entries in the keyframe index */
+    uint64_t written_bytes;         /* record bytes ever written */
+    uint64_t instruction_count;     /* instructions recorded in those bytes */
+    uint64_t keyframe_count;        /* keyframes ever written; k is in slot k % keyframe_slots */
+} GigaVmTraceFileHeader;
+
+typedef struct {
+    uint64_t instruction_index;     /* instructions retired before the keyframe */
+    uint64_t offset;                /* stream offset of its tag byte */
+} GigaVmTraceKeyframeEntry;
+
+struct GigaVmTraceWriter {
+    int fd;
+    uint8_t *mapping;
+    size_t mapping_bytes;
+    GigaVmTraceFileHeader *header;
+    GigaVmTraceKeyframeEntry *keyframes;
+    uint8_t *ring;
+    uint64_t capacity;
+    uint64_t keyframe_slots;
+    uint64_t flushed_bytes;         /* stream offset of batch[0] */
+    uint64_t instruction_count;
+    uint64_t keyframe_count;
+    uint64_t next_keyframe;         /* instruction index of the next periodic keyframe */
+    int has_last_frame;
+    uint8_t last_frame[GIGA_VM_TRACE_KEYFRAME_BYTES]; /* state where the last run stopped */
+    size_t batch_used;
+    uint8_t batch[GIGA_VM_TRACE_BATCH_BYTES];
+};
+
+struct GigaVmReplay {
+    uint8_t *mapping;
+    size_t mapping_bytes;
+    const GigaVmTraceKeyframeEntry *keyframes;
+    const uint8_t *ring;
+    uint64_t capacity;
+    uint64_t keyframe_slots;
+    uint64_t written_bytes;
+    uint64_t instruction_count;
+    uint64_t keyframe_count;
+    int positioned;                 /* a seek succeeded; offset and index are valid */
+    uint64_t offset;                /* stream offset of the next record */
+    uint64_t index;                 /* instructions applied to reach offset */
+};
+
+static size_t giga_vm_trace_file_bytes(uint64_t capacity, uint64_t keyframe_slots) {
+    return sizeof(GigaVmTraceFileHeader) + (size_t)keyframe_slots * sizeof(GigaVmTraceKeyframeEntry) +
+           (size_t)capacity;
+}
+
+static void giga_vm_trace_put_u64(uint8_t *out, uint64_t value) {
+    for (size_t index = 0; index < 8u; ++index) {
+        out[index] = (uint8_t)(value >> (8u * index));
+    }
+}
+
+/*
+ * Keyframe record for a state. Fields follow the layout in vm_trace.h;
+ * the instruction index is left to the caller.
+ */
+static void giga_vm_trace_encode_state(const GigaVmState *state, uint8_t *frame) {
+    uint8_t *out = frame;
+    *out++ = GIGA_VM_TRACE_TAG_KEYFRAME;
+    memset(out, 0, 8u);
+    out += 8u;
+    for (size_t index = 0; index < GIGA_VM_REGISTER_COUNT; ++index) {
+        *out++ = (uint8_t)(state->registers[index] & 0x0Fu);
+    }
+    *out++ = (uint8_t)((state->flags_zero ? GIGA_VM_PACKED_FLAG_ZERO : 0u) |
+                       (state->flags_carry ? GIGA_VM_PACKED_FLAG_CARRY : 0u) |
+                       (state->flags_negative ? GIGA_VM_PACKED_FLAG_NEGATIVE : 0u) |
+                       (state->flags_overflow ? GIGA_VM_PACKED_FLAG_OVERFLOW : 0u));
+    *out++ = (uint8_t)(state->program_counter & 0xFFu);
+    *out++ = (uint8_t)(state->program_counter >> 8);
+    *out++ = (uint8_t)state->loaded_program_words;
+    memcpy(out, state->memory, GIGA_VM_MEMORY_SIZE);
+}
+
+GigaVmTraceWriter *giga_vm_trace_create(const char *path, size_t capacity) {
+    if (path == NULL || capacity < GIGA_VM_TRACE_MIN_CAPACITY) {
+        return NULL;
+    }
+    GigaVmTraceWriter *writer = (GigaVmTraceWriter *)calloc(1, sizeof(*writer));
+    if (writer == NULL) {
+        return NULL;
+    }
+
+    /* every keyframe still in the ring or the batch keeps its index slot */
+    writer->capacity = capacity;
+    writer->keyframe_slots = (capacity + GIGA_VM_TRACE_BATCH_BYTES) / GIGA_VM_TRACE_KEYFRAME_BYTES + 2u;
+    writer->mapping_bytes = giga_vm_trace_file_bytes(writer->capacity, writer->keyframe_slots);
+
+    writer->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (writer->fd < 0) {
+        free(writer);
+        return NULL;
+    }
+    if (ftruncate(writer->fd, (off_t)writer->mapping_bytes) != 0) {
+        close(writer->fd);
+        free(writer);
+        return NULL;
+    }
+    void *mapping = mmap(NULL, writer->mapping_bytes, PROT_READ | PROT_WRITE, GIGA_VM_TRACE_MAP_FLAGS,
+                         writer->fd, 0);
+    if (mapping == MAP_FAILED) {
+        close(writer->fd);
+        free(writer);
+        return NULL;
+    }
+
+    writer->mapping = (uint8_t *)mapping;
+    writer->header = (GigaVmTraceFileHeader *)mapping;
+    writer->keyframes = (GigaVmTraceKeyframeEntry *)(writer->mapping + sizeof(GigaVmTraceFileHeader));
+    writer->ring = writer->mapping + sizeof(GigaVmTraceFileHeader) +
+                   (size_t)writer->keyframe_slots * sizeof(GigaVmTraceKeyframeEntry);
+    memcpy(writer->header->magic, giga_vm_trace_magic, sizeof(giga_vm_trace_magic));
+    writer->header->capacity = writer->capacity;
+    writer->header->keyframe_slots = writer->keyframe_slots;
+    return writer;
+}
+
+int giga_vm_trace_flush(GigaVmTraceWriter *writer) {
+    if (writer == NULL) {
+        return -1;
+    }
+    size_t position = (size_t)(writer->flushed_bytes % writer->capacity);
+    size_t first = writer->batch_used;
+    if (first > writer->capacity - position) {
+        first = (size_t)(writer->capacity - position);
+    }
+    memcpy(&writer->ring[position], writer->batch, first);
+    memcpy(writer->ring, writer->batch + first, writer->batch_used - first);
+
+    writer->flushed_bytes += writer->batch_used;
+    writer->batch_used = 0;
+    writer->header->written_bytes = writer->flushed_bytes;
+    writer->header->instruction_count = writer->instruction_count;
+    writer->header->keyframe_count = writer->keyframe_count;
+    return 0;
+}
+
+/* Append a keyframe for state (already encoded in frame) to the batch. */
+static void giga_vm_trace_emit_keyframe(GigaVmTraceWriter *writer, uint8_t *frame) {
+    if (writer->batch_used + GIGA_VM_TRACE_KEYFRAME_BYTES > GIGA_VM_TRACE_BATCH_BYTES) {
+        giga_vm_trace_flush(writer);
+    }
+    GigaVmTraceKeyframeEntry *entry = &writer->keyframes[writer->keyframe_count % writer->keyframe_slots];
+    entry->instruction_index = writer->instruction_count;
+    entry->offset = writer->flushed_bytes + writer->batch_used;
+    ++writer->keyframe_count;
+
+    giga_vm_trace_put_u64(frame + 1u, writer->instruction_count);
+    memcpy(&writer->batch[writer->batch_used], frame, GIGA_VM_TRACE_KEYFRAME_BYTES);
+    writer->batch_used += GIGA_VM_TRACE_KEYFRAME_BYTES;
+    writer->next_keyframe = writer->instruction_count + GIGA_VM_TRACE_KEYFRAME_INTERVAL;
+}
+
+GigaVmStatus giga_vm_trace_run(GigaVmTraceWriter *writer, GigaVmState *state, uint64_t max_steps) {
+    if (writer == NULL || state == NULL) {
+        return GIGA_VM_STATUS_INVALID_STATE;
+    }
+
+    uint8_t frame[GIGA_VM_TRACE_KEYFRAME_BYTES];
+    giga_vm_trace_encode_state(state, frame);
+    if (!writer->has_last_frame || memcmp(frame, writer->last_frame, sizeof(frame)) != 0) {
+        giga_vm_trace_emit_keyframe(writer, frame);
+    }
+
+    uint64_t remaining_steps = max_steps;
+    GigaVmStatus status;
+    do {
+        if (writer->instruction_count >= writer->next_keyframe) {
+            giga_vm_trace_encode_state(state, frame);
+            giga_vm_trace_emit_keyframe(writer, frame);
+        }
+        size_t room = GIGA_VM_TRACE_BATCH_BYTES - writer->batch_used - GIGA_VM_TRACE_STOP_BYTES;
+        if (room / GIGA_VM_TRACE_MAX_RECORD_BYTES < GIGA_VM_TRACE_MIN_CHUNK) {
+            giga_vm_trace_flush(writer);
+            room = GIGA_VM_TRACE_BATCH_BYTES - GIGA_VM_TRACE_STOP_BYTES;
+        }
+
+        uint64_t chunk = room / GIGA_VM_TRACE_MAX_RECORD_BYTES;
+        if (chunk > remaining_steps) {
+            chunk = remaining_steps;
+        }
+        if (chunk > writer->next_keyframe - writer->instruction_count) {
+            chunk = writer->next_keyframe - writer->instruction_count;
+        }
+
+        size_t record_bytes = 0;
+        uint64_t retired = 0;
+        status = giga_vm_run_traced(state, chunk, &writer->batch[writer->batch_used], &record_bytes, &retired);
+        writer->batch_used += record_bytes;
+        writer->instruction_count += retired;
+        remaining_steps -= chunk;
+    } while (status == GIGA_VM_STATUS_STEP_LIMIT && remaining_steps > 0);
+
+    giga_vm_trace_encode_state(state, writer->last_frame);
+    writer->has_last_frame = 1;
+    return status;
+}
+
+uint64_t giga_vm_trace_instruction_count(const GigaVmTraceWriter *writer) {
+    return (writer != NULL) ? writer->instruction_count : 0;
+}
+
+int giga_vm_trace_close(GigaVmTraceWriter *writer) {
+    if (writer == NULL) {
+        return -1;
+    }
+    giga_vm_trace_flush(writer);
+    int result = 0;
+    if (msync(writer->mapping, writer->mapping_bytes, MS_SYNC) != 0) {
+        result = -1;
+    }
+    munmap(writer->mapping, writer->mapping_bytes);
+    if (close(writer->fd) != 0) {
+        result = -1;
+    }
+    free(writer);
+    return result;
+}
+
+/* ---- replay ---- */
+
+GigaVmReplay *giga_vm_replay_open(const char *path) {
+    if (path == NULL) {
+        return NULL;
+    }
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(GigaVmTraceFileHeader)) {
+        close(fd);
+        return NULL;
+    }
+    size_t mapping_bytes = (size_t)info.st_size;
+    void *mapping = mmap(NULL, mapping_bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        return NULL;
+    }
+
+    const GigaVmTraceFileHeader *header = (const GigaVmTraceFileHeader *)mapping;
+    if (memcmp(header->magic, giga_vm_trace_magic, sizeof(giga_vm_trace_magic)) != 0 ||
+        header->capacity < GIGA_VM_TRACE_MIN_CAPACITY || header->keyframe_slots == 0 ||
+        giga_vm_trace_file_bytes(header->capacity, header->keyframe_slots) != mapping_bytes) {
+        munmap(mapping, mapping_bytes);
+        return NULL;
+    }
+
+    GigaVmReplay *replay = (GigaVmReplay *)calloc(1, sizeof(*replay));
+    if (replay == NULL) {
+        munmap(mapping, mapping_bytes);
+        return NULL;
+    }
+    replay->mapping = (uint8_t *)mapping;
+    replay->mapping_bytes = mapping_bytes;
+    replay->keyframes = (const GigaVmTraceKeyframeEntry *)(replay->mapping + sizeof(GigaVmTraceFileHeader));
+    replay->ring = replay->mapping + sizeof(GigaVmTraceFileHeader) +
+                   (size_t)header->keyframe_slots * sizeof(GigaVmTraceKeyframeEntry);
+    replay->capacity = header->capacity;
+    replay->keyframe_slots = header->keyframe_slots;
+    replay->written_bytes = header->written_bytes;
+    replay->instruction_count = header->instruction_count;
+    replay->keyframe_count = header->keyframe_count;
+    return replay;
+}
+
+void giga_vm_replay_close(GigaVmReplay *replay) {
+    if (replay == NULL) {
+        return;
+    }
+    munmap(replay->mapping, replay->mapping_bytes);
+    free(replay);
+}
+
+/* Oldest stream offset the ring still holds. */
+static uint64_t giga_vm_replay_oldest_offset(const GigaVmReplay *replay) {
+    return (replay->written_bytes > replay->capacity) ? replay->written_bytes - replay->capacity : 0;
+}
+
+/* Index entry of keyframe k, or NULL if its slot or its bytes were overwritten. */
+static const GigaVmTraceKeyframeEntry *giga_vm_replay_keyframe(const GigaVmReplay *replay, uint64_t keyframe) {
+    if (keyframe >= replay->keyframe_count || replay->keyframe_count - keyframe > replay->keyframe_slots) {
+        return NULL;
+    }
+    const GigaVmTraceKeyframeEntry *entry = &replay->keyframes[keyframe % replay->keyframe_slots];
+    if (entry->offset < giga_vm_replay_oldest_offset(replay) ||
+        entry->offset + GIGA_VM_TRACE_KEYFRAME_BYTES > replay->written_bytes) {
+        return NULL;
+    }
+    return entry;
+}
+
+uint64_t giga_vm_replay_first_instruction(const GigaVmReplay *replay) {
+    if (replay == NULL) {
+        return 0;
+    }
+    /* keyframes only become unusable from the oldest end */
+    const GigaVmTraceKeyframeEntry *oldest = NULL;
+    for (uint64_t keyframe = replay->keyframe_count; keyframe-- > 0;) {
+        const GigaVmTraceKeyframeEntry *entry = giga_vm_replay_keyframe(replay, keyframe);
+        if (entry == NULL) {
+            break;
+        }
+        oldest = entry;
+    }
+    return (oldest != NULL) ? oldest->instruction_index : replay->instruction_count;
+}
+
+uint64_t giga_vm_replay_instruction_count(const GigaVmReplay *replay) {
+    return (replay != NULL) ? replay->instruction_count : 0;
+}
+
+/* Byte at a stream offset; -3 once the offset passes the written records. */
+static inline int giga_vm_replay_byte(const GigaVmReplay *replay, uint64_t offset, uint8_t *out) {
+    if (offset >= replay->written_bytes) {
+        return -3;
+    }
+    *out = replay->ring[offset % replay->capacity];
+    return 0;
+}
+
+static int giga_vm_replay_is_instruction(uint8_t tag) {
+    return tag != GIGA_VM_TRACE_TAG_KEYFRAME && tag != GIGA_VM_TRACE_TAG_STOP;
+}
+
+static int giga_vm_replay_apply_keyframe(const GigaVmReplay *replay, uint64_t offset, GigaVmState *state,
+                                         uint64_t *index) {
+    uint8_t frame[GIGA_VM_TRACE_KEYFRAME_BYTES];
+    for (size_t position = 0; position < sizeof(frame); ++position) {
+        if (giga_vm_replay_byte(replay, offset + position, &frame[position]) != 0) {
+            return -3;
+        }
+    }
+    const uint8_t *in = frame + 1u;
+    uint64_t instruction_index = 0;
+    for (size_t position = 0; position < 8u; ++position) {
+        instruction_index |= (uint64_t)in[position] << (8u * position);
+    }
+    in += 8u;
+    const uint8_t *registers = in;
+    in += GIGA_VM_REGISTER_COUNT;
+    uint8_t flags = *in++;
+    uint16_t program_counter = (uint16_t)(in[0] | (in[1] << 8));
+    in += 2u;
+    size_t word_count = *in++;
+    if (word_count > GIGA_VM_MAX_PROGRAM_WORDS) {
+        return -3;
+    }
+
+    /* reload the program from the captured memory so the state is runnable */
+    uint16_t words[GIGA_VM_MAX_PROGRAM_WORDS];
+    for (size_t word = 0; word < word_count; ++word) {
+        words[word] = (uint16_t)(in[word * 2u] | (in[word * 2u + 1u] << 8));
+    }
+    giga_vm_init(state);
+    memcpy(state->memory, in, GIGA_VM_MEMORY_SIZE);
+    giga_vm_load_program(state, words, word_count);
+    memcpy(state->registers, registers, GIGA_VM_REGISTER_COUNT);
+    state->flags_zero = (uint8_t)((flags & GIGA_VM_PACKED_FLAG_ZERO) != 0);
+    state->flags_carry = (uint8_t)((flags & GIGA_VM_PACKED_FLAG_CARRY) != 0);
+    state->flags_negative = (uint8_t)((flags & GIGA_VM_PACKED_FLAG_NEGATIVE) != 0);
+    state->flags_overflow = (uint8_t)((flags & GIGA_VM_PACKED_FLAG_OVERFLOW) != 0);
+    state->program_counter = program_counter;
+    *index = instruction_index;
+    return 0;
+}
+
+/*
+ * Apply the record at *offset and advance past it. Instruction records
+ * also advance *index.
+ */
+static int giga_vm_replay_apply(const GigaVmReplay *replay, uint64_t *offset, GigaVmState *state,
+                                uint64_t *index) {
+    uint64_t at = *offset;
+    uint8_t tag;
+    if (giga_vm_replay_byte(replay, at++, &tag) != 0) {
+        return -3;
+    }
+
+    if (tag == GIGA_VM_TRACE_TAG_KEYFRAME) {
+        if (giga_vm_replay_apply_keyframe(replay, *offset, state, index) != 0) {
+            return -3;
+        }
+        *offset += GIGA_VM_TRACE_KEYFRAME_BYTES;
+        return 0;
+    }
+    if (tag == GIGA_VM_TRACE_TAG_STOP) {
+        uint8_t stop[GIGA_VM_TRACE_STOP_BYTES - 1u];
+        for (size_t position = 0; position < sizeof(stop); ++position) {
+            if (giga_vm_replay_byte(replay, at++, &stop[position]) != 0) {
+                return -3;
+            }
+        }
+        state->program_counter = (uint16_t)(stop[1] | (stop[2] << 8));
+        *offset = at;
+        return 0;
+    }
+
+    uint16_t next_pc = (uint16_t)(state->program_counter + 1u);
+    uint8_t value;
+    if (tag < GIGA_VM_TRACE_TAG_ALU) {
+        state->registers[tag >> 4] = (uint8_t)(tag & 0x0Fu);
+    } else if (tag < GIGA_VM_TRACE_TAG_NOP) {
+        if (giga_vm_replay_byte(replay, at++, &value) != 0 || value >= 0x80u) {
+            return -3;
+        }
+        state->flags_zero = (uint8_t)((tag & GIGA_VM_PACKED_FLAG_ZERO) != 0);
+        state->flags_carry = (uint8_t)((tag & GIGA_VM_PACKED_FLAG_CARRY) != 0);
+        state->flags_negative = (uint8_t)((tag & GIGA_VM_PACKED_FLAG_NEGATIVE) != 0);
+        state->flags_overflow = (uint8_t)((tag & GIGA_VM_PACKED_FLAG_OVERFLOW) != 0);
+        state->registers[value >> 4] = (uint8_t)(value & 0x0Fu);
+    } else if (tag == GIGA_VM_TRACE_TAG_STORE) {
+        uint8_t address;
+        if (giga_vm_replay_byte(replay, at++, &address) != 0 || giga_vm_replay_byte(replay, at++, &value) != 0) {
+            return -3;
+        }
+        state->memory[address] = value;
+        if (address < state->loaded_program_words * 2u) {
+            giga_vm_invalidate_code(state, address);
+        } else {
+            giga_vm_mark_dirty(state, address);
+        }
+    } else if (tag == GIGA_VM_TRACE_TAG_FLAGS) {
+        if (giga_vm_replay_byte(replay, at++, &value) != 0 || value > 0x0Fu) {
+            return -3;
+        }
+        state->flags_zero = (uint8_t)((value & GIGA_VM_PACKED_FLAG_ZERO) != 0);
+        state->flags_carry = (uint8_t)((value & GIGA_VM_PACKED_FLAG_CARRY) != 0);
+        state->flags_negative = (uint8_t)((value & GIGA_VM_PACKED_FLAG_NEGATIVE) != 0);
+        state->flags_overflow = (uint8_t)((value & GIGA_VM_PACKED_FLAG_OVERFLOW) != 0);
+    } else if (tag == GIGA_VM_TRACE_TAG_JUMP) {
+        uint32_t zigzag = 0;
+        size_t length = 0;
+        do {
+            if (length == GIGA_VM_TRACE_MAX_VARINT_BYTES || giga_vm_replay_byte(replay, at++, &value) != 0) {
+                return -3;
+            }
+            zigzag |= (uint32_t)(value & 0x7Fu) << (7u * length++);
+        } while (value & 0x80u);
+        int32_t delta = (int32_t)(zigzag >> 1) ^ -(int32_t)(zigzag & 1u);
+        next_pc = (uint16_t)(next_pc + delta);
+    } else if (tag != GIGA_VM_TRACE_TAG_NOP) {
+        return -3;
+    }
+    state->program_counter = next_pc;
+    *offset = at;
+    ++*index;
+    return 0;
+}
+
+/* Apply the stop records and keyframes between *offset and the next instruction. */
+static int giga_vm_replay_apply_markers(const GigaVmReplay *replay, uint64_t *offset, GigaVmState *state,
+                                        uint64_t *index) {
+    uint8_t tag;
+    while (giga_vm_replay_byte(replay, *offset, &tag) == 0 && !giga_vm_replay_is_instruction(tag)) {
+        if (giga_vm_replay_apply(replay, offset, state, index) != 0) {
+            return -3;
+        }
+    }
+    return 0;
+}
+
+int giga_vm_replay_seek(GigaVmReplay *replay, uint64_t instruction_index, GigaVmState *out) {
+    if (replay == NULL || out == NULL) {
+        return -1;
+    }
+    replay->positioned = 0;
+    if (instruction_index > replay->instruction_count) {
+        return -2;
+    }
+
+    /* closest usable keyframe at or before the index */
+    const GigaVmTraceKeyframeEntry *start = NULL;
+    for (uint64_t keyframe = replay->keyframe_count; keyframe-- > 0;) {
+        const GigaVmTraceKeyframeEntry *entry = giga_vm_replay_keyframe(replay, keyframe);
+        if (entry == NULL) {
+            break;
+        }
+        if (entry->instruction_index <= instruction_index) {
+            start = entry;
+            break;
+        }
+    }
+    if (start == NULL) {
+        return -2;
+    }
+
+    uint64_t offset = start->offset;
+    uint64_t index = 0;
+    if (giga_vm_replay_apply(replay, &offset, out, &index) != 0 || index != start->instruction_index) {
+        return -3;
+    }
+    while (index < instruction_index) {
+        if (giga_vm_replay_apply(replay, &offset, out, &index) != 0) {
+            return -3;
+        }
+    }
+    if (giga_vm_replay_apply_markers(replay, &offset, out, &index) != 0 || index != instruction_index) {
+        return -3;
+    }
+
+    replay->offset = offset;
+    replay->index = index;
+    replay->positioned = 1;
+    return 0;
+}
+
+int giga_vm_replay_step(GigaVmReplay *replay, GigaVmState *state) {
+    if (replay == NULL || state == NULL || !replay->positioned) {
+        return -1;
+    }
+    if (replay->index >= replay->instruction_count) {
+        return 1;
+    }
+    if (giga_vm_replay_apply(replay, &replay->offset, state, &replay->index) != 0 ||
+        giga_vm_replay_apply_markers(replay, &replay->offset, state, &replay->index) != 0) {
+        replay->positioned = 0;
+        return -3;
+    }
+    return 0;
+}
@@ -1,6 +1,11 @@
 #include <stdio.h>
 #include <stdint.h>
+#include <string.h>
 #include "alu/alu.h"
+#include "alu/alu_bitslice.h"
+#include "alu/alu_batch.h"
+#include "alu/alu_bigint.h"
+#include "alu/alu_lut.h"
 
 static int test_add_exhaustive(void) {
     int failure_count = 0;
@@ -110,6 +115,420 @@ static int test_shifts(void) {
     return failure_count;
 }
 
+static AluResult alu_reference(AluSliceOp op, uint8_t operand_a, uint8_t operand_b) {
+    switch (op) {
+        case ALU_SLICE_ADD: return alu_add(operand_a, operand_b);
+        case ALU_SLICE_SUB: return alu_sub(operand_a, operand_b);
+        case ALU_SLICE_AND: return alu_and(operand_a, operand_b);
+        case ALU_SLICE_OR:  return alu_or(operand_a, operand_b);
+        case ALU_SLICE_XOR: return alu_xor(operand_a, operand_b);
+        case ALU_SLICE_NOT: return alu_not(operand_a);
+        case ALU_SLICE_SHL: return alu_shl(operand_a);
+        default:            return alu_shr(operand_a);
+    }
+}
+
+static uint8_t alu_slice_bit(const uint64_t *mask, unsigned lane) {
+    return (uint8_t)((mask[lane / 64u] >> (lane % 64u)) & 1u);
+}
+
+static int test_bitslice_exhaustive(void) {
+    int failure_count = 0;
+
+    /* lane = (a << 4) | b covers every operand pair; high bits must be ignored */
+    uint8_t operands_a[256], operands_b[256], values[256];
+    for (unsigned lane = 0; lane < 256; ++lane) {
+        operands_a[lane] = (uint8_t)((lane >> 4) | 0xA0u);
+        operands_b[lane] = (uint8_t)((lane & 0x0Fu) | 0x50u);
+    }
+
+    AluSlice256 slice_a, slice_b;
+    alu_slice256_pack(operands_a, &slice_a);
+    alu_slice256_pack(operands_b, &slice_b);
+    alu_slice256_unpack(&slice_a, values);
+    for (unsigned lane = 0; lane < 256; ++lane) {
+        if (values[lane] != (lane >> 4)) {
+            printf("BITSLICE fail: pack/unpack lane %u -> %u\n", lane, values[lane]);
+            ++failure_count;
+            break;
+        }
+    }
+
+    for (int op = ALU_SLICE_ADD; op <= ALU_SLICE_SHR; ++op) {
+        AluSliceResult256 wide;
+        alu_slice256_eval((AluSliceOp)op, &slice_a, &slice_b, &wide);
+        alu_slice256_unpack(&wide.result, values);
+
+        for (unsigned word = 0; word < 4; ++word) {
+            AluSlice64 narrow_a, narrow_b;
+            alu_slice64_pack(operands_a + 64 * word, &narrow_a);
+            alu_slice64_pack(operands_b + 64 * word, &narrow_b);
+            AluSliceResult64 narrow = alu_slice64_eval((AluSliceOp)op, narrow_a, narrow_b);
+            uint8_t narrow_values[64];
+            alu_slice64_unpack(&narrow.result, narrow_values);
+            if (narrow.zero_flags != wide.zero_flags[word] ||
+                narrow.carry_flags != wide.carry_flags[word] ||
+                narrow.negative_flags != wide.negative_flags[word] ||
+                narrow.overflow_flags != wide.overflow_flags[word] ||
+                memcmp(narrow_values, values + 64 * word, 64) != 0) {
+                printf("BITSLICE fail: op %d, 64-lane and 256-lane results differ\n", op);
+                ++failure_count;
+            }
+        }
+
+        for (unsigned lane = 0; lane < 256; ++lane) {
+            AluResult expected = alu_reference((AluSliceOp)op, (uint8_t)(lane >> 4), (uint8_t)(lane & 0x0Fu));
+            if (values[lane] != expected.result ||
+                alu_slice_bit(wide.zero_flags, lane) != expected.zero_flag ||
+                alu_slice_bit(wide.carry_flags, lane) != expected.carry_flag ||
+                alu_slice_bit(wide.negative_flags, lane) != expected.negative_flag ||
+                alu_slice_bit(wide.overflow_flags, lane) != expected.overflow_flag) {
+                printf("BITSLICE fail: op %d, a=%u b=%u -> %u (exp %u)\n",
+                       op, lane >> 4, lane & 0x0Fu, values[lane], expected.result);
+                ++failure_count;
+                break;
+            }
+        }
+    }
+
+    return failure_count;
+}
+
+static AluResult alu_lut_reference(AluSliceOp op, uint8_t operand_a, uint8_t operand_b) {
+    switch (op) {
+        case ALU_SLICE_ADD: return alu_lut_add(operand_a, operand_b);
+        case ALU_SLICE_SUB: return alu_lut_sub(operand_a, operand_b);
+        case ALU_SLICE_AND: return alu_lut_and(operand_a, operand_b);
+        case ALU_SLICE_OR:  return alu_lut_or(operand_a, operand_b);
+        case ALU_SLICE_XOR: return alu_lut_xor(operand_a, operand_b);
+        case ALU_SLICE_NOT: return alu_lut_not(operand_a);
+        case ALU_SLICE_SHL: return alu_lut_shl(operand_a);
+        default:            return alu_lut_shr(operand_a);
+    }
+}
+
+static int test_lut_exhaustive(void) {
+    int failure_count = 0;
+
+    /* full byte range: the tables must ignore the high nibble like alu_* */
+    for (int op = ALU_SLICE_ADD; op <= ALU_SLICE_SHR; ++op) {
+        for (unsigned operand_a = 0; operand_a < 256; ++operand_a) {
+            for (unsigned operand_b = 0; operand_b < 256; ++operand_b) {
+                AluResult expected = alu_reference((AluSliceOp)op, (uint8_t)operand_a, (uint8_t)operand_b);
+                AluResult actual = alu_lut_reference((AluSliceOp)op, (uint8_t)operand_a, (uint8_t)operand_b);
+                if (memcmp(&expected, &actual, sizeof(expected)) != 0) {
+                    printf("LUT fail: op %d, a=%u b=%u -> %u (exp %u)\n",
+                           op, operand_a, operand_b, actual.result, expected.result);
+                    ++failure_count;
+                    operand_a = 256;
+                    break;
+                }
+            }
+        }
+    }
+
+    return failure_count;
+}
+
+static int test_batch_kernels(void) {
+    int failure_count = 0;
+    enum { MAX_COUNT = 1100 };
+    static uint8_t operands[MAX_COUNT];
+    static uint8_t results[MAX_COUNT / 2 + 1];
+    static uint8_t bitmaps[4][MAX_COUNT / 8 + 1];
+    const size_t counts[] = {0, 1, 7, 31, 32, 33, 64, 127, 128, 129, 255, 256, 1000, MAX_COUNT - 3};
+
+    uint32_t seed = 99u;
+    for (size_t index = 0; index < MAX_COUNT; ++index) {
+        seed = seed * 1103515245u + 12345u;
+        operands[index] = (uint8_t)(seed >> 16);
+    }
+
+    for (int kernel = ALU_BATCH_KERNEL_SCALAR; kernel <= ALU_BATCH_KERNEL_AVX512; ++kernel) {
+        for (int op = ALU_BATCH_ADD; op <= ALU_BATCH_SHR; ++op) {
+            for (size_t case_index = 0; case_index < sizeof(counts) / sizeof(counts[0]); ++case_index) {
+                size_t count = counts[case_index];
+                memset(results, 0xA5, sizeof(results));
+                memset(bitmaps, 0xA5, sizeof(bitmaps));
+                AluBatchOutput out = {results, bitmaps[0], bitmaps[1], bitmaps[2],
+                                      (case_index % 3 == 0) ? NULL : bitmaps[3]};
+                int status = alu_batch_run((AluBatchKernel)kernel, (AluBatchOp)op, operands, count, &out);
+                if (status == -2) {
+                    break; /* kernel not available on this CPU */
+                }
+                if (status != 0) {
+                    printf("BATCH fail: kernel %d op %d returned %d\n", kernel, op, status);
+                    ++failure_count;
+                    break;
+                }
+
+                for (size_t element = 0; element < count; ++element) {
+                    uint8_t operand_a = (op >= ALU_BATCH_NOT)
+                                            ? (uint8_t)(operands[element / 2] >> (4 * (element % 2)))
+                                            : operands[element];
+                    AluResult expected = alu_reference((AluSliceOp)op, operand_a,
+                                                       (uint8_t)(operands[element] >> 4));
+                    uint8_t result = (uint8_t)((results[element / 2] >> (4 * (element % 2))) & 0x0F);
+                    uint8_t flags[4];
+                    for (int flag = 0; flag < 4; ++flag) {
+                        flags[flag] = (uint8_t)((bitmaps[flag][element / 8] >> (element % 8)) & 1u);
+                    }
+                    if (result != expected.result || flags[0] != expected.zero_flag ||
+                        flags[1] != expected.carry_flag || flags[2] != expected.negative_flag ||
+                        (out.overflow_flags != NULL && flags[3] != expected.overflow_flag)) {
+                        printf("BATCH fail: kernel %d op %d count %zu element %zu -> %u (exp %u)\n",
+                               kernel, op, count, element, result, expected.result);
+                        ++failure_count;
+                        break;
+                    }
+                }
+                if ((count % 2 != 0 && (results[count / 2] >> 4) != 0) ||
+                    (count % 8 != 0 && (bitmaps[0][count / 8] >> (count % 8)) != 0) ||
+                    (out.overflow_flags == NULL && count > 0 && bitmaps[3][0] != 0xA5)) {
+                    printf("BATCH fail: kernel %d op %d count %zu wrote outside the layout\n",
+                           kernel, op, count);
+                    ++failure_count;
+                }
+            }
+        }
+    }
+
+    AluBatchOutput no_results = {NULL, NULL, NULL, NULL, NULL};
+    if (alu_add_batch(operands, 4, &no_results) != -1 || alu_add_batch(operands, 0, &no_results) != 0) {
+        printf("BATCH fail: NULL results should only be rejected when count > 0\n");
+        ++failure_count;
+    }
+
+    return failure_count;
+}
+
+static int test_carry_chain_exhaustive(void) {
+    int failure_count = 0;
+    for (int operand_a = 0; operand_a < 16; ++operand_a) {
+        for (int operand_b = 0; operand_b < 16; ++operand_b) {
+            for (int carry = 0; carry < 2; ++carry) {
+                int signed_a = operand_a >= 8 ? operand_a - 16 : operand_a;
+                int signed_b = operand_b >= 8 ? operand_b - 16 : operand_b;
+
+                AluResult adc = alu_adc((uint8_t)operand_a, (uint8_t)operand_b, (uint8_t)carry);
+                int sum = operand_a + operand_b + carry;
+                int signed_sum = signed_a + signed_b + carry;
+                if (adc.result != (sum & 0x0F) || adc.carry_flag != (sum >> 4) ||
+                    adc.zero_flag != ((sum & 0x0F) == 0) || adc.negative_flag != ((sum >> 3) & 1) ||
+                    adc.overflow_flag != (signed_sum < -8 || signed_sum > 7)) {
+                    printf("ADC fail: %d + %d + %d -> result=%u C=%u V=%u\n",
+                           operand_a, operand_b, carry, adc.result, adc.carry_flag, adc.overflow_flag);
+                    ++failure_count;
+                }
+
+                AluResult sbc = alu_sbc((uint8_t)operand_a, (uint8_t)operand_b, (uint8_t)carry);
+                int difference = operand_a - operand_b - (1 - carry);
+                int signed_difference = signed_a - signed_b - (1 - carry);
+                if (sbc.result != (difference & 0x0F) || sbc.carry_flag != (difference >= 0) ||
+                    sbc.zero_flag != ((difference & 0x0F) == 0) ||
+                    sbc.negative_flag != ((difference >> 3) & 1) ||
+                    sbc.overflow_flag != (signed_difference < -8 || signed_difference > 7)) {
+                    printf("SBC fail: %d - %d - !%d -> result=%u C=%u V=%u\n",
+                           operand_a, operand_b, carry, sbc.result, sbc.carry_flag, sbc.overflow_flag);
+                    ++failure_count;
+                }
+            }
+
+            AluResult add = alu_add((uint8_t)operand_a, (uint8_t)operand_b);
+            AluResult sub = alu_sub((uint8_t)operand_a, (uint8_t)operand_b);
+            AluResult adc = alu_adc((uint8_t)operand_a, (uint8_t)operand_b, 0);
+            AluResult sbc = alu_sbc((uint8_t)operand_a, (uint8_t)operand_b, 1);
+            if (memcmp(&add, &adc, sizeof(add)) != 0 || memcmp(&sub, &sbc, sizeof(sub)) != 0) {
+                printf("ADC/SBC fail: %d, %d without carry should match ADD/SUB\n", operand_a, operand_b);
+                ++failure_count;
+            }
+        }
+    }
+    return failure_count;
+}
+
+static uint8_t bigint_nibble(const uint8_t *value, size_t index) {
+    return (uint8_t)((value[index / 2] >> (4 * (index % 2))) & 0x0F);
+}
+
+/* N-nibble add/sub as a chain of alu_adc / alu_sbc from the lowest nibble. */
+static AluResult bigint_reference(AluBigintOp op, const uint8_t *operand_a, const uint8_t *operand_b,
+                                  size_t nibble_count, uint8_t carry_in, uint8_t *result) {
+    AluResult flags = {0, 1, carry_in, 0, 0};
+    uint8_t all_zero = 1;
+    memset(result, 0, (nibble_count + 1) / 2);
+    for (size_t index = 0; index < nibble_count; ++index) {
+        uint8_t a = bigint_nibble(operand_a, index);
+        uint8_t b = bigint_nibble(operand_b, index);
+        flags = (op == ALU_BIGINT_ADD) ? alu_adc(a, b, flags.carry_flag) : alu_sbc(a, b, flags.carry_flag);
+        result[index / 2] = (uint8_t)(result[index / 2] | (flags.result << (4 * (index % 2))));
+        all_zero = (uint8_t)(all_zero && flags.result == 0);
+    }
+    flags.zero_flag = all_zero;
+    return flags;
+}
+
+static int test_bigint_add_sub(void) {
+    int failure_count = 0;
+    enum { MAX_NIBBLES = 2100, MAX_BYTES = MAX_NIBBLES / 2 + 8 };
+    static uint8_t operand_a[MAX_BYTES], operand_b[MAX_BYTES];
+    static uint8_t result[MAX_BYTES], expected[MAX_BYTES];
+    const size_t counts[] = {0, 1, 2, 3, 15, 16, 17, 31, 32, 33, 63, 64, 65, 127, 128, 129,
+                             255, 256, 257, 1000, 1001, MAX_NIBBLES};
+
+    uint32_t seed = 7u;
+    for (int pattern = 0; pattern < 4; ++pattern) {
+        /* random, all-ones a (carries ripple across every lane), mostly-ones, equal operands */
+        for (size_t index = 0; index < MAX_BYTES; ++index) {
+            seed = seed * 1103515245u + 12345u;
+            uint8_t random = (uint8_t)(seed >> 16);
+            operand_a[index] = (pattern == 1) ? 0xFF : (pattern == 2 && random % 64 != 0) ? 0xFF : random;
+            seed = seed * 1103515245u + 12345u;
+            operand_b[index] = (pattern == 3) ? operand_a[index] : (pattern == 1) ? 0 : (uint8_t)(seed >> 16);
+        }
+        if (pattern == 2) {
+            memset(operand_b, 0, sizeof(operand_b));
+            operand_b[0] = 1;
+        }
+
+        for (int kernel = ALU_BIGINT_KERNEL_SCALAR; kernel <= ALU_BIGINT_KERNEL_AVX512; ++kernel) {
+            for (int op = ALU_BIGINT_ADD; op <= ALU_BIGINT_SUB; ++op) {
+                for (size_t case_index = 0; case_index < sizeof(counts) / sizeof(counts[0]); ++case_index) {
+                    for (uint8_t carry_in = 0; carry_in < 2; ++carry_in) {
+                        size_t count = counts[case_index];
+                        size_t byte_count = (count + 1) / 2;
+                        AluResult want = bigint_reference((AluBigintOp)op, operand_a, operand_b, count,
+                                                          carry_in, expected);
+                        AluResult got;
+                        memset(result, 0xA5, sizeof(result));
+                        int status = alu_bigint_run((AluBigintKernel)kernel, (AluBigintOp)op, operand_a,
+                                                    operand_b, count, carry_in, result, &got);
+                        if (status == -2) {
+                            break; /* kernel not available on this CPU */
+                        }
+                        if (status != 0 || memcmp(&got, &want, sizeof(got)) != 0 ||
+                            memcmp(result, expected, byte_count) != 0 || result[byte_count] != 0xA5) {
+                            printf("BIGINT fail: pattern %d kernel %d op %d count %zu carry %u -> "
+                                   "top=%u Z=%u C=%u N=%u V=%u (exp top=%u Z=%u C=%u N=%u V=%u)\n",
+                                   pattern, kernel, op, count, carry_in, got.result, got.zero_flag,
+                                   got.carry_flag, got.negative_flag, got.overflow_flag, want.result,
+                                   want.zero_flag, want.carry_flag, want.negative_flag, want.overflow_flag);
+                            ++failure_count;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    /* in place, and flags only */
+    size_t count = 1001;
+    AluResult want = bigint_reference(ALU_BIGINT_ADD, operand_a, operand_b, count, 1, expected);
+    AluResult got;
+    memcpy(result, operand_a, sizeof(result));
+    if (alu_bigint_add(result, operand_b, count, 1, result, &got) != 0 ||
+        memcmp(result, expected, (count + 1) / 2) != 0 || memcmp(&got, &want, sizeof(got)) != 0) {
+        printf("BIGINT fail: in-place add should match the reference\n");
+        ++failure_count;
+    }
+    want = bigint_reference(ALU_BIGINT_SUB, operand_a, operand_b, count, 1, expected);
+    if (alu_bigint_compare(operand_a, operand_b, count, &got) != 0 || memcmp(&got, &want, sizeof(got)) != 0) {
+        printf("BIGINT fail: compare should report the flags of a - b\n");
+        ++failure_count;
+    }
+    if (alu_bigint_compare(operand_a, operand_a, count, &got) != 0 || !got.zero_flag || !got.carry_flag) {
+        printf("BIGINT fail: compare of equal values should set Z and C\n");
+        ++failure_count;
+    }
+    if (alu_bigint_add(NULL, operand_b, count, 0, result, &got) != -1 ||
+        alu_bigint_run((AluBigintKernel)99, ALU_BIGINT_ADD, operand_a, operand_b, count, 0, result, &got) != -2) {
+        printf("BIGINT fail: invalid arguments should be rejected\n");
+        ++failure_count;
+    }
+    return failure_count;
+}
+
+static int test_bigint_shifts(void) {
+    int failure_count = 0;
+    enum { MAX_NIBBLES = 301, MAX_BYTES = MAX_NIBBLES / 2 + 2 };
+    static uint8_t operand[MAX_BYTES], result[MAX_BYTES], expected[MAX_BYTES];
+    const size_t counts[] = {1, 2, 3, 16, 17, 100, MAX_NIBBLES};
+
+    uint32_t seed = 3u;
+    for (size_t index = 0; index < MAX_BYTES; ++index) {
+        seed = seed * 1103515245u + 12345u;
+        operand[index] = (uint8_t)(seed >> 16);
+    }
+
+    for (size_t case_index = 0; case_index < sizeof(counts) / sizeof(counts[0]); ++case_index) {
+        size_t count = counts[case_index];
+        size_t bit_total = count * 4;
+        size_t byte_count = (count + 1) / 2;
+        const size_t shifts[] = {0, 1, 3, 4, 7, 8, 9, 15, 16, 17, bit_total - 1, bit_total, bit_total + 5};
+
+        for (int left = 0; left < 2; ++left) {
+            for (size_t shift_index = 0; shift_index < sizeof(shifts) / sizeof(shifts[0]); ++shift_index) {
+                size_t shift = shifts[shift_index];
+                uint8_t carry = 0, nonzero = 0;
+                memset(expected, 0, sizeof(expected));
+                for (size_t bit = 0; bit < bit_total; ++bit) {
+                    size_t source = left ? bit - shift : bit + shift;
+                    int inside = left ? (bit >= shift) : (shift < bit_total && source < bit_total);
+                    uint8_t value = inside ? (uint8_t)((operand[source / 8] >> (source % 8)) & 1u) : 0u;
+                    expected[bit / 8] = (uint8_t)(expected[bit / 8] | (value << (bit % 8)));
+                    nonzero |= value;
+                }
+                if (shift >= 1 && shift <= bit_total) {
+                    size_t out_bit = left ? bit_total - shift : shift - 1;
+                    carry = (uint8_t)((operand[out_bit / 8] >> (out_bit % 8)) & 1u);
+                }
+
+                AluResult flags;
+                memset(result, 0xA5, sizeof(result));
+                int status = left ? alu_bigint_shl(operand, count, shift, result, &flags)
+                                  : alu_bigint_shr(operand, count, shift, result, &flags);
+                uint8_t top = bigint_nibble(expected, count - 1);
+                if (status != 0 || memcmp(result, expected, byte_count) != 0 || flags.carry_flag != carry ||
+                    flags.zero_flag != !nonzero || flags.result != top || flags.negative_flag != (top >> 3) ||
+                    flags.overflow_flag != 0 || result[byte_count] != 0xA5) {
+                    printf("BIGINT fail: %s count %zu by %zu -> C=%u Z=%u top=%u (exp C=%u Z=%u top=%u)\n",
+                           left ? "SHL" : "SHR", count, shift, flags.carry_flag, flags.zero_flag, flags.result,
+                           carry, !nonzero, top);
+                    ++failure_count;
+                }
+            }
+        }
+
+        /* a shift by one is a chain of alu_shl from the lowest nibble */
+        AluResult chain = {0, 0, 0, 0, 0};
+        AluResult flags;
+        alu_bigint_shl(operand, count, 1, result, &flags);
+        for (size_t index = 0; index < count; ++index) {
+            uint8_t carry_in = chain.carry_flag;
+            chain = alu_shl(bigint_nibble(operand, index));
+            if (bigint_nibble(result, index) != (chain.result | carry_in)) {
+                printf("BIGINT fail: SHL by 1 nibble %zu differs from the alu_shl chain\n", index);
+                ++failure_count;
+                break;
+            }
+        }
+        if (flags.carry_flag != chain.carry_flag) {
+            printf("BIGINT fail: SHL by 1 carry differs from the alu_shl chain\n");
+            ++failure_count;
+        }
+
+        /* in place */
+        memcpy(expected, operand, sizeof(expected));
+        alu_bigint_shr(operand, count, 9, result, NULL);
+        alu_bigint_shr(expected, count, 9, expected, NULL);
+        if (memcmp(result, expected, byte_count) != 0) {
+            printf("BIGINT fail: in-place SHR count %zu should match\n", count);
+            ++failure_count;
+        }
+    }
+    return failure_count;
+}
+
 int main(void) {
     int failure_count = 0;
 
@@ -117,6 +536,12 @@ int main(void) {
     failure_count += test_sub_basic();
     failure_count += test_logic_ops();
     failure_count += test_shifts();
+    failure_count += test_bitslice_exhaustive();
+    failure_count += test_lut_exhaustive();
+    failure_count += test_batch_kernels();
+    failure_count += test_carry_chain_exhaustive();
+    failure_count += test_bigint_add_sub();
+    failure_count += test_bigint_shifts();
 
     if (failure_count == 0) {
         printf("ALU tests: ALL PASSED\n");
@@ -0,0 +1,212 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "aot/aot.h"
+#include "vm/vm.h"
+#include "vm/vm_ports.h"
+
+/* Generated at build time from tests/programs by giga_add_aot_program. */
+#include "aot_loop.h"
+#include "aot_selfmod.h"
+#include "aot_branch.h"
+#include "aot_ports.h"
+
+typedef int (*AotLoadFunction)(GigaVmState *state);
+typedef GigaVmStatus (*AotRunFunction)(GigaVmState *state, uint64_t max_steps);
+
+static int aot_states_equal(const GigaVmState *left, const GigaVmState *right) {
+    return memcmp(left->registers, right->registers, sizeof(left->registers)) == 0 &&
+           left->flags_zero == right->flags_zero &&
+           left->flags_carry == right->flags_carry &&
+           left->flags_negative == right->flags_negative &&
+           left->flags_overflow == right->flags_overflow &&
+           left->program_counter == right->program_counter &&
+           memcmp(left->memory, right->memory, sizeof(left->memory)) == 0;
+}
+
+/* Run the translated and interpreted program side by side in chunks of chunk_steps. */
+static int aot_compare_chunked(const char *name, AotLoadFunction load, AotRunFunction run,
+                               const uint16_t *program, size_t word_count,
+                               uint64_t chunk_steps, int max_chunks) {
+    static GigaVmState translated;
+    static GigaVmState interpreted;
+    giga_vm_init(&translated);
+    giga_vm_init(&interpreted);
+    if (load(&translated) != 0 || giga_vm_load_program(&interpreted, program, word_count) != 0) {
+        printf("AOT fail: %s did not load\n", name);
+        return 1;
+    }
+
+    for (int chunk = 0; chunk < max_chunks; ++chunk) {
+        GigaVmStatus translated_status = run(&translated, chunk_steps);
+        GigaVmStatus interpreted_status = giga_vm_run(&interpreted, chunk_steps);
+        if (translated_status != interpreted_status || !aot_states_equal(&translated, &interpreted)) {
+            printf("AOT fail: %s differs from giga_vm_run (chunk %d of %llu steps)\n",
+                   name, chunk, (unsigned long long)chunk_steps);
+            return 1;
+        }
+        if (translated_status != GIGA_VM_STATUS_STEP_LIMIT) {
+            break;
+        }
+    }
+    return 0;
+}
+
+static int test_aot_loop_matches_interpreter(void) {
+    int failure_count = 0;
+
+    for (uint64_t max_steps = 0; max_steps < 64; ++max_steps) {
+        failure_count += aot_compare_chunked("aot_loop", aot_loop_load, aot_loop,
+                                             aot_loop_program, aot_loop_program_words,
+                                             max_steps, 1);
+    }
+    failure_count += aot_compare_chunked("aot_loop", aot_loop_load, aot_loop,
+                                         aot_loop_program, aot_loop_program_words,
+                                         1000003u, 1);
+    for (uint64_t chunk_steps = 1; chunk_steps < 16; ++chunk_steps) {
+        failure_count += aot_compare_chunked("aot_loop", aot_loop_load, aot_loop,
+                                             aot_loop_program, aot_loop_program_words,
+                                             chunk_steps, 40);
+    }
+
+    return failure_count;
+}
+
+static int test_aot_self_modifying_program(void) {
+    int failure_count = 0;
+
+    static GigaVmState state;
+    giga_vm_init(&state);
+    aot_selfmod_load(&state);
+    GigaVmStatus status = aot_selfmod(&state, UINT64_MAX);
+    if (status != GIGA_VM_STATUS_HALTED || state.program_counter != 8 || state.registers[0] != 1) {
+        printf("AOT fail: self-modifying program should halt at 8 with R0=1 (status %d, pc %u, R0 %u)\n",
+               (int)status, state.program_counter, state.registers[0]);
+        ++failure_count;
+    }
+
+    /* Resuming after the store must not re-enter the stale translation. */
+    for (uint64_t chunk_steps = 0; chunk_steps < 12; ++chunk_steps) {
+        failure_count += aot_compare_chunked("aot_selfmod", aot_selfmod_load, aot_selfmod,
+                                             aot_selfmod_program, aot_selfmod_program_words,
+                                             chunk_steps, 20);
+    }
+
+    return failure_count;
+}
+
+static int test_aot_branch_program(void) {
+    int failure_count = 0;
+
+    static GigaVmState state;
+    giga_vm_init(&state);
+    aot_branch_load(&state);
+    GigaVmStatus status = aot_branch(&state, UINT64_MAX);
+    if (status != GIGA_VM_STATUS_HALTED || state.program_counter != aot_branch_program_words - 1u ||
+        state.registers[0] != 0) {
+        printf("AOT fail: branch program should halt on its last word with R0=0 (status %d, pc %u)\n",
+               (int)status, state.program_counter);
+        ++failure_count;
+    }
+
+    /* budgets that run out on either side of each branch */
+    for (uint64_t chunk_steps = 0; chunk_steps < 16; ++chunk_steps) {
+        failure_count += aot_compare_chunked("aot_branch", aot_branch_load, aot_branch,
+                                             aot_branch_program, aot_branch_program_words,
+                                             chunk_steps, 200);
+    }
+
+    return failure_count;
+}
+
+static int test_aot_ports_program(void) {
+    int failure_count = 0;
+    const uint16_t expected[] = {0x2101, 0xE500, 0x3000, 0xE610, 0x3210, 0xD001};
+    if (aot_ports_program_words != 6 || memcmp(aot_ports_program, expected, sizeof(expected)) != 0) {
+        printf("AOT fail: IN R0, 0 / OUT 1, R0 assembled wrong\n");
+        return 1;
+    }
+
+    /* the translated code hands IN/OUT to the interpreter, which uses the ports */
+    static GigaVmState state;
+    giga_vm_init(&state);
+    aot_ports_load(&state);
+    if (aot_ports(&state, 100) != GIGA_VM_STATUS_PORT_FAULT || state.program_counter != 1) {
+        printf("AOT fail: IN without ports should fault at PC 1\n");
+        ++failure_count;
+    }
+    GigaVmPorts *ports = giga_vm_ports_create(16);
+    giga_vm_attach_ports(&state, ports);
+    for (uint8_t nibble = 1; nibble <= 5; ++nibble) {
+        giga_vm_ring_push(&ports->input[0], nibble);
+    }
+    GigaVmStatus status = aot_ports(&state, 1000);
+    uint8_t value = 0;
+    if (status != GIGA_VM_STATUS_IO_WAIT || state.program_counter != 1 || state.registers[2] != 5 ||
+        giga_vm_ring_count(&ports->output[1]) != 5 || !giga_vm_ring_pop(&ports->output[1], &value) ||
+        value != 2) {
+        printf("AOT fail: ports program should double 5 nibbles and wait (status %d, pc %u)\n", (int)status,
+               state.program_counter);
+        ++failure_count;
+    }
+    giga_vm_attach_ports(&state, NULL);
+    giga_vm_ports_destroy(ports);
+    return failure_count;
+}
+
+static int test_aot_translate_arguments(void) {
+    int failure_count = 0;
+    const uint16_t program[] = {0x2105, 0xF000}; /* MOVI R1, 5; HALT */
+
+    FILE *output = tmpfile();
+    if (output == NULL) {
+        printf("AOT fail: tmpfile unavailable\n");
+        return 1;
+    }
+
+    if (giga_aot_translate(program, 2, "3bad", output) != -1 ||
+        giga_aot_translate(program, 0, "empty", output) != -1 ||
+        giga_aot_translate(NULL, 2, "missing", output) != -1 ||
+        giga_aot_write_header("bad-name", output) != -1) {
+        printf("AOT fail: invalid arguments should return -1\n");
+        ++failure_count;
+    }
+
+    if (giga_aot_translate(program, 2, "small_program", output) != 0) {
+        printf("AOT fail: valid program should translate\n");
+        ++failure_count;
+    }
+
+    char text[8192];
+    rewind(output);
+    size_t length = fread(text, 1, sizeof(text) - 1u, output);
+    text[length] = '\0';
+    fclose(output);
+
+    if (strstr(text, "GigaVmStatus small_program(GigaVmState *state, uint64_t max_steps)") == NULL ||
+        strstr(text, "int small_program_load(GigaVmState *state)") == NULL ||
+        strstr(text, "GIGA_VM_STATUS_HALTED") == NULL) {
+        printf("AOT fail: translation missing expected definitions\n");
+        ++failure_count;
+    }
+
+    return failure_count;
+}
+
+int main(void) {
+    int failure_count = 0;
+
+    failure_count += test_aot_loop_matches_interpreter();
+    failure_count += test_aot_self_modifying_program();
+    failure_count += test_aot_branch_program();
+    failure_count += test_aot_ports_program();
+    failure_count += test_aot_translate_arguments();
+
+    if (failure_count == 0) {
+        printf("AOT tests: ALL PASSED\n");
+        return 0;
+    }
+
+    printf("AOT tests: %d failure(s)\n", failure_count);
+    return 1;
+}
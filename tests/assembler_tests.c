@@ -0,0 +1,337 @@
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "assembler/assembler.h"
+#include "assembler/assembler_cache.h"
+
+static const char *giga_test_program =
+    "start:\n"
+    "    MOVI R0, 5\n"
+    "    MOVI R1, 1\n"
+    "loop:\n"
+    "    SUB R0, R1\n"
+    "    CMP R0, R2\n"
+    "    JNZ loop\n"
+    "    HALT\n";
+
+static int test_hash(void) {
+    int failure_count = 0;
+    /* reference XXH64 values */
+    if (giga_assembler_hash("", 0, 0) != 0xEF46DB3751D8E999u ||
+        giga_assembler_hash("a", 1, 0) != 0xD24EC4F1A98C6E5Bu ||
+        giga_assembler_hash("abc", 3, 0) != 0x44BC2CF5AD770999u) {
+        printf("ASSEMBLER fail: giga_assembler_hash does not match XXH64\n");
+        ++failure_count;
+    }
+    /* every length through the stripe loop and the tails, and the seed */
+    char text[100];
+    for (size_t index = 0; index < sizeof(text); ++index) {
+        text[index] = (char)('a' + index % 26u);
+    }
+    for (size_t length = 1; length <= sizeof(text); ++length) {
+        uint64_t hash = giga_assembler_hash(text, length, 1);
+        if (hash == giga_assembler_hash(text, length - 1u, 1) || hash == giga_assembler_hash(text, length, 2) ||
+            hash != giga_assembler_hash(text, length, 1)) {
+            printf("ASSEMBLER fail: hash of %zu bytes not distinct or not stable\n", length);
+            ++failure_count;
+            break;
+        }
+    }
+    return failure_count;
+}
+
+static int test_assemble_without_cache(void) {
+    int failure_count = 0;
+    GigaAssemblerResult result;
+    if (giga_assembler_cache_assemble(NULL, giga_test_program, strlen(giga_test_program), &result) != 0) {
+        printf("ASSEMBLER fail: uncached assembly: %s\n", result.error_message);
+        return failure_count + 1;
+    }
+    if (result.word_count != 6 || result.bytecode[0] != 0x2005 || result.bytecode[5] != 0xF000 ||
+        result.source_lines[2] != 5 || result.label_count != 2 || result.labels[1].address != 2 ||
+        result.labels[1].name != strstr(giga_test_program, "loop")) {
+        printf("ASSEMBLER fail: uncached assembly gave %zu words\n", result.word_count);
+        ++failure_count;
+    }
+    giga_assembler_free(&result);
+
+    const char *bad = "MOVI R0,\n";
+    if (giga_assembler_cache_assemble(NULL, bad, strlen(bad), &result) == 0 || !result.has_error ||
+        result.error_message == NULL || result.error_line != 1) {
+        printf("ASSEMBLER fail: parse error not reported in the result\n");
+        ++failure_count;
+    }
+    giga_assembler_free(&result);
+    return failure_count;
+}
+
+/* Results must agree word for word, line for line and label for label. */
+static int giga_test_same_result(const GigaAssemblerResult *left, const GigaAssemblerResult *right) {
+    if (left->word_count != right->word_count || left->label_count != right->label_count) {
+        return 0;
+    }
+    for (size_t index = 0; index < left->word_count; ++index) {
+        if (left->bytecode[index] != right->bytecode[index] ||
+            left->source_lines[index] != right->source_lines[index]) {
+            return 0;
+        }
+    }
+    for (size_t index = 0; index < left->label_count; ++index) {
+        if (left->labels[index].name != right->labels[index].name ||
+            left->labels[index].name_length != right->labels[index].name_length ||
+            left->labels[index].address != right->labels[index].address) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int test_cache(void) {
+    int failure_count = 0;
+    char directory[] = "/tmp/giga_cache_XXXXXX";
+    if (mkdtemp(directory) == NULL) {
+        printf("ASSEMBLER fail: cannot create a temporary directory\n");
+        return failure_count + 1;
+    }
+    GigaAssemblerCache *cache = giga_assembler_cache_open(directory);
+    if (cache == NULL) {
+        printf("ASSEMBLER fail: giga_assembler_cache_open\n");
+        rmdir(directory);
+        return failure_count + 1;
+    }
+
+    size_t length = strlen(giga_test_program);
+    GigaAssemblerResult expected;
+    GigaAssemblerResult first;
+    GigaAssemblerResult second;
+    GigaAssemblerCacheStats stats;
+    giga_assembler_cache_assemble(NULL, giga_test_program, length, &expected);
+    if (giga_assembler_cache_assemble(cache, giga_test_program, length, &first) != 0 ||
+        giga_assembler_cache_assemble(cache, giga_test_program, length, &second) != 0) {
+        printf("ASSEMBLER fail: cached assembly failed\n");
+        ++failure_count;
+    }
+    giga_assembler_cache_stats(cache, &stats);
+    if (stats.hits != 1 || stats.misses != 1 || stats.write_failures != 0) {
+        printf("ASSEMBLER fail: stats after miss then hit: hits=%llu misses=%llu\n",
+               (unsigned long long)stats.hits, (unsigned long long)stats.misses);
+        ++failure_count;
+    }
+    if (!giga_test_same_result(&expected, &first) || !giga_test_same_result(&expected, &second)) {
+        printf("ASSEMBLER fail: cache hit differs from assembling\n");
+        ++failure_count;
+    }
+    giga_assembler_free(&first);
+    giga_assembler_free(&second);
+
+    /* the same text at another address still hits, with names into that copy */
+    char *copy = (char *)malloc(length + 1u);
+    memcpy(copy, giga_test_program, length + 1u);
+    if (giga_assembler_cache_assemble(cache, copy, length, &first) != 0 || first.label_count != 2 ||
+        first.labels[1].name != strstr(copy, "loop")) {
+        printf("ASSEMBLER fail: hit on a copy of the source\n");
+        ++failure_count;
+    }
+    giga_assembler_free(&first);
+
+    /* an edit is a miss; failed programs are not stored */
+    copy[strlen("start:\n    MOVI R0, ")] = '7';
+    giga_assembler_cache_assemble(cache, copy, length, &first);
+    if (first.has_error || first.bytecode[0] != 0x2007) {
+        printf("ASSEMBLER fail: edited source served from the old entry\n");
+        ++failure_count;
+    }
+    giga_assembler_free(&first);
+    const char *bad = "MOVI R0,\n";
+    giga_assembler_cache_assemble(cache, bad, strlen(bad), &first);
+    giga_assembler_free(&first);
+    giga_assembler_cache_assemble(cache, bad, strlen(bad), &first);
+    giga_assembler_free(&first);
+    giga_assembler_cache_stats(cache, &stats);
+    if (stats.hits != 2 || stats.misses != 4) {
+        printf("ASSEMBLER fail: stats after edits: hits=%llu misses=%llu\n", (unsigned long long)stats.hits,
+               (unsigned long long)stats.misses);
+        ++failure_count;
+    }
+
+    /* a damaged entry is a miss and is rewritten */
+    char path[64];
+    snprintf(path, sizeof(path), "%s/%016llx.gac", directory,
+             (unsigned long long)giga_assembler_hash(giga_test_program, length, GIGA_ASSEMBLER_VERSION));
+    FILE *entry = fopen(path, "r+b");
+    if (entry == NULL) {
+        printf("ASSEMBLER fail: no entry at %s\n", path);
+        ++failure_count;
+    } else {
+        fseek(entry, -1, SEEK_END);
+        fputc(0x5A, entry);
+        fclose(entry);
+        giga_assembler_cache_assemble(cache, giga_test_program, length, &first);
+        giga_assembler_cache_assemble(cache, giga_test_program, length, &second);
+        giga_assembler_cache_stats(cache, &stats);
+        if (!giga_test_same_result(&expected, &first) || !giga_test_same_result(&expected, &second) ||
+            stats.hits != 3 || stats.misses != 5) {
+            printf("ASSEMBLER fail: damaged entry: hits=%llu misses=%llu\n", (unsigned long long)stats.hits,
+                   (unsigned long long)stats.misses);
+            ++failure_count;
+        }
+        giga_assembler_free(&first);
+        giga_assembler_free(&second);
+    }
+
+    /* a store that died before its rename leaves a temporary, which clear also removes */
+    char temporary[64];
+    snprintf(temporary, sizeof(temporary), "%s/.gac.AbC123", directory);
+    entry = fopen(temporary, "wb");
+    if (entry != NULL) {
+        fputs("GAC", entry);
+        fclose(entry);
+    }
+    if (giga_assembler_cache_clear(cache) != 2) {
+        printf("ASSEMBLER fail: giga_assembler_cache_clear should remove both entries\n");
+        ++failure_count;
+    }
+    giga_assembler_free(&expected);
+    free(copy);
+    giga_assembler_cache_close(cache);
+    if (rmdir(directory) != 0) {
+        printf("ASSEMBLER fail: cache directory not empty after clear\n");
+        ++failure_count;
+    }
+    return failure_count;
+}
+
+/* An entry whose hash and length match but whose source differs is a miss. */
+static int test_cache_collision(void) {
+    int failure_count = 0;
+    char directory[] = "/tmp/giga_cache_XXXXXX";
+    if (mkdtemp(directory) == NULL) {
+        printf("ASSEMBLER fail: cannot create a temporary directory\n");
+        return failure_count + 1;
+    }
+    GigaAssemblerCache *cache = giga_assembler_cache_open(directory);
+    if (cache == NULL) {
+        printf("ASSEMBLER fail: giga_assembler_cache_open\n");
+        rmdir(directory);
+        return failure_count + 1;
+    }
+
+    size_t length = strlen(giga_test_program);
+    char *other = (char *)malloc(length + 1u);
+    memcpy(other, giga_test_program, length + 1u);
+    other[strlen("start:\n    MOVI R0, ")] = '7';
+    uint64_t hash = giga_assembler_hash(giga_test_program, length, GIGA_ASSEMBLER_VERSION);
+    uint64_t other_hash = giga_assembler_hash(other, length, GIGA_ASSEMBLER_VERSION);
+
+    GigaAssemblerResult result;
+    giga_assembler_cache_assemble(cache, giga_test_program, length, &result);
+    giga_assembler_free(&result);
+
+    /* copy the entry to the other source's name, as if the hashes collided */
+    char path[64];
+    char other_path[64];
+    snprintf(path, sizeof(path), "%s/%016llx.gac", directory, (unsigned long long)hash);
+    snprintf(other_path, sizeof(other_path), "%s/%016llx.gac", directory, (unsigned long long)other_hash);
+    unsigned char entry[4096];
+    size_t entry_bytes = 0;
+    FILE *file = fopen(path, "rb");
+    if (file != NULL) {
+        entry_bytes = fread(entry, 1, sizeof(entry), file);
+        fclose(file);
+    }
+    if (entry_bytes <= 48u) {
+        printf("ASSEMBLER fail: no entry at %s\n", path);
+        ++failure_count;
+    } else {
+        /* source_hash at byte 24, payload_hash (seeded with it) at byte 40 */
+        uint64_t payload_hash = giga_assembler_hash(entry + 48, entry_bytes - 48u, other_hash);
+        memcpy(entry + 24, &other_hash, sizeof(other_hash));
+        memcpy(entry + 40, &payload_hash, sizeof(payload_hash));
+        file = fopen(other_path, "wb");
+        if (file != NULL) {
+            fwrite(entry, 1, entry_bytes, file);
+            fclose(file);
+        }
+        GigaAssemblerCacheStats stats;
+        giga_assembler_cache_assemble(cache, other, length, &result);
+        giga_assembler_cache_stats(cache, &stats);
+        if (result.has_error || result.bytecode[0] != 0x2007 || stats.hits != 0 || stats.misses != 2) {
+            printf("ASSEMBLER fail: forged entry served: hits=%llu misses=%llu\n",
+                   (unsigned long long)stats.hits, (unsigned long long)stats.misses);
+            ++failure_count;
+        }
+        giga_assembler_free(&result);
+
+        /* the miss rewrote the entry with the right source */
+        giga_assembler_cache_assemble(cache, other, length, &result);
+        giga_assembler_cache_stats(cache, &stats);
+        if (result.has_error || result.bytecode[0] != 0x2007 || stats.hits != 1) {
+            printf("ASSEMBLER fail: rewritten entry not hit\n");
+            ++failure_count;
+        }
+        giga_assembler_free(&result);
+    }
+
+    if (giga_assembler_cache_clear(cache) != 2) {
+        printf("ASSEMBLER fail: giga_assembler_cache_clear should remove both entries\n");
+        ++failure_count;
+    }
+    free(other);
+    giga_assembler_cache_close(cache);
+    if (rmdir(directory) != 0) {
+        printf("ASSEMBLER fail: cache directory not empty after clear\n");
+        ++failure_count;
+    }
+    return failure_count;
+}
+
+/* Branches past word 255: by offset when near, around a JMP when far. */
+static int test_long_branches(void) {
+    int failure_count = 0;
+    char source[4096];
+    size_t length = (size_t)sprintf(source, "start:\n    JZ end\n    JC end\n");
+    for (int index = 0; index < 300; ++index) {
+        length += (size_t)sprintf(source + length, "    NOP\n");
+    }
+    length += (size_t)sprintf(source + length, "loop:\n    SUB R0, R1\n    JNZ loop\nend:\n    HALT\n");
+
+    static const uint16_t expected[] = {
+        0xE902, 0xD133,         /* JZ end: JNZ 2, JMP 307 */
+        0xEA04, 0xD005, 0xD133, /* JC end: JC 4, JMP 5, JMP 307 */
+    };
+    GigaAssemblerResult result;
+    if (giga_assembler_cache_assemble(NULL, source, length, &result) != 0) {
+        printf("ASSEMBLER fail: long branches: %s\n", result.error_message);
+        return failure_count + 1;
+    }
+    if (result.word_count != 308 || memcmp(result.bytecode, expected, sizeof(expected)) != 0 ||
+        result.bytecode[306] != 0xEDFE /* JNZ by -2 */ || result.bytecode[307] != 0xF000 ||
+        result.source_lines[1] != 2 || result.source_lines[4] != 3 || result.label_count != 3 ||
+        result.labels[1].address != 305 || result.labels[2].address != 307) {
+        printf("ASSEMBLER fail: long branches laid out as %zu words\n", result.word_count);
+        ++failure_count;
+    }
+    giga_assembler_free(&result);
+    return failure_count;
+}
+
+int main(void) {
+    int failure_count = 0;
+
+    failure_count += test_hash();
+    failure_count += test_assemble_without_cache();
+    failure_count += test_cache();
+    failure_count += test_cache_collision();
+    failure_count += test_long_branches();
+
+    if (failure_count == 0) {
+        printf("Assembler tests: ALL PASSED\n");
+        return 0;
+    }
+
+    printf("Assembler tests: %d failure(s)\n", failure_count);
+    return 1;
+}
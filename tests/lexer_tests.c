@@ -170,6 +170,232 @@ static int test_labels(void) {
     return failure_count;
 }
 
+/* Long runs cross the vector blocks and windows the fast path scans. */
+static int test_long_runs(void) {
+    int failure_count = 0;
+    char source[512];
+    size_t length = 0;
+    /* spaces, a comment and an identifier each longer than a 64-byte window */
+    memset(source, ' ', 70);
+    length += 70;
+    source[length++] = ';';
+    memset(source + length, 'c', 80);
+    length += 80;
+    source[length++] = '\n';
+    memset(source + length, '\t', 3);
+    length += 3;
+    memset(source + length, 'a', 100);
+    length += 100;
+    length += (size_t)sprintf(source + length, " 12345, 0x1F:\n  .word 7");
+
+    static const struct {
+        GigaTokenKind kind;
+        size_t text_length;
+        size_t line_number;
+        size_t column_number;
+    } expected[] = {
+        {GIGA_TOKEN_NEWLINE, 1, 1, 152},  {GIGA_TOKEN_IDENTIFIER, 100, 2, 4}, {GIGA_TOKEN_NUMBER, 5, 2, 105},
+        {GIGA_TOKEN_COMMA, 1, 2, 110},    {GIGA_TOKEN_NUMBER, 4, 2, 112},     {GIGA_TOKEN_COLON, 1, 2, 116},
+        {GIGA_TOKEN_NEWLINE, 1, 2, 117},  {GIGA_TOKEN_DIRECTIVE, 5, 3, 3},    {GIGA_TOKEN_NUMBER, 1, 3, 9},
+        {GIGA_TOKEN_EOF, 0, 3, 10},
+    };
+
+    GigaLexer lexer;
+    giga_lexer_init(&lexer, source, length);
+    for (size_t index = 0; index < sizeof(expected) / sizeof(expected[0]); ++index) {
+        GigaToken token = giga_lexer_next_token(&lexer);
+        if (token.kind != expected[index].kind || token.text_length != expected[index].text_length ||
+            token.line_number != expected[index].line_number ||
+            token.column_number != expected[index].column_number) {
+            printf("LEXER fail: token %zu is kind %d length %zu at %zu:%zu\n", index, (int)token.kind,
+                   token.text_length, token.line_number, token.column_number);
+            ++failure_count;
+            break;
+        }
+    }
+    return failure_count;
+}
+
+/* Token edges at every offset around the end of the first 64-byte window. */
+static int test_window_edges(void) {
+    int failure_count = 0;
+    static const struct {
+        const char *name;
+        const char *text;
+        size_t text_bytes;
+        struct {
+            GigaTokenKind kind;
+            size_t offset;
+            size_t text_length;
+            size_t line_number;
+        } tokens[3];
+        size_t token_count;
+    } cases[] = {
+        {"number then letters", "12ab", 4,
+         {{GIGA_TOKEN_NUMBER, 0, 2, 1}, {GIGA_TOKEN_IDENTIFIER, 2, 2, 1}}, 2},
+        {"hex number", "0x1Fz", 5, {{GIGA_TOKEN_NUMBER, 0, 4, 1}, {GIGA_TOKEN_IDENTIFIER, 4, 1, 1}}, 2},
+        {"straddling identifier", "abcdefgh,", 9,
+         {{GIGA_TOKEN_IDENTIFIER, 0, 8, 1}, {GIGA_TOKEN_COMMA, 8, 1, 1}}, 2},
+        {"comment", "; comment text\nX", 16,
+         {{GIGA_TOKEN_NEWLINE, 14, 1, 1}, {GIGA_TOKEN_IDENTIFIER, 15, 1, 2}}, 2},
+        {"NUL", "AB\0CD", 5,
+         {{GIGA_TOKEN_IDENTIFIER, 0, 2, 1}, {GIGA_TOKEN_EOF, 2, 0, 1}, {GIGA_TOKEN_EOF, 2, 0, 1}}, 3},
+        {"high bytes", "\x80\xff" "1", 3,
+         {{GIGA_TOKEN_UNKNOWN, 0, 1, 1}, {GIGA_TOKEN_UNKNOWN, 1, 1, 1}, {GIGA_TOKEN_NUMBER, 2, 1, 1}}, 3},
+    };
+
+    char source[256];
+    for (size_t index = 0; index < sizeof(cases) / sizeof(cases[0]); ++index) {
+        for (size_t pad = 0; pad <= 72; ++pad) {
+            /* padding of spaces, or of "x " pairs so the window is reloaded along the way */
+            for (int filler = 0; filler < 2; ++filler) {
+                for (size_t byte = 0; byte < pad; ++byte) {
+                    source[byte] = (filler && (pad - byte) % 2u == 0) ? 'x' : ' ';
+                }
+                memcpy(source + pad, cases[index].text, cases[index].text_bytes);
+                size_t length = pad + cases[index].text_bytes;
+                memset(source + length, ' ', 80);
+                length += 80;
+
+                GigaLexer lexer;
+                giga_lexer_init(&lexer, source, length);
+                GigaToken token = giga_lexer_next_token(&lexer);
+                while (token.kind == GIGA_TOKEN_IDENTIFIER && token.text_begin < source + pad) {
+                    token = giga_lexer_next_token(&lexer);
+                }
+                for (size_t position = 0; position < cases[index].token_count; ++position) {
+                    size_t offset = pad + cases[index].tokens[position].offset;
+                    size_t column = (cases[index].tokens[position].line_number == 1)
+                                        ? offset + 1u
+                                        : offset - (size_t)(strchr(source + pad, '\n') - source);
+                    if (token.kind != cases[index].tokens[position].kind ||
+                        (token.kind != GIGA_TOKEN_EOF && token.text_begin != source + offset) ||
+                        token.text_length != cases[index].tokens[position].text_length ||
+                        token.line_number != cases[index].tokens[position].line_number ||
+                        token.column_number != column) {
+                        printf("LEXER fail: %s at offset %zu: token %zu is kind %d length %zu at %zu:%zu\n",
+                               cases[index].name, pad, position, (int)token.kind, token.text_length,
+                               token.line_number, token.column_number);
+                        ++failure_count;
+                        break;
+                    }
+                    token = giga_lexer_next_token(&lexer);
+                }
+            }
+        }
+    }
+    return failure_count;
+}
+
+/* Byte-at-a-time lexer with the rules of the scalar path, for comparison. */
+static GigaToken giga_test_reference_token(const char *source, size_t length, size_t *index, size_t *line,
+                                           size_t *line_start) {
+#define PEEK(at) (((at) < length) ? (unsigned char)source[at] : 0)
+#define IS_WORD(c) ((c) == '_' || ((c) >= '0' && (c) <= '9') || (((c) | 0x20) >= 'a' && ((c) | 0x20) <= 'z'))
+    size_t at = *index;
+    for (;;) {
+        while (PEEK(at) == ' ' || PEEK(at) == '\t' || PEEK(at) == '\r' || PEEK(at) == '\f' || PEEK(at) == '\v') {
+            ++at;
+        }
+        if (PEEK(at) != ';') {
+            break;
+        }
+        while (PEEK(at) != 0 && PEEK(at) != '\n') {
+            ++at;
+        }
+    }
+    GigaToken token;
+    memset(&token, 0, sizeof(token));
+    token.line_number = *line;
+    token.column_number = at - *line_start + 1u;
+    int character = PEEK(at);
+    size_t end = at + 1u;
+    if (character == 0) {
+        *index = at;
+        token.kind = GIGA_TOKEN_EOF;
+        return token;
+    } else if (character == '\n') {
+        token.kind = GIGA_TOKEN_NEWLINE;
+        *line += 1u;
+        *line_start = end;
+    } else if (character == ',') {
+        token.kind = GIGA_TOKEN_COMMA;
+    } else if (character == ':') {
+        token.kind = GIGA_TOKEN_COLON;
+    } else if (character == '.') {
+        token.kind = GIGA_TOKEN_DIRECTIVE;
+        while (IS_WORD(PEEK(end))) {
+            ++end;
+        }
+    } else if (character >= '0' && character <= '9') {
+        token.kind = GIGA_TOKEN_NUMBER;
+        if (character == '0' && (PEEK(end) | 0x20) == 'x') {
+            ++end;
+            while ((PEEK(end) >= '0' && PEEK(end) <= '9') || ((PEEK(end) | 0x20) >= 'a' && (PEEK(end) | 0x20) <= 'f')) {
+                ++end;
+            }
+        } else {
+            while (PEEK(end) >= '0' && PEEK(end) <= '9') {
+                ++end;
+            }
+        }
+    } else if (IS_WORD(character)) {
+        token.kind = GIGA_TOKEN_IDENTIFIER;
+        while (IS_WORD(PEEK(end))) {
+            ++end;
+        }
+    } else {
+        token.kind = GIGA_TOKEN_UNKNOWN;
+    }
+#undef PEEK
+#undef IS_WORD
+    token.text_begin = source + at;
+    token.text_length = end - at;
+    *index = end;
+    return token;
+}
+
+/* Random sources built from the bytes the window path treats specially. */
+static int test_against_reference(void) {
+    int failure_count = 0;
+    static const char alphabet[] = "   \t\r;;\n\n,:.0123456789xXaAfFgz__\x80\xff";
+    uint32_t state = 12345u;
+    char source[400];
+    for (int round = 0; round < 3000 && failure_count == 0; ++round) {
+        state = state * 1103515245u + 12345u;
+        size_t length = 64u + (state >> 16) % (sizeof(source) - 64u);
+        for (size_t byte = 0; byte < length; ++byte) {
+            state = state * 1103515245u + 12345u;
+            source[byte] = alphabet[(state >> 16) % sizeof(alphabet)]; /* the final NUL included */
+        }
+
+        GigaLexer lexer;
+        giga_lexer_init(&lexer, source, length);
+        size_t index = 0;
+        size_t line = 1;
+        size_t line_start = 0;
+        for (size_t count = 0;; ++count) {
+            GigaToken token = giga_lexer_next_token(&lexer);
+            GigaToken expected = giga_test_reference_token(source, length, &index, &line, &line_start);
+            if (token.kind != expected.kind || token.line_number != expected.line_number ||
+                token.column_number != expected.column_number ||
+                (expected.kind != GIGA_TOKEN_EOF &&
+                 (token.text_begin != expected.text_begin || token.text_length != expected.text_length))) {
+                printf("LEXER fail: round %d token %zu is kind %d length %zu at %zu:%zu, expected kind %d "
+                       "length %zu at %zu:%zu\n",
+                       round, count, (int)token.kind, token.text_length, token.line_number, token.column_number,
+                       (int)expected.kind, expected.text_length, expected.line_number, expected.column_number);
+                ++failure_count;
+                break;
+            }
+            if (expected.kind == GIGA_TOKEN_EOF) {
+                break;
+            }
+        }
+    }
+    return failure_count;
+}
+
 int main(void) {
     int failure_count = 0;
 
@@ -177,6 +403,9 @@ int main(void) {
     failure_count += test_numbers();
     failure_count += test_comments();
     failure_count += test_labels();
+    failure_count += test_long_runs();
+    failure_count += test_window_edges();
+    failure_count += test_against_reference();
 
     if (failure_count == 0) {
         printf("Lexer tests: ALL PASSED\n");
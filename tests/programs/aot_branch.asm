@@ -0,0 +1,25 @@
+; Conditional branches for the AOT tests: nested countdown loops that halt.
+    MOVI R0, 6
+    MOVI R1, 1
+    MOVI R7, 0
+OUTER:
+    MOV  R2, R0
+INNER:
+    ADD  R3, R2
+    JC   CARRY
+    JMP  NEXT
+CARRY:
+    ADD  R4, R1
+NEXT:
+    SUB  R2, R1
+    JNZ  INNER
+    XOR  R5, R3
+    JN   NEGATIVE
+    ADD  R6, R1
+NEGATIVE:
+    SUB  R0, R1
+    CMP  R0, R7
+    JZ   DONE
+    JMP  OUTER
+DONE:
+    HALT
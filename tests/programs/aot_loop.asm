@@ -0,0 +1,18 @@
+; ALU workout for the AOT tests. Never halts; compared under step budgets.
+    MOVI R0, 1
+    MOVI R1, 3
+    LD   R4, [3]
+LOOP:
+    ADD  R0, R1
+    SUB  R2, R0
+    AND  R3, R2
+    OR   R3, R1
+    XOR  R5, R3
+    NOT  R6
+    SHL  R1
+    SHR  R7
+    MOV  R7, R5
+    ADD  R7, R4
+    ADC  R2, R7
+    SBC  R6, R1
+    JMP  LOOP
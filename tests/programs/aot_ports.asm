@@ -0,0 +1,9 @@
+; Port I/O for the AOT tests: double every nibble from port 0 onto port 1,
+; counting them in R2.
+    MOVI R1, 1
+LOOP:
+    IN   R0, 0
+    ADD  R0, R0
+    OUT  1, R0
+    ADD  R2, R1
+    JMP  LOOP
@@ -0,0 +1,12 @@
+; Self-modifying program for the AOT tests. The store clears the high byte
+; of word 7 (JMP LOOP), turning it into a NOP so execution reaches HALT.
+    MOVI R0, 0
+    MOVI R1, 1
+LOOP:
+    ADD  R0, R1
+    MOVI R2, 0
+    ST   [15], R2
+    NOP
+    NOP
+    JMP  LOOP
+    HALT
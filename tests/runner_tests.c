@@ -0,0 +1,218 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "runner/runner.h"
+#include "vm/vm_ports.h"
+
+static uint32_t runner_test_random(uint32_t *seed) {
+    *seed = *seed * 1103515245u + 12345u;
+    return (*seed >> 16) & 0x7FFFu;
+}
+
+/* Expected result: the same job run directly through giga_vm_run. */
+static GigaRunnerResult runner_test_reference(const GigaRunnerJob *job, int fuse) {
+    static GigaVmState state;
+    GigaRunnerResult result;
+    memset(&result, 0, sizeof(result));
+    if (job->initial_state != NULL) {
+        state = *job->initial_state;
+    } else {
+        giga_vm_init(&state);
+        if (giga_vm_load_program(&state, job->program_words, job->word_count) != 0) {
+            result.status = GIGA_VM_STATUS_INVALID_STATE;
+            return result;
+        }
+        if (job->initial_registers != NULL) {
+            memcpy(state.registers, job->initial_registers, sizeof(state.registers));
+        }
+    }
+    if (fuse) {
+        giga_vm_fuse_superinstructions(&state);
+    }
+    giga_vm_counters_reset(&state);
+    result.status = giga_vm_run(&state, job->max_steps);
+    result.program_counter = state.program_counter;
+    memcpy(result.registers, state.registers, sizeof(result.registers));
+    result.flags_zero = state.flags_zero;
+    result.flags_carry = state.flags_carry;
+    result.flags_negative = state.flags_negative;
+    result.flags_overflow = state.flags_overflow;
+    giga_vm_counters(&state, &result.counters);
+    return result;
+}
+
+static int runner_results_equal(const GigaRunnerResult *left, const GigaRunnerResult *right) {
+    return left->status == right->status &&
+           left->program_counter == right->program_counter &&
+           memcmp(left->registers, right->registers, sizeof(left->registers)) == 0 &&
+           left->flags_zero == right->flags_zero &&
+           left->flags_carry == right->flags_carry &&
+           left->flags_negative == right->flags_negative &&
+           left->flags_overflow == right->flags_overflow &&
+           memcmp(&left->counters, &right->counters, sizeof(left->counters)) == 0;
+}
+
+static int test_runner_matches_sequential(void) {
+    int failure_count = 0;
+    enum { PROGRAMS = 16, JOBS = 5000 };
+
+    static uint16_t programs[PROGRAMS][24];
+    static size_t word_counts[PROGRAMS];
+    static uint8_t registers[JOBS][GIGA_VM_REGISTER_COUNT];
+    static GigaRunnerJob jobs[JOBS];
+    static GigaRunnerResult results[JOBS];
+    static GigaVmState initial_state;
+
+    uint32_t seed = 4242u;
+    for (size_t program = 0; program < PROGRAMS; ++program) {
+        word_counts[program] = 4 + runner_test_random(&seed) % 20;
+        for (size_t index = 0; index < word_counts[program]; ++index) {
+            uint16_t opcode = (uint16_t)(runner_test_random(&seed) % 13); /* NOP..ST */
+            uint16_t operands = (uint16_t)(runner_test_random(&seed) & 0x0FFF);
+            if (opcode == GIGA_OP_ST) {
+                operands |= 0x0800; /* data region */
+            }
+            programs[program][index] = (uint16_t)((opcode << 12) | operands);
+        }
+        /* loop back to the start so budgets matter */
+        programs[program][word_counts[program] - 1] = 0xD000;
+    }
+
+    giga_vm_init(&initial_state);
+    giga_vm_load_program(&initial_state, programs[0], word_counts[0]);
+    initial_state.registers[2] = 7;
+
+    for (size_t job = 0; job < JOBS; ++job) {
+        size_t program = runner_test_random(&seed) % PROGRAMS;
+        for (size_t reg = 0; reg < GIGA_VM_REGISTER_COUNT; ++reg) {
+            registers[job][reg] = (uint8_t)(runner_test_random(&seed) & 0x0F);
+        }
+        jobs[job].program_words = programs[program];
+        jobs[job].word_count = word_counts[program];
+        jobs[job].initial_registers = (job % 5 == 0) ? NULL : registers[job];
+        jobs[job].initial_state = (job % 97 == 0) ? &initial_state : NULL;
+        jobs[job].max_steps = runner_test_random(&seed) % 3000;
+    }
+
+    const size_t thread_counts[] = {1, 3, 8};
+    for (size_t config = 0; config < sizeof(thread_counts) / sizeof(thread_counts[0]); ++config) {
+        GigaRunnerOptions options;
+        giga_runner_default_options(&options);
+        options.thread_count = thread_counts[config];
+        options.fuse_superinstructions = (int)(config % 2);
+        GigaRunner *runner = giga_runner_create(&options);
+        if (runner == NULL || giga_runner_thread_count(runner) != thread_counts[config]) {
+            printf("RUNNER fail: could not create %zu workers\n", thread_counts[config]);
+            giga_runner_destroy(runner);
+            return failure_count + 1;
+        }
+
+        /* several batches on one runner reuse its threads and states */
+        for (int repeat = 0; repeat < 3; ++repeat) {
+            memset(results, 0xA5, sizeof(results));
+            size_t job_count = (repeat == 1) ? 7u : (size_t)JOBS;
+            if (giga_runner_run(runner, jobs, job_count, results) != 0) {
+                printf("RUNNER fail: run returned an error\n");
+                ++failure_count;
+                continue;
+            }
+            for (size_t job = 0; job < job_count; ++job) {
+                GigaRunnerResult expected = runner_test_reference(&jobs[job], options.fuse_superinstructions);
+                if (!runner_results_equal(&expected, &results[job])) {
+                    printf("RUNNER fail: job %zu differs (%zu threads, batch %d)\n",
+                           job, thread_counts[config], repeat);
+                    ++failure_count;
+                    break;
+                }
+            }
+        }
+        giga_runner_destroy(runner);
+    }
+
+    return failure_count;
+}
+
+static int test_runner_edge_cases(void) {
+    int failure_count = 0;
+    GigaRunnerOptions options;
+    giga_runner_default_options(&options);
+    options.thread_count = 4;
+    GigaRunner *runner = giga_runner_create(&options);
+    if (runner == NULL) {
+        printf("RUNNER fail: could not create runner\n");
+        return 1;
+    }
+
+    if (giga_runner_run(runner, NULL, 0, NULL) != 0) {
+        printf("RUNNER fail: empty batch should succeed\n");
+        ++failure_count;
+    }
+    if (giga_runner_run(NULL, NULL, 0, NULL) != -1 || giga_runner_run(runner, NULL, 3, NULL) != -1) {
+        printf("RUNNER fail: invalid arguments should return -1\n");
+        ++failure_count;
+    }
+
+    static uint16_t too_long[GIGA_VM_MAX_PROGRAM_WORDS + 1];
+    GigaRunnerJob job = {too_long, GIGA_VM_MAX_PROGRAM_WORDS + 1, NULL, NULL, 10};
+    GigaRunnerResult result;
+    if (giga_runner_run(runner, &job, 1, &result) != 0 || result.status != GIGA_VM_STATUS_INVALID_STATE) {
+        printf("RUNNER fail: oversized program should report INVALID_STATE\n");
+        ++failure_count;
+    }
+
+    /* ports on a shared initial_state are not used by the parallel jobs */
+    static const uint16_t port_program[] = {
+        0xE500, /* IN R0, 0 */
+        0xE610, /* OUT 1, R0 */
+        0xF000  /* HALT */
+    };
+    GigaVmPorts *ports = giga_vm_ports_create(16);
+    static GigaVmState port_state;
+    giga_vm_init(&port_state);
+    giga_vm_load_program(&port_state, port_program, 3);
+    giga_vm_attach_ports(&port_state, ports);
+    for (int value = 0; value < 16; ++value) {
+        giga_vm_ring_push(&ports->input[0], (uint8_t)value);
+    }
+    GigaRunnerJob port_jobs[8];
+    GigaRunnerResult port_results[8];
+    for (size_t index = 0; index < 8; ++index) {
+        port_jobs[index] = (GigaRunnerJob){NULL, 0, NULL, &port_state, 10};
+    }
+    if (giga_runner_run(runner, port_jobs, 8, port_results) != 0) {
+        printf("RUNNER fail: ports batch should run\n");
+        ++failure_count;
+    }
+    for (size_t index = 0; index < 8; ++index) {
+        if (port_results[index].status != GIGA_VM_STATUS_PORT_FAULT || port_results[index].program_counter != 0) {
+            printf("RUNNER fail: job %zu with ports should fault at PC 0\n", index);
+            ++failure_count;
+            break;
+        }
+    }
+    if (giga_vm_ring_count(&ports->input[0]) != 16 || giga_vm_ring_count(&ports->output[1]) != 0 ||
+        port_state.ports != ports) {
+        printf("RUNNER fail: jobs touched the initial_state's ports\n");
+        ++failure_count;
+    }
+    giga_vm_ports_destroy(ports);
+
+    giga_runner_destroy(runner);
+    return failure_count;
+}
+
+int main(void) {
+    int failure_count = 0;
+
+    failure_count += test_runner_matches_sequential();
+    failure_count += test_runner_edge_cases();
+
+    if (failure_count == 0) {
+        printf("Runner tests: ALL PASSED\n");
+        return 0;
+    }
+
+    printf("Runner tests: %d failure(s)\n", failure_count);
+    return 1;
+}
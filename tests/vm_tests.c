@@ -1,7 +1,18 @@
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include "vm/vm.h"
 #include "isa/isa.h"
+#include "vm/vm_banks.h"
+#include "vm/vm_ports.h"
+#include "vm/vm_image.h"
+#include "vm/vm_jit.h"
+#include "vm/vm_batch.h"
+#include "vm/vm_trace.h"
+#include "vm/vm_profile.h"
 
 static int test_vm_init(void) {
     int failure_count = 0;
@@ -163,6 +174,1929 @@ static int test_vm_decode_instruction(void) {
     return failure_count;
 }
 
+static int test_vm_run_alu(void) {
+    int failure_count = 0;
+    GigaVmState state;
+    giga_vm_init(&state);
+
+    uint16_t program[] = {
+        0x2009, /* MOVI R0, 9 */
+        0x2109, /* MOVI R1, 9 */
+        0x3010, /* ADD R0, R1 -> 18 & 0xF = 2, carry, overflow */
+        0x1200, /* MOV R2, R0 */
+        0x9200, /* SHL R2 -> 4 */
+        0xF000  /* HALT */
+    };
+    giga_vm_load_program(&state, program, 6);
+
+    GigaVmStatus status = giga_vm_run(&state, 100);
+    if (status != GIGA_VM_STATUS_HALTED) {
+        printf("VM fail: run should halt, got status %d\n", (int)status);
+        ++failure_count;
+    }
+    if (state.program_counter != 5) {
+        printf("VM fail: PC should point at HALT (5), got %u\n", state.program_counter);
+        ++failure_count;
+    }
+    if (state.registers[0] != 2 || state.registers[1] != 9 || state.registers[2] != 4) {
+        printf("VM fail: registers after run should be R0=2 R1=9 R2=4, got %u %u %u\n",
+               state.registers[0], state.registers[1], state.registers[2]);
+        ++failure_count;
+    }
+    /* flags come from the last ALU op (SHL 2 -> 4) */
+    if (state.flags_zero != 0 || state.flags_carry != 0 ||
+        state.flags_negative != 0 || state.flags_overflow != 0) {
+        printf("VM fail: flags after SHL should all be 0\n");
+        ++failure_count;
+    }
+
+    return failure_count;
+}
+
+static int test_vm_run_flags(void) {
+    int failure_count = 0;
+    GigaVmState state;
+    giga_vm_init(&state);
+
+    uint16_t program[] = {
+        0x2003, /* MOVI R0, 3 */
+        0x2105, /* MOVI R1, 5 */
+        0x4010, /* SUB R0, R1 -> 14, borrow */
+        0x2100, /* MOVI R1, 0 (MOVI leaves flags alone) */
+        0xF000  /* HALT */
+    };
+    giga_vm_load_program(&state, program, 5);
+    giga_vm_run(&state, 100);
+
+    AluResult expected = alu_sub(3, 5);
+    if (state.registers[0] != expected.result ||
+        state.flags_zero != expected.zero_flag ||
+        state.flags_carry != expected.carry_flag ||
+        state.flags_negative != expected.negative_flag ||
+        state.flags_overflow != expected.overflow_flag) {
+        printf("VM fail: SUB result/flags do not match alu_sub\n");
+        ++failure_count;
+    }
+
+    return failure_count;
+}
+
+static int test_vm_run_carry_chain(void) {
+    int failure_count = 0;
+    GigaVmState state;
+    giga_vm_init(&state);
+
+    /* 3-nibble add and subtract, lowest nibble first: [A0..A2] = [80..82] op [90..92] */
+    uint16_t program[] = {
+        0xB080, /* LD R0, [0x80] */
+        0xB190, /* LD R1, [0x90] */
+        0x3010, /* ADD R0, R1 */
+        0xCA00, /* ST [0xA0], R0 */
+        0xB081, /* LD R0, [0x81] */
+        0xB191, /* LD R1, [0x91] */
+        0xE001, /* ADC R0, R1 */
+        0xCA01, /* ST [0xA1], R0 */
+        0xB082, /* LD R0, [0x82] */
+        0xB192, /* LD R1, [0x92] */
+        0xE001, /* ADC R0, R1 */
+        0xCA02, /* ST [0xA2], R0 */
+        0xF000  /* HALT */
+    };
+    const uint8_t operand_a[3] = {0x8, 0xF, 0x9}; /* 0x9F8 */
+    const uint8_t operand_b[3] = {0x9, 0xA, 0x7}; /* 0x7A9 */
+
+    for (int subtract = 0; subtract < 2; ++subtract) {
+        if (subtract) {
+            program[2] = 0x4010;  /* SUB R0, R1 */
+            program[6] = 0xE101;  /* SBC R0, R1 */
+            program[10] = 0xE101; /* SBC R0, R1 */
+        }
+        giga_vm_init(&state);
+        giga_vm_load_program(&state, program, sizeof(program) / sizeof(program[0]));
+        memcpy(&state.memory[0x80], operand_a, 3);
+        memcpy(&state.memory[0x90], operand_b, 3);
+        giga_vm_fuse_superinstructions(&state);
+        giga_vm_run(&state, 100);
+
+        /* 0x9F8 + 0x7A9 = 0x11A1; 0x9F8 - 0x7A9 = 0x24F */
+        const uint8_t *expected = subtract ? (const uint8_t[]){0xF, 0x4, 0x2} : (const uint8_t[]){0x1, 0xA, 0x1};
+        if (memcmp(&state.memory[0xA0], expected, 3) != 0 || state.flags_carry != 1) {
+            printf("VM fail: 3-nibble %s gave %X%X%X C=%u\n", subtract ? "SBC chain" : "ADC chain",
+                   state.memory[0xA2], state.memory[0xA1], state.memory[0xA0], state.flags_carry);
+            ++failure_count;
+        }
+    }
+
+    /* the carry a run starts with feeds the first ADC */
+    uint16_t carry_in[] = {
+        0x2001, /* MOVI R0, 1 */
+        0x2102, /* MOVI R1, 2 */
+        0xE001, /* ADC R0, R1 */
+        0xF000  /* HALT */
+    };
+    giga_vm_init(&state);
+    giga_vm_load_program(&state, carry_in, 4);
+    state.flags_carry = 1;
+    giga_vm_run(&state, 100);
+    if (state.registers[0] != 4 || state.flags_carry != 0) {
+        printf("VM fail: ADC should consume the incoming carry (R0=%u)\n", state.registers[0]);
+        ++failure_count;
+    }
+
+    GigaInstruction inst = giga_decode_instruction(0xE137);
+    if (inst.opcode != GIGA_OP_EXT || inst.dest_reg != GIGA_EXT_SBC) {
+        printf("VM fail: 0xE137 should decode as extended opcode SBC\n");
+        ++failure_count;
+    }
+
+    return failure_count;
+}
+
+static int test_vm_run_load_store(void) {
+    int failure_count = 0;
+    GigaVmState state;
+    giga_vm_init(&state);
+
+    uint16_t program[] = {
+        0x2307, /* MOVI R3, 7 */
+        0xC83A, /* ST [0x8A], R3 */
+        0xB48A, /* LD R4, [0x8A] */
+        0xF000  /* HALT */
+    };
+    giga_vm_load_program(&state, program, 4);
+    giga_vm_run(&state, 100);
+
+    if (state.memory[0x8A] != 7) {
+        printf("VM fail: ST should write 7 to [0x8A], got %u\n", state.memory[0x8A]);
+        ++failure_count;
+    }
+    if (state.registers[4] != 7) {
+        printf("VM fail: LD should load 7 into R4, got %u\n", state.registers[4]);
+        ++failure_count;
+    }
+
+    return failure_count;
+}
+
+static int test_vm_run_jump_and_limits(void) {
+    int failure_count = 0;
+    GigaVmState state;
+    giga_vm_init(&state);
+
+    uint16_t program[] = {
+        0x2101, /* MOVI R1, 1 */
+        0x3010, /* loop: ADD R0, R1 */
+        0xD001  /* JMP loop */
+    };
+    giga_vm_load_program(&state, program, 3);
+
+    GigaVmStatus status = giga_vm_run(&state, 21);
+    if (status != GIGA_VM_STATUS_STEP_LIMIT) {
+        printf("VM fail: infinite loop should stop at step limit, got %d\n", (int)status);
+        ++failure_count;
+    }
+    /* 1 MOVI + 10 * (ADD, JMP) = 21 steps, ten ADDs */
+    if (state.registers[0] != 10 || state.program_counter != 1) {
+        printf("VM fail: after 21 steps expected R0=10 PC=1, got R0=%u PC=%u\n",
+               state.registers[0], state.program_counter);
+        ++failure_count;
+    }
+
+    status = giga_vm_step(&state);
+    if (status != GIGA_VM_STATUS_RUNNING || state.registers[0] != 11 || state.program_counter != 2) {
+        printf("VM fail: single step should retire one ADD\n");
+        ++failure_count;
+    }
+
+    uint16_t escape[] = {
+        0xD07F  /* JMP 0x7F (past the program) */
+    };
+    giga_vm_load_program(&state, escape, 1);
+    status = giga_vm_run(&state, 100);
+    if (status != GIGA_VM_STATUS_PC_OUT_OF_RANGE || state.program_counter != 0x7F) {
+        printf("VM fail: jump past program should report PC out of range\n");
+        ++failure_count;
+    }
+
+    uint16_t invalid[] = {
+        0x0000, /* NOP */
+        0xEF00  /* undefined extended opcode */
+    };
+    giga_vm_load_program(&state, invalid, 2);
+    status = giga_vm_run(&state, 100);
+    if (status != GIGA_VM_STATUS_INVALID_OPCODE || state.program_counter != 1) {
+        printf("VM fail: extended opcode 0xF should report invalid opcode at PC 1\n");
+        ++failure_count;
+    }
+
+    if (giga_vm_run(NULL, 1) != GIGA_VM_STATUS_INVALID_STATE) {
+        printf("VM fail: NULL state should be rejected\n");
+        ++failure_count;
+    }
+
+    return failure_count;
+}
+
+static int test_vm_image(void) {
+    int failure_count = 0;
+    static GigaVmCode code;
+    static GigaVmState state;
+    static GigaVmState expected;
+    const char *path = "vm_tests_image.gbc";
+
+    /* loop: R0 += R1 five times through a fused CMP/branch, then store R0 */
+    uint16_t words[] = {
+        0x2001, /* MOVI R0, 1 */
+        0x2103, /* MOVI R1, 3 */
+        0x2205, /* MOVI R2, 5 */
+        0x2301, /* MOVI R3, 1 */
+        0x3010, /* loop: ADD R0, R1 */
+        0x4230, /* SUB R2, R3 */
+        0x2400, /* MOVI R4, 0 */
+        0xE224, /* CMP R2, R4 */
+        0xE904, /* JNZ loop */
+        0xC005, /* ST [0x05], R0 */
+        0xB506, /* LD R5, [0x06] */
+        0xF000  /* HALT */
+    };
+    size_t word_count = sizeof(words) / sizeof(words[0]);
+    size_t source_lines[sizeof(words) / sizeof(words[0])];
+    for (size_t index = 0; index < word_count; ++index) {
+        source_lines[index] = index + 2u;
+    }
+    uint8_t data[8] = {0, 0, 0, 0, 0, 0, 9, 0};
+    GigaVmImageLabel labels[] = {{"start", 5, 0}, {"loop", 4, 4}};
+    GigaVmImageSource source = {
+        .words = words,
+        .word_count = word_count,
+        .data = data,
+        .data_bytes = sizeof(data),
+        .labels = labels,
+        .label_count = 2,
+        .source_lines = source_lines,
+        .fuse = 1
+    };
+    if (giga_vm_image_write(path, &source) != 0) {
+        printf("VM fail: giga_vm_image_write failed\n");
+        return failure_count + 1;
+    }
+
+    GigaVmImage image;
+    if (giga_vm_image_open(path, &image) != 0) {
+        printf("VM fail: giga_vm_image_open rejected a fresh image\n");
+        remove(path);
+        return failure_count + 1;
+    }
+    if (image.word_count != word_count || memcmp(image.words, words, sizeof(words)) != 0 ||
+        image.data_bytes != sizeof(data) || giga_vm_image_find_symbol(&image, "loop") != 4 ||
+        giga_vm_image_find_symbol(&image, "start") != 0 || giga_vm_image_find_symbol(&image, "end") != -1 ||
+        giga_vm_image_source_line(&image, 9) != 11 || giga_vm_image_source_line(&image, 99) != 0) {
+        printf("VM fail: image sections did not round-trip\n");
+        ++failure_count;
+    }
+
+    /* the mapped image runs like the same code decoded in memory */
+    giga_vm_code_init(&code, words, word_count);
+    giga_vm_code_fuse(&code);
+    giga_vm_init(&expected);
+    memcpy(expected.memory, data, sizeof(data));
+    GigaVmStatus expected_status = giga_vm_run_code(&expected, &code, 1000);
+    giga_vm_load_image(&state, &image);
+    GigaVmStatus status = giga_vm_run_image(&state, &image, 1000);
+    if (status != expected_status || status != GIGA_VM_STATUS_HALTED ||
+        memcmp(state.registers, expected.registers, sizeof(state.registers)) != 0 ||
+        state.program_counter != expected.program_counter || state.memory[5] != 0 || state.memory[6] != 9 || state.registers[5] != 9 ||
+        state.registers[0] != 0) {
+        printf("VM fail: image run gave status=%d pc=%u R0=%u R5=%u\n", (int)status, state.program_counter,
+               state.registers[0], state.registers[5]);
+        ++failure_count;
+    }
+
+    /* an in-memory copy can be viewed without a file */
+    size_t copy_bytes = (image.mapping_bytes + GIGA_VM_IMAGE_ALIGN - 1u) & ~(size_t)(GIGA_VM_IMAGE_ALIGN - 1u);
+    void *copy = aligned_alloc(GIGA_VM_IMAGE_ALIGN, copy_bytes);
+    if (copy == NULL) {
+        printf("VM fail: out of memory\n");
+        giga_vm_image_close(&image);
+        remove(path);
+        return failure_count + 1;
+    }
+    memcpy(copy, image.mapping, image.mapping_bytes);
+    size_t file_bytes = image.mapping_bytes;
+    giga_vm_image_close(&image);
+    GigaVmImage view;
+    if (giga_vm_image_view(copy, file_bytes, &view) != 0 || view.mapping != NULL || view.word_count != word_count) {
+        printf("VM fail: giga_vm_image_view rejected a valid image\n");
+        ++failure_count;
+    }
+    if (giga_vm_image_view(copy, file_bytes - 1u, &view) != -3 ||
+        giga_vm_image_view((const uint8_t *)copy + 1, file_bytes - 1u, &view) != -1) {
+        printf("VM fail: giga_vm_image_view accepted a truncated or misaligned image\n");
+        ++failure_count;
+    }
+
+    /* corrupt headers and decoded entries are refused */
+    GigaVmImageHeader *header = (GigaVmImageHeader *)copy;
+    header->magic[0] = 'X';
+    if (giga_vm_image_view(copy, file_bytes, &view) != -3) {
+        printf("VM fail: bad magic accepted\n");
+        ++failure_count;
+    }
+    header->magic[0] = 'G';
+    header->version = GIGA_VM_IMAGE_VERSION + 1u;
+    if (giga_vm_image_view(copy, file_bytes, &view) != -3) {
+        printf("VM fail: future version accepted\n");
+        ++failure_count;
+    }
+    header->version = GIGA_VM_IMAGE_VERSION;
+    GigaVmDecodedInstruction *decoded =
+        (GigaVmDecodedInstruction *)((uint8_t *)copy + header->sections[GIGA_VM_IMAGE_DECODED].offset);
+    decoded[8].operand = 0x0FFF; /* branch far past the code */
+    if (giga_vm_image_view(copy, file_bytes, &view) != -3) {
+        printf("VM fail: out-of-range branch target accepted\n");
+        ++failure_count;
+    }
+    decoded[8].operand = 4;
+    decoded[0].dest_reg = 200;
+    if (giga_vm_image_view(copy, file_bytes, &view) != -3) {
+        printf("VM fail: bad register index accepted\n");
+        ++failure_count;
+    }
+    decoded[0].dest_reg = 0;
+    if (giga_vm_image_view(copy, file_bytes, &view) != 0) {
+        printf("VM fail: restored image rejected\n");
+        ++failure_count;
+    }
+    free(copy);
+
+    if (giga_vm_image_open("vm_tests_missing.gbc", &image) != -2) {
+        printf("VM fail: opening a missing image should fail with -2\n");
+        ++failure_count;
+    }
+    remove(path);
+    return failure_count;
+}
+
+/* Thread body of test_vm_image_writers: writes its program to the shared path again and again. */
+typedef struct {
+    const char *path;
+    uint16_t words[4];
+    size_t word_count;
+    int failures;
+} ImageWriter;
+
+static void *image_writer_run(void *argument) {
+    ImageWriter *writer = argument;
+    GigaVmImageSource source = {.words = writer->words, .word_count = writer->word_count};
+    for (int round = 0; round < 3000; ++round) {
+        writer->failures += giga_vm_image_write(writer->path, &source) != 0;
+    }
+    return NULL;
+}
+
+/* Writers in one process never share a temporary file: the image is always one of theirs, whole. */
+static int test_vm_image_writers(void) {
+    int failure_count = 0;
+    const char *path = "vm_tests_writers.gbc";
+    ImageWriter writers[2] = {
+        {path, {0x2101, 0xF000}, 2, 0},
+        {path, {0x2102, 0x2203, 0x0000, 0xF000}, 4, 0}
+    };
+    pthread_t threads[2];
+    int started = 0;
+    for (; started < 2; ++started) {
+        if (pthread_create(&threads[started], NULL, image_writer_run, &writers[started]) != 0) {
+            printf("VM fail: cannot start image writer\n");
+            ++failure_count;
+            break;
+        }
+    }
+    for (int index = 0; index < started; ++index) {
+        pthread_join(threads[index], NULL);
+    }
+    if (writers[0].failures != 0 || writers[1].failures != 0) {
+        printf("VM fail: concurrent giga_vm_image_write failed %d and %d times\n", writers[0].failures,
+               writers[1].failures);
+        ++failure_count;
+    }
+    GigaVmImage image;
+    if (giga_vm_image_open(path, &image) != 0) {
+        printf("VM fail: image from concurrent writers does not open\n");
+        remove(path);
+        return failure_count + 1;
+    }
+    const ImageWriter *last = (image.word_count == writers[0].word_count) ? &writers[0] : &writers[1];
+    if (image.word_count != last->word_count ||
+        memcmp(image.words, last->words, last->word_count * sizeof(uint16_t)) != 0) {
+        printf("VM fail: image from concurrent writers mixes their programs\n");
+        ++failure_count;
+    }
+    giga_vm_image_close(&image);
+    remove(path);
+    return failure_count;
+}
+
+static int test_vm_self_modifying_store(void) {
+    int failure_count = 0;
+    GigaVmState state;
+    giga_vm_init(&state);
+
+    uint16_t program[] = {
+        0x2205, /* MOVI R2, 5 */
+        0xC026, /* ST [6], R2 -> low byte of word 3 becomes 0x05 */
+        0x0000, /* NOP */
+        0x2101, /* MOVI R1, 1 (rewritten to MOVI R1, 5) */
+        0xF000  /* HALT */
+    };
+    giga_vm_load_program(&state, program, 5);
+
+    GigaVmStatus status = giga_vm_run(&state, 100);
+    if (status != GIGA_VM_STATUS_HALTED || state.registers[1] != 5) {
+        printf("VM fail: self-modified MOVI should load 5 into R1, got %u\n", state.registers[1]);
+        ++failure_count;
+    }
+
+    /* host-side patch of the HALT into a NOP followed by end of program */
+    state.memory[9] = 0x00;
+    giga_vm_invalidate_code(&state, 9);
+    state.program_counter = 4;
+    status = giga_vm_run(&state, 100);
+    if (status != GIGA_VM_STATUS_PC_OUT_OF_RANGE || state.program_counter != 5) {
+        printf("VM fail: patched HALT should fall off the program end\n");
+        ++failure_count;
+    }
+
+    return failure_count;
+}
+
+static int vm_states_equal(const GigaVmState *left, const GigaVmState *right) {
+    return memcmp(left->registers, right->registers, sizeof(left->registers)) == 0 &&
+           left->flags_zero == right->flags_zero &&
+           left->flags_carry == right->flags_carry &&
+           left->flags_negative == right->flags_negative &&
+           left->flags_overflow == right->flags_overflow &&
+           left->program_counter == right->program_counter &&
+           memcmp(left->memory, right->memory, sizeof(left->memory)) == 0;
+}
+
+static int test_vm_conditional_branches(void) {
+    int failure_count = 0;
+    GigaVmState state;
+
+    /* R2 = 5 + 4 + 3 + 2 + 1, counting R0 down to zero */
+    uint16_t countdown[] = {
+        0x2005, /* MOVI R0, 5 */
+        0x2101, /* MOVI R1, 1 */
+        0x2200, /* MOVI R2, 0 */
+        0x2300, /* MOVI R3, 0 */
+        0x3200, /* loop: ADD R2, R0 */
+        0x4010, /* SUB R0, R1 */
+        0xE203, /* CMP R0, R3 */
+        0xE904, /* JNZ loop */
+        0xF000  /* HALT */
+    };
+    for (int fuse = 0; fuse < 2; ++fuse) {
+        giga_vm_init(&state);
+        giga_vm_load_program(&state, countdown, 9);
+        if (fuse && giga_vm_fuse_superinstructions(&state) != 2) {
+            printf("VM fail: CMP; JNZ should fuse\n");
+            ++failure_count;
+        }
+        GigaVmStatus status = giga_vm_run(&state, 100);
+        GigaVmCounters counters;
+        giga_vm_counters(&state, &counters);
+        if (status != GIGA_VM_STATUS_HALTED || state.registers[2] != 0xF || state.program_counter != 8 ||
+            state.flags_zero != 1 || state.flags_carry != 1 || counters.retired != 25 ||
+            counters.taken_jumps != 4 || counters.flag_reads != 5 || counters.alu_ops[GIGA_VM_COUNTER_CMP] != 5) {
+            printf("VM fail: CMP/JNZ countdown (%s) gave R2=%X PC=%u retired=%llu\n", fuse ? "fused" : "unfused",
+                   state.registers[2], state.program_counter, (unsigned long long)counters.retired);
+            ++failure_count;
+        }
+
+        /* every budget stops at the same place as stepping */
+        for (uint64_t budget = 0; budget < 26; ++budget) {
+            GigaVmState run;
+            GigaVmState stepped;
+            giga_vm_init(&run);
+            giga_vm_load_program(&run, countdown, 9);
+            if (fuse) {
+                giga_vm_fuse_superinstructions(&run);
+            }
+            giga_vm_init(&stepped);
+            giga_vm_load_program(&stepped, countdown, 9);
+            giga_vm_run(&run, budget);
+            for (uint64_t step = 0; step < budget && giga_vm_step(&stepped) == GIGA_VM_STATUS_RUNNING; ++step) {
+            }
+            if (!vm_states_equal(&run, &stepped)) {
+                printf("VM fail: countdown after %llu steps differs from stepping\n", (unsigned long long)budget);
+                ++failure_count;
+                break;
+            }
+        }
+    }
+
+    /* each condition, after CMP 3, 5 (borrow, negative) and CMP 5, 5 (zero, carry) */
+    static const struct {
+        uint16_t compare;
+        uint16_t branch;
+        int taken;
+    } cases[] = {
+        {0xE201, 0xE803, 0}, {0xE201, 0xE903, 1}, {0xE201, 0xEA03, 0}, {0xE201, 0xEB03, 1},
+        {0xE211, 0xE803, 1}, {0xE211, 0xE903, 0}, {0xE211, 0xEA03, 1}, {0xE211, 0xEB03, 0},
+    };
+    for (size_t index = 0; index < sizeof(cases) / sizeof(cases[0]); ++index) {
+        uint16_t program[] = {
+            0x2003,              /* MOVI R0, 3 */
+            0x2105,              /* MOVI R1, 5 */
+            cases[index].compare, /* CMP R0, R1 or CMP R1, R1 */
+            cases[index].branch,  /* Jcc 3 */
+            0xF000               /* HALT */
+        };
+        for (int fuse = 0; fuse < 2; ++fuse) {
+            giga_vm_init(&state);
+            giga_vm_load_program(&state, program, 5);
+            if (fuse) {
+                giga_vm_fuse_superinstructions(&state);
+            }
+            giga_vm_run(&state, 4);
+            uint16_t expected_pc = cases[index].taken ? 3 : 4;
+            if (state.program_counter != expected_pc || state.registers[0] != 3 || state.registers[1] != 5) {
+                printf("VM fail: %04X after %04X should %s (PC=%u)\n", cases[index].branch, cases[index].compare,
+                       cases[index].taken ? "jump" : "fall through", state.program_counter);
+                ++failure_count;
+            }
+        }
+    }
+
+    /* flags from an ALU op, and from the state when a run starts at the branch */
+    uint16_t after_sub[] = {
+        0x2003, /* MOVI R0, 3 */
+        0x4000, /* SUB R0, R0 */
+        0xE804, /* JZ 4 */
+        0xF000, /* HALT */
+        0xE904  /* JNZ 4 */
+    };
+    giga_vm_init(&state);
+    giga_vm_load_program(&state, after_sub, 5);
+    giga_vm_run(&state, 3);
+    if (state.program_counter != 4) {
+        printf("VM fail: JZ after SUB R0, R0 should be taken\n");
+        ++failure_count;
+    }
+    giga_vm_run(&state, 1);
+    if (state.program_counter != 5) {
+        printf("VM fail: JNZ on saved zero flag should fall through\n");
+        ++failure_count;
+    }
+
+    uint16_t escape[] = {
+        0xE87F, /* JZ 0x7F (past the program) */
+        0xE97F  /* JNZ 0x7F */
+    };
+    giga_vm_init(&state);
+    giga_vm_load_program(&state, escape, 2);
+    GigaVmStatus status = giga_vm_run(&state, 100);
+    if (status != GIGA_VM_STATUS_PC_OUT_OF_RANGE || state.program_counter != 0x7F) {
+        printf("VM fail: taken branch past program should report PC out of range\n");
+        ++failure_count;
+    }
+
+    GigaInstruction inst = giga_decode_instruction(0xEA12);
+    if (inst.opcode != GIGA_OP_EXT || !GIGA_EXT_IS_BRANCH(inst.dest_reg) || inst.dest_reg != GIGA_EXT_JC ||
+        GIGA_EXT_IS_BRANCH(GIGA_EXT_CMP)) {
+        printf("VM fail: 0xEA12 should decode as JC\n");
+        ++failure_count;
+    }
+
+    return failure_count;
+}
+
+static int test_vm_banked_memory(void) {
+    int failure_count = 0;
+    static GigaVmState state;
+    static GigaVmState reference;
+
+    /* the same address in banks 0, 1 and 4095 holds three values */
+    uint16_t round_trip[] = {
+        0x2107, /* MOVI R1, 7 */
+        0xE401, /* BANKI 1 */
+        0xC810, /* ST [0x80], R1 */
+        0xC010, /* ST [0x00], R1: bank 1, so not a code write */
+        0x2109, /* MOVI R1, 9 */
+        0xE400, /* BANKI 0 */
+        0xC810, /* ST [0x80], R1 */
+        0x240F, /* MOVI R4, 0xF */
+        0x250F, /* MOVI R5, 0xF */
+        0x260F, /* MOVI R6, 0xF */
+        0xE340, /* BANK R4: bank 0xFFF */
+        0x210C, /* MOVI R1, 0xC */
+        0xC810, /* ST [0x80], R1 */
+        0xE401, /* BANKI 1 */
+        0xB280, /* LD R2, [0x80] */
+        0xE400, /* BANKI 0 */
+        0xB380, /* LD R3, [0x80] */
+        0xF000  /* HALT */
+    };
+    GigaVmBanks *banks = giga_vm_banks_create(GIGA_VM_BANK_COUNT);
+    if (banks == NULL || giga_vm_banks_count(banks) != GIGA_VM_BANK_COUNT ||
+        giga_vm_banks_data(banks, 0) != NULL || giga_vm_banks_data(banks, GIGA_VM_BANK_COUNT) != NULL) {
+        printf("VM fail: bank store creation or bounds\n");
+        giga_vm_banks_destroy(banks);
+        return failure_count + 1;
+    }
+    for (int fuse = 0; fuse < 2; ++fuse) {
+        giga_vm_init(&state);
+        giga_vm_load_program(&state, round_trip, 18);
+        giga_vm_attach_banks(&state, banks);
+        if (fuse) {
+            giga_vm_fuse_superinstructions(&state);
+        }
+        GigaVmStatus status = giga_vm_run(&state, 100);
+        GigaVmCounters counters;
+        giga_vm_counters(&state, &counters);
+        if (status != GIGA_VM_STATUS_HALTED || state.registers[2] != 7 || state.registers[3] != 9 ||
+            state.memory[0x80] != 9 || state.memory[0x00] != 0x07 || state.data_bank != 0 ||
+            giga_vm_banks_data(banks, 1)[0x80] != 7 || giga_vm_banks_data(banks, 1)[0x00] != 7 ||
+            giga_vm_banks_data(banks, 0xFFF)[0x80] != 0xC || counters.code_writes != 0 || counters.stores != 4) {
+            printf("VM fail: banked round trip (%s) gave R2=%u R3=%u status=%d\n", fuse ? "fused" : "unfused",
+                   state.registers[2], state.registers[3], (int)status);
+            ++failure_count;
+        }
+        giga_vm_banks_clear(banks);
+    }
+    size_t resident = giga_vm_banks_resident_bytes(banks);
+    if (giga_vm_banks_data(banks, 1)[0x80] != 0 || giga_vm_banks_data(banks, 0xFFF)[0x80] != 0 ||
+        resident > 64u * 1024u) {
+        printf("VM fail: cleared banks should read zero and hold little memory (%zu bytes)\n", resident);
+        ++failure_count;
+    }
+
+    /* the JIT hands banked stretches to the interpreter */
+    GigaVmJit *jit = giga_vm_jit_create();
+    giga_vm_init(&reference);
+    giga_vm_load_program(&reference, round_trip, 18);
+    giga_vm_attach_banks(&reference, banks);
+    for (uint64_t budget = 0; budget < 20; ++budget) {
+        state = reference;
+        GigaVmStatus expected_status = giga_vm_run(&state, budget);
+        uint8_t expected = giga_vm_banks_data(banks, 1)[0x80];
+        giga_vm_banks_clear(banks);
+        GigaVmState translated = reference;
+        GigaVmStatus status = giga_vm_jit_run(jit, &translated, budget);
+        if (status != expected_status || !vm_states_equal(&state, &translated) ||
+            translated.data_bank != state.data_bank || giga_vm_banks_data(banks, 1)[0x80] != expected) {
+            printf("VM fail: JIT banked run differs from interpreter after %llu steps\n",
+                   (unsigned long long)budget);
+            ++failure_count;
+            break;
+        }
+        giga_vm_banks_clear(banks);
+    }
+    giga_vm_jit_destroy(jit);
+
+    /* a missing bank faults at the BANK/BANKI, leaving the selection alone */
+    GigaVmBanks *small = giga_vm_banks_create(16);
+    uint16_t select[] = {
+        0x2001, /* MOVI R0, 1 */
+        0xE420, /* BANKI 0x20 */
+        0xE300, /* BANK R0: bank 0x100 (R0, R1, R2 = 1, 0, 0) */
+        0xF000  /* HALT */
+    };
+    giga_vm_init(&state);
+    giga_vm_load_program(&state, select, 4);
+    if (giga_vm_run(&state, 10) != GIGA_VM_STATUS_BANK_FAULT || state.program_counter != 1 || state.data_bank != 0) {
+        printf("VM fail: BANKI without banks should fault at PC 1\n");
+        ++failure_count;
+    }
+    giga_vm_attach_banks(&state, small);
+    if (giga_vm_run(&state, 10) != GIGA_VM_STATUS_BANK_FAULT || state.program_counter != 1) {
+        printf("VM fail: BANKI past the store should fault\n");
+        ++failure_count;
+    }
+    state.program_counter = 2;
+    if (giga_vm_run(&state, 10) != GIGA_VM_STATUS_BANK_FAULT || state.program_counter != 2) {
+        printf("VM fail: BANK R0 past the store should fault\n");
+        ++failure_count;
+    }
+    state.data_bank = 3;
+    giga_vm_attach_banks(&state, NULL);
+    if (giga_vm_run(&state, 10) != GIGA_VM_STATUS_BANK_FAULT) {
+        printf("VM fail: starting in a detached bank should fault\n");
+        ++failure_count;
+    }
+    giga_vm_banks_destroy(small);
+
+    /* engines that only model bank 0 fault on the first switch */
+    uint16_t switch_bank[] = {
+        0x2103, /* MOVI R1, 3 */
+        0xE401, /* BANKI 1 */
+        0xC810, /* ST [0x80], R1 */
+        0xF000  /* HALT */
+    };
+    static GigaVmProgram program;
+    giga_vm_program_init(&program, switch_bank, 4);
+    GigaVmPackedState packed;
+    giga_vm_packed_init(&packed, &program);
+    if (giga_vm_packed_run(&packed, &program, 10) != GIGA_VM_STATUS_BANK_FAULT || packed.program_counter != 1) {
+        printf("VM fail: packed run should fault on BANKI 1\n");
+        ++failure_count;
+    }
+
+    giga_vm_init(&state);
+    giga_vm_load_program(&state, switch_bank, 4);
+    giga_vm_attach_banks(&state, banks);
+    GigaVmSnapshot *snapshot = giga_vm_snapshot_take(&state);
+    GigaVmFork child;
+    if (giga_vm_fork(&child, snapshot) != 0 || giga_vm_fork_run(&child, 10) != GIGA_VM_STATUS_BANK_FAULT ||
+        child.program_counter != 1) {
+        printf("VM fail: fork should fault on BANKI 1\n");
+        ++failure_count;
+    }
+    giga_vm_fork_release(&child);
+
+    uint8_t records[64];
+    size_t record_bytes = 0;
+    uint64_t retired = 0;
+    if (giga_vm_run_traced(&state, 10, records, &record_bytes, &retired) != GIGA_VM_STATUS_BANK_FAULT ||
+        retired != 1 || record_bytes != 1 + GIGA_VM_TRACE_STOP_BYTES ||
+        records[1] != GIGA_VM_TRACE_TAG_STOP || records[2] != (uint8_t)GIGA_VM_STATUS_BANK_FAULT) {
+        printf("VM fail: traced run should stop on BANKI 1\n");
+        ++failure_count;
+    }
+
+    /* the interpreter goes on; restores keep the state's own store */
+    if (giga_vm_run(&state, 10) != GIGA_VM_STATUS_HALTED || state.data_bank != 1 ||
+        giga_vm_banks_data(banks, 1)[0x80] != 3) {
+        printf("VM fail: interpreter should finish in bank 1\n");
+        ++failure_count;
+    }
+    GigaVmPackedState repacked;
+    if (giga_vm_packed_pack(&state, &program, &repacked) != -3) {
+        printf("VM fail: packing a state in bank 1 should fail\n");
+        ++failure_count;
+    }
+    GigaVmSnapshot *banked = giga_vm_snapshot_take(&state);
+    if (giga_vm_fork(&child, banked) != -2) {
+        printf("VM fail: forking a snapshot in bank 1 should fail\n");
+        ++failure_count;
+    }
+    giga_vm_init(&reference);
+    giga_vm_snapshot_restore(&reference, snapshot);
+    giga_vm_snapshot_restore(&state, snapshot);
+    if (reference.banks != NULL || state.banks != banks || state.data_bank != 0) {
+        printf("VM fail: snapshot restore should keep the banks attachment\n");
+        ++failure_count;
+    }
+    giga_vm_snapshot_release(banked);
+    giga_vm_snapshot_release(snapshot);
+
+    GigaVmBatch batch;
+    if (giga_vm_batch_init(&batch, 8, switch_bank, 4) == 0) {
+        giga_vm_batch_run(&batch, 10);
+        if (batch.status[0] != (uint8_t)GIGA_VM_STATUS_BANK_FAULT || batch.program_counter[7] != 1 ||
+            giga_vm_batch_set_lane(&batch, 0, &state) != 0) {
+            printf("VM fail: batch lanes should fault on BANKI 1\n");
+            ++failure_count;
+        }
+        giga_vm_batch_free(&batch);
+    }
+
+    giga_vm_banks_destroy(banks);
+    return failure_count;
+}
+
+static int test_vm_separate_code(void) {
+    int failure_count = 0;
+    static GigaVmCode code;
+    static GigaVmState state;
+    static uint16_t words[GIGA_VM_MAX_CODE_WORDS];
+
+    /* a program using the whole JMP range, with data at address 0 */
+    for (size_t index = 0; index < GIGA_VM_MAX_CODE_WORDS; ++index) {
+        words[index] = 0x0000; /* NOP */
+    }
+    words[0] = 0x2105;    /* MOVI R1, 5 */
+    words[1] = 0xDFA0;    /* JMP 0xFA0 */
+    words[0xFA0] = 0xC010; /* ST [0x00], R1 */
+    words[0xFA1] = 0x2203; /* MOVI R2, 3 */
+    words[0xFA2] = 0x3120; /* ADD R1, R2 */
+    words[0xFA3] = 0xB300; /* LD R3, [0x00] */
+    words[0xFA4] = 0xDFFF; /* JMP 0xFFF */
+    words[0xFFF] = 0xF000; /* HALT */
+    if (giga_vm_code_init(&code, words, GIGA_VM_MAX_CODE_WORDS) != 0 ||
+        giga_vm_code_init(&code, words, GIGA_VM_MAX_CODE_WORDS + 1u) != -2 ||
+        giga_vm_code_init(NULL, words, 1) != -1) {
+        printf("VM fail: giga_vm_code_init bounds\n");
+        return failure_count + 1;
+    }
+    giga_vm_code_init(&code, words, GIGA_VM_MAX_CODE_WORDS);
+    for (int fuse = 0; fuse < 2; ++fuse) {
+        if (fuse && giga_vm_code_fuse(&code) == 0) {
+            printf("VM fail: giga_vm_code_fuse formed no superinstruction\n");
+            ++failure_count;
+        }
+        giga_vm_init(&state);
+        GigaVmStatus status = giga_vm_run_code(&state, &code, 100);
+        if (status != GIGA_VM_STATUS_HALTED || state.program_counter != 0xFFF || state.memory[0] != 5 ||
+            state.registers[1] != 8 || state.registers[3] != 5 || state.loaded_program_words != 0 ||
+            (state.dirty_blocks & 1u) == 0) {
+            printf("VM fail: Harvard run (%s) gave status=%d pc=%u R1=%u R3=%u\n", fuse ? "fused" : "unfused",
+                   (int)status, state.program_counter, state.registers[1], state.registers[3]);
+            ++failure_count;
+        }
+    }
+
+    /* step budget, a jump past a short store and a run off the end */
+    uint16_t short_code[] = {
+        0x2107, /* MOVI R1, 7 */
+        0xC010, /* ST [0x00], R1: data only, the code is unchanged */
+        0xD005, /* JMP 5 */
+        0x0000  /* NOP */
+    };
+    giga_vm_code_init(&code, short_code, 4);
+    giga_vm_init(&state);
+    if (giga_vm_run_code(&state, &code, 2) != GIGA_VM_STATUS_STEP_LIMIT || state.program_counter != 2 ||
+        code.words[0] != 0x2107 || state.memory[0] != 7) {
+        printf("VM fail: Harvard step limit\n");
+        ++failure_count;
+    }
+    if (giga_vm_run_code(&state, &code, 10) != GIGA_VM_STATUS_PC_OUT_OF_RANGE || state.program_counter != 5) {
+        printf("VM fail: Harvard JMP past the code should stop at 5\n");
+        ++failure_count;
+    }
+    state.program_counter = 3;
+    if (giga_vm_run_code(&state, &code, 10) != GIGA_VM_STATUS_PC_OUT_OF_RANGE || state.program_counter != 4) {
+        printf("VM fail: Harvard run off the end should stop at 4\n");
+        ++failure_count;
+    }
+    if (giga_vm_run_code(NULL, &code, 1) != GIGA_VM_STATUS_INVALID_STATE ||
+        giga_vm_run_code(&state, NULL, 1) != GIGA_VM_STATUS_INVALID_STATE) {
+        printf("VM fail: Harvard run should reject NULL arguments\n");
+        ++failure_count;
+    }
+
+    /* a small program runs the same as from VM memory */
+    uint16_t loop[] = {
+        0x2005, /* MOVI R0, 5 */
+        0x2101, /* MOVI R1, 1 */
+        0x2300, /* MOVI R3, 0 */
+        0x4010, /* SUB R0, R1 */
+        0xE203, /* CMP R0, R3 */
+        0xE903, /* JNZ 3 */
+        0xC8A0, /* ST [0x8A], R0 */
+        0xF000  /* HALT */
+    };
+    static GigaVmState reference;
+    giga_vm_init(&reference);
+    giga_vm_load_program(&reference, loop, 8);
+    giga_vm_code_init(&code, loop, 8);
+    giga_vm_init(&state);
+    GigaVmStatus expected = giga_vm_run(&reference, 100);
+    if (giga_vm_run_code(&state, &code, 100) != expected || state.program_counter != reference.program_counter ||
+        memcmp(state.registers, reference.registers, sizeof(state.registers)) != 0 ||
+        state.flags_zero != reference.flags_zero || state.flags_carry != reference.flags_carry ||
+        state.memory[0x8A] != reference.memory[0x8A]) {
+        printf("VM fail: Harvard loop differs from the interpreter\n");
+        ++failure_count;
+    }
+
+    /* relative branches: a loop above word 255 and a branch before word 0 */
+    for (size_t index = 0; index < 0x310; ++index) {
+        words[index] = 0x0000; /* NOP */
+    }
+    words[0] = 0xD300;     /* JMP 0x300 */
+    words[0x300] = 0x2005; /* MOVI R0, 5 */
+    words[0x301] = 0x2101; /* MOVI R1, 1 */
+    words[0x302] = 0x2300; /* MOVI R3, 0 */
+    words[0x303] = 0x4010; /* SUB R0, R1 */
+    words[0x304] = 0xE203; /* CMP R0, R3 */
+    words[0x305] = 0xEDFD; /* JNZR -3: to 0x303 */
+    words[0x306] = 0xEC01; /* JZR +1: to 0x308 */
+    words[0x307] = 0x2209; /* MOVI R2, 9 (skipped) */
+    words[0x308] = 0xF000; /* HALT */
+    giga_vm_code_init(&code, words, 0x310);
+    for (int fuse = 0; fuse < 2; ++fuse) {
+        if (fuse) {
+            giga_vm_code_fuse(&code);
+        }
+        giga_vm_init(&state);
+        GigaVmStatus status = giga_vm_run_code(&state, &code, 100);
+        if (status != GIGA_VM_STATUS_HALTED || state.program_counter != 0x308 || state.registers[0] != 0 ||
+            state.registers[2] != 0) {
+            printf("VM fail: relative branches (%s) gave status=%d pc=0x%x\n", fuse ? "fused" : "unfused",
+                   (int)status, state.program_counter);
+            ++failure_count;
+        }
+    }
+    uint16_t backward[] = {
+        0x2000, /* MOVI R0, 0 */
+        0xE200, /* CMP R0, R0: zero */
+        0xECF0  /* JZR -16: before word 0 */
+    };
+    giga_vm_code_init(&code, backward, 3);
+    giga_vm_init(&state);
+    if (giga_vm_run_code(&state, &code, 10) != GIGA_VM_STATUS_PC_OUT_OF_RANGE || state.program_counter < 3) {
+        printf("VM fail: relative branch before word 0 should leave the code\n");
+        ++failure_count;
+    }
+    /* programs in VM memory keep 0xC-0xF undefined */
+    giga_vm_init(&reference);
+    giga_vm_load_program(&reference, backward, 3);
+    if (giga_vm_run(&reference, 10) != GIGA_VM_STATUS_INVALID_OPCODE || reference.program_counter != 2) {
+        printf("VM fail: relative branch in VM memory should be an invalid opcode\n");
+        ++failure_count;
+    }
+    return failure_count;
+}
+
+/* Host side of test_vm_ports: feeds port 0 and checks port 1 until every nibble is back. */
+typedef struct {
+    GigaVmPorts *ports;
+    size_t nibbles;
+    size_t received;
+    int mismatch;
+    atomic_int done;
+    atomic_int stopped;
+} PortStream;
+
+static void *port_stream_host(void *argument) {
+    PortStream *stream = argument;
+    GigaVmRing *input = &stream->ports->input[0];
+    GigaVmRing *output = &stream->ports->output[1];
+    size_t sent = 0;
+    while (stream->received < stream->nibbles && !atomic_load(&stream->stopped)) {
+        uint8_t *write_at;
+        size_t span = giga_vm_ring_write_span(input, &write_at);
+        if (span > stream->nibbles - sent) {
+            span = stream->nibbles - sent;
+        }
+        for (size_t index = 0; index < span; ++index) {
+            write_at[index] = (uint8_t)((sent + index) & 0x0Fu);
+        }
+        giga_vm_ring_write_commit(input, span);
+        sent += span;
+
+        const uint8_t *read_at;
+        size_t read_span = giga_vm_ring_read_span(output, &read_at);
+        for (size_t index = 0; index < read_span; ++index) {
+            if (read_at[index] != (uint8_t)(((stream->received + index) * 2u) & 0x0Fu)) {
+                stream->mismatch = 1;
+            }
+        }
+        giga_vm_ring_read_commit(output, read_span);
+        stream->received += read_span;
+        if (span == 0 && read_span == 0) {
+            sched_yield();
+        }
+    }
+    atomic_store(&stream->done, 1);
+    return NULL;
+}
+
+static int test_vm_ports(void) {
+    int failure_count = 0;
+    static GigaVmState state;
+    uint16_t doubler[] = {
+        0x2101, /* MOVI R1, 1 */
+        0xE500, /* IN R0, 0 */
+        0x3000, /* ADD R0, R0 */
+        0xE610, /* OUT 1, R0 */
+        0x3210, /* ADD R2, R1 */
+        0xD001  /* JMP 1 */
+    };
+
+    if (giga_vm_ports_create(0) != NULL || giga_vm_ports_create(1) != NULL || giga_vm_ports_create(6) != NULL) {
+        printf("VM fail: ports need a power-of-two capacity of at least 2\n");
+        ++failure_count;
+    }
+
+    /* without ports IN faults and leaves pc on it */
+    giga_vm_init(&state);
+    giga_vm_load_program(&state, doubler, 6);
+    if (giga_vm_run(&state, 10) != GIGA_VM_STATUS_PORT_FAULT || state.program_counter != 1 ||
+        state.registers[1] != 1) {
+        printf("VM fail: IN without ports should fault at PC 1\n");
+        ++failure_count;
+    }
+
+    /* an empty input or a full output stops the run before the instruction */
+    GigaVmPorts *small = giga_vm_ports_create(2);
+    GigaVmRing *input = &small->input[0];
+    GigaVmRing *output = &small->output[1];
+    giga_vm_attach_ports(&state, small);
+    if (!giga_vm_ring_push(input, 1) || !giga_vm_ring_push(input, 2) || giga_vm_ring_push(input, 3)) {
+        printf("VM fail: a ring of 2 should take exactly 2 bytes\n");
+        ++failure_count;
+    }
+    if (giga_vm_run(&state, 100) != GIGA_VM_STATUS_IO_WAIT || state.program_counter != 1 ||
+        state.registers[2] != 2 || giga_vm_ring_count(output) != 2) {
+        printf("VM fail: IN on an empty port should wait at PC 1\n");
+        ++failure_count;
+    }
+    giga_vm_ring_push(input, 3);
+    if (giga_vm_run(&state, 100) != GIGA_VM_STATUS_IO_WAIT || state.program_counter != 3 ||
+        state.registers[0] != 6 || state.registers[2] != 2) {
+        printf("VM fail: OUT on a full port should wait at PC 3\n");
+        ++failure_count;
+    }
+    uint8_t value = 0;
+    if (!giga_vm_ring_pop(output, &value) || value != 2) {
+        printf("VM fail: port 1 should hold the doubled nibbles in order\n");
+        ++failure_count;
+    }
+    if (giga_vm_run(&state, 100) != GIGA_VM_STATUS_IO_WAIT || state.program_counter != 1 ||
+        state.registers[2] != 3 || !giga_vm_ring_pop(output, &value) || value != 4 ||
+        !giga_vm_ring_pop(output, &value) || value != 6 || giga_vm_ring_pop(output, &value)) {
+        printf("VM fail: resuming OUT should finish the third nibble\n");
+        ++failure_count;
+    }
+
+    /* traced runs record what IN read; Harvard runs use the same ports */
+    uint8_t records[64];
+    size_t record_bytes = 0;
+    uint64_t retired = 0;
+    giga_vm_init(&state);
+    giga_vm_load_program(&state, doubler, 6);
+    giga_vm_attach_ports(&state, small);
+    giga_vm_ring_push(input, 5);
+    if (giga_vm_run_traced(&state, 100, records, &record_bytes, &retired) != GIGA_VM_STATUS_IO_WAIT ||
+        state.program_counter != 1 || records[0] != 0x11 || records[1] != 0x05) {
+        printf("VM fail: traced IN should record R0=5 and wait\n");
+        ++failure_count;
+    }
+    static GigaVmCode code;
+    giga_vm_code_init(&code, doubler, 6);
+    giga_vm_ports_reset(small);
+    giga_vm_ring_push(input, 7);
+    state.program_counter = 1;
+    if (giga_vm_run_code(&state, &code, 100) != GIGA_VM_STATUS_IO_WAIT || state.program_counter != 1 ||
+        !giga_vm_ring_pop(output, &value) || value != 0x0E) {
+        printf("VM fail: Harvard IN/OUT should double 7 to E\n");
+        ++failure_count;
+    }
+
+    /* restores keep the state's ports; engines without ports fault */
+    GigaVmSnapshot *snapshot = giga_vm_snapshot_take(&state);
+    giga_vm_snapshot_restore(&state, snapshot);
+    if (state.ports != small) {
+        printf("VM fail: snapshot restore should keep the ports attachment\n");
+        ++failure_count;
+    }
+    GigaVmFork child;
+    if (giga_vm_fork(&child, snapshot) != 0 || giga_vm_fork_run(&child, 10) != GIGA_VM_STATUS_PORT_FAULT ||
+        child.program_counter != 1) {
+        printf("VM fail: fork should fault on IN\n");
+        ++failure_count;
+    }
+    giga_vm_fork_release(&child);
+    giga_vm_snapshot_release(snapshot);
+
+    static GigaVmProgram program;
+    giga_vm_program_init(&program, doubler, 6);
+    GigaVmPackedState packed;
+    giga_vm_packed_init(&packed, &program);
+    if (giga_vm_packed_run(&packed, &program, 10) != GIGA_VM_STATUS_PORT_FAULT || packed.program_counter != 1) {
+        printf("VM fail: packed run should fault on IN\n");
+        ++failure_count;
+    }
+    GigaVmBatch batch;
+    if (giga_vm_batch_init(&batch, 8, doubler, 6) == 0) {
+        giga_vm_batch_run(&batch, 10);
+        if (batch.status[0] != (uint8_t)GIGA_VM_STATUS_PORT_FAULT || batch.program_counter[7] != 1) {
+            printf("VM fail: batch lanes should fault on IN\n");
+            ++failure_count;
+        }
+        giga_vm_batch_free(&batch);
+    }
+    giga_vm_attach_ports(&state, NULL);
+    giga_vm_ports_destroy(small);
+
+    /* a host thread streams nibbles through small rings while the VM runs */
+    GigaVmPorts *ports = giga_vm_ports_create(4096);
+    PortStream stream = {ports, (size_t)1 << 21, 0, 0, 0, 0};
+    giga_vm_init(&state);
+    giga_vm_load_program(&state, doubler, 6);
+    giga_vm_attach_ports(&state, ports);
+    pthread_t host;
+    if (ports == NULL || pthread_create(&host, NULL, port_stream_host, &stream) != 0) {
+        printf("VM fail: could not start the port host thread\n");
+        giga_vm_ports_destroy(ports);
+        return failure_count + 1;
+    }
+    GigaVmStatus status;
+    while ((status = giga_vm_run(&state, UINT64_MAX)) == GIGA_VM_STATUS_IO_WAIT && !atomic_load(&stream.done)) {
+        sched_yield();
+    }
+    atomic_store(&stream.stopped, 1);
+    pthread_join(host, NULL);
+    if (status != GIGA_VM_STATUS_IO_WAIT || stream.received != stream.nibbles || stream.mismatch ||
+        state.program_counter != 1 || state.registers[2] != (stream.nibbles & 0x0Fu)) {
+        printf("VM fail: streamed %zu of %zu nibbles (status %d, mismatch %d)\n", stream.received,
+               stream.nibbles, (int)status, stream.mismatch);
+        ++failure_count;
+    }
+    giga_vm_ports_destroy(ports);
+    return failure_count;
+}
+
+static int test_vm_superinstructions(void) {
+    int failure_count = 0;
+
+    uint16_t program[] = {
+        0x2A0F, /* MOVI R2, 0xF (R2 index 10 & 7) */
+        0x2307, /* loop: MOVI R3, 7 */
+        0x3030, /* ADD R0, R3 */
+        0xB1F0, /* LD R1, [0xF0] */
+        0x3120, /* ADD R1, R2 */
+        0xCF01, /* ST [0xF0], R0 */
+        0x9400, /* SHL R4 */
+        0x9400, /* SHL R4 */
+        0x3440, /* ADD R4, R0 */
+        0xD001  /* JMP loop */
+    };
+    size_t word_count = sizeof(program) / sizeof(program[0]);
+
+    GigaVmState fused;
+    giga_vm_init(&fused);
+    giga_vm_load_program(&fused, program, word_count);
+    size_t fused_count = giga_vm_fuse_superinstructions(&fused);
+    if (fused_count != 3) {
+        printf("VM fail: expected 3 superinstructions, got %zu\n", fused_count);
+        ++failure_count;
+    }
+
+    /* every step budget, including ones that end inside a fused sequence */
+    for (uint64_t max_steps = 0; max_steps < 64; ++max_steps) {
+        GigaVmState plain;
+        giga_vm_init(&plain);
+        giga_vm_load_program(&plain, program, word_count);
+        GigaVmState fused_run;
+        giga_vm_init(&fused_run);
+        giga_vm_load_program(&fused_run, program, word_count);
+        giga_vm_fuse_superinstructions(&fused_run);
+
+        GigaVmStatus plain_status = giga_vm_run(&plain, max_steps);
+        GigaVmStatus fused_status = giga_vm_run(&fused_run, max_steps);
+        if (plain_status != fused_status || !vm_states_equal(&plain, &fused_run)) {
+            printf("VM fail: fused run differs from unfused after %llu steps\n",
+                   (unsigned long long)max_steps);
+            ++failure_count;
+        }
+    }
+
+    /* a store into the covered ADD must unfuse the MOVI; ADD pair */
+    uint16_t patch[] = {
+        0x2101, /* MOVI R1, 1 */
+        0x3010, /* ADD R0, R1 (rewritten to NOP) */
+        0xC023, /* ST [3], R2 -> high byte of word 1 becomes 0 (NOP) */
+        0xD000  /* JMP 0 */
+    };
+    GigaVmState plain;
+    giga_vm_init(&plain);
+    giga_vm_load_program(&plain, patch, 4);
+    giga_vm_init(&fused);
+    giga_vm_load_program(&fused, patch, 4);
+    giga_vm_fuse_superinstructions(&fused);
+    giga_vm_run(&plain, 9);
+    giga_vm_run(&fused, 9);
+    if (!vm_states_equal(&plain, &fused) || fused.registers[0] != 1) {
+        printf("VM fail: self-modified fused pair should match unfused run (R0=%u)\n",
+               fused.registers[0]);
+        ++failure_count;
+    }
+
+    return failure_count;
+}
+
+static uint32_t vm_test_random(uint32_t *seed) {
+    *seed = *seed * 1103515245u + 12345u;
+    return (*seed >> 16) & 0x7FFFu;
+}
+
+/* Random program mixing every opcode, loops and occasional code writes. */
+static size_t vm_test_random_program(uint32_t *seed, uint16_t *program, size_t max_words) {
+    size_t word_count = 4 + vm_test_random(seed) % (max_words - 4);
+    for (size_t index = 0; index < word_count; ++index) {
+        uint16_t opcode = (uint16_t)(vm_test_random(seed) % 16);
+        uint16_t operands = (uint16_t)(vm_test_random(seed) & 0x0FFF);
+        if (opcode == GIGA_OP_JMP) {
+            operands = (uint16_t)(vm_test_random(seed) % (word_count + 1));
+        } else if (opcode == GIGA_OP_HALT && vm_test_random(seed) % 4 != 0) {
+            opcode = GIGA_OP_ADD;
+        } else if (opcode == GIGA_OP_EXT && vm_test_random(seed) % 2 == 0) {
+            operands = (uint16_t)(((vm_test_random(seed) % 3) << 8) | (operands & 0x00FF)); /* ADC, SBC or CMP */
+        } else if (opcode == GIGA_OP_EXT) {
+            operands = (uint16_t)(((GIGA_EXT_JZ + vm_test_random(seed) % 4) << 8) |
+                                  (vm_test_random(seed) % (word_count + 1))); /* JZ, JNZ, JC or JN */
+        } else if (opcode == GIGA_OP_ST && vm_test_random(seed) % 8 != 0) {
+            operands |= 0x0800; /* keep most stores out of the program */
+        }
+        program[index] = (uint16_t)((opcode << 12) | operands);
+    }
+    return word_count;
+}
+
+static int test_vm_lazy_flags(void) {
+    int failure_count = 0;
+
+    /* a run without ALU instructions must keep the flags it started with */
+    GigaVmState state;
+    giga_vm_init(&state);
+    uint16_t no_alu[] = {0x2007, 0x1100, 0xF000}; /* MOVI R0, 7; MOV R1, R0; HALT */
+    giga_vm_load_program(&state, no_alu, 3);
+    state.flags_zero = 1;
+    state.flags_overflow = 1;
+    giga_vm_run(&state, 100);
+    if (state.flags_zero != 1 || state.flags_carry != 0 ||
+        state.flags_negative != 0 || state.flags_overflow != 1) {
+        printf("VM fail: flags changed by a run with no ALU instructions\n");
+        ++failure_count;
+    }
+
+    /* one long run must agree with stepping, which materializes every word */
+    uint32_t seed = 777u;
+    for (int trial = 0; trial < 300; ++trial) {
+        uint16_t program[32];
+        size_t word_count = vm_test_random_program(&seed, program, 32);
+        uint64_t max_steps = vm_test_random(&seed) % 200;
+
+        GigaVmState stepped;
+        giga_vm_init(&stepped);
+        giga_vm_load_program(&stepped, program, word_count);
+        for (size_t reg = 0; reg < GIGA_VM_REGISTER_COUNT; ++reg) {
+            stepped.registers[reg] = (uint8_t)vm_test_random(&seed); /* high bits ignored */
+        }
+        stepped.flags_carry = (uint8_t)(trial & 1);
+        GigaVmState whole = stepped;
+
+        GigaVmStatus whole_status = giga_vm_run(&whole, max_steps);
+        GigaVmStatus stepped_status = GIGA_VM_STATUS_STEP_LIMIT;
+        for (uint64_t step = 0; step < max_steps; ++step) {
+            stepped_status = giga_vm_step(&stepped);
+            if (stepped_status != GIGA_VM_STATUS_RUNNING) {
+                break;
+            }
+            stepped_status = GIGA_VM_STATUS_STEP_LIMIT;
+        }
+        if (whole_status != stepped_status || !vm_states_equal(&whole, &stepped)) {
+            printf("VM fail: lazy flags differ between run and step (trial %d)\n", trial);
+            ++failure_count;
+        }
+    }
+
+    return failure_count;
+}
+
+static int test_vm_packed_matches_interpreter(void) {
+    int failure_count = 0;
+
+    if (sizeof(GigaVmPackedState) * 2 > sizeof(GigaVmState)) {
+        printf("VM fail: packed state (%zu bytes) is not under half of GigaVmState (%zu)\n",
+               sizeof(GigaVmPackedState), sizeof(GigaVmState));
+        ++failure_count;
+    }
+
+    static GigaVmProgram program;
+    uint32_t seed = 2024u;
+    for (int trial = 0; trial < 400; ++trial) {
+        uint16_t words[40];
+        size_t word_count = vm_test_random_program(&seed, words, 40);
+        uint64_t max_steps = vm_test_random(&seed) % 500;
+        int fuse = trial % 2;
+
+        GigaVmState full;
+        giga_vm_init(&full);
+        giga_vm_load_program(&full, words, word_count);
+        giga_vm_program_init(&program, words, word_count);
+        if (fuse) {
+            giga_vm_fuse_superinstructions(&full);
+            giga_vm_program_fuse(&program);
+        }
+
+        GigaVmPackedState packed;
+        giga_vm_packed_init(&packed, &program);
+        for (size_t reg = 0; reg < GIGA_VM_REGISTER_COUNT; ++reg) {
+            uint8_t value = (uint8_t)(vm_test_random(&seed) & 0x0F);
+            full.registers[reg] = value;
+            giga_vm_packed_set_register(&packed, reg, value);
+        }
+
+        for (int leg = 0; leg < 2; ++leg) {
+            uint64_t budget = (leg == 0) ? max_steps : 61u;
+            GigaVmStatus full_status = giga_vm_run(&full, budget);
+            GigaVmStatus packed_status = giga_vm_packed_run(&packed, &program, budget);
+            GigaVmState expanded;
+            giga_vm_packed_unpack(&packed, &program, &expanded);
+            if (full_status != packed_status || !vm_states_equal(&full, &expanded)) {
+                printf("VM fail: packed run differs from interpreter (trial %d, leg %d)\n", trial, leg);
+                ++failure_count;
+                break;
+            }
+        }
+
+        /* pack -> unpack keeps the observable state */
+        GigaVmPackedState repacked;
+        GigaVmState round_trip;
+        if (giga_vm_packed_pack(&full, &program, &repacked) != 0 ||
+            giga_vm_packed_unpack(&repacked, &program, &round_trip) != 0 ||
+            !vm_states_equal(&full, &round_trip)) {
+            printf("VM fail: packed pack/unpack round trip differs (trial %d)\n", trial);
+            ++failure_count;
+        }
+    }
+
+    return failure_count;
+}
+
+static int test_vm_jit_matches_interpreter(void) {
+    int failure_count = 0;
+    if (!giga_vm_jit_available()) {
+        return 0;
+    }
+    GigaVmJit *jit = giga_vm_jit_create();
+    if (jit == NULL) {
+        printf("VM fail: JIT available but could not be created\n");
+        return 1;
+    }
+
+    uint32_t seed = 12345u;
+    for (int trial = 0; trial < 400; ++trial) {
+        uint16_t program[48];
+        size_t word_count = vm_test_random_program(&seed, program, 48);
+        uint64_t max_steps = vm_test_random(&seed) % 600;
+
+        GigaVmState interpreted;
+        giga_vm_init(&interpreted);
+        giga_vm_load_program(&interpreted, program, word_count);
+        interpreted.registers[3] = 9;
+        GigaVmState translated = interpreted;
+
+        GigaVmStatus interpreted_status = giga_vm_run(&interpreted, max_steps);
+        GigaVmStatus translated_status = giga_vm_jit_run(jit, &translated, max_steps);
+        if (interpreted_status != translated_status || !vm_states_equal(&interpreted, &translated)) {
+            printf("VM fail: JIT differs from interpreter (trial %d, status %d vs %d, pc %u vs %u)\n",
+                   trial, (int)interpreted_status, (int)translated_status,
+                   interpreted.program_counter, translated.program_counter);
+            ++failure_count;
+        }
+
+        /* resuming a stopped run must also agree */
+        interpreted_status = giga_vm_run(&interpreted, 97);
+        translated_status = giga_vm_jit_run(jit, &translated, 97);
+        if (interpreted_status != translated_status || !vm_states_equal(&interpreted, &translated)) {
+            printf("VM fail: resumed JIT run differs from interpreter (trial %d)\n", trial);
+            ++failure_count;
+        }
+    }
+
+    giga_vm_jit_destroy(jit);
+    return failure_count;
+}
+
+static int test_vm_snapshot_and_fork(void) {
+    int failure_count = 0;
+
+    /* restore copies back only what the run wrote */
+    uint16_t program[] = {
+        0x2105, /* MOVI R1, 5 */
+        0xC411, /* ST [0x41], R1 */
+        0x2300, /* MOVI R3, 0 */
+        0xC039, /* ST [0x09], R3: word 4 becomes NOP */
+        0x2607, /* MOVI R6, 7 */
+        0xF000  /* HALT */
+    };
+    GigaVmState state;
+    giga_vm_init(&state);
+    giga_vm_load_program(&state, program, 6);
+    state.memory[0x90] = 7;
+    GigaVmSnapshot *snapshot = giga_vm_snapshot_take(&state);
+    GigaVmState original = state;
+    if (snapshot == NULL || state.dirty_blocks != 0) {
+        printf("VM fail: snapshot_take did not clear dirty_blocks\n");
+        return failure_count + 1;
+    }
+    giga_vm_run(&state, 100);
+    if (state.dirty_blocks != (GIGA_VM_DIRTY_BIT(0x41) | GIGA_VM_DIRTY_BIT(0x09)) || state.registers[6] != 0) {
+        printf("VM fail: dirty_blocks 0x%04X after two stores\n", state.dirty_blocks);
+        ++failure_count;
+    }
+    state.memory[0x90] = 3; /* untracked host write is not undone */
+    giga_vm_snapshot_restore(&state, snapshot);
+    if (state.memory[0x90] != 3 || state.memory[0x41] != 0 || state.memory[0x09] != 0x26 ||
+        state.registers[1] != 0 || state.program_counter != 0) {
+        printf("VM fail: restore did not copy exactly the dirty blocks\n");
+        ++failure_count;
+    }
+    state.memory[0x90] = 7;
+    giga_vm_mark_dirty(&state, 0x90);
+    state.program_counter = 4; /* the rewritten word runs as captured */
+    if (giga_vm_run(&state, 100) != GIGA_VM_STATUS_HALTED || state.registers[6] != 7) {
+        printf("VM fail: restore kept the predecoded entry of rewritten code\n");
+        ++failure_count;
+    }
+    giga_vm_snapshot_restore(&state, snapshot);
+    GigaVmState rerun = original;
+    if (giga_vm_run(&state, 100) != giga_vm_run(&rerun, 100) || !vm_states_equal(&state, &rerun)) {
+        printf("VM fail: run after restore differs from the first run\n");
+        ++failure_count;
+    }
+
+    /* a child runs the code it rewrote, without touching the parent */
+    GigaVmFork child;
+    giga_vm_fork(&child, snapshot);
+    if (giga_vm_fork_run(&child, 100) != GIGA_VM_STATUS_HALTED || child.registers[6] != 0 ||
+        giga_vm_fork_load(&child, 0x41) != 5 ||
+        child.dirty_blocks != (GIGA_VM_DIRTY_BIT(0x41) | GIGA_VM_DIRTY_BIT(0x09))) {
+        printf("VM fail: fork did not run its self-modified code\n");
+        ++failure_count;
+    }
+    giga_vm_fork_release(&child);
+    giga_vm_fork(&child, snapshot);
+    if (giga_vm_fork_run(&child, 100) != GIGA_VM_STATUS_HALTED || child.registers[6] != 0) {
+        printf("VM fail: second fork saw the first child's writes\n");
+        ++failure_count;
+    }
+    giga_vm_fork_release(&child);
+    giga_vm_snapshot_release(snapshot);
+
+    /* forks and restores agree with runs on full copies */
+    GigaVmJit *jit = giga_vm_jit_available() ? giga_vm_jit_create() : NULL;
+    uint32_t seed = 4242u;
+    for (int trial = 0; trial < 300; ++trial) {
+        uint16_t words[48];
+        size_t word_count = vm_test_random_program(&seed, words, 48);
+        giga_vm_init(&state);
+        giga_vm_load_program(&state, words, word_count);
+        if (trial % 2) {
+            giga_vm_fuse_superinstructions(&state);
+        }
+        for (size_t address = word_count * 2u; address < GIGA_VM_MEMORY_SIZE; ++address) {
+            state.memory[address] = (uint8_t)(vm_test_random(&seed) & 0x0F);
+        }
+        giga_vm_run(&state, vm_test_random(&seed) % 100);
+
+        snapshot = giga_vm_snapshot_take(&state);
+        original = state;
+        giga_vm_fork(&child, snapshot);
+        if (trial % 3 == 0) {
+            giga_vm_snapshot_release(snapshot); /* the child keeps it alive */
+        }
+
+        for (int leg = 0; leg < 2; ++leg) {
+            uint64_t budget = (leg == 0) ? vm_test_random(&seed) % 400 : 53u;
+            GigaVmStatus state_status = (jit != NULL && trial % 4 == 1) ? giga_vm_jit_run(jit, &state, budget)
+                                                                        : giga_vm_run(&state, budget);
+            GigaVmStatus child_status = giga_vm_fork_run(&child, budget);
+            GigaVmState expanded;
+            giga_vm_fork_unpack(&child, &expanded);
+            if (state_status != child_status || !vm_states_equal(&state, &expanded)) {
+                printf("VM fail: fork differs from interpreter (trial %d, leg %d)\n", trial, leg);
+                ++failure_count;
+                break;
+            }
+        }
+
+        if (trial % 3 != 0) {
+            giga_vm_snapshot_restore(&state, snapshot);
+            rerun = original;
+            if (!vm_states_equal(&state, &original) ||
+                giga_vm_run(&state, 300) != giga_vm_run(&rerun, 300) || !vm_states_equal(&state, &rerun)) {
+                printf("VM fail: restored state differs from the snapshot (trial %d)\n", trial);
+                ++failure_count;
+            }
+            giga_vm_snapshot_release(snapshot);
+        }
+        giga_vm_fork_release(&child);
+    }
+    if (jit != NULL) {
+        giga_vm_jit_destroy(jit);
+    }
+
+    return failure_count;
+}
+
+static int test_vm_batch_matches_interpreter(void) {
+    int failure_count = 0;
+    enum { LANES = 100 };
+    static GigaVmState reference[LANES];
+    static GigaVmState lane_state;
+    const GigaVmBatchKernel kernels[] = {
+        GIGA_VM_BATCH_KERNEL_SCALAR, GIGA_VM_BATCH_KERNEL_SSE2, GIGA_VM_BATCH_KERNEL_AVX2
+    };
+
+    uint32_t seed = 777u;
+    for (int trial = 0; trial < 60; ++trial) {
+        uint16_t program[48];
+        size_t word_count = vm_test_random_program(&seed, program, 48);
+        uint64_t max_steps = vm_test_random(&seed) % 600;
+
+        for (size_t lane = 0; lane < LANES; ++lane) {
+            giga_vm_init(&reference[lane]);
+            giga_vm_load_program(&reference[lane], program, word_count);
+            for (size_t reg = 0; reg < GIGA_VM_REGISTER_COUNT; ++reg) {
+                reference[lane].registers[reg] = (uint8_t)(vm_test_random(&seed) & 0x0F);
+            }
+            for (size_t address = word_count * 2u; address < GIGA_VM_MEMORY_SIZE; ++address) {
+                reference[lane].memory[address] = (uint8_t)vm_test_random(&seed);
+            }
+            if (lane % 37 == 5) {
+                reference[lane].program_counter = 1; /* starts outside lock-step */
+            }
+        }
+
+        for (size_t kernel_index = 0; kernel_index < sizeof(kernels) / sizeof(kernels[0]); ++kernel_index) {
+            GigaVmBatch batch;
+            if (giga_vm_batch_init(&batch, LANES, program, word_count) != 0) {
+                printf("VM fail: batch init failed\n");
+                return failure_count + 1;
+            }
+            if (giga_vm_batch_set_kernel(&batch, kernels[kernel_index]) != 0) {
+                giga_vm_batch_free(&batch);
+                continue;
+            }
+            for (size_t lane = 0; lane < LANES; ++lane) {
+                giga_vm_batch_set_lane(&batch, lane, &reference[lane]);
+            }
+
+            const uint64_t budgets[] = {max_steps, 97};
+            for (size_t run = 0; run < 2; ++run) {
+                giga_vm_batch_run(&batch, budgets[run]);
+                for (size_t lane = 0; lane < LANES; ++lane) {
+                    GigaVmState expected = reference[lane];
+                    GigaVmStatus expected_status = giga_vm_run(&expected, max_steps);
+                    if (run == 1) {
+                        expected_status = giga_vm_run(&expected, 97);
+                    }
+                    giga_vm_batch_get_lane(&batch, lane, &lane_state);
+                    if (batch.status[lane] != (uint8_t)expected_status ||
+                        !vm_states_equal(&expected, &lane_state)) {
+                        printf("VM fail: batch lane %zu differs (trial %d, kernel %d, run %zu)\n",
+                               lane, trial, (int)kernels[kernel_index], run);
+                        ++failure_count;
+                        break;
+                    }
+                }
+            }
+            giga_vm_batch_free(&batch);
+        }
+    }
+
+    return failure_count;
+}
+
+#define VM_TEST_TRACE_PATH "vm_tests_trace.gtr"
+
+static int test_vm_trace_record_replay(void) {
+    int failure_count = 0;
+
+    /* random programs: every index replays to the interpreter's state */
+    uint32_t seed = 9001u;
+    for (int trial = 0; trial < 40; ++trial) {
+        uint16_t words[48];
+        size_t word_count = vm_test_random_program(&seed, words, 48);
+        GigaVmState state;
+        giga_vm_init(&state);
+        giga_vm_load_program(&state, words, word_count);
+        GigaVmState original = state;
+
+        GigaVmTraceWriter *writer = giga_vm_trace_create(VM_TEST_TRACE_PATH, GIGA_VM_TRACE_MIN_CAPACITY);
+        if (writer == NULL) {
+            printf("VM fail: could not create %s\n", VM_TEST_TRACE_PATH);
+            return failure_count + 1;
+        }
+        GigaVmState plain = original;
+        GigaVmStatus traced_status = giga_vm_trace_run(writer, &state, 200);
+        GigaVmStatus plain_status = giga_vm_run(&plain, 200);
+        uint64_t recorded = giga_vm_trace_instruction_count(writer);
+        giga_vm_trace_close(writer);
+        if (traced_status != plain_status || !vm_states_equal(&state, &plain)) {
+            printf("VM fail: traced run differs from interpreter (trial %d)\n", trial);
+            ++failure_count;
+            continue;
+        }
+
+        GigaVmReplay *replay = giga_vm_replay_open(VM_TEST_TRACE_PATH);
+        if (replay == NULL || giga_vm_replay_instruction_count(replay) != recorded) {
+            printf("VM fail: replay_open lost the trace (trial %d)\n", trial);
+            giga_vm_replay_close(replay);
+            ++failure_count;
+            continue;
+        }
+        GigaVmState replayed;
+        GigaVmState stepped;
+        giga_vm_replay_seek(replay, 0, &stepped);
+        for (uint64_t index = 0; index <= recorded; ++index) {
+            GigaVmState expected = original;
+            giga_vm_run(&expected, index);
+            if (index == recorded) {
+                /* HALT or an error adds a stop record, not an instruction */
+                expected = plain;
+            }
+            if (giga_vm_replay_seek(replay, index, &replayed) != 0 || !vm_states_equal(&replayed, &expected) ||
+                !vm_states_equal(&stepped, &expected)) {
+                printf("VM fail: replay differs at instruction %llu (trial %d)\n",
+                       (unsigned long long)index, trial);
+                ++failure_count;
+                break;
+            }
+            if (giga_vm_replay_step(replay, &stepped) != (index == recorded ? 1 : 0)) {
+                printf("VM fail: replay_step at instruction %llu (trial %d)\n", (unsigned long long)index, trial);
+                ++failure_count;
+                break;
+            }
+        }
+        if (giga_vm_replay_seek(replay, recorded + 1u, &replayed) != -2) {
+            printf("VM fail: seek past the end accepted\n");
+            ++failure_count;
+        }
+        /* replayed state runs on like the original */
+        giga_vm_replay_seek(replay, recorded / 2u, &replayed);
+        GigaVmState expected = original;
+        giga_vm_run(&expected, recorded / 2u);
+        if (giga_vm_run(&replayed, 300) != giga_vm_run(&expected, 300) || !vm_states_equal(&replayed, &expected)) {
+            printf("VM fail: replayed state does not run like the original (trial %d)\n", trial);
+            ++failure_count;
+        }
+        giga_vm_replay_close(replay);
+    }
+
+    /* a long loop wraps the ring; keyframes keep recent history seekable */
+    uint16_t loop[] = {
+        0x2101, /* MOVI R1, 1 */
+        0x3010, /* loop: ADD R0, R1 */
+        0xC800, /* ST [0x80], R0 */
+        0xB280, /* LD R2, [0x80] */
+        0x1320, /* MOV R3, R2 */
+        0xD001  /* JMP loop */
+    };
+    GigaVmState state;
+    giga_vm_init(&state);
+    giga_vm_load_program(&state, loop, 6);
+    GigaVmState original = state;
+    GigaVmTraceWriter *writer = giga_vm_trace_create(VM_TEST_TRACE_PATH, GIGA_VM_TRACE_MIN_CAPACITY);
+    if (writer == NULL) {
+        return failure_count + 1;
+    }
+    giga_vm_trace_run(writer, &state, 300000);
+    state.registers[5] = 9; /* host change: the next run starts with a keyframe */
+    GigaVmState changed = state;
+    giga_vm_trace_run(writer, &state, 1000);
+    giga_vm_trace_close(writer);
+
+    GigaVmReplay *replay = giga_vm_replay_open(VM_TEST_TRACE_PATH);
+    uint64_t first = giga_vm_replay_first_instruction(replay);
+    GigaVmState replayed;
+    if (replay == NULL || first == 0 || giga_vm_replay_instruction_count(replay) != 301000u ||
+        giga_vm_replay_seek(replay, first - 1u, &replayed) != -2) {
+        printf("VM fail: wrapped trace kept instruction %llu\n", (unsigned long long)first);
+        giga_vm_replay_close(replay);
+        return failure_count + 1;
+    }
+    uint64_t targets[] = {first, first + 12345u, 299999u, 300000u, 300500u, 301000u};
+    for (size_t target = 0; target < sizeof(targets) / sizeof(targets[0]); ++target) {
+        uint64_t index = targets[target];
+        GigaVmState expected = original;
+        giga_vm_run(&expected, index < 300000u ? index : 300000u);
+        if (index >= 300000u) {
+            expected = changed;
+            giga_vm_run(&expected, index - 300000u);
+        }
+        if (giga_vm_replay_seek(replay, index, &replayed) != 0 || !vm_states_equal(&replayed, &expected)) {
+            printf("VM fail: wrapped replay differs at instruction %llu\n", (unsigned long long)index);
+            ++failure_count;
+        }
+    }
+    giga_vm_replay_close(replay);
+    remove(VM_TEST_TRACE_PATH);
+
+    if (giga_vm_trace_create(VM_TEST_TRACE_PATH, 1024u) != NULL || giga_vm_replay_open("vm_tests_missing.gtr") != NULL) {
+        printf("VM fail: trace accepted a tiny ring or a missing file\n");
+        ++failure_count;
+    }
+
+    return failure_count;
+}
+
+static int test_vm_profile(void) {
+    int failure_count = 0;
+
+    uint16_t program[] = {
+        0x2103, /* MOVI R1, 3 */
+        0x2201, /* loop: MOVI R2, 1 */
+        0x3120, /* ADD R1, R2 */
+        0xC811, /* ST [0x81], R1 */
+        0xD001, /* JMP loop */
+        0xF000  /* HALT (never reached) */
+    };
+    GigaVmState state;
+    giga_vm_init(&state);
+    giga_vm_load_program(&state, program, 6);
+    giga_vm_fuse_superinstructions(&state); /* profiling counts the words anyway */
+    static GigaVmProfile profile;
+    giga_vm_profile_reset(&profile);
+    if (giga_vm_run_profiled(&state, 1 + 4 * 100, &profile) != GIGA_VM_STATUS_STEP_LIMIT ||
+        profile.pc_counts[0] != 1 || profile.pc_counts[1] != 100 || profile.pc_counts[4] != 100 ||
+        profile.pc_counts[5] != 0 || profile.jump_counts[4] != 100 || profile.jump_counts[3] != 0 ||
+        profile.opcode_counts[GIGA_OP_MOVI] != 101 || profile.opcode_counts[GIGA_OP_ADD] != 100 ||
+        profile.opcode_counts[GIGA_OP_ST] != 100) {
+        printf("VM fail: profile counts wrong for a simple loop\n");
+        ++failure_count;
+    }
+
+    GigaVmHotBlock blocks[4];
+    size_t block_count = giga_vm_profile_hot_blocks(&profile, &state, blocks, 4);
+    if (block_count != 2 || blocks[0].first_pc != 1 || blocks[0].last_pc != 4 ||
+        blocks[0].entry_count != 100 || blocks[0].instruction_count != 400 ||
+        blocks[1].first_pc != 0 || blocks[1].last_pc != 0) {
+        printf("VM fail: hot blocks wrong (%zu blocks)\n", block_count);
+        ++failure_count;
+    }
+    if (giga_vm_profile_hot_blocks(&profile, &state, blocks, 1) != 1 || blocks[0].first_pc != 1) {
+        printf("VM fail: hot blocks ignored max_blocks\n");
+        ++failure_count;
+    }
+
+    /* running off the end counts no instruction past the last word */
+    uint16_t straight[] = {
+        0x2103, /* MOVI R1, 3 */
+        0x0000  /* NOP */
+    };
+    giga_vm_init(&state);
+    giga_vm_load_program(&state, straight, 2);
+    giga_vm_profile_reset(&profile);
+    giga_vm_run_profiled(&state, 10, &profile);
+    if (profile.pc_counts[0] != 1 || profile.pc_counts[1] != 1 || profile.pc_counts[2] != 0 ||
+        giga_vm_profile_hot_blocks(&profile, &state, blocks, 4) != 1 || blocks[0].instruction_count != 2) {
+        printf("VM fail: profile counted the end-of-program sentinel\n");
+        ++failure_count;
+    }
+
+    /* same results as giga_vm_run, self-modifying code included */
+    uint32_t seed = 777u;
+    for (int trial = 0; trial < 200; ++trial) {
+        uint16_t words[48];
+        size_t word_count = vm_test_random_program(&seed, words, 48);
+        GigaVmState profiled;
+        giga_vm_init(&profiled);
+        giga_vm_load_program(&profiled, words, word_count);
+        if (trial % 2) {
+            giga_vm_fuse_superinstructions(&profiled);
+        }
+        GigaVmState plain = profiled;
+        giga_vm_profile_reset(&profile);
+        GigaVmStatus profiled_status = giga_vm_run_profiled(&profiled, 300, &profile);
+        GigaVmStatus plain_status = giga_vm_run(&plain, 300);
+        uint64_t dispatched = 0;
+        for (size_t pc = 0; pc < GIGA_VM_PROFILE_PC_SLOTS; ++pc) {
+            dispatched += profile.pc_counts[pc];
+        }
+        GigaVmCounters counters;
+        giga_vm_counters(&plain, &counters);
+        if (profiled_status != plain_status || !vm_states_equal(&profiled, &plain) ||
+            dispatched != counters.retired) {
+            printf("VM fail: profiled run differs from interpreter (trial %d)\n", trial);
+            ++failure_count;
+            break;
+        }
+    }
+
+    return failure_count;
+}
+
+/* Step once, adding what the instruction should count to expected. */
+static GigaVmStatus vm_test_counted_step(GigaVmState *state, GigaVmCounters *expected) {
+    size_t word_count = state->loaded_program_words;
+    uint16_t pc = state->program_counter;
+    uint16_t word = 0;
+    giga_vm_fetch_word(state, &word);
+    GigaInstruction instruction = giga_decode_instruction(word);
+    int branch = instruction.opcode == GIGA_OP_EXT && GIGA_EXT_IS_BRANCH(instruction.dest_reg);
+    int taken = 0;
+    if (branch) {
+        switch (instruction.dest_reg) {
+            case GIGA_EXT_JZ: taken = state->flags_zero; break;
+            case GIGA_EXT_JNZ: taken = !state->flags_zero; break;
+            case GIGA_EXT_JC: taken = state->flags_carry; break;
+            default: taken = state->flags_negative; break;
+        }
+    }
+    GigaVmStatus status = giga_vm_step(state);
+    int jumped_out = status == GIGA_VM_STATUS_PC_OUT_OF_RANGE && pc < word_count &&
+                     (instruction.opcode == GIGA_OP_JMP || (branch && taken));
+    if (status != GIGA_VM_STATUS_RUNNING && status != GIGA_VM_STATUS_HALTED && !jumped_out) {
+        return status;
+    }
+
+    ++expected->retired;
+    if (instruction.opcode >= GIGA_OP_ADD && instruction.opcode <= GIGA_OP_SHR) {
+        ++expected->alu_ops[GIGA_VM_COUNTER_ADD + (instruction.opcode - GIGA_OP_ADD)];
+    } else if (branch) {
+        ++expected->flag_reads;
+        expected->taken_jumps += (uint64_t)taken;
+    } else if (instruction.opcode == GIGA_OP_EXT && instruction.dest_reg == GIGA_EXT_CMP) {
+        ++expected->alu_ops[GIGA_VM_COUNTER_CMP];
+    } else if (instruction.opcode == GIGA_OP_EXT) {
+        ++expected->alu_ops[(instruction.dest_reg == GIGA_EXT_ADC) ? GIGA_VM_COUNTER_ADC : GIGA_VM_COUNTER_SBC];
+        ++expected->flag_reads;
+    } else if (instruction.opcode == GIGA_OP_LD) {
+        ++expected->loads;
+    } else if (instruction.opcode == GIGA_OP_ST) {
+        ++expected->stores;
+        if ((size_t)((instruction.dest_reg << 4) | instruction.imm4) < word_count * 2u) {
+            ++expected->code_writes;
+        }
+    } else if (instruction.opcode == GIGA_OP_JMP) {
+        ++expected->taken_jumps;
+    }
+    return status;
+}
+
+static int test_vm_counters(void) {
+    int failure_count = 0;
+
+    uint16_t program[] = {
+        0x2103, /* MOVI R1, 3 */
+        0x2201, /* loop: MOVI R2, 1 */
+        0x3120, /* ADD R1, R2 */
+        0xC811, /* ST [0x81], R1 */
+        0xD001  /* JMP loop */
+    };
+    GigaVmState state;
+    giga_vm_init(&state);
+    giga_vm_load_program(&state, program, 5);
+    giga_vm_fuse_superinstructions(&state);
+    GigaVmCounters counters;
+    giga_vm_run(&state, 1 + 4 * 100);
+    if (giga_vm_counters(&state, &counters) != 0 || counters.retired != 401 ||
+        counters.alu_ops[GIGA_VM_COUNTER_ADD] != 100 || counters.alu_ops[GIGA_VM_COUNTER_SUB] != 0 ||
+        counters.stores != 100 || counters.loads != 0 || counters.taken_jumps != 100 ||
+        counters.code_writes != 0 || counters.flag_reads != 0) {
+        printf("VM fail: counters wrong for a simple loop\n");
+        ++failure_count;
+    }
+    giga_vm_counters_reset(&state);
+    giga_vm_counters(&state, &counters);
+    if (counters.retired != 0 || counters.stores != 0 || giga_vm_counters(NULL, &counters) != -1 ||
+        giga_vm_counters(&state, NULL) != -1) {
+        printf("VM fail: counters reset or argument checks wrong\n");
+        ++failure_count;
+    }
+
+    /* chunked runs count exactly what stepping retires, self-modifying code included */
+    uint32_t seed = 1717u;
+    for (int trial = 0; trial < 300; ++trial) {
+        uint16_t words[48];
+        size_t word_count = vm_test_random_program(&seed, words, 48);
+        GigaVmState run;
+        giga_vm_init(&run);
+        giga_vm_load_program(&run, words, word_count);
+        GigaVmState stepped = run;
+        if (trial % 2) {
+            giga_vm_fuse_superinstructions(&run);
+        }
+        GigaVmSnapshot *snapshot = giga_vm_snapshot_take(&run);
+
+        GigaVmCounters expected;
+        memset(&expected, 0, sizeof(expected));
+        GigaVmStatus stepped_status = GIGA_VM_STATUS_RUNNING;
+        for (int step = 0; step < 400 && stepped_status == GIGA_VM_STATUS_RUNNING; ++step) {
+            stepped_status = vm_test_counted_step(&stepped, &expected);
+        }
+        GigaVmStatus run_status = GIGA_VM_STATUS_STEP_LIMIT;
+        for (uint64_t budget = 400; budget > 0 && run_status == GIGA_VM_STATUS_STEP_LIMIT;) {
+            uint64_t chunk = 1 + vm_test_random(&seed) % 50;
+            chunk = (chunk < budget) ? chunk : budget;
+            run_status = giga_vm_run(&run, chunk);
+            budget -= chunk;
+        }
+
+        GigaVmCounters stepped_counters;
+        giga_vm_counters(&run, &counters);
+        giga_vm_counters(&stepped, &stepped_counters);
+        if (memcmp(&counters, &expected, sizeof(expected)) != 0 ||
+            memcmp(&stepped_counters, &expected, sizeof(expected)) != 0) {
+            printf("VM fail: counters differ from stepping (trial %d)\n", trial);
+            ++failure_count;
+            giga_vm_snapshot_release(snapshot);
+            break;
+        }
+
+        /* a restore keeps the counters, so a second run doubles them */
+        giga_vm_snapshot_restore(&run, snapshot);
+        giga_vm_run(&run, 400);
+        giga_vm_counters(&run, &counters);
+        giga_vm_snapshot_release(snapshot);
+        if (counters.retired != 2 * expected.retired || counters.code_writes != 2 * expected.code_writes ||
+            counters.taken_jumps != 2 * expected.taken_jumps) {
+            printf("VM fail: counters not kept across a restore (trial %d)\n", trial);
+            ++failure_count;
+            break;
+        }
+    }
+
+    return failure_count;
+}
+
 int main(void) {
     int failure_count = 0;
 
@@ -170,6 +2104,27 @@ int main(void) {
     failure_count += test_vm_load_program();
     failure_count += test_vm_fetch_word();
     failure_count += test_vm_decode_instruction();
+    failure_count += test_vm_run_alu();
+    failure_count += test_vm_run_flags();
+    failure_count += test_vm_run_carry_chain();
+    failure_count += test_vm_run_load_store();
+    failure_count += test_vm_run_jump_and_limits();
+    failure_count += test_vm_conditional_branches();
+    failure_count += test_vm_banked_memory();
+    failure_count += test_vm_separate_code();
+    failure_count += test_vm_ports();
+    failure_count += test_vm_image();
+    failure_count += test_vm_image_writers();
+    failure_count += test_vm_self_modifying_store();
+    failure_count += test_vm_superinstructions();
+    failure_count += test_vm_lazy_flags();
+    failure_count += test_vm_packed_matches_interpreter();
+    failure_count += test_vm_jit_matches_interpreter();
+    failure_count += test_vm_batch_matches_interpreter();
+    failure_count += test_vm_snapshot_and_fork();
+    failure_count += test_vm_trace_record_replay();
+    failure_count += test_vm_profile();
+    failure_count += test_vm_counters();
 
     if (failure_count == 0) {
         printf("VM tests: ALL PASSED\n");